@@ -0,0 +1,71 @@
+#include "Adpcm.h"
+
+static const int16_t STEPS[89] =
+{
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+  12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t INDEX_STEPS[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+// Move the state by code, the same for the encoder and the decoder
+static inline int16_t update(Adpcm::State &state, uint8_t code)
+{
+  int32_t step = STEPS[state.index];
+  int32_t diff = step >> 3;
+  if (code & 4) diff += step;
+  if (code & 2) diff += step >> 1;
+  if (code & 1) diff += step >> 2;
+  int32_t p = code & 8 ? state.predictor - diff : state.predictor + diff;
+  state.predictor = p > INT16_MAX ? INT16_MAX : p < INT16_MIN ? INT16_MIN : p;
+  int16_t index = state.index + INDEX_STEPS[code & 7];
+  state.index = index < 0 ? 0 : index > 88 ? 88 : index;
+  return state.predictor;
+}
+
+// The code that brings the predictor closest to sample
+uint8_t Adpcm::encode(State &state, int16_t sample)
+{
+  int32_t step = STEPS[state.index];
+  int32_t diff = sample - state.predictor;
+  uint8_t code = 0;
+  if (diff < 0)
+  {
+    code = 8;
+    diff = -diff;
+  }
+  if (diff >= step) { code |= 4; diff -= step; }
+  step >>= 1;
+  if (diff >= step) { code |= 2; diff -= step; }
+  step >>= 1;
+  if (diff >= step) code |= 1;
+  update(state, code);
+  return code;
+}
+
+int16_t Adpcm::decode(State &state, uint8_t code)
+{
+  return update(state, code);
+}
+
+/**
+ * Decode the samples first .. first + n - 1 of block into out, the codes
+ * before first have to be run through as well.
+ */
+void Adpcm::decodeBlock(const uint8_t *block, uint16_t first, int16_t *out, uint16_t n)
+{
+  State state;
+  state.predictor = (int16_t)(block[0] | block[1] << 8);
+  state.index = block[2] <= 88 ? block[2] : 88;
+  const uint8_t *codes = block + HEADER_BYTES;
+  uint16_t end = first + n <= BLOCK_SAMPLES ? first + n : BLOCK_SAMPLES;
+  for (uint16_t i = 0; i < end; i++)
+  {
+    int16_t s = update(state, codes[i / 2] >> (i & 1 ? 4 : 0) & 15);
+    if (i >= first) *out++ = s;
+  }
+}
@@ -0,0 +1,34 @@
+#ifndef _ADPCM_H_
+#define _ADPCM_H_
+#include <stdint.h>
+
+/**
+ * IMA ADPCM, 4 bits per 16 bit sample. The samples are coded in blocks of
+ * BLOCK_SAMPLES, each block starts with the state of the coder, so any
+ * block can be decoded on its own and a bit error does not last longer
+ * than its block:
+ *   predictor   int16, little endian
+ *   index       uint8, into the step table, 0 .. 88
+ *   reserved    uint8, 0
+ *   codes       BLOCK_SAMPLES / 2 bytes, the first sample in the low nibble
+ * 132 bytes per 256 samples, 3.9 times less than 16 bit.
+ */
+class Adpcm
+{
+  public:
+    static const uint16_t BLOCK_SAMPLES = 256;
+    static const uint16_t HEADER_BYTES = 4;
+    static const uint16_t BLOCK_BYTES = HEADER_BYTES + BLOCK_SAMPLES / 2;
+
+    struct State
+    {
+      int16_t predictor = 0;
+      uint8_t index = 0;
+    };
+
+    static uint8_t encode(State &state, int16_t sample);
+    static int16_t decode(State &state, uint8_t code);
+    static void decodeBlock(const uint8_t *block, uint16_t first, int16_t *out, uint16_t n);
+    static uint32_t bytes(uint32_t samples) { return (samples + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES * BLOCK_BYTES; }
+};
+#endif
@@ -0,0 +1,312 @@
+#ifndef _AUDIOWORKER_H_
+#define _AUDIOWORKER_H_
+#ifndef ARDUINO
+#include <thread>
+#endif
+#include "SpscQueue.h"
+#include "PolyPlayer.h"
+#include "Concert.h"
+#include "SongCode.h"
+
+/**
+ * What the audio worker is asked to do. The fields a command does not
+ * use are ignored.
+ *   BIRD      voice, bird, msPause
+ *   CHIRP     voice, fStart, fStop, nSteps, nPeriods, nChirps, gen, duty, msPause
+ *             gen is a SongGen, a sinc carries nPi in the upper 4 bits (see SongCode.h)
+ *   STOP      all voices and the concert
+ *   CONCERT   birdsPerMinute, maxOverlap; birdsPerMinute 0 ends the concert
+ */
+struct AudioCommand
+{
+  enum Op : uint8_t { BIRD, CHIRP, STOP, CONCERT };
+
+  Op       op;
+  uint8_t  voice;
+  uint8_t  gen;
+  uint8_t  duty;
+  uint16_t bird;
+  uint16_t fStart;
+  uint16_t fStop;
+  uint16_t nSteps;
+  uint16_t nPeriods;
+  uint16_t nChirps;
+  uint16_t birdsPerMinute;
+  uint8_t  maxOverlap;
+  uint32_t msPause;
+};
+
+/**
+ * Plays in a task of its own: a FreeRTOS task on core 0 of the ESP32
+ * (loop() runs on core 1), a std::thread on the host. The worker owns the
+ * chirpmakers of the voices, a PolyPlayer with one pin per voice and a
+ * Concert. The caller only posts commands into a wait-free SPSC queue,
+ * post() neither blocks nor takes a lock; when the queue is full the
+ * command is dropped and counted.
+ *
+ * While a voice or the concert plays, the worker wakes every ms, executes
+ * the queued commands and tops up the edge queues of the voices, the edges
+ * themselves are played by the timer. On the ESP32 an idle worker sleeps
+ * until post() wakes it with a task notification, which it only sends to
+ * a sleeping worker. A stop takes effect after the edges already queued,
+ * a few ms at most.
+ *   AudioWorker<Chirpmaker> audio;
+ *   audio.begin(voices, pins, 2);
+ *   audio.bird(0, 11);           // the cuckoo on voice 0, returns at once
+ */
+template <class Cm>
+class AudioWorker
+{
+  public:
+    static const uint16_t QUEUE_SIZE = 16;     // commands, must be a power of 2
+    static const uint32_t STACK_BYTES = 8192;  // of the FreeRTOS task
+
+    bool begin(Cm *const *voices, const uint8_t *pins, uint8_t nVoices, uint8_t timerNbr = 0);
+    void end();
+
+    bool post(const AudioCommand &cmd);
+    bool bird(uint8_t voice, uint16_t birdNbr, uint32_t msPause = 20);
+    bool chirp(uint8_t voice, uint16_t fStart, uint16_t fStop, uint16_t nSteps, uint16_t nPeriods, uint16_t nChirps, uint8_t gen, uint8_t duty, uint32_t msPause);
+    bool stop();
+    bool concert(uint16_t birdsPerMinute, uint8_t maxOverlap);
+
+    uint16_t depth() const { return _queue.size(); }
+    uint16_t maxDepth() const { return _maxDepth.load(std::memory_order_relaxed); }
+    uint32_t posted() const { return _posted.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    uint32_t executed() const { return _executed.load(std::memory_order_acquire); }
+    bool isBusy() const { return _busy.load(std::memory_order_acquire); }
+    const Concert<Cm> &concertState() const { return _concert; }
+
+  private:
+    static void _task(void *self);
+    void _run();
+    void _service();
+    void _execute(const AudioCommand &cmd);
+
+    Cm *const *_voices = nullptr;
+    uint8_t _nVoices = 0;
+    PolyPlayer _poly;
+    Concert<Cm> _concert;
+    bool _concertOn = false;
+    SpscQueue<AudioCommand, QUEUE_SIZE> _queue;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _done{true};
+    std::atomic<bool> _busy{false};
+    std::atomic<uint16_t> _maxDepth{0};
+    std::atomic<uint32_t> _posted{0};    // written by the caller only
+    std::atomic<uint32_t> _dropped{0};   // written by the caller only
+    std::atomic<uint32_t> _executed{0};  // written by the worker only
+#ifdef ARDUINO
+    std::atomic<bool> _sleeping{false};  // the worker waits for a notification
+    TaskHandle_t _handle = nullptr;
+#else
+    std::thread _thread;
+#endif
+};
+
+/**
+ * Set up the voices, voice v plays voices[v] on pins[v], and start the worker
+ * timerNbr   hardware timer 0..3 of the PolyPlayer
+ */
+template <class Cm>
+bool AudioWorker<Cm>::begin(Cm *const *voices, const uint8_t *pins, uint8_t nVoices, uint8_t timerNbr)
+{
+  if (_running) return false;
+  _voices = voices;
+  _nVoices = nVoices < PolyPlayer::MAX_VOICES ? nVoices : PolyPlayer::MAX_VOICES;
+  _poly.begin(timerNbr);
+  for (uint8_t v = 0; v < _nVoices; v++) _poly.addVoice(pins[v]);
+  _concertOn = false;
+  _running = true;
+  _done = false;
+#ifdef ARDUINO
+  if (xTaskCreatePinnedToCore(&AudioWorker::_task, "audio", STACK_BYTES, this, 2, &_handle, 0) == pdPASS) return true;
+  _running = false;
+  _done = true;
+  return false;
+#else
+  _thread = std::thread(&AudioWorker::_task, this);
+  return true;
+#endif
+}
+
+// Stop the worker, the queued edges are played first
+template <class Cm>
+void AudioWorker<Cm>::end()
+{
+  if (! _running) return;
+  _running = false;
+#ifdef ARDUINO
+  if (_sleeping) xTaskNotifyGive(_handle);
+  while (! _done) delay(1);
+#else
+  _thread.join();
+#endif
+  _poly.end();
+}
+
+/**
+ * Queue a command for the worker. Returns false and counts it as dropped
+ * if the queue is full.
+ */
+template <class Cm>
+bool AudioWorker<Cm>::post(const AudioCommand &cmd)
+{
+  if (! _queue.push(cmd))
+  {
+    _dropped.store(_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+  }
+  _posted.store(_posted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#ifdef ARDUINO
+  if (_sleeping) xTaskNotifyGive(_handle);
+#endif
+  return true;
+}
+
+template <class Cm>
+bool AudioWorker<Cm>::bird(uint8_t voice, uint16_t birdNbr, uint32_t msPause)
+{
+  AudioCommand cmd = {};
+  cmd.op = AudioCommand::BIRD;
+  cmd.voice = voice;
+  cmd.bird = birdNbr;
+  cmd.msPause = msPause;
+  return post(cmd);
+}
+
+template <class Cm>
+bool AudioWorker<Cm>::chirp(uint8_t voice, uint16_t fStart, uint16_t fStop, uint16_t nSteps, uint16_t nPeriods, uint16_t nChirps, uint8_t gen, uint8_t duty, uint32_t msPause)
+{
+  AudioCommand cmd = {};
+  cmd.op = AudioCommand::CHIRP;
+  cmd.voice = voice;
+  cmd.fStart = fStart;
+  cmd.fStop = fStop;
+  cmd.nSteps = nSteps;
+  cmd.nPeriods = nPeriods;
+  cmd.nChirps = nChirps;
+  cmd.gen = gen;
+  cmd.duty = duty;
+  cmd.msPause = msPause;
+  return post(cmd);
+}
+
+template <class Cm>
+bool AudioWorker<Cm>::stop()
+{
+  AudioCommand cmd = {};
+  cmd.op = AudioCommand::STOP;
+  return post(cmd);
+}
+
+template <class Cm>
+bool AudioWorker<Cm>::concert(uint16_t birdsPerMinute, uint8_t maxOverlap)
+{
+  AudioCommand cmd = {};
+  cmd.op = AudioCommand::CONCERT;
+  cmd.birdsPerMinute = birdsPerMinute;
+  cmd.maxOverlap = maxOverlap;
+  return post(cmd);
+}
+
+template <class Cm>
+void AudioWorker<Cm>::_task(void *self)
+{
+  static_cast<AudioWorker *>(self)->_run();
+#ifdef ARDUINO
+  vTaskDelete(nullptr);
+#endif
+}
+
+template <class Cm>
+void AudioWorker<Cm>::_run()
+{
+  while (_running)
+  {
+    _service();
+#ifdef ARDUINO
+    if (! _busy.load(std::memory_order_relaxed))
+    {
+      // Sleep until post() or end() notify; they see the flag, or the check here sees their change
+      _sleeping = true;
+      if (_queue.size() == 0 && _running) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      _sleeping = false;
+      continue;
+    }
+#endif
+    delay(1);
+  }
+  while (! _poly.isIdle()) delay(1);
+  _busy = false;
+  _done = true;
+}
+
+/**
+ * One round of the worker: execute the queued commands, then feed the voices
+ */
+template <class Cm>
+void AudioWorker<Cm>::_service()
+{
+  uint16_t depth = _queue.size();
+  if (depth > _maxDepth.load(std::memory_order_relaxed)) _maxDepth.store(depth, std::memory_order_relaxed);
+  AudioCommand cmd;
+  uint32_t executed = _executed.load(std::memory_order_relaxed);
+  while (_queue.pop(cmd))
+  {
+    _execute(cmd);
+    executed++;
+  }
+
+  if (_concertOn) _concert.play(_poly, millis());
+  else for (uint8_t v = 0; v < _nVoices; v++) _poly.feed(v, *_voices[v]);
+
+  bool busy = _concertOn || ! _poly.isIdle();
+  for (uint8_t v = 0; v < _nVoices && ! busy; v++) busy = _voices[v]->isBusy();
+  _busy.store(busy, std::memory_order_release);
+  _executed.store(executed, std::memory_order_release);  // after _busy, so a caller that sees its command done sees the sound
+}
+
+template <class Cm>
+void AudioWorker<Cm>::_execute(const AudioCommand &cmd)
+{
+  switch (cmd.op)
+  {
+    case AudioCommand::BIRD:
+      if (cmd.voice < _nVoices) _voices[cmd.voice]->startBird(cmd.bird, cmd.msPause);
+      break;
+    case AudioCommand::CHIRP:
+      if (cmd.voice < _nVoices)
+      {
+        // The parameters as a song of one chirp, recorded at once by startSong()
+        const uint8_t song[] =
+        {
+          S_PUSH16(cmd.fStart), S_PUSH16(cmd.fStop), S_PUSH16(cmd.nSteps), S_PUSH16(cmd.nPeriods), S_PUSH16(cmd.nChirps),
+          S_PUSH8(cmd.duty), S_PUSH16(cmd.msPause < UINT16_MAX ? cmd.msPause : UINT16_MAX), SONG_CHIRP, cmd.gen, S_END
+        };
+        _voices[cmd.voice]->startSong(song, 0);
+      }
+      break;
+    case AudioCommand::STOP:
+      _concertOn = false;
+      for (uint8_t v = 0; v < _nVoices; v++)
+      {
+        _voices[v]->stop();
+        _poly.push(v, LOW, 1);  // the queued edges may end HIGH, a buzzer must not stay on
+      }
+      break;
+    case AudioCommand::CONCERT:
+    {
+      _concertOn = cmd.birdsPerMinute > 0;
+      if (! _concertOn) break;
+      typename Concert<Cm>::Plan plan;
+      plan.birdsPerMinute = cmd.birdsPerMinute;
+      plan.maxOverlap = cmd.maxOverlap;
+      plan.seed = random(1, INT32_MAX);
+      _concert.begin(_voices, _nVoices, plan, millis());
+      break;
+    }
+  }
+}
+#endif
@@ -0,0 +1,124 @@
+#ifndef _BIRDREGISTRY_H_
+#define _BIRDREGISTRY_H_
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Description of a bird: its name, the function that sings it and some
+ * metadata. Bird is the member function pointer type of the chirpmaker.
+ * msTypical  typical duration of its song in ms, without the pause of birdVoice()
+ * weight     relative frequency in a concert, 0: never chosen by a concert
+ */
+template <class Bird>
+struct BirdInfo
+{
+  const char *name;
+  Bird sing;
+  uint16_t msTypical;
+  uint8_t weight;
+};
+
+// FNV-1a of a name, also at compile time
+constexpr uint32_t birdHash(const char *name)
+{
+  uint32_t h = 2166136261u;
+  for (; *name; name++) h = (h ^ (uint8_t)*name) * 16777619u;
+  return h;
+}
+
+constexpr bool sameBirdName(const char *a, const char *b)
+{
+  for (; *a && *a == *b; a++, b++) {}
+  return *a == *b;
+}
+
+/**
+ * View of a bird registry, the same type whatever the number of birds.
+ * The names are found through an open addressing hash table with at
+ * least twice as many slots as birds, a lookup compares one or two names.
+ */
+template <class Bird>
+class BirdTable
+{
+  public:
+    constexpr BirdTable(const BirdInfo<Bird> *birds, const uint16_t *slots, const uint32_t *cumWeights, uint16_t nBirds, uint16_t nSlots)
+      : _birds(birds), _slots(slots), _cumWeights(cumWeights), _nBirds(nBirds), _nSlots(nSlots) {}
+
+    uint16_t size() const { return _nBirds; }
+    const BirdInfo<Bird> &operator[](uint16_t i) const { return _birds[i]; }
+    const BirdInfo<Bird> *begin() const { return _birds; }
+    const BirdInfo<Bird> *end() const { return _birds + _nBirds; }
+    uint32_t totalWeight() const { return _nBirds ? _cumWeights[_nBirds - 1] : 0; }
+
+    // Index of the bird called name, -1 if there is none
+    int indexOf(const char *name) const
+    {
+      for (uint16_t s = birdHash(name) & (_nSlots - 1); _slots[s]; s = (s + 1) & (_nSlots - 1))
+      {
+        if (sameBirdName(_birds[_slots[s] - 1].name, name)) return _slots[s] - 1;
+      }
+      return -1;
+    }
+
+    // The bird for a number 0 .. totalWeight() - 1, e.g. random(totalWeight())
+    uint16_t byWeight(uint32_t w) const
+    {
+      uint16_t lo = 0, hi = _nBirds - 1;
+      while (lo < hi)
+      {
+        uint16_t mid = (lo + hi) / 2;
+        if (_cumWeights[mid] > w) hi = mid;
+        else lo = mid + 1;
+      }
+      return lo;
+    }
+
+  private:
+    const BirdInfo<Bird> *_birds;
+    const uint16_t *_slots;
+    const uint32_t *_cumWeights;
+    uint16_t _nBirds;
+    uint16_t _nSlots;
+};
+
+/**
+ * The birds of a chirpmaker with their name index, built by the compiler:
+ *   static constexpr auto REGISTRY = makeBirdRegistry<Bird>({{"cuckoo", &Cm::_cuckoo, 2100, 1}, ...});
+ * As a constexpr it is placed in flash and shared by all instances.
+ */
+template <class Bird, size_t N>
+struct BirdRegistry
+{
+  static constexpr size_t SLOTS = [] { size_t s = 1; while (s < 2 * N) s *= 2; return s; }();
+
+  BirdInfo<Bird> birds[N];
+  uint16_t slots[SLOTS];  // index + 1 of a bird, 0: free
+  uint32_t cumWeights[N];
+
+  constexpr bool hasDuplicates() const
+  {
+    for (size_t i = 0; i < N; i++) for (size_t j = i + 1; j < N; j++) if (sameBirdName(birds[i].name, birds[j].name)) return true;
+    return false;
+  }
+
+  constexpr BirdTable<Bird> table() const { return BirdTable<Bird>(birds, slots, cumWeights, N, SLOTS); }
+};
+
+template <class Bird, size_t N>
+constexpr BirdRegistry<Bird, N> makeBirdRegistry(const BirdInfo<Bird> (&birds)[N])
+{
+  static_assert(N > 0 && N < UINT16_MAX / 2, "a registry holds 1 .. 32766 birds");
+  BirdRegistry<Bird, N> r = {};
+  uint32_t weight = 0;
+  for (size_t i = 0; i < N; i++)
+  {
+    r.birds[i] = birds[i];
+    size_t s = birdHash(birds[i].name) & (r.SLOTS - 1);
+    while (r.slots[s]) s = (s + 1) & (r.SLOTS - 1);
+    r.slots[s] = i + 1;
+    weight += birds[i].weight;
+    r.cumWeights[i] = weight;
+  }
+  return r;
+}
+#endif
@@ -0,0 +1,139 @@
+#ifndef _BIRDSONGS_H_
+#define _BIRDSONGS_H_
+#include "SongCode.h"
+
+/**
+ * The birds of Chirpmaker as bytecode (see SongCode.h), in the order of
+ * the bird registry. Each song does what the member function of the bird
+ * does, the random parameters drawn from left to right.
+ */
+inline constexpr uint8_t SONG_BIRD0_CODE[] =
+{
+  S_RANDOM16(1200, 1900), S_RANDOM16(4300, 4500), S_RANDOM8(10, 27), S_RANDOM8(1, 5), S_PUSH8(5), S_PUSH8(50), S_RANDOM8(59, 199), S_CHIRP(GEN_CHROMATIC),
+  S_RANDOM16(2000, 2050), S_RANDOM16(3200, 3400), S_RANDOM8(5, 30), S_RANDOM8(2, 15), S_RANDOM8(4, 10), S_PUSH8(50), S_PUSH8(20), S_CHIRP(GEN_ATAN_PI),
+  S_PUSH16(1500), S_PUSH16(4500), S_RANDOM8(50, 100), S_RANDOM8(1, 13), S_RANDOM8(1, 5), S_PUSH8(50), S_PUSH8(100), S_CHIRP(GEN_SINE_2PI),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD1_CODE[] =
+{
+  S_RANDOM16(4200, 4400), S_RANDOM16(2800, 2500), S_PUSH8(100), S_RANDOM8(1, 3), S_RANDOM8(3, 9), S_PUSH8(50), S_RANDOM8(25, 75), S_CHIRP(GEN_CHROMATIC),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD2_CODE[] =
+{
+  S_RANDOM16(3500, 3900), S_RANDOM16(5600, 5900), S_RANDOM8(3, 7), S_RANDOM8(5, 10), S_PUSH8(1), S_PUSH8(50), S_RANDOM8(50, 100), S_CHIRP(GEN_SINE_2PI),
+  S_RANDOM16(5600, 5900), S_RANDOM16(3500, 3900), S_RANDOM8(6, 15), S_RANDOM8(3, 7), S_PUSH8(1), S_PUSH8(50), S_RANDOM8(50, 100), S_CHIRP(GEN_COSINE_2PI),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD3_CODE[] =
+{
+  S_RANDOM16(1280, 1300), S_RANDOM16(1310, 1620), S_PUSH8(10), S_RANDOM8(4, 8), S_RANDOM8(2, 9), S_PUSH8(50), S_RANDOM8(100, 200), S_CHIRP(GEN_LINEAR),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD4_CODE[] =
+{
+  S_RANDOM8(10, 15), S_TABLE(SONG_BIRD4_A),
+  S_PUSH8(1), S_TABLE(SONG_BIRD4_B),
+  S_PUSH8(1), S_TABLE(SONG_BIRD4_C),
+  S_RANDOM8(75, 150), S_PAUSE,
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD5_CODE[] =
+{
+  S_RANDOM16(4404, 4484), S_RANDOM16(4380, 4420), S_PUSH8(20), S_RANDOM8(1, 4), S_RANDOM8(1, 7), S_PUSH8(50), S_PUSH8(250), S_CHIRP(GEN_LINEAR),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD6_CODE[] =
+{
+  S_RANDOM16(1000, 1050), S_RANDOM16(900, 1200), S_PUSH8(20), S_RANDOM8(1, 5), S_RANDOM8(10, 15), S_PUSH8(50), S_RANDOM8(150, 250), S_CHIRP(GEN_CHROMATIC),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD7_CODE[] =
+{
+  S_PUSH16(2600), S_PUSH16(4400), S_PUSH8(10), S_PUSH8(1), S_RANDOM8(5, 9), S_PUSH8(50), S_RANDOM8(20, 150), S_CHIRP(GEN_CHROMATIC),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD8_CODE[] =
+{
+  S_PUSH8(5), S_TABLE(SONG_BIRD8),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD9_CODE[] =
+{
+  S_RANDOM16(3500, 3540), S_RANDOM8(6, 12), S_PUSH8(5), S_PUSH8(50), S_RANDOM8(3, 15), S_PUSH8(0), S_PHASER,
+  S_RANDOM16(1660, 1800), S_RANDOM8(3, 10), S_PUSH8(5), S_PUSH8(30), S_RANDOM8(6, 13), S_RANDOM16(100, 300), S_PHASER,
+  S_END
+};
+
+inline constexpr uint8_t SONG_BIRD10_CODE[] =
+{
+  S_RANDOM8(1, 9), S_TABLE(SONG_BIRD10_UP),
+  S_RANDOM8(1, 9), S_TABLE(SONG_BIRD10_DOWN),
+  S_END
+};
+
+inline constexpr uint8_t SONG_CUCKOO_CODE[] =
+{
+  S_PUSH8(4), S_REPEAT,
+    S_PUSH8(1), S_TABLE(SONG_CUCKOO_CUC),
+    S_PUSH8(1), S_TABLE(SONG_CUCKOO_KOO),
+  S_LOOP,
+  S_PUSH16(300), S_PAUSE,
+  S_END
+};
+
+inline constexpr uint8_t SONG_RAVEN_CODE[] =
+{
+  S_RANDOM8(2, 6), S_TABLE(SONG_RAVEN),
+  S_END
+};
+
+inline constexpr uint8_t SONG_CHAFFINCH_CODE[] =
+{
+  S_PUSH16(4000), S_PUSH16(5000), S_PUSH8(10), S_RANDOM8(15, 30), S_RANDOM8(1, 9), S_PUSH8(50), S_RANDOM8(10, 100), S_CHIRP(GEN_CHROMATIC),
+  S_PUSH16(5000), S_PUSH16(4000), S_PUSH8(10), S_RANDOM8(15, 50), S_RANDOM8(1, 9), S_PUSH8(15), S_RANDOM8(10, 30), S_CHIRP(GEN_CHROMATIC),
+  S_END
+};
+
+inline constexpr uint8_t SONG_BLACKBIRD_CODE[] =
+{
+  S_PUSH16(900), S_PUSH16(2000), S_RANDOM8(10, 50), S_PUSH8(13), S_RANDOM8(1, 4), S_PUSH8(50), S_PUSH8(80), S_CHIRP(GEN_ATAN_PI),
+  S_PUSH16(2400), S_PUSH16(1000), S_RANDOM8(15, 65), S_PUSH8(8), S_RANDOM8(1, 3), S_PUSH8(50), S_PUSH8(80), S_CHIRP(GEN_SINE_2PI),
+  S_RANDOM16(3000, 2000), S_RANDOM16(1500, 1200), S_RANDOM8(75, 120), S_RANDOM8(2, 9), S_RANDOM8(1, 4), S_PUSH8(50), S_PUSH8(80), S_CHIRP(GEN_COSINE_2PI),
+  S_END
+};
+
+struct BirdSong
+{
+  const uint8_t *code;
+  uint16_t bytes;
+};
+
+inline constexpr BirdSong BIRD_SONGS[] =
+{
+  {SONG_BIRD0_CODE,     sizeof(SONG_BIRD0_CODE)},
+  {SONG_BIRD1_CODE,     sizeof(SONG_BIRD1_CODE)},
+  {SONG_BIRD2_CODE,     sizeof(SONG_BIRD2_CODE)},
+  {SONG_BIRD3_CODE,     sizeof(SONG_BIRD3_CODE)},
+  {SONG_BIRD4_CODE,     sizeof(SONG_BIRD4_CODE)},
+  {SONG_BIRD5_CODE,     sizeof(SONG_BIRD5_CODE)},
+  {SONG_BIRD6_CODE,     sizeof(SONG_BIRD6_CODE)},
+  {SONG_BIRD7_CODE,     sizeof(SONG_BIRD7_CODE)},
+  {SONG_BIRD8_CODE,     sizeof(SONG_BIRD8_CODE)},
+  {SONG_BIRD9_CODE,     sizeof(SONG_BIRD9_CODE)},
+  {SONG_BIRD10_CODE,    sizeof(SONG_BIRD10_CODE)},
+  {SONG_CUCKOO_CODE,    sizeof(SONG_CUCKOO_CODE)},
+  {SONG_RAVEN_CODE,     sizeof(SONG_RAVEN_CODE)},
+  {SONG_CHAFFINCH_CODE, sizeof(SONG_CHAFFINCH_CODE)},
+  {SONG_BLACKBIRD_CODE, sizeof(SONG_BLACKBIRD_CODE)},
+};
+#endif
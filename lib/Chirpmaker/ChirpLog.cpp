@@ -0,0 +1,102 @@
+#include "ChirpLog.h"
+
+static_assert((ChirpLog::EVENTS & (ChirpLog::EVENTS - 1)) == 0, "CHIRPMAKER_LOG_EVENTS must be a power of 2");
+
+// The log of the library and the sketch
+ChirpLog &chirpLog()
+{
+  static ChirpLog log;
+  return log;
+}
+
+/**
+ * Reserve the next event by counting up the head, claim its slot, fill it
+ * in and mark it complete with its sequence number. A slot is claimed with
+ * a CAS on its busy flag: when the ring has gone round and another producer
+ * is still writing the same slot, this event is dropped and marked skipped,
+ * flush() counts it as lost. The payload is written with relaxed atomics,
+ * so flush() may copy it at any time and rejects what changed meanwhile.
+ * Constant time, wait-free.
+ */
+void ChirpLog::_record(const LogSite *site, const int32_t *args)
+{
+  uint32_t seq = _head.fetch_add(1, std::memory_order_relaxed);
+  Event &e = _events[seq & (EVENTS - 1)];
+  bool idle = false;
+  if (! e.busy.compare_exchange_strong(idle, true, std::memory_order_acquire))
+  {
+    e.skipped.store(seq + 1, std::memory_order_release);
+    return;
+  }
+  if ((int32_t)(e.seq.load(std::memory_order_relaxed) - (seq + 1)) > 0)
+  {
+    // Held up for a whole lap, a newer event is in the slot already
+    e.busy.store(false, std::memory_order_release);
+    e.skipped.store(seq + 1, std::memory_order_release);
+    return;
+  }
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.site.store(site, std::memory_order_relaxed);
+  e.us.store(micros(), std::memory_order_relaxed);
+  for (uint8_t i = 0; i < MAX_ARGS; i++) e.args[i].store(args[i], std::memory_order_relaxed);
+  e.seq.store(seq + 1, std::memory_order_release);
+  e.busy.store(false, std::memory_order_release);
+}
+
+// Events recorded and not yet flushed, lost ones included
+uint16_t ChirpLog::pending() const
+{
+  uint32_t n = _head.load(std::memory_order_acquire) - _tail;
+  return n < EVENTS ? n : EVENTS;
+}
+
+/**
+ * Format and write at most maxEvents events, one line each:
+ *   [   12.345678] I Bird  3 is singing
+ * Takes the time of printf() and of the serial port, call it only where
+ * nothing is played. One task at a time. Returns the events written.
+ */
+uint16_t ChirpLog::flush(uint16_t maxEvents)
+{
+  static const char LEVELS[] = "-EWID";
+  uint16_t written = 0;
+  while (written < maxEvents)
+  {
+    uint32_t head = _head.load(std::memory_order_acquire);
+    if (_tail == head) break;
+    if (head - _tail > EVENTS)
+    {
+      _lost += head - _tail - EVENTS;   // overwritten before they were flushed
+      _tail = head - EVENTS;
+    }
+
+    Event &e = _events[_tail & (EVENTS - 1)];
+    if (e.seq.load(std::memory_order_acquire) != _tail + 1)
+    {
+      if ((int32_t)(_head.load(std::memory_order_acquire) - _tail) > (int32_t)EVENTS) continue;  // overwritten meanwhile
+      if (e.skipped.load(std::memory_order_acquire) == _tail + 1)
+      {
+        _lost++;   // dropped by its producer, the slot was busy
+        _tail++;
+        continue;
+      }
+      break;  // still being written
+    }
+    const LogSite *site = e.site.load(std::memory_order_relaxed);
+    uint32_t us = e.us.load(std::memory_order_relaxed);
+    int32_t a[MAX_ARGS];
+    for (uint8_t i = 0; i < MAX_ARGS; i++) a[i] = e.args[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (e.seq.load(std::memory_order_relaxed) != _tail + 1) continue;  // overwritten while copied
+    _tail++;
+
+    char line[128];
+    int n = snprintf(line, sizeof(line), "[%5u.%06u] %c ", us / 1000000, us % 1000000, LEVELS[site->level < 5 ? site->level : 0]);
+    snprintf(line + n, sizeof(line) - n, site->format, a[0], a[1], a[2], a[3]);
+    if (_writer) _writer(line);
+    else printf("%s\n", line);
+    written++;
+  }
+  return written;
+}
@@ -0,0 +1,105 @@
+#ifndef _CHIRPLOG_H_
+#define _CHIRPLOG_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+#include <atomic>
+#include <type_traits>
+
+/**
+ * Deferred logging for the playback path. A log site records a binary
+ * event, its site (level and format string, both constant) and up to four
+ * integer arguments, into a ring buffer: some 25 ns and no formatting, no
+ * serial output and no lock, also from several tasks at once. flush()
+ * formats the events later, where a delay cannot be heard.
+ *
+ *   CHIRP_LOG_I("Bird %2d is singing", b);
+ *   ...
+ *   chirpLog().flush();     // in a pause
+ *
+ * Sites above CHIRPMAKER_LOG_LEVEL are removed by the compiler, their
+ * arguments are not even evaluated. When the ring is full, the oldest
+ * events are overwritten and counted as lost, as is an event whose slot
+ * another task is still writing a lap earlier.
+ */
+#define CHIRP_LOG_NONE  0
+#define CHIRP_LOG_ERROR 1
+#define CHIRP_LOG_WARN  2
+#define CHIRP_LOG_INFO  3
+#define CHIRP_LOG_DEBUG 4
+
+#ifndef CHIRPMAKER_LOG_LEVEL
+#define CHIRPMAKER_LOG_LEVEL CHIRP_LOG_INFO
+#endif
+
+#ifndef CHIRPMAKER_LOG_EVENTS
+#define CHIRPMAKER_LOG_EVENTS 256
+#endif
+
+struct LogSite
+{
+  uint8_t level;
+  const char *format;   // printf format of at most 4 int arguments, without newline
+};
+
+class ChirpLog
+{
+  public:
+    static const uint16_t EVENTS = CHIRPMAKER_LOG_EVENTS;  // must be a power of 2
+    static const uint8_t MAX_ARGS = 4;
+    using Writer = void (*)(const char *line);
+
+    template <class... Args>
+    void record(const LogSite *site, Args... args)
+    {
+      static_assert(sizeof...(Args) <= MAX_ARGS, "a log event takes at most 4 arguments");
+      static_assert((std::is_integral<Args>::value && ...), "log arguments are integers, format floats in the idle path");
+      int32_t values[MAX_ARGS] = {(int32_t)args...};
+      _record(site, values);
+    }
+
+    uint16_t flush(uint16_t maxEvents = EVENTS);
+    void setWriter(Writer writer) { _writer = writer; }
+    uint32_t recorded() const { return _head.load(std::memory_order_relaxed); }
+    uint32_t lost() const { return _lost; }
+    uint16_t pending() const;
+
+  private:
+    struct Event
+    {
+      std::atomic<uint32_t> seq{0};       // number of the event + 1 once it is complete
+      std::atomic<uint32_t> skipped{0};   // number + 1 of an event dropped here, the slot was busy
+      std::atomic<bool> busy{false};      // claimed by a producer
+      std::atomic<const LogSite *> site{nullptr};
+      std::atomic<uint32_t> us{0};
+      std::atomic<int32_t> args[MAX_ARGS] = {};
+    };
+
+    void _record(const LogSite *site, const int32_t *args);
+
+    Event _events[EVENTS];
+    std::atomic<uint32_t> _head{0};   // events reserved by the producers
+    uint32_t _tail = 0;               // next event to flush
+    uint32_t _lost = 0;
+    Writer _writer = nullptr;
+};
+
+ChirpLog &chirpLog();
+
+#define CHIRP_LOG(level, format, ...) \
+  do \
+  { \
+    if constexpr ((level) <= CHIRPMAKER_LOG_LEVEL) \
+    { \
+      static constexpr LogSite _chirpLogSite = {(level), (format)}; \
+      chirpLog().record(&_chirpLogSite, ##__VA_ARGS__); \
+    } \
+  } while (0)
+
+#define CHIRP_LOG_E(format, ...) CHIRP_LOG(CHIRP_LOG_ERROR, format, ##__VA_ARGS__)
+#define CHIRP_LOG_W(format, ...) CHIRP_LOG(CHIRP_LOG_WARN, format, ##__VA_ARGS__)
+#define CHIRP_LOG_I(format, ...) CHIRP_LOG(CHIRP_LOG_INFO, format, ##__VA_ARGS__)
+#define CHIRP_LOG_D(format, ...) CHIRP_LOG(CHIRP_LOG_DEBUG, format, ##__VA_ARGS__)
+#endif
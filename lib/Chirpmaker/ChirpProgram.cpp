@@ -0,0 +1,87 @@
+#include "ChirpProgram.h"
+
+/**
+ * Append count periods of tOn/tOff. Merges with the previous segment
+ * if it has the same timing. Returns false if the program is full.
+ * The last slot is kept free for the closing pause.
+ */
+bool ChirpProgram::add(uint32_t tOn, uint32_t tOff, uint16_t count)
+{
+  if (count == 0) return true;
+  if (_nSegments > 0)
+  {
+    Segment &last = _segments[_nSegments - 1];
+    if (! last.isPause() && last.tOn == tOn && last.tOff == tOff && last.count <= UINT16_MAX - count)
+    {
+      last.count += count;
+      return true;
+    }
+  }
+  if (_nSegments >= MAX_SEGMENTS - 1) return false;
+  _segments[_nSegments++] = {tOn, tOff, count};
+  return true;
+}
+
+/**
+ * Replace the content with a copy of a segment table, at most MAX_SEGMENTS
+ */
+void ChirpProgram::assign(const Segment *segments, uint16_t nSegments, uint16_t nRepeats)
+{
+  _nSegments = nSegments < MAX_SEGMENTS ? nSegments : MAX_SEGMENTS;
+  for (uint16_t i = 0; i < _nSegments; i++) _segments[i] = segments[i];
+  repeats = nRepeats;
+}
+
+/**
+ * Append a pause of msPause ms, nothing is added for a pause of 0 ms
+ */
+bool ChirpProgram::addPause(uint32_t msPause)
+{
+  if (msPause == 0) return true;
+  if (isFull()) return false;
+  _segments[_nSegments++] = {0, msPause, 0};
+  return true;
+}
+
+/**
+ * Total duration of one pass through the segment list in us
+ */
+uint32_t ChirpProgram::durationUs() const
+{
+  uint32_t us = 0;
+  for (const Segment &s : *this) us += s.isPause() ? s.tOff * 1000 : (s.tOn + s.tOff) * s.count;
+  return us;
+}
+
+// The free function generators, see FreqFn and FreqFnSinc
+int ChirpProgram::compileChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause, int firstStep)
+{
+  return compileChirp(fStart, fStop, nSteps, nPeriods, nChirps, FreqFn{&fgen}, duty, msPause, firstStep);
+}
+
+// A sinc chirp is played once, nPi takes the place of nChirps
+int ChirpProgram::compileChirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause, int firstStep)
+{
+  return compileChirp(fStart, fStop, nSteps, nPeriods, 1, FreqFnSinc{&fgen, nPi}, duty, msPause, firstStep);
+}
+
+/**
+ * Compile a phaser (see Chirpmaker::phaser), one segment per duty cycle.
+ * Like compileChirp() it returns the first step, dutyStart + step being the
+ * duty cycle, that did not fit, or dutyEnd - dutyStart + 1 when it is
+ * complete; only then it is played nChirps times.
+ */
+int ChirpProgram::compilePhaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause, int firstStep)
+{
+  clear();
+  uint32_t p = 1000000/freq;
+  for (int d = dutyStart + firstStep; d <= dutyEnd; d++)
+  {
+      uint32_t tOn  = p * d / 100;
+      uint32_t tOff = p - tOn;
+      if (! add(tOn, tOff, toCount(nPeriods))) return d - dutyStart;
+  }
+  addPause(msPause);
+  if (firstStep == 0) repeats = toCount(nChirps);
+  return dutyEnd - dutyStart + 1;
+}
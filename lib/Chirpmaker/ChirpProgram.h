@@ -0,0 +1,117 @@
+#ifndef _CHIRPPROGRAM_H_
+#define _CHIRPPROGRAM_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+#include "FreqGen.h"
+
+#ifndef CHIRPMAKER_SEGMENTS
+#define CHIRPMAKER_SEGMENTS 64
+#endif
+
+/**
+ * count periods of a square wave with tOn us high and tOff us low.
+ * A segment with count 0 is a pause record: the buzzer is silent for tOff ms.
+ */
+struct Segment
+{
+  uint32_t tOn;
+  uint32_t tOff;
+  uint16_t count;
+
+  bool isPause() const { return count == 0; }
+};
+
+/**
+ * A chirp or phaser call compiled into a run-length encoded list of segments.
+ * Successive steps with the same period are merged into one segment, so
+ * playing the program is pure integer work. The segment list describes one
+ * chirp including its pause and is played repeats times.
+ * A program holds CHIRPMAKER_SEGMENTS segments (12 bytes each), every
+ * Chirpmaker has one. A call with more steps than that is compiled and
+ * played piece by piece.
+ */
+class ChirpProgram
+{
+  public:
+    static const uint16_t MAX_SEGMENTS = CHIRPMAKER_SEGMENTS;
+    static const uint8_t STEP_CHUNK = 32;  // frequencies generated per batch
+
+    template <class Gen>
+    int compileChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause, int firstStep = 0);
+    int compileChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause, int firstStep = 0);
+    int compileChirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause, int firstStep = 0);
+    int compilePhaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause, int firstStep = 0);
+
+    void clear() { _nSegments = 0; repeats = 1; }
+    void assign(const Segment *segments, uint16_t nSegments, uint16_t nRepeats);
+    bool add(uint32_t tOn, uint32_t tOff, uint16_t count);
+    bool addPause(uint32_t msPause);
+    bool isFull() const { return _nSegments >= MAX_SEGMENTS; }
+    uint16_t size() const { return _nSegments; }
+    const Segment &operator[](uint16_t i) const { return _segments[i]; }
+    const Segment *begin() const { return _segments; }
+    const Segment *end() const { return _segments + _nSegments; }
+    uint32_t durationUs() const;
+    static uint16_t toCount(int n) { return n <= 0 ? 0 : n > UINT16_MAX ? UINT16_MAX : n; }   // repeats or periods, nothing if negative
+
+    uint16_t repeats = 1;
+
+  private:
+    template <class Gen>
+    int _compileSteps(const Gen &gen, double fStart, double fStop, int nSteps, int nPeriods, int duty, uint32_t msPause, int firstStep);
+
+    Segment _segments[MAX_SEGMENTS];
+    uint16_t _nSegments = 0;
+};
+
+static_assert(ChirpProgram::MAX_SEGMENTS >= 2, "CHIRPMAKER_SEGMENTS has to hold a segment and a pause");
+
+/**
+ * Compile a chirp (see Chirpmaker::chirp) into the program, replacing its
+ * content. gen is a generator object (see FreqGen.h), it inlines into the
+ * step loop. Returns nSteps + 1 if the whole chirp fits, otherwise the first
+ * step that has to be compiled by a further call with firstStep set to it.
+ * Only a complete program is played nChirps times, none if nChirps <= 0.
+ */
+template <class Gen>
+int ChirpProgram::compileChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause, int firstStep)
+{
+  clear();
+  int next = _compileSteps(gen, fStart, fStop, nSteps, nPeriods, duty, msPause, firstStep);
+  if (firstStep == 0 && next > nSteps) repeats = toCount(nChirps);
+  return next;
+}
+
+/**
+ * Evaluate the generator for the steps firstStep .. nSteps and append them.
+ * The frequencies are generated STEP_CHUNK steps at a time, a batch
+ * generator thus runs its setup once per chunk.
+ * Returns the first step that did not fit into the program, nSteps + 1 if
+ * the chirp and its pause are complete.
+ */
+template <class Gen>
+int ChirpProgram::_compileSteps(const Gen &gen, double fStart, double fStop, int nSteps, int nPeriods, int duty, uint32_t msPause, int firstStep)
+{
+  double freqs[STEP_CHUNK];
+  int s = firstStep;
+  while (s <= nSteps)
+  {
+    int n = nSteps + 1 - s < STEP_CHUNK ? nSteps + 1 - s : STEP_CHUNK;
+    fillSteps(freqs, s, n, fStart, fStop, nSteps, gen);
+    for (int i = 0; i < n; i++, s++)
+    {
+      uint32_t tOn, tOff;
+      chirpPeriod(Real(freqs[i]), duty, tOn, tOff);
+      // log_i("%2d: f = %5.2f, ton = %d, toff = %d", s, freqs[i], tOn, tOff);
+      int k = nPeriods;
+      for (; k > UINT16_MAX; k -= UINT16_MAX) if (! add(tOn, tOff, UINT16_MAX)) return s;
+      if (k > 0 && ! add(tOn, tOff, k)) return s;
+    }
+  }
+  addPause(msPause);
+  return s;
+}
+#endif
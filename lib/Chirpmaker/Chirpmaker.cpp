@@ -1,4 +1,26 @@
 # include "Chirpmaker.h"
+#include "ConstSounds.h"
+#include "CurveCache.h"
+
+/**
+ * Keep the buzzer silent for msPause ms. With a timer or recorder sink
+ * the pause is queued like any other edge so it stays in step with the sound.
+ * While a bird is recorded for non-blocking playback it becomes a call.
+ */
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_pause(uint32_t msPause)
+{
+  if (_recording)
+  {
+    Call c;
+    c.kind = Call::PAUSE;
+    c.msPause = msPause;
+    _record(c);
+    return;
+  }
+  uint32_t ms = _sink.pause(msPause);
+  if (ms) Clock::delayMs(ms);
+}
 
 /**
  * Simulate the chirp of a bird. Start with fStart and reach fStop in n steps.
@@ -14,47 +36,17 @@
  * duty      duty cycle (1..99 %) of a period 
  * msPause   ms Pause between chirps
  */
-void Chirpmaker::chirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::chirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause)
 {
-    auto buz = [](uint8_t pin, uint32_t usTon, uint32_t usToff){
-      digitalWrite(pin, HIGH);
-      delayMicroseconds(usTon);
-      digitalWrite(pin, LOW);
-      delayMicroseconds(usToff);};
-
-  for (int n = 0; n < nChirps; n++) // output nChirps
-  {
-    for (int s = 0; s <= nSteps; s++)
-    {
-      double fNext = fgen(s, fStart, fStop, nSteps);
-      double p = 1000000.0 / fNext;
-      uint32_t tOn  = p * duty / 100.0;
-      uint32_t tOff = p - tOn;
-      // log_i("%2d: f = %5.2f, ton = %d, toff = %d", s, fNext, tOn, tOff);
-      for (int n = 0; n < nPeriods; n++) buz(_pinBuzzer, tOn, tOff);
-    }
-    delay(msPause);
-  }
+  chirp(fStart, fStop, nSteps, nPeriods, nChirps, FreqFn{&fgen}, duty, msPause);
 }
 
-void Chirpmaker::chirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause)
+// The sinc generators take nPi in place of nChirps and are played once
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::chirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause)
 {
-    auto buz = [](uint8_t pin, uint32_t usTon, uint32_t usToff){
-      digitalWrite(pin, HIGH);
-      delayMicroseconds(usTon);
-      digitalWrite(pin, LOW);
-      delayMicroseconds(usToff);};
-
-    for (int s = 0; s <= nSteps; s++)
-    {
-      double fNext = fgen(s, fStart, fStop, nSteps, nPi);
-      double p = 1000000.0 / fNext;
-      uint32_t tOn  = p * duty / 100.0;
-      uint32_t tOff = p - tOn;
-      // log_i("%2d: f = %5.2f, ton = %d, toff = %d", s, fNext, tOn, tOff);
-      for (int n = 0; n < nPeriods; n++) buz(_pinBuzzer, tOn, tOff);
-    }
-    delay(msPause);
+  chirp(fStart, fStop, nSteps, nPeriods, 1, FreqFnSinc{&fgen, nPi}, duty, msPause);
 }
 
 /**
@@ -68,246 +60,228 @@ void Chirpmaker::chirp(double fStart, double fStop, int nSteps, int nPeriods, in
  * nChirps      n chirps are generated
  * msPause      ms to wait after each chirp
  */
-void Chirpmaker::phaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::phaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause)
 {
-  uint32_t p = 1000000/freq;
-
-  auto buz = [](uint8_t pin, uint32_t usTon, uint32_t usToff){
-      digitalWrite(pin, HIGH);
-      delayMicroseconds(usTon);
-      digitalWrite(pin, LOW);
-      delayMicroseconds(usToff);};
-  for (int n = 0; n < nChirps; n++) // output nChirps
+  if (_recording)
   {
-    for (int d = dutyStart; d <= dutyEnd; d++)
-    {
-        uint32_t tOn  = p * d / 100;
-        uint32_t tOff = p - tOn;
-        for (int n = 0; n < nPeriods; n++) buz(_pinBuzzer, tOn, tOff);
-    } 
-    delay(msPause);
-  }    
-}
-
-
-void Chirpmaker::phoneCall(uint8_t nTimes)
-{
-  chirp(667, 557, 2, 20, nTimes, sinePiScale, 50, 20);
-}
-
-void Chirpmaker::signet()
-{
-  chirp(440, 1320, 6, 300, 1, cosine2PiScale, 50, 1000);
-  chirp(1320, 440, 6, 300, 1, cosine2PiScale, 50, 3000);
-}
-
-
-double linearScale(int stepNbr, double fStart, double fStop,int nSteps)
-{
-  double df = (fStop - fStart) / nSteps;
-  double fNext = fStart + stepNbr * df;
-  return fNext;
-}
-
-double chromaticScale(int stepNbr, double fStart, double fStop,int nSteps)
-{
-    // We calculate the multiplicator k to get fStop in nSteps
-    // fStop = fStart * k ^ nSteps
-    double k = log(fStop / fStart) / (double)nSteps;  
-    double fNext = fStart * exp(k * stepNbr);
-    return fNext;
-}
-
-double sinePiScale(int stepNbr, double fStart, double fStop,int nSteps)
-{
-  double fa = (fStop - fStart);  // max. frequency swing
-  const double k = PI / nSteps;
-  double fNext = fStart + fa * sin(k * stepNbr); // get next frequency
-  return fNext;
-}
-
-double sine2PiScale(int stepNbr, double fStart, double fStop,int nSteps)
-{
-  double fm = (fStart + fStop) / 2.0;  // arithmetic mean
-  double fa = (fStop - fStart) / 2.0;  // max. frequency swing around fm
-  const double k = TWO_PI / nSteps;
-  double fNext = fm + fa * sin(k * stepNbr); // get next frequency
-  return fNext;
-}
-
-double cosinePiScale(int stepNbr, double fStart, double fStop,int nSteps)
-{
-  double fm = (fStart + fStop) / 2.0;  // arithmetic mean
-  double fa = (fStop - fStart) / 2.0;  // max. frequency swing around fm
-  const double k = PI / nSteps;
-  double fNext = fm - fa * cos(k * stepNbr); // get next frequency
-  return fNext;
-}
-
-double cosine2PiScale(int stepNbr, double fStart, double fStop,int nSteps)
-{
-  double fm = (fStart + fStop) / 2.0;  // arithmetic mean
-  double fa = (fStop - fStart) / 2.0;  // max. frequency swing around fm
-  const double k = TWO_PI / nSteps;
-  double fNext = fm - fa * cos(k * stepNbr); // get next frequency
-  return fNext;
+    Call c;
+    c.kind = Call::PHASER;
+    c.duty = dutyStart;
+    c.dutyEnd = dutyEnd;
+    c.fStart = freq;
+    c.msPause = msPause;
+    c.nSteps = dutyEnd - dutyStart;
+    c.nPeriods = nPeriods;
+    c.nChirps = nChirps;
+    _record(c, Call::fits(nPeriods) && Call::fits(nChirps));
+    return;
+  }
+  int nSteps = dutyEnd - dutyStart;
+  if (_program.compilePhaser(freq, nPeriods, dutyStart, dutyEnd, nChirps, msPause) > nSteps)
+  {
+    play(_program);
+    return;
+  }
+  for (int n = 0; n < nChirps; n++) // more duty cycles than fit into one program, compile and play piece by piece
+  {
+    for (int s = 0; s <= nSteps; play(_program))
+      s = _program.compilePhaser(freq, nPeriods, dutyStart, dutyEnd, nChirps, msPause, s);
+  }
 }
 
-double atanPiScale(int stepNbr, double fStart, double fStop,int nSteps)
+/**
+ * Replay a compiled chirp or phaser. No floating point work is left,
+ * the segments are simply output program.repeats times.
+ */
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::play(const ChirpProgram &program)
 {
-  double k = (fStop - fStart)/atan(PI);
-  double fNext = fStart + k * atan(PI/nSteps * stepNbr);
-  return fNext;
+  _playSegments(program.begin(), program.size(), program.repeats);
 }
 
-double atan2PiScale(int stepNbr, double fStart, double fStop,int nSteps)
+/**
+ * Play a table of segments repeats times, typically a chirp compiled at
+ * compile time (see ConstSounds.h). The table has to stay in place while
+ * it is played, also when it was started non-blocking.
+ */
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::play(const Segment *segments, uint16_t nSegments, uint16_t repeats)
 {
-  double k = (fStop - fStart)/atan(TWO_PI);
-  double fNext = fStart + k * atan(TWO_PI/nSteps * stepNbr);
-  return fNext;
+  if (_recording)
+  {
+    Call c;
+    c.kind = Call::TABLE;
+    c.table = segments;
+    c.nSteps = nSegments;
+    c.nChirps = repeats;
+    _record(c, Call::fits(nSegments) && Call::fits(repeats));
+    return;
+  }
+  _playSegments(segments, nSegments, repeats);
 }
 
-double sincScaleNpi_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_playSegments(const Segment *segments, uint16_t nSegments, uint16_t repeats)
 {
-  double halfRange = nPi * PI;
-  double range = 2 * halfRange;
-
-  auto sinc = [](double x)
+  for (int n = 0; n < repeats; n++)
   {
-    return fabs(x) < 0.001 ? 1.0 : sin(x)/x;
-  };
-
-  double fa = (fStop - fStart);  // max. frequency swing
-  double k = range / nSteps;
-  double fNext = fStart + fa * sinc(k * stepNbr - halfRange); // get next frequency
-  //printf("%2d  %0.2f\n", stepNbr, fNext);
-  return fNext;
+    for (const Segment *seg = segments; seg < segments + nSegments; seg++)
+    {
+      if (seg->isPause()) _pause(seg->tOff);
+      else for (int i = 0; i < seg->count; i++) _buz(seg->tOn, seg->tOff);
+    }
+  }
 }
 
-double sincScaleNpi_0(int stepNbr, double fStart, double fStop,int nSteps, int nPi)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::phoneCall(uint8_t nTimes)
 {
-  double range = nPi * PI;
-
-  auto sinc = [](double x)
-  {
-    return fabs(x) < 0.001 ? 1.0 : sin(x)/x;
-  };
-
-  double fa = (fStop - fStart);  // max. frequency swing
-  double k = range / nSteps;
-  double fNext = fStart + fa * sinc(k * stepNbr - range); // get next frequency
-  //printf("%2d  %0.2f\n", stepNbr, fNext);
-  return fNext;
+  play(ConstSounds::PHONE_CALL, nTimes);
 }
 
-double sincScale0_Npi(int stepNbr, double fStart, double fStop, int nSteps, int nPi)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::signet()
 {
-  double range = nPi * PI;
-
-  auto sinc = [](double x)
-  {
-    return fabs(x) < 0.001 ? 1.0 : sin(x)/x;
-  };
-  double swap = fStart; fStart = fStop; fStop = swap;
-
-  double fa = (fStop - fStart);  // max. frequency swing
-  double k = range / nSteps;
-  double fNext = fStart + fa * sinc(k * stepNbr); // get next frequency
-  //printf("%2d  %0.2f\n", stepNbr, fNext);
-  return fNext;
+  play(ConstSounds::SIGNET_UP, 1);
+  play(ConstSounds::SIGNET_DOWN, 1);
 }
 
-void Chirpmaker::_bird0()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird0()
 {
     chirp(random(1200, 1900), random(4300, 4500), random(10, 27), random(1,5), 5, chromaticScale, 50, random(59, 199));
-    chirp(random(2000, 2050), random(3200, 3400), random(5, 30),  random(2,15), random(4, 10), atanPiScale, 50, 20 );
-    chirp(1500, 4500, random(50, 100), random(1, 13), random(1, 5), sine2PiScale, 50, 100);
+    chirp(random(2000, 2050), random(3200, 3400), random(5, 30),  random(2,15), random(4, 10), Cached<AtanPi>(), 50, 20 );
+    chirp(1500, 4500, random(50, 100), random(1, 13), random(1, 5), Cached<Sine2Pi>(), 50, 100);
 }
 
-void Chirpmaker::_bird1()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird1()
 {
     chirp(random(4200, 4400), random(2800, 2500), 100,  random(1,3), random(3, 9), chromaticScale, 50, random(25, 75));
 }
 
-void Chirpmaker::_bird2()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird2()
 {
-    chirp(random(3500,3900), random(5600,5900), random(3,7), random(5,10), 1, sine2PiScale, 50, random(50, 100));
-    chirp(random(5600,5900), random(3500,3900), random(6,15), random(3,7), 1, cosine2PiScale, 50, random(50, 100));
+    chirp(random(3500,3900), random(5600,5900), random(3,7), random(5,10), 1, Sine2Pi(), 50, random(50, 100));
+    chirp(random(5600,5900), random(3500,3900), random(6,15), random(3,7), 1, Cached<Cosine2Pi>(), 50, random(50, 100));
 };
 
-void Chirpmaker::_bird3()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird3()
 {
     chirp(random(1280,1300), random(1310,1620), 10, random(4,8), random(2,9), linearScale, 50, random(100, 200));
 }
 
-void Chirpmaker::_bird4()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird4()
 {
-    chirp(4000, 4800, 10, 4, random(10, 15), atan2PiScale, 50, 20);
-    chirp(3500, 4300, 15, 10, 1, atanPiScale, 50, 20);
-    chirp(3500, 3000, 25, 10, 1, sinePiScale, 50, random(75, 150));
+    play(ConstSounds::BIRD4_A, random(10, 15));
+    play(ConstSounds::BIRD4_B, 1);
+    play(ConstSounds::BIRD4_C, 1);
+    _pause(random(75, 150));
 };
 
- void Chirpmaker::_bird5()
+ template <class Sink, class Clock>
+ void BasicChirpmaker<Sink, Clock>::_bird5()
  {
    chirp(random(4404, 4484), random(4380,4420), 20, random(1,4), random(1,7), linearScale, 50, 250);
  }
 
- void Chirpmaker::_bird6()
+ template <class Sink, class Clock>
+ void BasicChirpmaker<Sink, Clock>::_bird6()
  {
-   Chirpmaker::chirp(random(1000, 1050), random(900, 1200), 20, random(1, 5), random(10, 15), chromaticScale, 50, random(150, 250));
+   chirp(random(1000, 1050), random(900, 1200), 20, random(1, 5), random(10, 15), chromaticScale, 50, random(150, 250));
  }
 
- void Chirpmaker::_bird7()
+ template <class Sink, class Clock>
+ void BasicChirpmaker<Sink, Clock>::_bird7()
  {
    chirp(2600, 4400, 10, 1, random(5,9), chromaticScale, 50, random(20, 150));
  }
 
-void Chirpmaker::_bird8()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird8()
 {
-    chirp(1320, 3880, 5, 10, 5, sine2PiScale, 50, 100);
+    play(ConstSounds::BIRD8, 5);
 }
 
-void Chirpmaker::_bird9()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird9()
 {
   phaser(random(3500,3540), random(6, 12), 5, 50, random(3,15), 0);
   phaser(random(1660,1800), random(3, 10), 5, 30, random(6,13), random(100,300));
 }
 
-void Chirpmaker::_bird10()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_bird10()
 {
-  chirp(1440, 1880, 20, 10, random(1,9), atanPiScale, 5, 10);
-  chirp(1880, 1440, 20, 10, random(1,9), atanPiScale, 50, 30);
+  play(ConstSounds::BIRD10_UP, random(1,9));
+  play(ConstSounds::BIRD10_DOWN, random(1,9));
 }
 
-void Chirpmaker::_cuckoo()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_cuckoo()
 {
-  const float third = 1.222;     // minorThird = 1.18 ... majorThird = 1.25
-  const float cuc = 667;         //  E4
-  const float koo = cuc / third; // ~C#4
+  // cuc E4, koo a third below (minorThird = 1.18 ... majorThird = 1.25), see ConstSounds.h
   for (int i = 1; i < 5; i++)
   {
-    chirp(cuc, cuc, 1, 46, 1, linearScale, 50, 200);
-    chirp(koo, koo, 1, 52, 1, linearScale, 50, 830);
+    play(ConstSounds::CUCKOO_CUC_TABLE, 1);
+    play(ConstSounds::CUCKOO_KOO_TABLE, 1);
   }
-  delay(300);
+  _pause(300);
 }
 
-void Chirpmaker::_raven()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_raven()
 {
-  chirp(75,65,8,4,random(2, 6), atanPiScale, 20, 550);
+  play(ConstSounds::RAVEN, random(2, 6));
 }
 
-void Chirpmaker::_chaffinch()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_chaffinch()
 {
   chirp(4000, 5000, 10, random(15,30), random(1,9), chromaticScale, 50, random(10,100));
   chirp(5000, 4000, 10, random(15,50), random(1,9), chromaticScale, 15, random(10,30));
 }
 
-void Chirpmaker::_blackbird()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_blackbird()
 {
-  chirp(900, 2000, random(10,50), 13, random(1,4), atanPiScale, 50, 80);
-  chirp(2400, 1000, random(15,65), 8, random(1,3), sine2PiScale, 50, 80);
-  chirp(random(3000,2000), random(1500,1200), random(75,120), random(2,9), random(1, 4), cosine2PiScale, 50, 80);
+  chirp(900, 2000, random(10,50), 13, random(1,4), Cached<AtanPi>(), 50, 80);
+  chirp(2400, 1000, random(15,65), 8, random(1,3), Cached<Sine2Pi>(), 50, 80);
+  chirp(random(3000,2000), random(1500,1200), random(75,120), random(2,9), random(1, 4), Cosine2Pi(), 50, 80);
+}
+
+/**
+ * All birds with their names, the typical length of their song and their
+ * weight in a concert. A new bird is a member function plus a line here.
+ * The registry is constexpr and lies in flash, once for all instances.
+ */
+template <class Sink, class Clock>
+BirdTable<typename BasicChirpmaker<Sink, Clock>::Bird> BasicChirpmaker<Sink, Clock>::birds()
+{
+  using Cm = BasicChirpmaker;
+  static constexpr auto REGISTRY = makeBirdRegistry<Bird>({
+    {"bird0",     &Cm::_bird0,       1890, 1},
+    {"bird1",     &Cm::_bird1,        514, 1},
+    {"bird2",     &Cm::_bird2,        167, 1},
+    {"bird3",     &Cm::_bird3,        972, 1},
+    {"bird4",     &Cm::_bird4,        607, 1},
+    {"bird5",     &Cm::_bird5,        869, 1},
+    {"bird6",     &Cm::_bird6,       3023, 1},
+    {"bird7",     &Cm::_bird7,        587, 1},
+    {"bird8",     &Cm::_bird8,        630, 1},
+    {"bird9",     &Cm::_bird9,       3568, 1},
+    {"bird10",    &Cm::_bird10,      1302, 1},
+    {"cuckoo",    &Cm::_cuckoo,      5734, 1},
+    {"raven",     &Cm::_raven,       3699, 1},
+    {"chaffinch", &Cm::_chaffinch,    932, 1},
+    {"blackbird", &Cm::_blackbird,   1699, 1},
+  });
+  static_assert(! REGISTRY.hasDuplicates(), "two birds with the same name");
+  return REGISTRY.table();
 }
 
 /**
@@ -317,30 +291,44 @@ void Chirpmaker::_blackbird()
  * 
  * Note how the bird is called by a pointer to a method
  */
-void Chirpmaker::birdVoice(uint8_t birdNbr, uint32_t msPause)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::birdVoice(uint16_t birdNbr, uint32_t msPause)
 {
-    Bird p = Chirpmaker::_birds[birdNbr];
+    if (birdNbr >= birds().size()) return;
+    Bird p = birds()[birdNbr].sing;
     //printf("Bird %d is singing\n", birdNbr);
-    (this->*p)();   // or (this->*Chirpmaker::_birds[birdNbr])();
-    delay(msPause);
+    (this->*p)();   // or (this->*birds()[birdNbr].sing)();
+    _pause(msPause);
+}
+
+// The bird called name (see birds()), nothing if there is none
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::birdVoice(const char *name, uint32_t msPause)
+{
+    int b = birds().indexOf(name);
+    if (b >= 0) birdVoice(b, msPause);
 }
 
-void Chirpmaker::cuckoo()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::cuckoo()
 {
   birdVoice(11, 20);
 }
 
-void Chirpmaker::raven()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::raven()
 {
   birdVoice(12, 20);
 }
 
-void Chirpmaker::chaffinch()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::chaffinch()
 {
   birdVoice(13, 20);
 }
 
-void Chirpmaker::blackbird()
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::blackbird()
 {
   birdVoice(14, 20);
 }
@@ -349,14 +337,31 @@ void Chirpmaker::blackbird()
  * Make some birds sing in random order 
  * and then wait msPause milliseconds
  */
-void Chirpmaker::birdConcert(uint32_t msPause)
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::birdConcert(uint32_t msPause)
 {
-   for (int i = 0; i < _nbrBirds; i++) //random(5, nbrBirds); i++)
+   BirdTable<Bird> all = birds();
+   for (int i = 0; i < all.size() && all.totalWeight() > 0; i++) //random(5, nbrBirds); i++)
    {
-       int b = random(_nbrBirds);
-       Bird p = Chirpmaker::_birds[b];
-       printf("Bird %2d is singing\n", b);
+       int b = all.byWeight(random(all.totalWeight()));
+       Bird p = all[b].sing;
+       CHIRP_LOG_I("Bird %2d is singing", b);
        (this->*p)();
    }
-    delay(msPause);
-}
\ No newline at end of file
+    _pause(msPause);
+}
+
+#include "ChirpmakerAsync.h"
+#include "ChirpmakerSong.h"
+
+template class BasicChirpmaker<GpioSink, ArduinoClock>;
+template class BasicChirpmaker<FastGpioSink, ArduinoClock>;
+template class BasicChirpmaker<TimerSink, ArduinoClock>;
+template class BasicChirpmaker<PcmSink, VirtualClock>;
+template class BasicChirpmaker<PdmSink, ArduinoClock>;
+#ifndef ARDUINO
+// Only the host tools record, render band-limited or count edges
+template class BasicChirpmaker<RecorderSink, VirtualClock>;
+template class BasicChirpmaker<BlepSink, VirtualClock>;
+template class BasicChirpmaker<NullSink, VirtualClock>;
+#endif
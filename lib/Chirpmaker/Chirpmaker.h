@@ -1,64 +1,147 @@
 #ifndef _CHIRPMAKER_H_
 #define _CHIRPMAKER_H_
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+#include "TimerPlayer.h"
+#include "ChirpProgram.h"
+#include "ProgramCache.h"
+#include "DdsEngine.h"
+#include "OutputSink.h"
+#include "Clock.h"
+#include "FreqGen.h"
+#include "ConstChirp.h"
+#include "BirdRegistry.h"
+#include "SongCode.h"
+#include "ChirpLog.h"
 
-// typedef double (*FreqGen)(int stepNbr, double fStart, double fStop,int nSteps); // is equivalent to "using FreqGen = ... "
-using FreqGen = double (&)(int stepNbr, double fStart, double fStop, int nSteps);
-using FreqGenSinc = double (&)(int stepNbr, double fStart, double fStop, int nSteps, int nPi);
+#ifndef CHIRPMAKER_CALLS
+#define CHIRPMAKER_CALLS 12
+#endif
 
-double linearScale(int stepNbr, double fStart, double fStop,int nSteps);
-double chromaticScale(int stepNbr, double fStart, double fStop,int nSteps);
-double sinePiScale(int stepNbr, double fStart, double fStop,int nSteps);
-double sine2PiScale(int stepNbr, double fStart, double fStop,int nSteps);
-double cosinePiScale(int stepNbr, double fStart, double fStop,int nSteps);
-double cosine2PiScale(int stepNbr, double fStart, double fStop,int nSteps);
-double atanPiScale(int stepNbr, double fStart, double fStop,int nSteps);
-double atan2PiScale(int stepNbr, double fStart, double fStop,int nSteps);
-
-double sincScaleNpi_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi);
-double sincScale0_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi);
-double sincScaleNpi_0(int stepNbr, double fStart, double fStop,int nSteps, int nPi);
-
-class Chirpmaker
+/**
+ * Sound generator for a piezo buzzer. Where the edges go is defined by the
+ * Sink policy (see OutputSink.h), how the time between them passes by the
+ * Clock policy (see Clock.h). Both are resolved at compile time.
+ */
+template <class Sink = GpioSink, class Clock = ArduinoClock>
+class BasicChirpmaker
 {
     public:
-        using Bird = void (Chirpmaker::*)();
+        using Bird = void (BasicChirpmaker::*)();
 
-        Chirpmaker(uint8_t pinBuzzer) : _pinBuzzer(pinBuzzer)
+        BasicChirpmaker(uint8_t pinBuzzer)
         {
-            pinMode(_pinBuzzer, OUTPUT);
-
-            _birds[0] = &Chirpmaker::_bird0; // Store the birds in an array
-            _birds[1] = &Chirpmaker::_bird1;
-            _birds[2] = &Chirpmaker::_bird2;
-            _birds[3] = &Chirpmaker::_bird3;
-            _birds[4] = &Chirpmaker::_bird4;
-            _birds[5] = &Chirpmaker::_bird5;
-            _birds[6] = &Chirpmaker::_bird6;
-            _birds[7] = &Chirpmaker::_bird7;
-            _birds[8] = &Chirpmaker::_bird8;
-            _birds[9] = &Chirpmaker::_bird9;
-            _birds[10] = &Chirpmaker::_bird10;
-            _birds[11] = &Chirpmaker::_cuckoo;
-            _birds[12] = &Chirpmaker::_raven;
-            _birds[13] = &Chirpmaker::_chaffinch;
-            _birds[14] = &Chirpmaker::_blackbird;
+            _sink.begin(pinBuzzer);
         }
 
+        template <class Gen>
+        void chirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause);
         void chirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause);
         void chirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause);
         void phaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause);
-        void birdVoice(uint8_t birdNbr, uint32_t msPause);
+        template <class Gen>
+        void chirpDds(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause);
+        void play(const ChirpProgram &program);
+        void play(const Segment *segments, uint16_t nSegments, uint16_t repeats);
+        template <size_t N>
+        void play(const ConstProgram<N> &table, uint16_t repeats) { play(table.segments, N, repeats); }
+        void birdVoice(uint16_t birdNbr, uint32_t msPause);
+        void birdVoice(const char *name, uint32_t msPause);
         void birdConcert(uint32_t msPause);
+        bool sing(const uint8_t *song, const SongTables &tables = CONST_SONG_TABLES);  // bytecode of SongCode.h
         void signet();
         void phoneCall(uint8_t nTimes);
         void cuckoo();
         void raven();
         void chaffinch();
         void blackbird();
+        Sink &sink() { return _sink; }
+        static BirdTable<Bird> birds();  // the registry of all birds, in flash
+        void useProgramCache(ProgramCache *cache = &ProgramCache::shared()) { _programs = cache; }  // nullptr: none
+        ProgramCache *programCache() { return _programs; }
+
+        // Non-blocking playback, the sound advances with each call of tick()
+        template <class Gen>
+        bool startChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause);
+        bool startChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause);
+        bool startChirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause);
+        bool startPhaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause);
+        bool startBird(uint16_t birdNbr, uint32_t msPause);
+        bool startConcert(uint32_t msPause);
+        bool startSong(const uint8_t *song, uint32_t msPause, const SongTables &tables = CONST_SONG_TABLES);
+        bool tick(uint32_t nowUs);
+        bool pull(uint8_t &level, uint32_t &us);  // for an output with its own time base (PolyPlayer)
+        bool isBusy() const { return _state.busy; }
+        bool overflowed() const { return _state.overflow; }  // a sound had more calls than MAX_CALLS or a count beyond 32767
+        void stop();
 
     private:
-        uint8_t _pinBuzzer;
+        // A chirp, phaser or pause recorded from a bird for non-blocking playback
+        struct Call
+        {
+          enum Kind : uint8_t { CHIRP, PHASER, PAUSE, TABLE };
+          float fStart = 0;    // freq of a phaser, exact for whole Hz
+          float fStop = 0;
+          uint32_t msPause = 0;
+          int16_t nSteps = 0;  // segments of a table
+          int16_t nPeriods = 0;
+          int16_t nChirps = 0; // repeats of a table
+          Kind kind = PAUSE;
+          uint8_t duty = 0;    // dutyStart of a phaser
+          uint8_t dutyEnd = 0;
+          const Segment *table = nullptr;
+          AnyFreqGen gen;
+
+          // Whether a count fits into the call, a call that does not is an overflow like a full script
+          static bool fits(int n) { return n >= INT16_MIN && n <= INT16_MAX; }
+        };
+        static const uint8_t MAX_CALLS = CHIRPMAKER_CALLS;
+        static_assert(CHIRPMAKER_CALLS >= 1 && CHIRPMAKER_CALLS <= 255, "CHIRPMAKER_CALLS must be 1 .. 255");
+
+        // Position of the non-blocking playback
+        struct PlayState
+        {
+          uint32_t deadline;   // us at which the next edge is due
+          uint32_t msPause;    // pause after a concert
+          const Segment *segments;   // being played, of the program or of a table
+          uint16_t nSegments;
+          uint16_t nRepeats;
+          int16_t  nextStep;   // next step to compile of a chirp too long for one program
+          uint16_t chirpNbr;   // chirp of a piecewise compiled call
+          uint16_t repeat;     // pass through the program
+          uint16_t seg;        // segment of the program
+          uint16_t period;     // period within the segment
+          uint8_t  call;       // call of the script
+          uint8_t  nCalls;
+          uint16_t birdsLeft;  // birds still to sing in a concert
+          bool     high;       // high half of the period has been output
+          bool     piecewise;
+          bool     started;
+          bool     busy;
+          bool     overflow;   // a call did not fit into the script
+        };
+
+        Sink _sink;
+        ChirpProgram _program;
+        ProgramCache *_programs = nullptr;
+        Call _script[MAX_CALLS];
+        PlayState _state = {};
+        bool _recording = false;
+
+        inline void _hold(uint8_t level, uint32_t ticks);
+        inline void _buz(uint32_t usTon, uint32_t usToff);
+        void _pause(uint32_t msPause);
+        void _playSegments(const Segment *segments, uint16_t nSegments, uint16_t repeats);
+        void _record(const Call &call, bool fits = true);
+        void _recordBird(uint16_t birdNbr);
+        bool _singChirp(uint8_t gen, const int32_t *a);
+        bool _start();
+        bool _compileCall(int firstStep);
+        bool _loadNext();
+        bool _nextEdge(uint8_t &level, uint32_t &us);
 
         void _bird0();
         void _bird1();
@@ -75,8 +158,141 @@ class Chirpmaker
         void _raven();
         void _chaffinch();
         void _blackbird();
-        
-        Bird _birds[15];
-        int _nbrBirds = sizeof(_birds) / sizeof(_birds[0]);
 };
+
+/**
+ * Output level for ticks sink ticks and wait as long as the sink asks for
+ */
+template <class Sink, class Clock>
+inline void BasicChirpmaker<Sink, Clock>::_hold(uint8_t level, uint32_t ticks)
+{
+  uint32_t us = _sink.write(level, ticks);
+  if (us) Clock::delayUs(us);
+}
+
+/**
+ * Toggle the buzzer once with a duty cycle of tOn / (tOn + tOff)
+ * |¨¨¨|______|
+ *  tOn  tOff
+ */
+template <class Sink, class Clock>
+inline void BasicChirpmaker<Sink, Clock>::_buz(uint32_t usTon, uint32_t usToff)
+{
+  _hold(HIGH, usTon * Sink::TICKS_PER_US);
+  _hold(LOW, usToff * Sink::TICKS_PER_US);
+}
+
+/**
+ * Simulate the chirp of a bird, see the chirp() with a FreqGen in
+ * Chirpmaker.cpp for the parameters. Here the generator is an object
+ * (Chromatic(), Sinc(3) ..., see FreqGen.h) that is inlined into the step
+ * loop, every generator can be played nChirps times.
+ * With a program cache (useProgramCache()), a chirp that fits into one
+ * program is kept there and played from it when it comes again with the
+ * same arguments.
+ */
+template <class Sink, class Clock>
+template <class Gen>
+void BasicChirpmaker<Sink, Clock>::chirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause)
+{
+  if (_recording)
+  {
+    Call c;
+    c.kind = Call::CHIRP;
+    c.duty = duty;
+    c.fStart = fStart;
+    c.fStop = fStop;
+    c.msPause = msPause;
+    c.nSteps = nSteps;
+    c.nPeriods = nPeriods;
+    c.nChirps = nChirps;
+    c.gen = AnyFreqGen(gen);
+    _record(c, Call::fits(nSteps) && Call::fits(nPeriods) && Call::fits(nChirps));
+    return;
+  }
+  ProgramCache::Key key = {fStart, fStop, nSteps, nPeriods, duty, msPause, AnyFreqGen(gen)};
+  uint16_t nSegments;
+  const Segment *cached = _programs ? _programs->find(key, nSegments) : nullptr;
+  if (cached)
+  {
+    _playSegments(cached, nSegments, ChirpProgram::toCount(nChirps));
+    return;
+  }
+  int next = _program.compileChirp(fStart, fStop, nSteps, nPeriods, nChirps, gen, duty, msPause);
+  if (next > nSteps)
+  {
+    if (_programs) _programs->insert(key, _program);
+    play(_program);
+    return;
+  }
+  for (int n = 0; n < nChirps; n++) // too many steps for one program, compile and play piece by piece
+  {
+    for (int s = 0; s <= nSteps; play(_program))
+      s = _program.compileChirp(fStart, fStop, nSteps, nPeriods, nChirps, gen, duty, msPause, s);
+  }
+}
+
+/**
+ * Same as chirp(), but the periods come from a DDS phase accumulator
+ * (see DdsEngine) and keep their fractional part. The edges are placed on
+ * the ticks of the sink (0.1 us with the timer, 1 us with the GPIO sinks),
+ * the frequency of each step is met on average over its periods.
+ */
+template <class Sink, class Clock>
+template <class Gen>
+void BasicChirpmaker<Sink, Clock>::chirpDds(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause)
+{
+  DdsEngine dds(Sink::TICK_HZ);
+  for (int n = 0; n < nChirps; n++)
+  {
+    dds.reset();
+    for (int s = 0; s <= nSteps; s++)
+    {
+      dds.setTone(gen(s, fStart, fStop, nSteps), duty);
+      for (int p = 0; p < nPeriods; p++)
+      {
+        uint32_t tOn, tOff;
+        dds.nextPeriod(tOn, tOff);
+        _hold(HIGH, tOn);
+        _hold(LOW, tOff);
+      }
+    }
+    _pause(msPause);
+  }
+}
+
+template <class Sink, class Clock>
+template <class Gen>
+bool BasicChirpmaker<Sink, Clock>::startChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, const Gen &gen, int duty, uint32_t msPause)
+{
+  stop();
+  _recording = true;
+  chirp(fStart, fStop, nSteps, nPeriods, nChirps, gen, duty, msPause);
+  _recording = false;
+  return _start();
+}
+
+// The member functions are instantiated in Chirpmaker.cpp for these policies.
+// PcmSink (SampleClip::render()) and PdmSink (I2S) are used on the ESP32 too,
+// the others only by the host tools.
+extern template class BasicChirpmaker<GpioSink, ArduinoClock>;
+extern template class BasicChirpmaker<FastGpioSink, ArduinoClock>;
+extern template class BasicChirpmaker<TimerSink, ArduinoClock>;
+extern template class BasicChirpmaker<PcmSink, VirtualClock>;
+extern template class BasicChirpmaker<PdmSink, ArduinoClock>;
+#ifndef ARDUINO
+extern template class BasicChirpmaker<RecorderSink, VirtualClock>;
+extern template class BasicChirpmaker<BlepSink, VirtualClock>;
+extern template class BasicChirpmaker<NullSink, VirtualClock>;
+#endif
+
+using Chirpmaker = BasicChirpmaker<GpioSink, ArduinoClock>;
+using FastChirpmaker = BasicChirpmaker<FastGpioSink, ArduinoClock>;
+using TimedChirpmaker = BasicChirpmaker<TimerSink, ArduinoClock>;
+using PcmChirpmaker = BasicChirpmaker<PcmSink, VirtualClock>;
+using BlepChirpmaker = BasicChirpmaker<BlepSink, VirtualClock>;
+using PdmChirpmaker = BasicChirpmaker<PdmSink, ArduinoClock>;
+#ifndef ARDUINO
+using NullChirpmaker = BasicChirpmaker<NullSink, VirtualClock>;  // only counts its edges, for the host tools and tests
+#endif
 #endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+/**
+ * Non-blocking playback for Chirpmaker
+ *
+ * A start function records what is to be played as a short script of calls
+ * (the birds simply run in a recording mode, so their random parameters are
+ * drawn right away). tick() then walks through the script as a resumable
+ * state machine: call -> compiled program -> pass -> segment -> period.
+ * Each call is compiled when the previous one has emitted its last edge, so
+ * the floating point work falls into a pause instead of into the sound.
+ * The script holds MAX_CALLS calls (CHIRPMAKER_CALLS, default 12). A sound
+ * with more calls, or with a count beyond 32767, is not played: the start
+ * function returns false and overflowed() tells why. A bird of a concert
+ * that does not fit is skipped. A call keeps its frequencies as float,
+ * exact for whole Hz.
+ *
+ * Example
+ *   cm.startBird(13, 20);
+ *   while (cm.tick(micros())) { serviceSensors(); }
+ *
+ * Template definitions, only included by Chirpmaker.cpp which instantiates them.
+ */
+#ifndef _CHIRPMAKERASYNC_H_
+#define _CHIRPMAKERASYNC_H_
+#include "Chirpmaker.h"
+
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::startChirp(double fStart, double fStop, int nSteps, int nPeriods, int nChirps, FreqGen fgen, int duty, uint32_t msPause)
+{
+  stop();
+  _recording = true;
+  chirp(fStart, fStop, nSteps, nPeriods, nChirps, fgen, duty, msPause);
+  _recording = false;
+  return _start();
+}
+
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::startChirp(double fStart, double fStop, int nSteps, int nPeriods, int nPi, FreqGenSinc fgen, int duty, uint32_t msPause)
+{
+  stop();
+  _recording = true;
+  chirp(fStart, fStop, nSteps, nPeriods, nPi, fgen, duty, msPause);
+  _recording = false;
+  return _start();
+}
+
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::startPhaser(uint32_t freq, int nPeriods, int dutyStart, int dutyEnd, int nChirps, uint32_t msPause)
+{
+  stop();
+  _recording = true;
+  phaser(freq, nPeriods, dutyStart, dutyEnd, nChirps, msPause);
+  _recording = false;
+  return _start();
+}
+
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::startBird(uint16_t birdNbr, uint32_t msPause)
+{
+  stop();
+  _recording = true;
+  birdVoice(birdNbr, msPause);
+  _recording = false;
+  return _start();
+}
+
+/**
+ * Like birdConcert(), the birds are chosen one after the other
+ * as the previous one has finished.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::startConcert(uint32_t msPause)
+{
+  stop();
+  _state.birdsLeft = birds().totalWeight() > 0 ? birds().size() : 0;
+  _state.msPause = msPause;
+  return _start();
+}
+
+/**
+ * Output all edges that are due at nowUs. Call it at least once per
+ * half period of the highest frequency. If a call comes late, the missed
+ * edges are skipped and the sound stays on its time line.
+ * Returns true as long as the sound is playing.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::tick(uint32_t nowUs)
+{
+  if (! _state.busy) return false;
+  if (! _state.started)
+  {
+    _state.started = true;
+    _state.deadline = nowUs;
+  }
+
+  bool changed = false;
+  uint8_t level = LOW;
+  while ((int32_t)(nowUs - _state.deadline) >= 0)
+  {
+    uint32_t us;
+    if (! _nextEdge(level, us))
+    {
+      _sink.set(LOW);
+      _state.busy = false;
+      return false;
+    }
+    _state.deadline += us;
+    changed = true;
+  }
+  if (changed) _sink.set(level);
+  return true;
+}
+
+/**
+ * Take the next edge of the sound instead of playing it: the level and
+ * how long it lasts in us. The sink is not used, the caller keeps the time.
+ * Returns false when the sound is over.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::pull(uint8_t &level, uint32_t &us)
+{
+  if (! _state.busy) return false;
+  if (_nextEdge(level, us)) return true;
+  _state.busy = false;
+  return false;
+}
+
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::stop()
+{
+  if (_state.busy) _sink.set(LOW);
+  _state = {};
+  _program.clear();
+}
+
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_record(const Call &call, bool fits)
+{
+  if (fits && _state.nCalls < MAX_CALLS) _script[_state.nCalls++] = call;
+  else _state.overflow = true;
+}
+
+template <class Sink, class Clock>
+void BasicChirpmaker<Sink, Clock>::_recordBird(uint16_t birdNbr)
+{
+  _recording = true;
+  (this->*birds()[birdNbr].sing)();
+  _recording = false;
+}
+
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::_start()
+{
+  _state.call = 0;
+  _program.clear();
+  if (_state.overflow)
+  {
+    CHIRP_LOG_W("Sound of more than %d calls or of a count beyond 32767 not played", MAX_CALLS);
+    return false;
+  }
+  if (_state.nCalls > 0 && _compileCall(0)) _state.busy = true;
+  else _state.busy = _loadNext();
+  return true;
+}
+
+/**
+ * Compile the current call into the program, starting at firstStep.
+ * Returns false if the program stays empty.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::_compileCall(int firstStep)
+{
+  const Call &c = _script[_state.call];
+  switch (c.kind)
+  {
+    case Call::CHIRP:
+    case Call::PHASER:
+      if (c.nChirps <= 0)
+      {
+        _program.clear();
+        _state.nextStep = 0;
+        break;
+      }
+      if (c.kind == Call::PHASER)
+      {
+        _state.nextStep = _program.compilePhaser(c.fStart, c.nPeriods, c.duty, c.dutyEnd, c.nChirps, c.msPause, firstStep);
+        if (firstStep == 0) _state.piecewise = _state.nextStep <= c.nSteps;
+      }
+      else
+      {
+        ProgramCache::Key key = {c.fStart, c.fStop, c.nSteps, c.nPeriods, c.duty, c.msPause, c.gen};
+        uint16_t nSegments;
+        const Segment *cached = firstStep == 0 && _programs ? _programs->find(key, nSegments) : nullptr;
+        if (cached)
+        {
+          _program.assign(cached, nSegments, ChirpProgram::toCount(c.nChirps));
+          _state.nextStep = c.nSteps + 1;
+          _state.piecewise = false;
+          break;
+        }
+        _state.nextStep = _program.compileChirp(c.fStart, c.fStop, c.nSteps, c.nPeriods, c.nChirps, c.gen, c.duty, c.msPause, firstStep);
+        if (firstStep == 0)
+        {
+          _state.piecewise = _state.nextStep <= c.nSteps;
+          if (! _state.piecewise && _programs) _programs->insert(key, _program);
+        }
+      }
+      break;
+    case Call::TABLE:
+      // Played where it is, it may be longer than a program
+      _state.segments = c.table;
+      _state.nSegments = c.nSteps;
+      _state.nRepeats = c.nChirps;
+      _state.nextStep = 0;
+      _state.repeat = 0;
+      _state.seg = 0;
+      _state.period = 0;
+      _state.high = false;
+      return _state.nSegments > 0 && _state.nRepeats > 0;
+    case Call::PAUSE:
+      _program.clear();
+      _program.addPause(c.msPause);
+      _state.nextStep = 0;
+      break;
+  }
+  _state.segments = _program.begin();
+  _state.nSegments = _program.size();
+  _state.nRepeats = _program.repeats;
+  _state.repeat = 0;
+  _state.seg = 0;
+  _state.period = 0;
+  _state.high = false;
+  return _state.nSegments > 0 && _state.nRepeats > 0;
+}
+
+/**
+ * Move on to the next non-empty program: the rest of a piecewise compiled
+ * chirp, its next repetition, the next call or the next bird of a concert.
+ * Returns false when there is nothing left to play.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::_loadNext()
+{
+  for (;;)
+  {
+    if (_state.nCalls > 0)
+    {
+      const Call &c = _script[_state.call];
+      if (_state.nextStep > 0 && _state.nextStep <= c.nSteps)
+      {
+        if (_compileCall(_state.nextStep)) return true;
+        continue;
+      }
+      if (_state.piecewise && ++_state.chirpNbr < c.nChirps)
+      {
+        if (_compileCall(0)) return true;
+        continue;
+      }
+      _state.chirpNbr = 0;
+      _state.piecewise = false;
+      if (++_state.call < _state.nCalls)
+      {
+        if (_compileCall(0)) return true;
+        continue;
+      }
+    }
+    if (_state.birdsLeft == 0) return false;
+
+    _state.nCalls = 0;
+    _state.call = 0;
+    bool overflow = _state.overflow;
+    _state.overflow = false;
+    _recordBird(birds().byWeight(random(birds().totalWeight())));
+    if (_state.overflow) _state.nCalls = 0;  // does not fit into the script, skipped
+    _state.overflow = _state.overflow || overflow;
+    if (--_state.birdsLeft == 0)
+    {
+      _recording = true;
+      _pause(_state.msPause);
+      _recording = false;
+    }
+    if (_state.nCalls > 0 && _compileCall(0)) return true;
+  }
+}
+
+/**
+ * Advance the state machine by one edge
+ * level   level of the pin from now on
+ * us      duration of that level
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::_nextEdge(uint8_t &level, uint32_t &us)
+{
+  if (_state.seg >= _state.nSegments) return false;
+
+  const Segment &seg = _state.segments[_state.seg];
+  if (seg.isPause())
+  {
+    level = LOW;
+    us = seg.tOff * 1000;
+    _state.seg++;
+  }
+  else if (! _state.high)
+  {
+    level = HIGH;
+    us = seg.tOn;
+    _state.high = true;
+  }
+  else
+  {
+    level = LOW;
+    us = seg.tOff;
+    _state.high = false;
+    if (++_state.period >= seg.count)
+    {
+      _state.period = 0;
+      _state.seg++;
+    }
+  }
+
+  if (_state.seg >= _state.nSegments)
+  {
+    if (++_state.repeat < _state.nRepeats) _state.seg = 0;
+    else if (! _loadNext()) _state.nSegments = 0;
+  }
+  return true;
+}
+#endif
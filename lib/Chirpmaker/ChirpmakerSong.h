@@ -0,0 +1,150 @@
+/**
+ * Bytecode interpreter for Chirpmaker
+ *
+ * sing() runs a song written in the bytecode of SongCode.h, e.g. one of
+ * BirdSongs.h or one loaded from a file and checked with songCheck().
+ * The interpreter uses a stack of SONG_STACK values and SONG_LOOPS loop
+ * frames on the C stack, nothing is allocated. The chirps, phasers and
+ * tables of a song are played by the ordinary functions, so a song can
+ * also be started non-blocking and uses the program cache.
+ *
+ * Example
+ *   cm.sing(SONG_CUCKOO_CODE);
+ *   cm.startSong(BIRD_SONGS[13].code, 20);
+ *
+ * Template definitions, only included by Chirpmaker.cpp which instantiates them.
+ */
+#ifndef _CHIRPMAKERSONG_H_
+#define _CHIRPMAKERSONG_H_
+#include "Chirpmaker.h"
+#include "SongCode.h"
+#include "CurveCache.h"
+
+/**
+ * Play a song, its SONG_TABLE ops refer to tables. Returns false if it
+ * stopped at an invalid instruction, a stack overflow or underflow or
+ * unbalanced loops; what was played up to there stays played.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::sing(const uint8_t *song, const SongTables &tables)
+{
+  int32_t stack[SONG_STACK];
+  struct Loop
+  {
+    const uint8_t *body;
+    int32_t left;
+  } loops[SONG_LOOPS];
+  uint8_t sp = 0, lp = 0;
+
+  for (const uint8_t *pc = song; ; )
+  {
+    uint8_t op = *pc++;
+    switch (op)
+    {
+      case SONG_END:
+        return sp == 0 && lp == 0;
+      case SONG_PUSH8:
+        if (sp == SONG_STACK) return false;
+        stack[sp++] = pc[0];
+        pc += 1;
+        break;
+      case SONG_PUSH16:
+        if (sp == SONG_STACK) return false;
+        stack[sp++] = pc[0] | pc[1] << 8;
+        pc += 2;
+        break;
+      case SONG_RANDOM8:
+        if (sp == SONG_STACK) return false;
+        stack[sp++] = random(pc[0], pc[1]);
+        pc += 2;
+        break;
+      case SONG_RANDOM16:
+        if (sp == SONG_STACK) return false;
+        stack[sp++] = random(pc[0] | pc[1] << 8, pc[2] | pc[3] << 8);
+        pc += 4;
+        break;
+      case SONG_CHIRP:
+        if (sp < 7 || ! _singChirp(*pc++, stack + (sp -= 7))) return false;
+        break;
+      case SONG_PHASER:
+      {
+        if (sp < 6) return false;
+        const int32_t *a = stack + (sp -= 6);
+        phaser(a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+      }
+      case SONG_TABLE:
+      {
+        uint16_t nSegments;
+        const Segment *table = tables.get(*pc++, nSegments);
+        if (sp < 1 || ! table) return false;
+        play(table, nSegments, stack[--sp]);
+        break;
+      }
+      case SONG_PAUSE:
+        if (sp < 1) return false;
+        _pause(stack[--sp]);
+        break;
+      case SONG_REPEAT:
+        if (sp < 1 || lp == SONG_LOOPS) return false;
+        loops[lp] = {pc, stack[--sp]};
+        if (loops[lp].left > 0)
+        {
+          lp++;
+          break;
+        }
+        for (int depth = 1; depth > 0; pc = songNext(pc))  // skip the body of a loop played 0 times
+        {
+          if (*pc == SONG_END || *pc >= SONG_OPS) return false;
+          if (*pc == SONG_REPEAT) depth++;
+          if (*pc == SONG_LOOP) depth--;
+        }
+        break;
+      case SONG_LOOP:
+        if (lp == 0) return false;
+        if (--loops[lp - 1].left > 0) pc = loops[lp - 1].body;
+        else lp--;
+        break;
+      default:
+        return false;
+    }
+  }
+}
+
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::startSong(const uint8_t *song, uint32_t msPause, const SongTables &tables)
+{
+  stop();
+  _recording = true;
+  sing(song, tables);
+  _pause(msPause);
+  _recording = false;
+  return _start();
+}
+
+/**
+ * The chirp of a SONG_CHIRP, a holds fStart fStop nSteps nPeriods nChirps duty msPause.
+ * The affine generators come from the curve cache, like in the birds.
+ */
+template <class Sink, class Clock>
+bool BasicChirpmaker<Sink, Clock>::_singChirp(uint8_t gen, const int32_t *a)
+{
+  int nPi = gen >> 4;
+  switch (gen & 0x0f)
+  {
+    case GEN_LINEAR:       chirp(a[0], a[1], a[2], a[3], a[4], Linear(), a[5], a[6]); break;
+    case GEN_CHROMATIC:    chirp(a[0], a[1], a[2], a[3], a[4], Chromatic(), a[5], a[6]); break;
+    case GEN_SINE_PI:      chirp(a[0], a[1], a[2], a[3], a[4], Cached<SinePi>(), a[5], a[6]); break;
+    case GEN_SINE_2PI:     chirp(a[0], a[1], a[2], a[3], a[4], Cached<Sine2Pi>(), a[5], a[6]); break;
+    case GEN_COSINE_PI:    chirp(a[0], a[1], a[2], a[3], a[4], Cached<CosinePi>(), a[5], a[6]); break;
+    case GEN_COSINE_2PI:   chirp(a[0], a[1], a[2], a[3], a[4], Cached<Cosine2Pi>(), a[5], a[6]); break;
+    case GEN_ATAN_PI:      chirp(a[0], a[1], a[2], a[3], a[4], Cached<AtanPi>(), a[5], a[6]); break;
+    case GEN_ATAN_2PI:     chirp(a[0], a[1], a[2], a[3], a[4], Cached<Atan2Pi>(), a[5], a[6]); break;
+    case GEN_SINC_NPI_NPI: chirp(a[0], a[1], a[2], a[3], a[4], Cached<Sinc>(Sinc(nPi)), a[5], a[6]); break;
+    case GEN_SINC_NPI_0:   chirp(a[0], a[1], a[2], a[3], a[4], Cached<SincNpi_0>(SincNpi_0(nPi)), a[5], a[6]); break;
+    case GEN_SINC_0_NPI:   chirp(a[0], a[1], a[2], a[3], a[4], Cached<Sinc0_Npi>(Sinc0_Npi(nPi)), a[5], a[6]); break;
+    default:               return false;
+  }
+  return true;
+}
+#endif
@@ -0,0 +1,31 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+
+/**
+ * Clock policies of BasicChirpmaker. A clock waits for the time an output
+ * sink asks for: delayUs() between the edges of a period, delayMs() for
+ * the pauses between chirps.
+ */
+
+// Busy waits with the Arduino core, delay() lets other tasks run
+struct ArduinoClock
+{
+  static inline void delayUs(uint32_t us) { delayMicroseconds(us); }
+  static inline void delayMs(uint32_t ms) { delay(ms); }
+};
+
+// Does not wait at all but adds up the time that should have passed,
+// per thread, so Chirpmakers rendering on several threads do not race
+struct VirtualClock
+{
+  static inline thread_local uint64_t us = 0;
+
+  static inline void delayUs(uint32_t t) { us += t; }
+  static inline void delayMs(uint32_t ms) { us += (uint64_t)ms * 1000; }
+};
+#endif
@@ -0,0 +1,294 @@
+#ifndef _CONCERT_H_
+#define _CONCERT_H_
+#include <math.h>
+#include "PolyPlayer.h"
+
+/**
+ * A concert of overlapping birds. The birds arrive at random like the
+ * customers of a queue, birdsPerMinute on average, and are placed on a
+ * timeline so that at most maxOverlap sing at the same time. Each event
+ * names the bird, its start and the voice it is planned for; a voice is
+ * taken for the typical length of the bird (see BirdInfo) plus msGap.
+ * rates gives the relative frequency of each bird, nullptr takes the
+ * weights of the registry.
+ *
+ * plan() computes the events msAhead into the future, dispatch() only
+ * starts the events that are due on their voices, a Chirpmaker each:
+ *   play(poly, millis())        several buzzers on a PolyPlayer
+ *   render(samples, n, 44100)   all voices mixed into 16 bit PCM
+ * The timeline has its own random generator, seeded by the plan, so the
+ * same plan gives the same events whatever the birds draw.
+ */
+template <class Cm>
+class Concert
+{
+  public:
+    static const uint8_t MAX_VOICES = PolyPlayer::MAX_VOICES;
+    static const uint8_t MAX_EVENTS = 32;  // must be a power of 2
+
+    struct Plan
+    {
+      uint16_t birdsPerMinute = 20;
+      uint8_t  maxOverlap = 2;         // birds singing at the same time, at most
+      uint16_t msGap = 100;            // rest of a voice between two birds
+      uint16_t msAhead = 4000;         // how far plan() looks ahead
+      uint16_t nBirds = 0;             // length of the concert, 0: endless
+      const uint8_t *rates = nullptr;  // per bird of the registry, nullptr: its weights
+      uint32_t seed = 1;
+    };
+
+    struct Event
+    {
+      uint32_t atMs;
+      uint16_t bird;
+      uint8_t  voice;
+    };
+
+    void begin(Cm *const *voices, uint8_t nVoices, const Plan &plan, uint32_t nowMs = 0);
+    void plan(uint32_t nowMs);
+    uint8_t dispatch(uint32_t nowMs);
+    bool next(Event &e);
+    void play(PolyPlayer &poly, uint32_t nowMs);
+    void render(int16_t *samples, size_t n, uint32_t sampleRate, int16_t amplitude = 8000);
+
+    bool isOver() const;
+    uint8_t pending() const { return _count; }
+    const Event &pendingEvent(uint8_t i) const { return _events[(_first + i) & (MAX_EVENTS - 1)]; }
+    uint32_t planned() const { return _planned; }
+    uint32_t started() const { return _started; }
+    uint32_t moved() const { return _moved; }          // started on another voice, the planned one was still singing
+    uint32_t msLateMax() const { return _msLateMax; }  // latest start after the planned time
+
+  private:
+    static bool _due(uint32_t atMs, uint32_t nowMs) { return (int32_t)(nowMs - atMs) >= 0; }
+    uint32_t _random();
+    uint16_t _pickBird();
+    uint32_t _gapMs();
+
+    Cm *const *_voices = nullptr;
+    uint8_t _nVoices = 0;
+    Plan _plan;
+    uint32_t _totalRate = 0;
+    uint32_t _rng = 1;
+    uint32_t _nextMs = 0;                // arrival of the next bird to be planned
+    uint32_t _busyUntil[MAX_VOICES];     // planned end of each voice
+    Event _events[MAX_EVENTS];
+    uint8_t _first = 0;
+    uint8_t _count = 0;
+    uint32_t _planned = 0;
+    uint32_t _started = 0;
+    uint32_t _moved = 0;
+    uint32_t _msLateMax = 0;
+
+    // Mixing state of render()
+    uint64_t _sample = 0;
+    uint64_t _edgeEnd[MAX_VOICES];       // tick at which the level of a voice ends
+    uint8_t _level[MAX_VOICES];
+    bool _fresh[MAX_VOICES] = {};        // voices started by the last dispatch()
+};
+
+/**
+ * Start a concert at nowMs on voices 0 .. nVoices - 1
+ */
+template <class Cm>
+void Concert<Cm>::begin(Cm *const *voices, uint8_t nVoices, const Plan &plan, uint32_t nowMs)
+{
+  _voices = voices;
+  _nVoices = nVoices < MAX_VOICES ? nVoices : MAX_VOICES;
+  _plan = plan;
+  if (_plan.maxOverlap == 0 || _plan.maxOverlap > _nVoices) _plan.maxOverlap = _nVoices;
+  if (_plan.birdsPerMinute == 0) _plan.birdsPerMinute = 1;
+  _totalRate = 0;
+  for (uint16_t b = 0; b < Cm::birds().size(); b++) _totalRate += _plan.rates ? _plan.rates[b] : Cm::birds()[b].weight;
+  _rng = _plan.seed ? _plan.seed : 1;
+  _nextMs = nowMs;
+  for (uint8_t v = 0; v < MAX_VOICES; v++)
+  {
+    _busyUntil[v] = nowMs;
+    _edgeEnd[v] = 0;
+    _level[v] = LOW;
+  }
+  _first = _count = 0;
+  _planned = _started = _moved = _msLateMax = 0;
+  _sample = 0;
+  for (bool &f : _fresh) f = false;
+}
+
+/**
+ * Add events up to msAhead after nowMs. Takes the time of the decisions,
+ * a few us per bird, so call it where a delay does not matter.
+ */
+template <class Cm>
+void Concert<Cm>::plan(uint32_t nowMs)
+{
+  if (_nVoices == 0 || _totalRate == 0) return;
+  while (_count < MAX_EVENTS && _due(_nextMs, nowMs + _plan.msAhead) && (_plan.nBirds == 0 || _planned < _plan.nBirds))
+  {
+    // Move the bird back until fewer than maxOverlap voices are taken
+    uint32_t t = _nextMs;
+    for (;;)
+    {
+      uint8_t busy = 0;
+      uint32_t firstFree = 0;
+      for (uint8_t v = 0; v < _nVoices; v++)
+      {
+        if (_due(_busyUntil[v], t)) continue;
+        if (busy++ == 0 || (int32_t)(_busyUntil[v] - firstFree) < 0) firstFree = _busyUntil[v];
+      }
+      if (busy < _plan.maxOverlap) break;
+      t = firstFree;
+    }
+
+    // The voice that has been free the longest
+    uint8_t voice = 0;
+    for (uint8_t v = 1; v < _nVoices; v++) if ((int32_t)(_busyUntil[v] - _busyUntil[voice]) < 0) voice = v;
+
+    uint16_t bird = _pickBird();
+    _busyUntil[voice] = t + Cm::birds()[bird].msTypical + _plan.msGap;
+    _events[(_first + _count) & (MAX_EVENTS - 1)] = {t, bird, voice};
+    _count++;
+    _planned++;
+    _nextMs = t + _gapMs();
+  }
+}
+
+/**
+ * Start the events that are due at nowMs. A voice that is still singing
+ * (its bird took longer than typical) hands the event to a free voice;
+ * if there is none, the event waits. Never blocks.
+ * Returns the number of birds started.
+ */
+template <class Cm>
+uint8_t Concert<Cm>::dispatch(uint32_t nowMs)
+{
+  uint8_t n = 0;
+  for (bool &f : _fresh) f = false;
+  while (_count > 0 && _due(_events[_first].atMs, nowMs))
+  {
+    const Event &e = _events[_first];
+    uint8_t voice = e.voice;
+    if (_voices[voice]->isBusy())
+    {
+      for (voice = 0; voice < _nVoices && _voices[voice]->isBusy(); voice++) {}
+      if (voice == _nVoices) break;
+      _moved++;
+    }
+    _voices[voice]->startBird(e.bird, 0);
+    if (nowMs - e.atMs > _msLateMax) _msLateMax = nowMs - e.atMs;
+    _fresh[voice] = true;
+    _first = (_first + 1) & (MAX_EVENTS - 1);
+    _count--;
+    _started++;
+    n++;
+  }
+  return n;
+}
+
+/**
+ * Take the next planned event without starting it, for a renderer that
+ * keeps the voices itself (see ConcertRenderer.h). False if none is planned.
+ */
+template <class Cm>
+bool Concert<Cm>::next(Event &e)
+{
+  if (_count == 0) return false;
+  e = _events[_first];
+  _first = (_first + 1) & (MAX_EVENTS - 1);
+  _count--;
+  return true;
+}
+
+// All birds of a concert of nBirds have been sung
+template <class Cm>
+bool Concert<Cm>::isOver() const
+{
+  if (_plan.nBirds == 0 || _started < _plan.nBirds) return false;
+  for (uint8_t v = 0; v < _nVoices; v++) if (_voices[v]->isBusy()) return false;
+  return true;
+}
+
+/**
+ * One round of a concert on the buzzers of poly, voice v of the concert
+ * on voice v of the player. Call it from loop() at least every 2 ms.
+ */
+template <class Cm>
+void Concert<Cm>::play(PolyPlayer &poly, uint32_t nowMs)
+{
+  plan(nowMs);
+  dispatch(nowMs);
+  for (uint8_t v = 0; v < _nVoices; v++) poly.feed(v, *_voices[v]);
+}
+
+/**
+ * Render the next n samples of the concert, the voices mixed: each adds
+ * amplitude while its level is HIGH, like the buzzers add up in the air.
+ * Sums beyond 16 bit are clipped. The concert time follows the samples.
+ */
+template <class Cm>
+void Concert<Cm>::render(int16_t *samples, size_t n, uint32_t sampleRate, int16_t amplitude)
+{
+  const uint32_t TICK_HZ = PolyPlayer::TICK_HZ;
+  plan(_sample * 1000 / sampleRate);
+  uint32_t nextMs = _count ? _events[_first].atMs : UINT32_MAX;
+  for (size_t i = 0; i < n; i++, _sample++)
+  {
+    uint64_t t = _sample * TICK_HZ / sampleRate;
+    if (_count && t >= (uint64_t)nextMs * (TICK_HZ / 1000))
+    {
+      dispatch(_sample * 1000 / sampleRate);
+      for (uint8_t v = 0; v < _nVoices; v++) if (_fresh[v]) _edgeEnd[v] = t;
+      nextMs = _count ? _events[_first].atMs : UINT32_MAX;
+    }
+
+    int32_t sum = 0;
+    for (uint8_t v = 0; v < _nVoices; v++)
+    {
+      uint8_t level;
+      uint32_t us;
+      while (_edgeEnd[v] <= t)
+      {
+        if (! _voices[v]->pull(level, us))
+        {
+          _level[v] = LOW;
+          _edgeEnd[v] = UINT64_MAX;
+          break;
+        }
+        _level[v] = level;
+        _edgeEnd[v] += (uint64_t)us * PolyPlayer::TICKS_PER_US;
+      }
+      if (_level[v]) sum += amplitude;
+    }
+    samples[i] = sum > INT16_MAX ? INT16_MAX : sum;
+  }
+}
+
+// xorshift32, independent of random() which the birds use
+template <class Cm>
+uint32_t Concert<Cm>::_random()
+{
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return _rng;
+}
+
+template <class Cm>
+uint16_t Concert<Cm>::_pickBird()
+{
+  uint32_t w = _random() % _totalRate;
+  if (! _plan.rates) return Cm::birds().byWeight(w);
+  uint16_t b = 0;
+  while (w >= _plan.rates[b]) w -= _plan.rates[b++];
+  return b;
+}
+
+// Time to the next arrival, exponentially distributed, at most 8 times the mean
+template <class Cm>
+uint32_t Concert<Cm>::_gapMs()
+{
+  double mean = 60000.0 / _plan.birdsPerMinute;
+  double u = (_random() >> 8) / 16777216.0;
+  double gap = -log(1.0 - u) * mean;
+  return gap < 8 * mean ? (uint32_t)gap : (uint32_t)(8 * mean);
+}
+#endif
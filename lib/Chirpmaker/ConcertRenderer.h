@@ -0,0 +1,284 @@
+#ifndef _CONCERTRENDERER_H_
+#define _CONCERTRENDERER_H_
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include "Concert.h"
+
+/**
+ * Renders a long concert on all cores of the host. compile() turns a plan
+ * into a timeline of segments, one per bird: its start, its end and the
+ * seed of random() that draws its parameters. render() cuts the timeline
+ * into chunks at segment starts. A chunk renders its samples on its own:
+ * the birds that began in an earlier chunk are run without output up to
+ * the chunk start, so each chunk carries the phase and the random state of
+ * the birds it continues. The chunks are rendered by a pool of threads and
+ * handed to the callback in order; the samples are the same bit for bit
+ * for any number of threads and any chunk length.
+ *
+ * The mix is that of Concert::render(): each voice adds amplitude while it
+ * is HIGH, sums beyond 16 bit are clipped. A bird waits for a free voice
+ * like in Concert::dispatch(), but from its exact end, not the next ms.
+ *   ConcertRenderer<NullChirpmaker> r;
+ *   r.compile(plan, 4, 3600000, 8);             // an hour on 4 voices
+ *   r.render(44100, WavWriter::block, &wav, 8);  // 8 threads
+ *
+ * Host only: the threads draw from random() states of their own (see
+ * hostOwnRandom()), and each has its own CurveCache.
+ */
+template <class Cm>
+class ConcertRenderer
+{
+  public:
+    static const uint32_t TICK_HZ = PolyPlayer::TICK_HZ;
+    static const uint32_t MS_CHUNK = 5000;   // default length of a chunk
+    using BlockHandler = void (*)(const int16_t *samples, size_t n, void *ctx);
+
+    struct Segment
+    {
+      uint64_t start;   // in ticks of TICK_HZ
+      uint64_t end;
+      uint32_t seed;    // of random() when the bird is started
+      uint16_t bird;
+      uint8_t  voice;
+    };
+
+    void compile(const typename Concert<Cm>::Plan &plan, uint8_t nVoices, uint32_t msLength, unsigned nThreads = 1);
+    uint64_t render(uint32_t sampleRate, BlockHandler handler, void *ctx, unsigned nThreads = 1,
+                    uint32_t msChunk = MS_CHUNK, int16_t amplitude = 8000);
+
+    const std::vector<Segment> &segments() const { return _segments; }
+    uint64_t ticks() const { return _ticks; }       // end of the last bird
+    uint32_t chunks() const { return _chunks; }     // of the last render()
+    uint32_t carried() const { return _carried; }   // birds continued from an earlier chunk
+
+  private:
+    template <class Fn> static void _parallel(size_t n, unsigned nThreads, Fn fn);
+    void _renderChunk(Cm &cm, uint64_t first, uint64_t last, uint32_t sampleRate, int16_t amplitude, std::vector<int16_t> &out) const;
+
+    std::vector<Segment> _segments;
+    uint64_t _ticks = 0;
+    uint64_t _maxTicks = 0;   // longest segment
+    uint32_t _chunks = 0;
+    uint32_t _carried = 0;
+};
+
+/**
+ * Run fn(cm, i) for i = 0 .. n - 1 on nThreads threads, each with a
+ * chirpmaker of its own. One of them is the caller, which keeps its
+ * random() state; the nThreads - 1 it starts get states of their own.
+ */
+template <class Cm>
+template <class Fn>
+void ConcertRenderer<Cm>::_parallel(size_t n, unsigned nThreads, Fn fn)
+{
+  std::atomic<size_t> next{0};
+  auto work = [&]()
+  {
+    std::unique_ptr<Cm> cm(new Cm(0));
+    for (size_t i; (i = next.fetch_add(1)) < n; ) fn(*cm, i);
+  };
+  if (nThreads <= 1) return work();
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < nThreads; t++) threads.emplace_back([&] { hostOwnRandom(); work(); });
+  work();
+  for (std::thread &t : threads) t.join();
+}
+
+/**
+ * Plan the birds of the first msLength ms of a concert on nVoices voices.
+ * The plan draws the birds and their arrivals, each bird gets a seed from
+ * its number and the seed of the plan. Its length is measured by running
+ * it without output, on nThreads threads. Then the voices are assigned in
+ * the order of arrival.
+ */
+template <class Cm>
+void ConcertRenderer<Cm>::compile(const typename Concert<Cm>::Plan &plan, uint8_t nVoices, uint32_t msLength, unsigned nThreads)
+{
+  Concert<Cm> concert;
+  concert.begin(nullptr, nVoices, plan);
+  std::vector<typename Concert<Cm>::Event> events;
+  typename Concert<Cm>::Event e;
+  bool more = true;
+  for (uint32_t nowMs = 0; more && nowMs <= msLength; nowMs += 1000)
+  {
+    for (bool got = true; got && more; )
+    {
+      concert.plan(nowMs);
+      for (got = false; more && concert.next(e); got = true)
+      {
+        if (e.atMs < msLength) events.push_back(e);
+        else more = false;
+      }
+      if (plan.nBirds && concert.planned() >= plan.nBirds && concert.pending() == 0) more = false;
+    }
+  }
+
+  _segments.resize(events.size());
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    uint64_t h = (plan.seed + 1) * 0x9E3779B97F4A7C15ULL ^ (i + 1) * 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 31;
+    _segments[i] = {0, 0, (uint32_t)(h % 2147483646) + 1, events[i].bird, events[i].voice};
+  }
+  _parallel(_segments.size(), nThreads, [this](Cm &cm, size_t i)
+  {
+    Segment &s = _segments[i];
+    randomSeed(s.seed);
+    cm.startBird(s.bird, 0);
+    uint8_t level;
+    uint32_t us;
+    while (cm.pull(level, us)) s.end += (uint64_t)us * PolyPlayer::TICKS_PER_US;
+  });
+
+  // The planned voice, another free one or the first to become free
+  uint8_t voices = nVoices < Concert<Cm>::MAX_VOICES ? nVoices : Concert<Cm>::MAX_VOICES;
+  uint64_t voiceEnd[Concert<Cm>::MAX_VOICES] = {};
+  uint64_t t = 0;
+  _ticks = _maxTicks = 0;
+  for (size_t i = 0; i < _segments.size(); i++)
+  {
+    Segment &s = _segments[i];
+    uint64_t length = s.end;
+    t = std::max(t, (uint64_t)events[i].atMs * (TICK_HZ / 1000));
+    uint8_t v = s.voice;
+    if (voiceEnd[v] > t)
+    {
+      for (uint8_t w = 0; w < voices; w++) if (voiceEnd[w] < voiceEnd[v]) v = w;
+      t = std::max(t, voiceEnd[v]);
+    }
+    s.voice = v;
+    s.start = t;
+    s.end = t + length;
+    voiceEnd[v] = s.end;
+    _ticks = std::max(_ticks, s.end);
+    _maxTicks = std::max(_maxTicks, length);
+  }
+}
+
+/**
+ * Add the birds that sound in samples first .. last - 1 into out. Sample i
+ * has the levels at tick i * TICK_HZ / sampleRate, rounded down.
+ */
+template <class Cm>
+void ConcertRenderer<Cm>::_renderChunk(Cm &cm, uint64_t first, uint64_t last, uint32_t sampleRate, int16_t amplitude, std::vector<int16_t> &out) const
+{
+  auto sampleAt = [sampleRate](uint64_t tick) { return (tick * sampleRate + TICK_HZ - 1) / TICK_HZ; };  // first sample at or after tick
+  uint64_t from = first * TICK_HZ / sampleRate, to = (last * TICK_HZ + sampleRate - 1) / sampleRate;
+  std::vector<int32_t> sum(last - first, 0);
+
+  // The segments that start before the chunk end and may still sound at its start
+  auto it = std::lower_bound(_segments.begin(), _segments.end(), from > _maxTicks ? from - _maxTicks : 0,
+                             [](const Segment &s, uint64_t t) { return s.start < t; });
+  for (; it != _segments.end() && it->start < to; ++it)
+  {
+    if (it->end <= from) continue;
+    randomSeed(it->seed);
+    cm.startBird(it->bird, 0);
+    uint64_t t = it->start;
+    uint8_t level;
+    uint32_t us;
+    while (t < to && cm.pull(level, us))
+    {
+      uint64_t next = t + (uint64_t)us * PolyPlayer::TICKS_PER_US;
+      if (level && next > from)
+      {
+        uint64_t a = std::max(sampleAt(t), first), b = std::min(sampleAt(next), last);
+        for (uint64_t i = a; i < b; i++) sum[i - first] += amplitude;
+      }
+      t = next;
+    }
+  }
+
+  out.resize(sum.size());
+  for (size_t i = 0; i < sum.size(); i++) out[i] = sum[i] > INT16_MAX ? INT16_MAX : sum[i];
+}
+
+/**
+ * Render the compiled concert at sampleRate on nThreads threads, in chunks
+ * of about msChunk ms, 0 for a single chunk. The samples go to handler
+ * chunk by chunk, in order; at most two chunks per thread are in memory.
+ * Returns the number of samples.
+ */
+template <class Cm>
+uint64_t ConcertRenderer<Cm>::render(uint32_t sampleRate, BlockHandler handler, void *ctx, unsigned nThreads, uint32_t msChunk, int16_t amplitude)
+{
+  if (nThreads == 0) nThreads = 1;
+  uint64_t total = (_ticks * sampleRate + TICK_HZ - 1) / TICK_HZ;
+
+  // Chunk boundaries at the first segment start after each msChunk
+  std::vector<uint64_t> bounds = {0};
+  _carried = 0;
+  uint64_t step = (uint64_t)msChunk * (TICK_HZ / 1000), target = step;
+  for (size_t i = 0; msChunk && i < _segments.size(); i++)
+  {
+    if (_segments[i].start < target) continue;
+    uint64_t sample = (_segments[i].start * sampleRate + TICK_HZ - 1) / TICK_HZ;
+    if (sample > bounds.back() && sample < total) bounds.push_back(sample);
+    while (target <= _segments[i].start) target += step;
+  }
+  bounds.push_back(total);
+  _chunks = bounds.size() - 1;
+  for (size_t k = 1; k < _chunks; k++)
+  {
+    uint64_t tick = bounds[k] * TICK_HZ / sampleRate;
+    for (const Segment &s : _segments) if (s.start < tick && s.end > tick) _carried++;
+  }
+
+  if (nThreads == 1)
+  {
+    std::unique_ptr<Cm> cm(new Cm(0));
+    std::vector<int16_t> chunk;
+    for (uint32_t k = 0; k < _chunks; k++)
+    {
+      _renderChunk(*cm, bounds[k], bounds[k + 1], sampleRate, amplitude, chunk);
+      if (handler && chunk.size()) handler(chunk.data(), chunk.size(), ctx);
+    }
+    return total;
+  }
+
+  // The pool takes the chunks in order, at most 2 per thread ahead of the
+  // caller, which hands them on as they are ready
+  std::vector<std::vector<int16_t>> done(_chunks);
+  std::vector<bool> ready(_chunks, false);
+  std::mutex mutex;
+  std::condition_variable changed;
+  uint32_t handed = 0;
+  std::thread pool([&]
+  {
+    hostOwnRandom();
+    _parallel(_chunks, nThreads, [&](Cm &cm, size_t k)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return k < handed + 2 * nThreads; });
+      }
+      std::vector<int16_t> chunk;
+      _renderChunk(cm, bounds[k], bounds[k + 1], sampleRate, amplitude, chunk);
+      std::lock_guard<std::mutex> lock(mutex);
+      done[k].swap(chunk);
+      ready[k] = true;
+      changed.notify_all();
+    });
+  });
+  std::unique_lock<std::mutex> lock(mutex);
+  while (handed < _chunks)
+  {
+    changed.wait(lock, [&] { return ready[handed]; });
+    std::vector<int16_t> chunk;
+    chunk.swap(done[handed]);
+    lock.unlock();
+    if (handler && chunk.size()) handler(chunk.data(), chunk.size(), ctx);
+    lock.lock();
+    handed++;
+    changed.notify_all();
+  }
+  lock.unlock();
+  pool.join();
+  return total;
+}
+#endif
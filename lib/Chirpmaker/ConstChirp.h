@@ -0,0 +1,208 @@
+#ifndef _CONSTCHIRP_H_
+#define _CONSTCHIRP_H_
+#include "ChirpProgram.h"
+
+/**
+ * Chirps with constant parameters compiled at compile time.
+ *
+ * The generator templates of FreqMath.h are evaluated with ConstReal, a
+ * double whose math functions are constexpr, and the periods are merged
+ * into segments exactly like ChirpProgram does. The result is a constexpr
+ * table that ends up in flash, playing it takes no floating point work.
+ *
+ *   static constexpr ConstChirp SPEC = {440, 1320, 6, 300, cosine2PiScaleT<ConstReal>, 50, 1000};
+ *   static constexpr auto TABLE = constCompile<constSegments(SPEC)>(SPEC);
+ *   cm.play(TABLE, 1);
+ *
+ * The tables hold the double results, whatever CHIRPMAKER_NUMERIC is.
+ */
+
+// Range reduction constants: pi/2 and ln(2) split into a high and a low part
+static constexpr double CX_PI_2_HI = 1.57079632679489655800e+00;
+static constexpr double CX_PI_2_LO = 6.12323399573676603587e-17;
+static constexpr double CX_LN2_HI  = 6.93147180369123816490e-01;
+static constexpr double CX_LN2_LO  = 1.90821492927058770002e-10;
+
+constexpr double cxRound(double x) { return (double)(long long)(x >= 0 ? x + 0.5 : x - 0.5); }
+
+// Taylor series of sin and cos for |x| <= pi/4
+constexpr double cxSinPoly(double x)
+{
+  double x2 = x * x, t = 1.0;
+  for (int k = 21; k >= 3; k -= 2) t = 1.0 - x2 / (k * (k - 1)) * t;
+  return x * t;
+}
+
+constexpr double cxCosPoly(double x)
+{
+  double x2 = x * x, t = 1.0;
+  for (int k = 20; k >= 2; k -= 2) t = 1.0 - x2 / (k * (k - 1)) * t;
+  return t;
+}
+
+constexpr double cxSin(double x)
+{
+  double n = cxRound(x / CX_PI_2_HI);
+  double r = (x - n * CX_PI_2_HI) - n * CX_PI_2_LO;
+  switch (((long long)n % 4 + 4) % 4)
+  {
+    case 0:  return cxSinPoly(r);
+    case 1:  return cxCosPoly(r);
+    case 2:  return -cxSinPoly(r);
+    default: return -cxCosPoly(r);
+  }
+}
+
+constexpr double cxCos(double x)
+{
+  double n = cxRound(x / CX_PI_2_HI);
+  double r = (x - n * CX_PI_2_HI) - n * CX_PI_2_LO;
+  switch (((long long)n % 4 + 4) % 4)
+  {
+    case 0:  return cxCosPoly(r);
+    case 1:  return -cxSinPoly(r);
+    case 2:  return -cxCosPoly(r);
+    default: return cxSinPoly(r);
+  }
+}
+
+/**
+ * atan(x) = pi/2 - atan(1/x) for x > 1, on 2 - sqrt(3) .. 1
+ * atan(x) = pi/6 + atan((sqrt(3) x - 1) / (x + sqrt(3))), then the series
+ */
+constexpr double cxAtan(double x)
+{
+  const double sqrt3 = 1.73205080756887729353;
+  if (x < 0) return -cxAtan(-x);
+  if (x > 1) return (CX_PI_2_HI - cxAtan(1.0 / x)) + CX_PI_2_LO;
+  double offset = 0;
+  if (x > 2 - sqrt3)
+  {
+    x = (sqrt3 * x - 1) / (x + sqrt3);
+    offset = CX_PI_2_HI / 3;
+  }
+  double x2 = x * x, t = 0;
+  for (int k = 41; k >= 3; k -= 2) t = x2 * (1.0 / k - t);
+  return offset + (x - x * t);
+}
+
+// exp(x) = 2^n exp(r) with |r| <= ln(2)/2
+constexpr double cxExp(double x)
+{
+  double n = cxRound(x / CX_LN2_HI);
+  double r = (x - n * CX_LN2_HI) - n * CX_LN2_LO;
+  double e = 1.0;
+  for (int k = 22; k >= 1; k--) e = 1.0 + r / k * e;
+  for (; n > 0; n--) e *= 2;
+  for (; n < 0; n++) e /= 2;
+  return e;
+}
+
+// log(x) = e ln(2) + 2 atanh((m - 1) / (m + 1)) with x = m 2^e, sqrt(1/2) <= m < sqrt(2)
+constexpr double cxLog(double x)
+{
+  int e = 0;
+  for (; x >= 1.41421356237309504880; e++) x /= 2;
+  for (; x < 0.70710678118654752440; e--) x *= 2;
+  double z = (x - 1) / (x + 1), z2 = z * z, s = 0;
+  for (int k = 31; k >= 3; k -= 2) s = z2 * (1.0 / k + s);
+  return e * CX_LN2_HI + (2 * (z + z * s) + e * CX_LN2_LO);
+}
+
+/**
+ * double with constexpr math, the number type of the compile time generators
+ */
+struct ConstReal
+{
+  double v;
+
+  constexpr ConstReal(double d = 0) : v(d) {}
+  explicit constexpr operator double() const { return v; }
+  explicit constexpr operator uint32_t() const { return (uint32_t)v; }
+
+  friend constexpr ConstReal operator+(ConstReal a, ConstReal b) { return a.v + b.v; }
+  friend constexpr ConstReal operator-(ConstReal a, ConstReal b) { return a.v - b.v; }
+  friend constexpr ConstReal operator-(ConstReal a) { return -a.v; }
+  friend constexpr ConstReal operator*(ConstReal a, ConstReal b) { return a.v * b.v; }
+  friend constexpr ConstReal operator/(ConstReal a, ConstReal b) { return a.v / b.v; }
+  friend constexpr bool operator<(ConstReal a, ConstReal b) { return a.v < b.v; }
+  friend constexpr bool operator>(ConstReal a, ConstReal b) { return a.v > b.v; }
+
+  friend constexpr ConstReal fabs(ConstReal x) { return x.v < 0 ? -x.v : x.v; }
+  friend constexpr ConstReal sin(ConstReal x) { return cxSin(x.v); }
+  friend constexpr ConstReal cos(ConstReal x) { return cxCos(x.v); }
+  friend constexpr ConstReal atan(ConstReal x) { return cxAtan(x.v); }
+  friend constexpr ConstReal exp(ConstReal x) { return cxExp(x.v); }
+  friend constexpr ConstReal log(ConstReal x) { return cxLog(x.v); }
+};
+
+using ConstGen = ConstReal (*)(int stepNbr, ConstReal fStart, ConstReal fStop, int nSteps);
+
+// The parameters of chirp() except nChirps, which is given to play()
+struct ConstChirp
+{
+  double fStart;
+  double fStop;
+  int nSteps;
+  int nPeriods;
+  ConstGen fgen;
+  int duty;
+  uint32_t msPause;  // 0: no pause in the table
+};
+
+/**
+ * Compile the chirp c into segments, or only count them for segments == nullptr.
+ * Same merging as ChirpProgram::add(), without its size limit.
+ */
+constexpr size_t constCompileInto(const ConstChirp &c, Segment *segments)
+{
+  size_t n = 0;
+  uint32_t lastOn = 0, lastOff = 0, lastCount = 0;
+  for (int s = 0; s <= c.nSteps; s++)
+  {
+    uint32_t tOn = 0, tOff = 0;
+    chirpPeriod(c.fgen(s, ConstReal(c.fStart), ConstReal(c.fStop), c.nSteps), c.duty, tOn, tOff);
+    for (int k = c.nPeriods; k > 0; )
+    {
+      uint16_t count = k > UINT16_MAX ? UINT16_MAX : k;
+      k -= count;
+      if (n > 0 && lastOn == tOn && lastOff == tOff && lastCount <= (uint32_t)(UINT16_MAX - count))
+      {
+        lastCount += count;
+        if (segments) segments[n - 1].count = lastCount;
+        continue;
+      }
+      if (segments) segments[n] = {tOn, tOff, count};
+      n++;
+      lastOn = tOn; lastOff = tOff; lastCount = count;
+    }
+  }
+  if (c.msPause > 0)
+  {
+    if (segments) segments[n] = {0, c.msPause, 0};
+    n++;
+  }
+  return n;
+}
+
+constexpr size_t constSegments(const ConstChirp &c) { return constCompileInto(c, nullptr); }
+
+// A compiled chirp, N = constSegments() of its ConstChirp
+template <size_t N>
+struct ConstProgram
+{
+  Segment segments[N];
+
+  constexpr uint16_t size() const { return N; }
+  const Segment *begin() const { return segments; }
+  const Segment *end() const { return segments + N; }
+};
+
+template <size_t N>
+constexpr ConstProgram<N> constCompile(const ConstChirp &c)
+{
+  ConstProgram<N> p = {};
+  constCompileInto(c, p.segments);
+  return p;
+}
+#endif
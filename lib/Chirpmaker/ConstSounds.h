@@ -0,0 +1,55 @@
+#ifndef _CONSTSOUNDS_H_
+#define _CONSTSOUNDS_H_
+#include "ConstChirp.h"
+
+/**
+ * The chirps of Chirpmaker whose parameters are all constant, compiled at
+ * compile time (see ConstChirp.h). A random number of repetitions or a
+ * random pause is added when they are played. The tables are constexpr
+ * and thus placed in flash.
+ */
+struct ConstSounds
+{
+  // signet()
+  static constexpr ConstChirp SIGNET_UP_SPEC   = {440, 1320, 6, 300, cosine2PiScaleT<ConstReal>, 50, 1000};
+  static constexpr ConstChirp SIGNET_DOWN_SPEC = {1320, 440, 6, 300, cosine2PiScaleT<ConstReal>, 50, 3000};
+  // phoneCall(), played nTimes
+  static constexpr ConstChirp PHONE_CALL_SPEC  = {667, 557, 2, 20, sinePiScaleT<ConstReal>, 50, 20};
+  // _cuckoo(), the two notes a minor third apart
+  static constexpr float CUCKOO_THIRD = 1.222;
+  static constexpr float CUCKOO_CUC   = 667;
+  static constexpr float CUCKOO_KOO   = CUCKOO_CUC / CUCKOO_THIRD;
+  static constexpr ConstChirp CUCKOO_CUC_SPEC  = {CUCKOO_CUC, CUCKOO_CUC, 1, 46, linearScaleT<ConstReal>, 50, 200};
+  static constexpr ConstChirp CUCKOO_KOO_SPEC  = {CUCKOO_KOO, CUCKOO_KOO, 1, 52, linearScaleT<ConstReal>, 50, 830};
+  // _bird4(), the first chirp with random repetitions, the last one with a random pause
+  static constexpr ConstChirp BIRD4_A_SPEC     = {4000, 4800, 10, 4, atan2PiScaleT<ConstReal>, 50, 20};
+  static constexpr ConstChirp BIRD4_B_SPEC     = {3500, 4300, 15, 10, atanPiScaleT<ConstReal>, 50, 20};
+  static constexpr ConstChirp BIRD4_C_SPEC     = {3500, 3000, 25, 10, sinePiScaleT<ConstReal>, 50, 0};
+  // _bird8()
+  static constexpr ConstChirp BIRD8_SPEC       = {1320, 3880, 5, 10, sine2PiScaleT<ConstReal>, 50, 100};
+  // _bird10(), both with random repetitions
+  static constexpr ConstChirp BIRD10_UP_SPEC   = {1440, 1880, 20, 10, atanPiScaleT<ConstReal>, 5, 10};
+  static constexpr ConstChirp BIRD10_DOWN_SPEC = {1880, 1440, 20, 10, atanPiScaleT<ConstReal>, 50, 30};
+  // _raven(), with random repetitions
+  static constexpr ConstChirp RAVEN_SPEC       = {75, 65, 8, 4, atanPiScaleT<ConstReal>, 20, 550};
+
+  static constexpr auto SIGNET_UP   = constCompile<constSegments(SIGNET_UP_SPEC)>(SIGNET_UP_SPEC);
+  static constexpr auto SIGNET_DOWN = constCompile<constSegments(SIGNET_DOWN_SPEC)>(SIGNET_DOWN_SPEC);
+  static constexpr auto PHONE_CALL  = constCompile<constSegments(PHONE_CALL_SPEC)>(PHONE_CALL_SPEC);
+  static constexpr auto CUCKOO_CUC_TABLE = constCompile<constSegments(CUCKOO_CUC_SPEC)>(CUCKOO_CUC_SPEC);
+  static constexpr auto CUCKOO_KOO_TABLE = constCompile<constSegments(CUCKOO_KOO_SPEC)>(CUCKOO_KOO_SPEC);
+  static constexpr auto BIRD4_A     = constCompile<constSegments(BIRD4_A_SPEC)>(BIRD4_A_SPEC);
+  static constexpr auto BIRD4_B     = constCompile<constSegments(BIRD4_B_SPEC)>(BIRD4_B_SPEC);
+  static constexpr auto BIRD4_C     = constCompile<constSegments(BIRD4_C_SPEC)>(BIRD4_C_SPEC);
+  static constexpr auto BIRD8       = constCompile<constSegments(BIRD8_SPEC)>(BIRD8_SPEC);
+  static constexpr auto BIRD10_UP   = constCompile<constSegments(BIRD10_UP_SPEC)>(BIRD10_UP_SPEC);
+  static constexpr auto BIRD10_DOWN = constCompile<constSegments(BIRD10_DOWN_SPEC)>(BIRD10_DOWN_SPEC);
+  static constexpr auto RAVEN       = constCompile<constSegments(RAVEN_SPEC)>(RAVEN_SPEC);
+
+  // Size of all tables in bytes
+  static constexpr size_t BYTES = sizeof(SIGNET_UP) + sizeof(SIGNET_DOWN) + sizeof(PHONE_CALL) + sizeof(CUCKOO_CUC_TABLE)
+                                + sizeof(CUCKOO_KOO_TABLE) + sizeof(BIRD4_A) + sizeof(BIRD4_B) + sizeof(BIRD4_C) + sizeof(BIRD8)
+                                + sizeof(BIRD10_UP) + sizeof(BIRD10_DOWN) + sizeof(RAVEN);
+  static_assert(BYTES <= 2048, "the constant sound tables have grown beyond their flash budget");
+};
+#endif
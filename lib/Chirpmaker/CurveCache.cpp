@@ -0,0 +1,66 @@
+#include "CurveCache.h"
+
+void CurveCache::clear()
+{
+  _next = 0;
+  _nextEntry = 0;
+  _last = 0;
+  _hits = 0;
+  _misses = 0;
+  for (Entry &e : _entries) e.valid = false;
+}
+
+/**
+ * The curve of generator kind for steps 0 .. nSteps, computed if it is not
+ * cached yet. nPi is only used by the sinc curves. Returns nullptr if the
+ * curve is larger than the whole pool.
+ */
+const Real *CurveCache::get(CurveKind kind, int nSteps, int nPi)
+{
+  if (kind < SINC_NPI_NPI_CURVE) nPi = 0;
+  // A chirp asks once per chunk of steps, mostly for the curve of the last call
+  for (uint8_t k = 0, i = _last; k < MAX_CURVES; k++, i = (i + 1) % MAX_CURVES)
+  {
+    const Entry &e = _entries[i];
+    if (e.valid && e.kind == kind && e.nSteps == nSteps && e.nPi == nPi)
+    {
+      _hits++;
+      _last = i;
+      return _pool + e.offset;
+    }
+  }
+
+  _misses++;
+  uint32_t n = nSteps + 1;
+  if (nSteps < 0 || nSteps > UINT16_MAX || nPi > UINT8_MAX || n > _poolSize) return nullptr;
+  if (_next + n > _poolSize) _next = 0;
+  for (Entry &e : _entries)  // drop the curves that are overwritten
+  {
+    if (e.valid && e.offset < _next + n && _next < e.offset + e.nSteps + 1u) e.valid = false;
+  }
+
+  _last = _nextEntry;
+  Entry &e = _entries[_nextEntry];
+  _nextEntry = (_nextEntry + 1) % MAX_CURVES;
+  e = {_next, (uint16_t)nSteps, (uint8_t)kind, (uint8_t)nPi, true};
+  _next += n;
+  curveT(_pool + e.offset, kind, nSteps, nPi);
+  return _pool + e.offset;
+}
+
+#ifdef ARDUINO
+CurveCache &CurveCache::shared()
+{
+  static Real pool[CHIRPMAKER_CURVE_BYTES / sizeof(Real)];
+  static CurveCache cache(pool, sizeof(pool) / sizeof(pool[0]));
+  return cache;
+}
+#else
+// One cache per thread on the host, for the renderer threads (see ConcertRenderer.h)
+CurveCache &CurveCache::shared()
+{
+  static thread_local Real pool[CHIRPMAKER_CURVE_BYTES / sizeof(Real)];
+  static thread_local CurveCache cache(pool, sizeof(pool) / sizeof(pool[0]));
+  return cache;
+}
+#endif
@@ -0,0 +1,84 @@
+#ifndef _CURVECACHE_H_
+#define _CURVECACHE_H_
+#include "FreqGen.h"
+
+#ifndef CHIRPMAKER_CURVE_BYTES
+#define CHIRPMAKER_CURVE_BYTES 16384
+#endif
+#ifndef CHIRPMAKER_CURVE_STEPS
+#define CHIRPMAKER_CURVE_STEPS 80
+#endif
+
+/**
+ * Keeps the curves (see curveT() in FreqMath.h) of recently used
+ * generators and step counts. The values of a curve lie one after the
+ * other in a pool; when the pool is used up, it is refilled from its start
+ * and the curves that are overwritten drop out, the oldest first.
+ * A curve is computed on the first request and shared by all chirps with
+ * the same generator and step count, whatever their frequencies.
+ * hits() and misses() count the lookups, one per chunk of steps.
+ */
+class CurveCache
+{
+  public:
+    static const uint8_t MAX_CURVES = 64;
+
+    CurveCache(Real *pool, uint32_t poolSize) : _pool(pool), _poolSize(poolSize) { clear(); }
+
+    const Real *get(CurveKind kind, int nSteps, int nPi);
+    void clear();
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+
+    // The cache of the Cached generators, CHIRPMAKER_CURVE_BYTES large
+    static CurveCache &shared();
+
+  private:
+    struct Entry
+    {
+      uint32_t offset;
+      uint16_t nSteps;
+      uint8_t  kind;
+      uint8_t  nPi;
+      bool     valid;
+    };
+
+    Real *_pool;
+    uint32_t _poolSize;
+    uint32_t _next;
+    uint8_t _nextEntry;
+    uint8_t _last;
+    uint32_t _hits;
+    uint32_t _misses;
+    Entry _entries[MAX_CURVES];
+};
+
+/**
+ * A generator object whose curve comes from CurveCache::shared(), so a
+ * chirp costs an affine map per step instead of a sin() or atan().
+ * The frequencies are the same as those of the generator Gen itself.
+ * Chirps of more than CHIRPMAKER_CURVE_STEPS steps are computed by Gen:
+ * their curves push each other out of the pool, and the cache was measured
+ * to be no faster for them (chirptool templates).
+ *   chirp(random(900, 1100), 2000, random(10, 50), 13, 1, Cached<AtanPi>(), 50, 80);
+ */
+template <class Gen>
+struct Cached : BatchGen<Cached<Gen>>
+{
+  Gen gen;
+
+  Cached(Gen g = Gen()) : gen(g) {}
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    const Real *curve = nSteps <= CHIRPMAKER_CURVE_STEPS ? CurveCache::shared().get(Gen::CURVE, nSteps, gen.nPi) : nullptr;
+    if (! curve)
+    {
+      gen.fill(freqs, firstStep, nFreqs, fStart, fStop, nSteps);
+      return;
+    }
+    CurveScale<Real> f(Gen::CURVE, Real(fStart), Real(fStop));
+    for (int i = 0; i < nFreqs; i++) freqs[i] = (double)f(curve[firstStep + i]);
+  }
+};
+#endif
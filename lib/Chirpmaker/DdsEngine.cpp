@@ -0,0 +1,32 @@
+#include "DdsEngine.h"
+
+/**
+ * Set frequency and duty cycle of the following periods. The phase
+ * is kept, so a change of tone does not break the time line.
+ * freq     frequency in Hz, at most tickHz / 2
+ * duty     duty cycle 0..100 %
+ */
+void DdsEngine::setTone(double freq, int duty)
+{
+  double inc = freq * 4294967296.0 / _tickHz + 0.5;
+  _inc = inc < 1.0 ? 1 : inc > 2147483648.0 ? 0x80000000 : (uint32_t)inc;
+  if (duty < 0) duty = 0;
+  if (duty > 100) duty = 100;
+  _threshold = duty == 100 ? 0xFFFFFFFF : (uint32_t)(((uint64_t)duty << 32) / 100);
+}
+
+/**
+ * Number of ticks until the phase reaches the duty threshold (high part)
+ * and until it wraps around (low part). The remainder of the phase is
+ * left for the next period.
+ */
+void DdsEngine::nextPeriod(uint32_t &ticksOn, uint32_t &ticksOff)
+{
+  const uint64_t wrap = 1ULL << 32;
+  uint64_t p = _phase;
+  ticksOn  = p >= _threshold ? 0 : (_threshold - p + _inc - 1) / _inc;
+  p += (uint64_t)ticksOn * _inc;
+  ticksOff = p >= wrap ? 0 : (wrap - p + _inc - 1) / _inc;
+  p += (uint64_t)ticksOff * _inc;
+  _phase = p - wrap;
+}
@@ -0,0 +1,35 @@
+#ifndef _DDSENGINE_H_
+#define _DDSENGINE_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+
+/**
+ * Square wave generator by direct digital synthesis. A 32 bit phase
+ * accumulator advances by inc = f * 2^32 / tickHz every timer tick, the
+ * output is high while the phase is below the duty threshold. The edges are
+ * scheduled in whole ticks, the fraction of a tick left over at an edge stays
+ * in the accumulator and is carried into the next period. So the single
+ * periods jitter by one tick, but any run of periods averages exactly to the
+ * requested frequency (resolution tickHz / 2^32, i.e. 2.3 mHz at 10 MHz)
+ * instead of to the truncated 1000000 / f us of Chirpmaker::chirp.
+ */
+class DdsEngine
+{
+  public:
+    DdsEngine(uint32_t tickHz) : _tickHz(tickHz) {}
+
+    void reset() { _phase = 0; }
+    void setTone(double freq, int duty);
+    void nextPeriod(uint32_t &ticksOn, uint32_t &ticksOff);
+    double frequency() const { return (double)_inc * _tickHz / 4294967296.0; }
+
+  private:
+    uint32_t _tickHz;
+    uint32_t _phase = 0;
+    uint32_t _inc = 1;
+    uint32_t _threshold = 0x80000000;
+};
+#endif
@@ -0,0 +1,232 @@
+#include "FreqGen.h"
+
+/**
+ * The frequency generators, computed with the number type selected by
+ * CHIRPMAKER_NUMERIC (see FreqMath.h for the templates)
+ */
+void linearScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  linearScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void chromaticScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  // We calculate the multiplicator k to get fStop in nSteps
+  // fStop = fStart * k ^ nSteps
+  chromaticScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void sinePiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  sinePiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void sine2PiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  sine2PiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void cosinePiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  cosinePiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void cosine2PiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  cosine2PiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void atanPiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  atanPiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void atan2PiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  atan2PiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void sincScaleNpi_NpiBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi)
+{
+  sincScaleNpi_NpiBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps, nPi);
+}
+
+void sincScaleNpi_0Batch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi)
+{
+  sincScaleNpi_0BatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps, nPi);
+}
+
+void sincScale0_NpiBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi)
+{
+  sincScale0_NpiBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps, nPi);
+}
+
+void chromaticScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  chromaticScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void sinePiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  sinePiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void sine2PiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  sine2PiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void cosinePiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  cosinePiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+void cosine2PiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+{
+  cosine2PiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+}
+
+/**
+ * The scalar generators are batches of one step
+ */
+double linearScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  linearScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double chromaticScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  chromaticScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double sinePiScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  sinePiScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double sine2PiScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  sine2PiScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double cosinePiScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  cosinePiScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double cosine2PiScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  cosine2PiScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double atanPiScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  atanPiScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double atan2PiScale(int stepNbr, double fStart, double fStop,int nSteps)
+{
+  double f;
+  atan2PiScaleBatch(&f, stepNbr, 1, fStart, fStop, nSteps);
+  return f;
+}
+
+double sincScaleNpi_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi)
+{
+  double f;
+  sincScaleNpi_NpiBatch(&f, stepNbr, 1, fStart, fStop, nSteps, nPi);
+  return f;
+}
+
+double sincScaleNpi_0(int stepNbr, double fStart, double fStop,int nSteps, int nPi)
+{
+  double f;
+  sincScaleNpi_0Batch(&f, stepNbr, 1, fStart, fStop, nSteps, nPi);
+  return f;
+}
+
+double sincScale0_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi)
+{
+  double f;
+  sincScale0_NpiBatch(&f, stepNbr, 1, fStart, fStop, nSteps, nPi);
+  return f;
+}
+
+struct BatchEntry
+{
+  double (*fgen)(int, double, double, int);
+  FreqGenBatch batch;
+};
+
+struct SincBatchEntry
+{
+  double (*fgen)(int, double, double, int, int);
+  FreqGenSincBatch batch;
+};
+
+static const BatchEntry batches[] =
+{
+  {linearScale,    linearScaleBatch},
+#if CHIRPMAKER_INCREMENTAL
+  {chromaticScale, chromaticScaleIncBatch},
+  {sinePiScale,    sinePiScaleIncBatch},
+  {sine2PiScale,   sine2PiScaleIncBatch},
+  {cosinePiScale,  cosinePiScaleIncBatch},
+  {cosine2PiScale, cosine2PiScaleIncBatch},
+#else
+  {chromaticScale, chromaticScaleBatch},
+  {sinePiScale,    sinePiScaleBatch},
+  {sine2PiScale,   sine2PiScaleBatch},
+  {cosinePiScale,  cosinePiScaleBatch},
+  {cosine2PiScale, cosine2PiScaleBatch},
+#endif
+  {atanPiScale,    atanPiScaleBatch},
+  {atan2PiScale,   atan2PiScaleBatch},
+};
+
+static const SincBatchEntry sincBatches[] =
+{
+  {sincScaleNpi_Npi, sincScaleNpi_NpiBatch},
+  {sincScaleNpi_0, sincScaleNpi_0Batch},
+  {sincScale0_Npi, sincScale0_NpiBatch},
+};
+
+FreqGenBatch batchOf(FreqGen fgen)
+{
+  for (const BatchEntry &e : batches) if (e.fgen == &fgen) return e.batch;
+  return nullptr;
+}
+
+FreqGenSincBatch batchOf(FreqGenSinc fgen)
+{
+  for (const SincBatchEntry &e : sincBatches) if (e.fgen == &fgen) return e.batch;
+  return nullptr;
+}
+
+void fillSteps(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, FreqGen fgen)
+{
+  FreqGenBatch batch = batchOf(fgen);
+  if (batch) batch(freqs, firstStep, nFreqs, fStart, fStop, nSteps);
+  else for (int i = 0; i < nFreqs; i++) freqs[i] = fgen(firstStep + i, fStart, fStop, nSteps);
+}
+
+void fillSteps(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi, FreqGenSinc fgen)
+{
+  FreqGenSincBatch batch = batchOf(fgen);
+  if (batch) batch(freqs, firstStep, nFreqs, fStart, fStop, nSteps, nPi);
+  else for (int i = 0; i < nFreqs; i++) freqs[i] = fgen(firstStep + i, fStart, fStop, nSteps, nPi);
+}
@@ -0,0 +1,361 @@
+#ifndef _FREQGEN_H_
+#define _FREQGEN_H_
+#include <new>
+#include <string.h>
+#include <type_traits>
+#include "FreqMath.h"
+
+// typedef double (*FreqGen)(int stepNbr, double fStart, double fStop,int nSteps); // is equivalent to "using FreqGen = ... "
+using FreqGen = double (&)(int stepNbr, double fStart, double fStop, int nSteps);
+using FreqGenSinc = double (&)(int stepNbr, double fStart, double fStop, int nSteps, int nPi);
+
+/**
+ * Batch form of a generator: writes the frequencies of the steps
+ * firstStep .. firstStep + nFreqs - 1 into freqs. The values that do not
+ * depend on the step (log(fStop/fStart), atan(PI), the sinc range ...) are
+ * computed once per call instead of once per step.
+ */
+using FreqGenBatch = void (*)(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+using FreqGenSincBatch = void (*)(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi);
+
+double linearScale(int stepNbr, double fStart, double fStop,int nSteps);
+double chromaticScale(int stepNbr, double fStart, double fStop,int nSteps);
+double sinePiScale(int stepNbr, double fStart, double fStop,int nSteps);
+double sine2PiScale(int stepNbr, double fStart, double fStop,int nSteps);
+double cosinePiScale(int stepNbr, double fStart, double fStop,int nSteps);
+double cosine2PiScale(int stepNbr, double fStart, double fStop,int nSteps);
+double atanPiScale(int stepNbr, double fStart, double fStop,int nSteps);
+double atan2PiScale(int stepNbr, double fStart, double fStop,int nSteps);
+
+double sincScaleNpi_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi);
+double sincScale0_Npi(int stepNbr, double fStart, double fStop,int nSteps, int nPi);
+double sincScaleNpi_0(int stepNbr, double fStart, double fStop,int nSteps, int nPi);
+
+void linearScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void chromaticScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void sinePiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void sine2PiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void cosinePiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void cosine2PiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void atanPiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void atan2PiScaleBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+
+void sincScaleNpi_NpiBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi);
+void sincScale0_NpiBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi);
+void sincScaleNpi_0Batch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi);
+
+/**
+ * Incremental batch forms: after the first step of a batch, the sine and
+ * cosine generators advance by a rotation, chromaticScale by a constant
+ * ratio. Every 32 steps the exact value is taken again. The deviation
+ * from the exact frequencies stays below 1e-14 (double), 2e-6 (float)
+ * and 1e-3 (Q16.16) of the span fStop - fStart.
+ */
+void chromaticScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void sinePiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void sine2PiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void cosinePiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+void cosine2PiScaleIncBatch(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+
+/**
+ * With CHIRPMAKER_INCREMENTAL set, ChirpProgram and fillSteps() use the
+ * incremental forms. Off by default, the exact values keep the periods
+ * of the original code.
+ */
+#ifndef CHIRPMAKER_INCREMENTAL
+#define CHIRPMAKER_INCREMENTAL 0
+#endif
+
+// The batch form of a scalar generator of this library, nullptr for any other function
+FreqGenBatch batchOf(FreqGen fgen);
+FreqGenSincBatch batchOf(FreqGenSinc fgen);
+
+/**
+ * Fill freqs with the steps firstStep .. firstStep + nFreqs - 1 of any
+ * generator. The library generators run in their batch form, others are
+ * called step by step.
+ */
+void fillSteps(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, FreqGen fgen);
+void fillSteps(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, int nPi, FreqGenSinc fgen);
+
+/**
+ * Generators as callable objects. Handed to the templated chirp() they
+ * inline into its step loop, parameters such as nPi are bound to the object:
+ *   cm.chirp(1000, 3000, 70, 4, 3, Sinc(3), 50, 20);
+ * fill() computes a range of steps in the batch form of the generator,
+ * operator() a single step with the same value. CURVE names the curve of
+ * the generator for the Cached generators (see CurveCache.h).
+ * pure() tells that the frequencies depend on the arguments and the state
+ * of the object only, so the program cache may keep their segments. A
+ * generator without pure(), a lambda or any other callable, is never cached.
+ */
+template <class Gen>
+struct BatchGen
+{
+  bool pure() const { return true; }
+
+  double operator()(int stepNbr, double fStart, double fStop, int nSteps) const
+  {
+    double f;
+    static_cast<const Gen *>(this)->fill(&f, stepNbr, 1, fStart, fStop, nSteps);
+    return f;
+  }
+};
+
+struct Linear : BatchGen<Linear>
+{
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    linearScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct Chromatic : BatchGen<Chromatic>
+{
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    if (CHIRPMAKER_INCREMENTAL) chromaticScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+    else chromaticScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct SinePi : BatchGen<SinePi>
+{
+  static constexpr CurveKind CURVE = SINE_PI_CURVE;
+  static constexpr int nPi = 0;
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    if (CHIRPMAKER_INCREMENTAL) sinePiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+    else sinePiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct Sine2Pi : BatchGen<Sine2Pi>
+{
+  static constexpr CurveKind CURVE = SINE_2PI_CURVE;
+  static constexpr int nPi = 0;
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    if (CHIRPMAKER_INCREMENTAL) sine2PiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+    else sine2PiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct CosinePi : BatchGen<CosinePi>
+{
+  static constexpr CurveKind CURVE = COSINE_PI_CURVE;
+  static constexpr int nPi = 0;
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    if (CHIRPMAKER_INCREMENTAL) cosinePiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+    else cosinePiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct Cosine2Pi : BatchGen<Cosine2Pi>
+{
+  static constexpr CurveKind CURVE = COSINE_2PI_CURVE;
+  static constexpr int nPi = 0;
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    if (CHIRPMAKER_INCREMENTAL) cosine2PiScaleIncT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+    else cosine2PiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct AtanPi : BatchGen<AtanPi>
+{
+  static constexpr CurveKind CURVE = ATAN_PI_CURVE;
+  static constexpr int nPi = 0;
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    atanPiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+struct Atan2Pi : BatchGen<Atan2Pi>
+{
+  static constexpr CurveKind CURVE = ATAN_2PI_CURVE;
+  static constexpr int nPi = 0;
+
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    atan2PiScaleBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps);
+  }
+};
+
+// sinc over -nPi .. +nPi
+struct Sinc : BatchGen<Sinc>
+{
+  static constexpr CurveKind CURVE = SINC_NPI_NPI_CURVE;
+  int nPi;
+
+  explicit Sinc(int nPi) : nPi(nPi) {}
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    sincScaleNpi_NpiBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps, nPi);
+  }
+};
+
+// sinc over -nPi .. 0
+struct SincNpi_0 : BatchGen<SincNpi_0>
+{
+  static constexpr CurveKind CURVE = SINC_NPI_0_CURVE;
+  int nPi;
+
+  explicit SincNpi_0(int nPi) : nPi(nPi) {}
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    sincScaleNpi_0BatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps, nPi);
+  }
+};
+
+// sinc over 0 .. +nPi
+struct Sinc0_Npi : BatchGen<Sinc0_Npi>
+{
+  static constexpr CurveKind CURVE = SINC_0_NPI_CURVE;
+  int nPi;
+
+  explicit Sinc0_Npi(int nPi) : nPi(nPi) {}
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    sincScale0_NpiBatchT<Real>(freqs, firstStep, nFreqs, Real(fStart), Real(fStop), nSteps, nPi);
+  }
+};
+
+// Adapters for free function generators, fill() uses batchOf() where it can
+struct FreqFn
+{
+  double (*fgen)(int, double, double, int);
+  bool pure() const { return batchOf(*fgen) != nullptr; }  // the functions of this library only
+  double operator()(int stepNbr, double fStart, double fStop, int nSteps) const { return fgen(stepNbr, fStart, fStop, nSteps); }
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    fillSteps(freqs, firstStep, nFreqs, fStart, fStop, nSteps, *fgen);
+  }
+};
+
+struct FreqFnSinc
+{
+  double (*fgen)(int, double, double, int, int);
+  int nPi;
+  bool operator==(const FreqFnSinc &other) const { return fgen == other.fgen && nPi == other.nPi; }  // not the padding
+  bool pure() const { return batchOf(*fgen) != nullptr; }
+  double operator()(int stepNbr, double fStart, double fStop, int nSteps) const { return fgen(stepNbr, fStart, fStop, nSteps, nPi); }
+  void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+  {
+    fillSteps(freqs, firstStep, nFreqs, fStart, fStop, nSteps, nPi, *fgen);
+  }
+};
+
+template <class Gen, class = void>
+struct HasFill : std::false_type {};
+
+template <class Gen>
+struct HasFill<Gen, decltype(std::declval<const Gen &>().fill((double *)nullptr, 0, 0, 0.0, 0.0, 0))> : std::true_type {};
+
+template <class Gen, class = bool>
+struct HasEqual : std::false_type {};
+
+template <class Gen>
+struct HasEqual<Gen, decltype(std::declval<const Gen &>() == std::declval<const Gen &>())> : std::true_type {};
+
+template <class Gen, class = bool>
+struct HasPure : std::false_type {};
+
+template <class Gen>
+struct HasPure<Gen, decltype(std::declval<const Gen &>().pure())> : std::true_type {};
+
+template <class Gen>
+inline bool isPure(const Gen &gen)
+{
+  if constexpr (HasPure<Gen>::value) return gen.pure();
+  else return false;
+}
+
+/**
+ * fillSteps() for any callable with the FreqGen signature: its fill() if
+ * it has one, otherwise step by step
+ */
+template <class Gen>
+inline void fillSteps(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps, const Gen &gen)
+{
+  if constexpr (HasFill<Gen>::value) gen.fill(freqs, firstStep, nFreqs, fStart, fStop, nSteps);
+  else for (int i = 0; i < nFreqs; i++) freqs[i] = gen(firstStep + i, fStart, fStop, nSteps);
+}
+
+/**
+ * Holds any small generator object by value, e.g. in a recorded call.
+ * Costs one indirect call per fill(), not per step. Only pure generators
+ * (see BatchGen) can be compared, any other one is equal to none.
+ */
+class AnyFreqGen
+{
+  public:
+    AnyFreqGen() = default;
+
+    template <class Gen>
+    AnyFreqGen(const Gen &gen) : _ops(isPure(gen) ? &_pureOps<Gen> : &_impureOps<Gen>)
+    {
+      static_assert(sizeof(Gen) <= sizeof(_storage) && std::is_trivially_copyable<Gen>::value,
+                    "generator objects have to be small and trivially copyable");
+      new (_storage) Gen(gen);
+    }
+
+    void fill(double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps) const
+    {
+      _ops->fill(_storage, freqs, firstStep, nFreqs, fStart, fStop, nSteps);
+    }
+
+    double operator()(int stepNbr, double fStart, double fStop, int nSteps) const
+    {
+      double f;
+      fill(&f, stepNbr, 1, fStart, fStop, nSteps);
+      return f;
+    }
+
+    // Same pure generator type with the same state (function, nPi ...)
+    bool operator==(const AnyFreqGen &other) const
+    {
+      return pure() && _ops == other._ops && _ops->same(_storage, other._storage);
+    }
+
+    bool pure() const { return _ops && _ops->same; }
+
+  private:
+    using Fill = void (*)(const void *gen, double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps);
+    using Same = bool (*)(const void *a, const void *b);
+
+    // What a generator type can do, one table per type, so a generator costs a single pointer besides its state
+    struct Ops
+    {
+      Fill fill;
+      Same same;   // nullptr if the generator is not pure
+    };
+
+    template <class Gen>
+    static void _fillAs(const void *gen, double *freqs, int firstStep, int nFreqs, double fStart, double fStop, int nSteps)
+    {
+      fillSteps(freqs, firstStep, nFreqs, fStart, fStop, nSteps, *static_cast<const Gen *>(gen));
+    }
+
+    // The generator's own operator== if it has one, otherwise its bytes, which are its state
+    template <class Gen>
+    static bool _sameAs(const void *a, const void *b)
+    {
+      if constexpr (HasEqual<Gen>::value) return *static_cast<const Gen *>(a) == *static_cast<const Gen *>(b);
+      else return memcmp(a, b, sizeof(Gen)) == 0;
+    }
+
+    template <class Gen> static constexpr Ops _pureOps = {&_fillAs<Gen>, &_sameAs<Gen>};
+    template <class Gen> static constexpr Ops _impureOps = {&_fillAs<Gen>, nullptr};
+
+    alignas(void *) unsigned char _storage[2 * sizeof(void *)] = {};
+    const Ops *_ops = nullptr;
+};
+#endif
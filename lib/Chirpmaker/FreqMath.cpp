@@ -0,0 +1,106 @@
+#include "FreqMath.h"
+
+// Internally the functions work with 30 fractional bits
+static const int64_t ONE_Q30     = 1LL << 30;
+static const int64_t PI_Q30      = 3373259426LL;  // pi * 2^30
+static const int64_t HALF_PI_Q30 = PI_Q30 / 2;
+static const int64_t TWO_PI_Q30  = PI_Q30 * 2;
+static const int64_t LN2_Q30     = 744261118LL;   // ln(2) * 2^30
+
+static inline int64_t mul30(int64_t a, int64_t b) { return (a * b) >> 30; }
+
+static inline Fix16 fromQ30(int64_t v)
+{
+  v = (v + (1 << 13)) >> 14;
+  if (v > INT32_MAX) v = INT32_MAX;
+  if (v < INT32_MIN) v = INT32_MIN;
+  return Fix16::fromRaw((int32_t)v);
+}
+
+/**
+ * Reduced to -pi/2 .. pi/2, then Taylor series up to x^9 (error < 4e-6)
+ */
+Fix16 sin(Fix16 x)
+{
+  int64_t r = ((int64_t)x.raw << 14) % TWO_PI_Q30;
+  if (r > PI_Q30) r -= TWO_PI_Q30;
+  else if (r < -PI_Q30) r += TWO_PI_Q30;
+  if (r > HALF_PI_Q30) r = PI_Q30 - r;
+  else if (r < -HALF_PI_Q30) r = -PI_Q30 - r;
+
+  int64_t x2 = mul30(r, r);
+  int64_t t = ONE_Q30 - x2 / 72;
+  t = ONE_Q30 - mul30(x2, t) / 42;
+  t = ONE_Q30 - mul30(x2, t) / 20;
+  t = ONE_Q30 - mul30(x2, t) / 6;
+  return fromQ30(mul30(r, t));
+}
+
+Fix16 cos(Fix16 x)
+{
+  return sin(Fix16::fromRaw(x.raw + (int32_t)(HALF_PI_Q30 >> 14)));
+}
+
+/**
+ * atan(x) = pi/2 - atan(1/x) for |x| > 1, on 0..1 a polynomial
+ * in x^2 (Abramowitz/Stegun 4.4.49, error < 1e-5)
+ */
+Fix16 atan(Fix16 x)
+{
+  static const int64_t c[] = {(int64_t)(0.0208351 * ONE_Q30), (int64_t)(-0.0851330 * ONE_Q30), (int64_t)(0.1801410 * ONE_Q30),
+                              (int64_t)(-0.3302995 * ONE_Q30), (int64_t)(0.9998660 * ONE_Q30)};
+  bool neg = x.raw < 0;
+  int64_t ax = neg ? -(int64_t)x.raw : x.raw;
+  bool inv = ax > 65536;
+  int64_t z = inv ? (1LL << 46) / ax : ax << 14;
+
+  int64_t z2 = mul30(z, z);
+  int64_t p = c[0];
+  for (int i = 1; i < 5; i++) p = c[i] + mul30(z2, p);
+  int64_t a = mul30(z, p);
+  if (inv) a = HALF_PI_Q30 - a;
+  return fromQ30(neg ? -a : a);
+}
+
+/**
+ * exp(x) = 2^n * exp(r) with |r| <= ln(2)/2, Taylor series up to r^6.
+ * Saturates at the largest Q16.16 number.
+ */
+Fix16 exp(Fix16 x)
+{
+  int64_t x30 = (int64_t)x.raw << 14;
+  int64_t n = (x30 >= 0 ? x30 + LN2_Q30 / 2 : x30 - LN2_Q30 / 2) / LN2_Q30;
+  int64_t r = x30 - n * LN2_Q30;
+
+  int64_t e = ONE_Q30 + r / 6;
+  e = ONE_Q30 + mul30(r, e) / 5;
+  e = ONE_Q30 + mul30(r, e) / 4;
+  e = ONE_Q30 + mul30(r, e) / 3;
+  e = ONE_Q30 + mul30(r, e) / 2;
+  e = ONE_Q30 + mul30(r, e);
+
+  if (n > 16) return Fix16::fromRaw(INT32_MAX);
+  if (n < -30) return Fix16();
+  return fromQ30(n >= 0 ? e << n : e >> -n);
+}
+
+/**
+ * log(x) = e * ln(2) + log(m) with x = m * 2^e and 1 <= m < 2,
+ * log(m) = 2 atanh((m - 1) / (m + 1)) as a series up to z^9.
+ * Returns the smallest Q16.16 number for x <= 0.
+ */
+Fix16 log(Fix16 x)
+{
+  if (x.raw <= 0) return Fix16::fromRaw(INT32_MIN);
+  int b = 30;
+  while (! ((uint32_t)x.raw & (1UL << b))) b--;
+  int64_t m = (int64_t)x.raw << (30 - b);
+  int64_t z = ((m - ONE_Q30) << 30) / (m + ONE_Q30);
+  int64_t z2 = mul30(z, z);
+  int64_t s = ONE_Q30 / 9;
+  s = ONE_Q30 / 7 + mul30(z2, s);
+  s = ONE_Q30 / 5 + mul30(z2, s);
+  s = ONE_Q30 / 3 + mul30(z2, s);
+  s = ONE_Q30 + mul30(z2, s);
+  return fromQ30((b - 16) * LN2_Q30 + 2 * mul30(z, s));
+}
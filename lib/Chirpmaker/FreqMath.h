@@ -0,0 +1,549 @@
+#ifndef _FREQMATH_H_
+#define _FREQMATH_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+#include <cmath>
+
+/**
+ * Numeric types for the frequency generators and the period computation.
+ *
+ * The ESP32 has a single precision FPU only, every double sin(), exp(),
+ * log() or atan() is emulated in software. The generators are therefore
+ * written as templates over the number type and can be run with
+ *   double   the reference, bit for bit the original code
+ *   float    hardware FPU
+ *   Fix16    Q16.16 fixed point, integer arithmetic only
+ *
+ * Which one is used by the scalar generators (linearScale() ...) and by the
+ * period math of chirp() is chosen at compile time with CHIRPMAKER_NUMERIC,
+ * e.g. build_flags = -DCHIRPMAKER_NUMERIC=CHIRPMAKER_FLOAT
+ */
+#define CHIRPMAKER_DOUBLE 0
+#define CHIRPMAKER_FLOAT  1
+#define CHIRPMAKER_FIXED  2
+#ifndef CHIRPMAKER_NUMERIC
+#define CHIRPMAKER_NUMERIC CHIRPMAKER_DOUBLE
+#endif
+
+/**
+ * Q16.16 fixed point number, range -32768 .. 32767.99998, resolution 1.5e-5.
+ * Frequencies, ratios and angles of the generators fit comfortably.
+ * The math functions keep 30 fractional bits internally.
+ */
+class Fix16
+{
+  public:
+    int32_t raw;
+
+    constexpr Fix16() : raw(0) {}
+    constexpr Fix16(int i) : raw(i * 65536) {}
+    constexpr Fix16(double d) : raw((int32_t)(d * 65536.0 + (d >= 0 ? 0.5 : -0.5))) {}
+    static constexpr Fix16 fromRaw(int32_t r) { Fix16 f; f.raw = r; return f; }
+    explicit constexpr operator double() const { return raw / 65536.0; }
+    explicit constexpr operator float() const { return raw / 65536.0f; }
+
+    friend constexpr Fix16 operator+(Fix16 a, Fix16 b) { return fromRaw(a.raw + b.raw); }
+    friend constexpr Fix16 operator-(Fix16 a, Fix16 b) { return fromRaw(a.raw - b.raw); }
+    friend constexpr Fix16 operator-(Fix16 a) { return fromRaw(-a.raw); }
+    friend constexpr Fix16 operator*(Fix16 a, Fix16 b) { return fromRaw((int32_t)(((int64_t)a.raw * b.raw + 0x8000) >> 16)); }
+    friend constexpr Fix16 operator/(Fix16 a, Fix16 b)
+    {
+      return b.raw == 0 ? fromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX) : fromRaw((int32_t)(((int64_t)a.raw * 65536) / b.raw));
+    }
+    friend constexpr bool operator<(Fix16 a, Fix16 b) { return a.raw < b.raw; }
+    friend constexpr bool operator>(Fix16 a, Fix16 b) { return a.raw > b.raw; }
+
+    friend Fix16 fabs(Fix16 x) { return fromRaw(x.raw < 0 ? -x.raw : x.raw); }
+    friend Fix16 sin(Fix16 x);
+    friend Fix16 cos(Fix16 x);
+    friend Fix16 atan(Fix16 x);
+    friend Fix16 exp(Fix16 x);
+    friend Fix16 log(Fix16 x);
+};
+
+#if CHIRPMAKER_NUMERIC == CHIRPMAKER_FIXED
+using Real = Fix16;
+#elif CHIRPMAKER_NUMERIC == CHIRPMAKER_FLOAT
+using Real = float;
+#else
+using Real = double;
+#endif
+
+/**
+ * Period of frequency f split into tOn and tOff us according to duty,
+ * truncated to whole us like the original code of chirp()
+ */
+template <class T>
+constexpr void chirpPeriod(T f, int duty, uint32_t &tOn, uint32_t &tOff)
+{
+  T p = T(1000000.0) / f;
+  tOn  = (uint32_t)(p * T(duty) / T(100.0));
+  tOff = (uint32_t)(p - T(tOn));
+}
+
+// 1000000 does not fit into Q16.16, the period is computed with 64 bit integers
+inline void chirpPeriod(Fix16 f, int duty, uint32_t &tOn, uint32_t &tOff)
+{
+  if (f.raw <= 0) { tOn = tOff = 0; return; }
+  uint64_t p = (1000000ULL << 32) / (uint32_t)f.raw;  // period in us, Q16
+  tOn  = (uint32_t)((p * duty / 100) >> 16);
+  tOff = (uint32_t)(p >> 16) - tOn;
+}
+
+/**
+ * x / nSteps * stepNbr, the position of a step within the range x.
+ * In Q16.16 the quotient would lose most of its digits before being
+ * multiplied, so there the product is formed first in 64 bits.
+ */
+template <class T>
+constexpr T stepScale(T x, int stepNbr, int nSteps)
+{
+  T k = x / T(nSteps);
+  return k * T(stepNbr);
+}
+
+constexpr Fix16 stepScale(Fix16 x, int stepNbr, int nSteps)
+{
+  return Fix16::fromRaw((int32_t)((int64_t)x.raw * stepNbr / nSteps));
+}
+
+/**
+ * stepScale() for a fixed range and number of steps, with the
+ * quotient computed only once
+ */
+template <class T>
+struct StepScaler
+{
+  T k;
+  StepScaler(T x, int nSteps) : k(x / T(nSteps)) {}
+  T operator()(int stepNbr) const { return k * T(stepNbr); }
+};
+
+template <>
+struct StepScaler<Fix16>
+{
+  int32_t raw;
+  int nSteps;
+  StepScaler(Fix16 x, int n) : raw(x.raw), nSteps(n) {}
+  Fix16 operator()(int stepNbr) const { return Fix16::fromRaw((int32_t)((int64_t)raw * stepNbr / nSteps)); }
+};
+
+/**
+ * The generators of FreqGen.h as templates over the number type,
+ * see there for their description. They are constexpr for number types
+ * with constexpr math functions (see ConstReal in ConstChirp.h).
+ */
+template <class T>
+constexpr T linearScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  T fNext = fStart + stepScale(fStop - fStart, stepNbr, nSteps);
+  return fNext;
+}
+
+template <class T>
+constexpr T chromaticScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::log; using std::exp;
+  T fNext = fStart * exp(stepScale(log(fStop / fStart), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T sinePiScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::sin;
+  T fa = (fStop - fStart);
+  T fNext = fStart + fa * sin(stepScale(T(PI), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T sine2PiScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::sin;
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  T fNext = fm + fa * sin(stepScale(T(TWO_PI), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T cosinePiScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::cos;
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  T fNext = fm - fa * cos(stepScale(T(PI), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T cosine2PiScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::cos;
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  T fNext = fm - fa * cos(stepScale(T(TWO_PI), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T atanPiScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::atan;
+  T k = (fStop - fStart) / atan(T(PI));
+  T fNext = fStart + k * atan(stepScale(T(PI), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T atan2PiScaleT(int stepNbr, T fStart, T fStop, int nSteps)
+{
+  using std::atan;
+  T k = (fStop - fStart) / atan(T(TWO_PI));
+  T fNext = fStart + k * atan(stepScale(T(TWO_PI), stepNbr, nSteps));
+  return fNext;
+}
+
+template <class T>
+constexpr T sincT(T x)
+{
+  using std::fabs; using std::sin;
+  return fabs(x) < T(0.001) ? T(1.0) : sin(x) / x;
+}
+
+template <class T>
+constexpr T sincScaleNpi_NpiT(int stepNbr, T fStart, T fStop, int nSteps, int nPi)
+{
+  T halfRange = T(nPi) * T(PI);
+  T range = T(2) * halfRange;
+  T fa = (fStop - fStart);
+  T fNext = fStart + fa * sincT(stepScale(range, stepNbr, nSteps) - halfRange);
+  return fNext;
+}
+
+template <class T>
+constexpr T sincScaleNpi_0T(int stepNbr, T fStart, T fStop, int nSteps, int nPi)
+{
+  T range = T(nPi) * T(PI);
+  T fa = (fStop - fStart);
+  T fNext = fStart + fa * sincT(stepScale(range, stepNbr, nSteps) - range);
+  return fNext;
+}
+
+template <class T>
+constexpr T sincScale0_NpiT(int stepNbr, T fStart, T fStop, int nSteps, int nPi)
+{
+  T range = T(nPi) * T(PI);
+  T swap = fStart; fStart = fStop; fStop = swap;
+  T fa = (fStop - fStart);
+  T fNext = fStart + fa * sincT(stepScale(range, stepNbr, nSteps));
+  return fNext;
+}
+
+/**
+ * Batch forms of the generators: the frequencies of the steps
+ * firstStep .. firstStep + nFreqs - 1 are written to freqs, everything
+ * that does not depend on the step is computed once per call. Each value
+ * is the same as that of the scalar template.
+ */
+template <class T, class Out>
+void linearScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  StepScaler<T> df(fStop - fStart, nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart + df(firstStep + i));
+}
+
+template <class T, class Out>
+void chromaticScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::log; using std::exp;
+  StepScaler<T> k(log(fStop / fStart), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart * exp(k(firstStep + i)));
+}
+
+template <class T, class Out>
+void sinePiScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::sin;
+  T fa = (fStop - fStart);
+  StepScaler<T> k(T(PI), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart + fa * sin(k(firstStep + i)));
+}
+
+template <class T, class Out>
+void sine2PiScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::sin;
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  StepScaler<T> k(T(TWO_PI), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fm + fa * sin(k(firstStep + i)));
+}
+
+template <class T, class Out>
+void cosinePiScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::cos;
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  StepScaler<T> k(T(PI), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fm - fa * cos(k(firstStep + i)));
+}
+
+template <class T, class Out>
+void cosine2PiScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::cos;
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  StepScaler<T> k(T(TWO_PI), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fm - fa * cos(k(firstStep + i)));
+}
+
+template <class T, class Out>
+void atanPiScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::atan;
+  T k = (fStop - fStart) / atan(T(PI));
+  StepScaler<T> x(T(PI), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart + k * atan(x(firstStep + i)));
+}
+
+template <class T, class Out>
+void atan2PiScaleBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::atan;
+  T k = (fStop - fStart) / atan(T(TWO_PI));
+  StepScaler<T> x(T(TWO_PI), nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart + k * atan(x(firstStep + i)));
+}
+
+template <class T, class Out>
+void sincScaleNpi_NpiBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps, int nPi)
+{
+  T halfRange = T(nPi) * T(PI);
+  T range = T(2) * halfRange;
+  T fa = (fStop - fStart);
+  StepScaler<T> k(range, nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart + fa * sincT(k(firstStep + i) - halfRange));
+}
+
+template <class T, class Out>
+void sincScaleNpi_0BatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps, int nPi)
+{
+  T range = T(nPi) * T(PI);
+  T fa = (fStop - fStart);
+  StepScaler<T> k(range, nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStart + fa * sincT(k(firstStep + i) - range));
+}
+
+template <class T, class Out>
+void sincScale0_NpiBatchT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps, int nPi)
+{
+  T range = T(nPi) * T(PI);
+  T fa = (fStart - fStop);
+  StepScaler<T> k(range, nSteps);
+  for (int i = 0; i < nFreqs; i++) freqs[i] = (Out)(fStop + fa * sincT(k(firstStep + i)));
+}
+
+/**
+ * sin and cos of the evenly spaced angles range / nSteps * step, the next
+ * step by a rotation with four multiplies. To bound the drift the pair is
+ * set from sin() and cos() at every multiple of RENORM steps, the value of
+ * a step therefore does not depend on the step a batch started with.
+ */
+template <class T>
+class SinCosStepper
+{
+  public:
+    static const int RENORM = 32;
+
+    SinCosStepper(T range, int nSteps, int step) : _x(range, nSteps), _step(step)
+    {
+      using std::sin; using std::cos;
+      _cd = cos(_x(1));
+      _sd = sin(_x(1));
+      int anchor = step - step % RENORM;
+      _anchor(anchor);
+      for (int s = anchor; s < step; s++) _rotate();
+    }
+
+    T sine() const { return _s; }
+    T cosine() const { return _c; }
+    void next() { if (++_step % RENORM == 0) _anchor(_step); else _rotate(); }
+
+  private:
+    void _anchor(int step) { using std::sin; using std::cos; _s = sin(_x(step)); _c = cos(_x(step)); }
+    void _rotate()
+    {
+      T c = _c * _cd - _s * _sd;
+      _s = _s * _cd + _c * _sd;
+      _c = c;
+    }
+
+    StepScaler<T> _x;
+    int _step;
+    T _s, _c, _sd, _cd;
+};
+
+/**
+ * exp(range / nSteps * step), the next step by one multiply with the
+ * constant ratio of two steps, renormalized like SinCosStepper
+ */
+template <class T>
+class ExpStepper
+{
+  public:
+    static const int RENORM = 32;
+
+    ExpStepper(T range, int nSteps, int step) : _x(range, nSteps), _step(step)
+    {
+      using std::exp;
+      _m = exp(_x(1));
+      int anchor = step - step % RENORM;
+      _e = exp(_x(anchor));
+      for (int s = anchor; s < step; s++) _e = _e * _m;
+    }
+
+    T value() const { return _e; }
+    void next() { using std::exp; if (++_step % RENORM == 0) _e = exp(_x(_step)); else _e = _e * _m; }
+
+  private:
+    StepScaler<T> _x;
+    int _step;
+    T _e, _m;
+};
+
+/**
+ * Incremental batch forms of the generators with a sin(), cos() or exp()
+ * per step, see SinCosStepper and ExpStepper. The values differ from the
+ * exact ones by the drift of at most RENORM - 1 recurrence steps.
+ */
+template <class T, class Out>
+void chromaticScaleIncT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  using std::log;
+  ExpStepper<T> e(log(fStop / fStart), nSteps, firstStep);
+  for (int i = 0; i < nFreqs; i++, e.next()) freqs[i] = (Out)(fStart * e.value());
+}
+
+template <class T, class Out>
+void sinePiScaleIncT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  T fa = (fStop - fStart);
+  SinCosStepper<T> x(T(PI), nSteps, firstStep);
+  for (int i = 0; i < nFreqs; i++, x.next()) freqs[i] = (Out)(fStart + fa * x.sine());
+}
+
+template <class T, class Out>
+void sine2PiScaleIncT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  SinCosStepper<T> x(T(TWO_PI), nSteps, firstStep);
+  for (int i = 0; i < nFreqs; i++, x.next()) freqs[i] = (Out)(fm + fa * x.sine());
+}
+
+template <class T, class Out>
+void cosinePiScaleIncT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  SinCosStepper<T> x(T(PI), nSteps, firstStep);
+  for (int i = 0; i < nFreqs; i++, x.next()) freqs[i] = (Out)(fm - fa * x.cosine());
+}
+
+template <class T, class Out>
+void cosine2PiScaleIncT(Out *freqs, int firstStep, int nFreqs, T fStart, T fStop, int nSteps)
+{
+  T fm = (fStart + fStop) / T(2.0);
+  T fa = (fStop - fStart) / T(2.0);
+  SinCosStepper<T> x(T(TWO_PI), nSteps, firstStep);
+  for (int i = 0; i < nFreqs; i++, x.next()) freqs[i] = (Out)(fm - fa * x.cosine());
+}
+
+/**
+ * All generators but linearScale and chromaticScale are an affine map of
+ * a curve that depends on the step count only, f(s) = a + b * curve(s)
+ * or a - b * curve(s). curveT() computes the curve for the steps
+ * 0 .. nSteps, CurveScale holds a and b of a chirp. Together they give the
+ * value of the batch generator bit for bit, so a curve can be computed once
+ * and be reused for any fStart and fStop.
+ */
+enum CurveKind : uint8_t
+{
+  SINE_PI_CURVE, SINE_2PI_CURVE, COSINE_PI_CURVE, COSINE_2PI_CURVE, ATAN_PI_CURVE, ATAN_2PI_CURVE,
+  SINC_NPI_NPI_CURVE, SINC_NPI_0_CURVE, SINC_0_NPI_CURVE
+};
+
+template <class T>
+void curveT(T *curve, CurveKind kind, int nSteps, int nPi)
+{
+  using std::sin; using std::cos; using std::atan;
+  bool pi = kind == SINE_PI_CURVE || kind == COSINE_PI_CURVE || kind == ATAN_PI_CURVE;
+  StepScaler<T> x(pi ? T(PI) : T(TWO_PI), nSteps);
+  T halfRange = T(nPi) * T(PI);
+  StepScaler<T> sx(kind == SINC_NPI_NPI_CURVE ? T(2) * halfRange : halfRange, nSteps);
+  for (int s = 0; s <= nSteps; s++)
+  {
+    switch (kind)
+    {
+      case SINE_PI_CURVE:
+      case SINE_2PI_CURVE:     curve[s] = sin(x(s)); break;
+      case COSINE_PI_CURVE:
+      case COSINE_2PI_CURVE:   curve[s] = cos(x(s)); break;
+      case ATAN_PI_CURVE:
+      case ATAN_2PI_CURVE:     curve[s] = atan(x(s)); break;
+      case SINC_NPI_NPI_CURVE:
+      case SINC_NPI_0_CURVE:   curve[s] = sincT(sx(s) - halfRange); break;
+      case SINC_0_NPI_CURVE:   curve[s] = sincT(sx(s)); break;
+    }
+  }
+}
+
+template <class T>
+struct CurveScale
+{
+  T a, b;
+  bool minus;
+
+  CurveScale(CurveKind kind, T fStart, T fStop) : a(fStart), b(fStop - fStart), minus(false)
+  {
+    using std::atan;
+    switch (kind)
+    {
+      case SINE_2PI_CURVE:
+      case COSINE_PI_CURVE:
+      case COSINE_2PI_CURVE:
+        a = (fStart + fStop) / T(2.0);
+        b = (fStop - fStart) / T(2.0);
+        minus = kind != SINE_2PI_CURVE;
+        break;
+      case ATAN_PI_CURVE:
+      {
+        static const T atanPi = atan(T(PI));
+        b = (fStop - fStart) / atanPi;
+        break;
+      }
+      case ATAN_2PI_CURVE:
+      {
+        static const T atan2Pi = atan(T(TWO_PI));
+        b = (fStop - fStart) / atan2Pi;
+        break;
+      }
+      case SINC_0_NPI_CURVE:
+        a = fStop;
+        b = fStart - fStop;
+        break;
+      default:
+        break;
+    }
+  }
+
+  T operator()(T curve) const { return minus ? a - b * curve : a + b * curve; }
+};
+#endif
@@ -0,0 +1,138 @@
+#ifndef ARDUINO
+#include "HostArduino.h"
+
+struct hw_timer_t
+{
+  bool     used;
+  uint16_t divider;
+  uint64_t alarm;       // alarm value in timer ticks
+  bool     autoreload;
+  bool     alarmEnabled;
+  uint64_t zeroCycle;   // virtual cycle at which the counter was 0
+  void   (*fn)(void);
+};
+
+static uint64_t      _now = 0;
+static hw_timer_t    _timers[4];
+static uint8_t       _levels[40];
+static HostEdgeHook  _edgeHook = nullptr;
+static HostRandomHook _randomHook = nullptr;
+static unsigned long _seed = 1;
+static thread_local unsigned long *_threadSeed = nullptr;   // set by hostOwnRandom()
+static uint64_t      _isrLatency = 0;
+
+void hostSetEdgeHook(HostEdgeHook hook) { _edgeHook = hook; }
+
+void hostSetRandomHook(HostRandomHook hook) { _randomHook = hook; }
+
+void hostSetIsrLatency(uint32_t cycles) { _isrLatency = cycles; }
+
+uint64_t hostNow() { return _now; }
+
+/**
+ * Let virtual time pass. Alarms that fall due are fired in chronological
+ * order with the clock set to their due time plus the ISR latency, so an
+ * ISR that calls digitalWrite() stamps its edge with the time the hardware
+ * would. An autoreload timer restarts at the alarm itself, as the hardware
+ * does.
+ */
+void hostAdvance(uint64_t cycles)
+{
+  uint64_t target = _now + cycles;
+  for (;;)
+  {
+    hw_timer_t *next = nullptr;
+    uint64_t due = target;
+    for (hw_timer_t &t : _timers)
+    {
+      if (! t.used || ! t.alarmEnabled || t.fn == nullptr) continue;
+      uint64_t d = t.zeroCycle + t.alarm * t.divider;
+      if (d < _now) d = _now;
+      if (d + _isrLatency <= due) { due = d + _isrLatency; next = &t; }
+    }
+    if (next == nullptr) break;
+    _now = due;
+    if (next->autoreload) next->zeroCycle = _now - _isrLatency;
+    else next->alarmEnabled = false;
+    next->fn();
+  }
+  _now = target;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin < sizeof(_levels) && _levels[pin] == val) return;
+  if (pin < sizeof(_levels)) _levels[pin] = val;
+  if (_edgeHook) _edgeHook(pin, val, _now);
+}
+
+int digitalRead(uint8_t pin) { return pin < sizeof(_levels) ? _levels[pin] : LOW; }
+
+void delay(uint32_t ms) { hostAdvance((uint64_t)ms * (HOST_APB_HZ / 1000)); }
+
+void delayMicroseconds(uint32_t us) { hostAdvance((uint64_t)us * (HOST_APB_HZ / 1000000)); }
+
+uint32_t micros() { return _now / (HOST_APB_HZ / 1000000); }
+
+uint32_t millis() { return _now / (HOST_APB_HZ / 1000); }
+
+void yield() { hostAdvance(HOST_APB_HZ / 1000000); }
+
+// Park-Miller minimal standard generator, so runs are reproducible (not the sequence of any libc rand())
+long random(long howbig)
+{
+  if (howbig <= 0) return 0;
+  if (_randomHook) return _randomHook(howbig);
+  unsigned long &seed = _threadSeed ? *_threadSeed : _seed;
+  seed = (16807UL * seed) % 2147483647UL;
+  return seed % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) { if (seed != 0) (_threadSeed ? *_threadSeed : _seed) = seed % 2147483647UL; }
+
+void hostOwnRandom()
+{
+  static thread_local unsigned long seed = 1;
+  _threadSeed = &seed;
+}
+
+hw_timer_t *timerBegin(uint8_t timer, uint16_t divider, bool countUp)
+{
+  (void)countUp;
+  if (timer >= 4) return nullptr;
+  hw_timer_t *t = &_timers[timer];
+  *t = hw_timer_t();
+  t->used = true;
+  t->divider = divider;
+  t->zeroCycle = _now;
+  return t;
+}
+
+void timerEnd(hw_timer_t *timer) { timer->used = false; }
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) { (void)edge; timer->fn = fn; }
+
+void timerDetachInterrupt(hw_timer_t *timer) { timer->fn = nullptr; }
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarmValue, bool autoreload)
+{
+  timer->alarm = alarmValue;
+  timer->autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t *timer) { timer->alarmEnabled = true; }
+
+void timerAlarmDisable(hw_timer_t *timer) { timer->alarmEnabled = false; }
+
+void timerWrite(hw_timer_t *timer, uint64_t val) { timer->zeroCycle = _now - val * timer->divider; }
+
+uint64_t timerRead(hw_timer_t *timer) { return (_now - timer->zeroCycle) / timer->divider; }
+#endif
@@ -0,0 +1,78 @@
+#ifndef _HOSTARDUINO_H_
+#define _HOSTARDUINO_H_
+/**
+ * Minimal stand-in for the parts of Arduino.h and esp32-hal-timer.h used by
+ * the Chirpmaker library, so that it can be built and checked on a Linux host
+ * (PlatformIO env:native).
+ *
+ * Time is virtual and counted in APB cycles (80 MHz, 12.5 ns) just like the
+ * ESP32 hardware timers. delay(), delayMicroseconds() and yield() advance the
+ * virtual clock and fire every timer alarm that falls due on the way, so an
+ * interrupt driven player runs exactly as it would on the chip.
+ *
+ * digitalWrite() does not touch any hardware, it reports each level change
+ * together with its virtual time stamp to an optional edge hook.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH 0x1
+#define LOW  0x0
+#define OUTPUT 0x03
+
+#define PI      3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI  6.283185307179586476925286766559
+
+#define IRAM_ATTR
+#define GPIO_NUM_4 4
+
+const uint32_t HOST_APB_HZ = 80000000;  // virtual clock runs at APB frequency
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint32_t micros();
+uint32_t millis();
+void yield();
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// Critical sections are no-ops: the simulated timers fire their ISRs in the
+// thread that advances the clock, so a timer player and its ISR never run
+// at once. Other host threads must not share a player with it.
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)     ((void)(mux))
+#define portEXIT_CRITICAL(mux)      ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)  ((void)(mux))
+
+// Simulated hardware timers (subset of the arduino-esp32 2.x timer API)
+struct hw_timer_t;
+hw_timer_t *timerBegin(uint8_t timer, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t *timer);
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t *timer);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerAlarmDisable(hw_timer_t *timer);
+void timerWrite(hw_timer_t *timer, uint64_t val);
+uint64_t timerRead(hw_timer_t *timer);
+
+// Host only: access to the virtual clock and the recorded pin activity
+using HostEdgeHook = void (*)(uint8_t pin, uint8_t level, uint64_t cycle);
+void hostSetEdgeHook(HostEdgeHook hook);
+using HostRandomHook = long (*)(long howbig);
+void hostSetRandomHook(HostRandomHook hook);  // replaces random(howbig) > 0, nullptr: Park-Miller again
+void hostOwnRandom();                   // random() and randomSeed() of the calling thread use a state of its own
+void hostSetIsrLatency(uint32_t cycles);  // delay between an alarm and its ISR, 0 by default
+uint64_t hostNow();                     // virtual time in APB cycles
+void hostAdvance(uint64_t cycles);      // let virtual time pass, firing due alarms
+#endif
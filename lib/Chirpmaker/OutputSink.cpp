@@ -0,0 +1,253 @@
+#include "OutputSink.h"
+#include <math.h>
+#include <string.h>
+#ifdef ARDUINO
+#include "driver/i2s.h"
+#endif
+#if defined(CHIRPMAKER_NO_SIMD)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+static const uint16_t HALF = BlepSink::TAPS / 2;
+
+/**
+ * The BLEP residual, row p for a step p / PHASES of a sample before the
+ * first sample after it, one value per tap. The low pass is a sinc cut off
+ * at 0.42 of the sample rate in a Kaiser window (beta 8) over the taps.
+ * The table is computed on first use and lives on the heap, 8 KB.
+ */
+const float *BlepSink::_residual()
+{
+  static float *table = nullptr;
+  if (table) return table;
+  const int SUB = 16;                                  // integration steps per phase
+  const double fc = 0.42, beta = 8;
+  auto i0 = [](double x) { double s = 1, t = 1; for (int k = 1; k < 25; k++) { t *= x * x / (4.0 * k * k); s += t; } return s; };
+  auto kernel = [&](double x)
+  {
+    double w = 1 - (x * x) / (HALF * HALF);
+    double sinc = x == 0 ? 2 * fc : sin(2 * M_PI * fc * x) / (M_PI * x);
+    return w > 0 ? sinc * i0(beta * sqrt(w)) / i0(beta) : 0.0;
+  };
+
+  // The step of the low pass at x = -HALF + i / PHASES, integrated with the trapezoid rule
+  const int N = TAPS * PHASES;
+  double *step = new double[N + 1];
+  step[0] = 0;
+  double dx = 1.0 / (PHASES * SUB);
+  for (int i = 0; i < N; i++)
+  {
+    double sum = 0, x = -HALF + (double)i / PHASES;
+    for (int k = 0; k < SUB; k++) sum += (kernel(x + k * dx) + kernel(x + (k + 1) * dx)) * dx / 2;
+    step[i + 1] = step[i] + sum;
+  }
+
+  float *t = new float[(PHASES + 1) * TAPS];
+  for (int p = 0; p <= PHASES; p++)
+  {
+    for (int j = 0; j < TAPS; j++)
+    {
+      int i = j * PHASES + p;                          // x = j - HALF + p / PHASES, x >= 0 after the step
+      double s = step[i] / step[N];
+      t[p * TAPS + j] = s - (j >= HALF ? 1 : 0);
+    }
+  }
+  delete[] step;
+  table = t;
+  return table;
+}
+
+void BlepSink::setOutput(uint32_t sampleRate, BlockHandler handler, void *ctx, int16_t amplitude)
+{
+  _table = _residual();
+  _sampleRate = sampleRate; _handler = handler; _ctx = ctx; _amplitude = amplitude;
+  _ticks = 0; _samples = 0; _n = 0; _level = LOW;
+  for (float &v : _buf) v = 0;
+}
+
+/**
+ * A step to level at _ticks. _samples is the first sample after it, at
+ * _n in the buffer; the residual spans HALF samples before and after.
+ */
+void BlepSink::_step(uint8_t level)
+{
+  float h = level ? 2.0f * _amplitude : -2.0f * _amplitude;
+  float d = (float)(_samples * TICK_HZ - _ticks * _sampleRate) / TICK_HZ * PHASES;  // 0 .. PHASES
+  uint16_t p = d;
+  if (p >= PHASES) p = PHASES - 1;
+  float f = d - p;
+  const float *a = _table + p * TAPS, *b = a + TAPS;
+  uint16_t j = _n < HALF ? HALF - _n : 0;            // the samples already emitted stay as they are
+  float *out = _buf + _n - HALF;
+  for (; j < TAPS; j++) out[j] += h * (a[j] + f * (b[j] - a[j]));
+  _level = level;
+}
+
+/**
+ * Add the level to the samples up to end. A full buffer is emitted only
+ * when the next sample is due, so a step can still correct the HALF samples
+ * before it.
+ */
+void BlepSink::_fill(uint64_t end)
+{
+  float v = _level ? _amplitude : -_amplitude;
+  while (_samples < end)
+  {
+    if (_n == BLOCK_SIZE + HALF) _emit();
+    uint64_t run = end - _samples;
+    if (run > (uint64_t)(BLOCK_SIZE + HALF - _n)) run = BLOCK_SIZE + HALF - _n;
+    float *p = _buf + _n;
+    for (uint16_t i = 0; i < run; i++) p[i] += v;
+    _n += run;
+    _samples += run;
+  }
+}
+
+// Hand BLOCK_SIZE samples to the callback, keep the last HALF and the corrections ahead
+void BlepSink::_emit()
+{
+  convert(_buf, _block, BLOCK_SIZE);
+  if (_handler) _handler(_block, BLOCK_SIZE, _ctx);
+  memmove(_buf, _buf + BLOCK_SIZE, TAPS * sizeof(float));
+  memset(_buf + TAPS, 0, BLOCK_SIZE * sizeof(float));
+  _n = HALF;
+}
+
+// Hand on all samples up to _n, a full block first if there are more
+void BlepSink::flush()
+{
+  if (_n > BLOCK_SIZE)
+  {
+    convert(_buf, _block, BLOCK_SIZE);
+    if (_handler) _handler(_block, BLOCK_SIZE, _ctx);
+    memmove(_buf, _buf + BLOCK_SIZE, TAPS * sizeof(float));
+    memset(_buf + TAPS, 0, BLOCK_SIZE * sizeof(float));
+    _n -= BLOCK_SIZE;
+  }
+  convert(_buf, _block, _n);
+  if (_n && _handler) _handler(_block, _n, _ctx);
+  memmove(_buf, _buf + _n, HALF * sizeof(float));
+  memset(_buf + HALF, 0, (BLOCK_SIZE + HALF) * sizeof(float));
+  _n = 0;
+}
+
+/**
+ * Round float samples to the nearest int16 and saturate, 16 samples at a
+ * time with AVX2, 8 with SSE2 or NEON, the rest one by one. All paths give
+ * the same result. CHIRPMAKER_NO_SIMD leaves only the scalar loop.
+ */
+void BlepSink::convert(const float *in, int16_t *out, size_t n)
+{
+  size_t i = 0;
+#if defined(CHIRPMAKER_NO_SIMD)
+#elif defined(__AVX2__)
+  for (; i + 16 <= n; i += 16)
+  {
+    __m256i a = _mm256_cvtps_epi32(_mm256_loadu_ps(in + i));
+    __m256i b = _mm256_cvtps_epi32(_mm256_loadu_ps(in + i + 8));
+    __m256i p = _mm256_packs_epi32(a, b);               // packs within the 128 bit lanes
+    _mm256_storeu_si256((__m256i *)(out + i), _mm256_permute4x64_epi64(p, 0xD8));
+  }
+#elif defined(__SSE2__)
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i a = _mm_cvtps_epi32(_mm_loadu_ps(in + i));
+    __m128i b = _mm_cvtps_epi32(_mm_loadu_ps(in + i + 4));
+    _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(a, b));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 8 <= n; i += 8)
+  {
+    int32x4_t a = vcvtnq_s32_f32(vld1q_f32(in + i));
+    int32x4_t b = vcvtnq_s32_f32(vld1q_f32(in + i + 4));
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+#endif
+  for (; i < n; i++)
+  {
+    float v = in[i] < -32768.0f ? -32768.0f : in[i] > 32767.0f ? 32767.0f : in[i];
+    out[i] = (int16_t)lrintf(v);
+  }
+}
+
+#ifdef ARDUINO
+static void i2sWords(const uint32_t *words, size_t n, void *ctx)
+{
+  (void)ctx;
+  size_t written;
+  i2s_write(I2S_NUM_0, words, n * sizeof(uint32_t), &written, portMAX_DELAY);
+}
+#endif
+
+/**
+ * Start the stream at bitRate. Without a handler, on the ESP32, I2S0 sends
+ * the words to the pin of begin(): one stereo frame of 2 x 32 bits takes
+ * 64 bits, the clock and word select lines are not routed to any pin.
+ */
+void PdmSink::setOutput(uint32_t bitRate, WordHandler handler, void *ctx, int16_t amplitude, const int16_t *wave)
+{
+#ifdef ARDUINO
+  if (! handler)
+  {
+    i2s_config_t config = {};
+    config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX);
+    config.sample_rate = bitRate / 64;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
+    config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+    config.dma_buf_count = 4;
+    config.dma_buf_len = PdmModulator::BLOCK_WORDS / 2;
+    config.tx_desc_auto_clear = true;     // LOW when the stream runs dry
+    i2s_pin_config_t pins = {};
+    pins.mck_io_num = I2S_PIN_NO_CHANGE;
+    pins.bck_io_num = I2S_PIN_NO_CHANGE;
+    pins.ws_io_num = I2S_PIN_NO_CHANGE;
+    pins.data_out_num = _pin;
+    pins.data_in_num = I2S_PIN_NO_CHANGE;
+    i2s_driver_uninstall(I2S_NUM_0);
+    i2s_driver_install(I2S_NUM_0, &config, 0, nullptr);
+    i2s_set_pin(I2S_NUM_0, &pins);
+    handler = i2sWords;
+  }
+#endif
+  _pdm.begin(bitRate, handler, ctx, amplitude, wave);
+  _level = LOW;
+  _periodTicks = 0;
+  _ticks = 0;
+}
+
+// The period since the last rising edge as one cycle of the wave
+void PdmSink::_period()
+{
+  if (_periodTicks == 0) return;
+  _output(_periodTicks, _periodTicks <= MAX_PERIOD_MS * 1000 * TICKS_PER_US);
+  _periodTicks = 0;
+}
+
+/**
+ * ticks more of the stream, a cycle of the wave or silence. The bits are
+ * counted from the start, so no fraction of a bit gets lost. A cycle
+ * shorter than two bits cannot be a tone and is silence.
+ */
+void PdmSink::_output(uint64_t ticks, bool sound)
+{
+  uint64_t bits = _pdm.bits();
+  _ticks += ticks;
+  uint64_t end = _ticks * _pdm.bitRate() / TICK_HZ;
+  if (end <= bits) return;
+  uint32_t n = end - bits;
+  if (sound && n >= 2) _pdm.tone((uint32_t)(4294967296ULL / n), n);   // a cycle of one bit is above Nyquist
+  else _pdm.silence(n);
+}
+
+// Output the period in progress and hand on all words
+void PdmSink::flush()
+{
+  _period();
+  _pdm.flush();
+}
@@ -0,0 +1,311 @@
+#ifndef _OUTPUTSINK_H_
+#define _OUTPUTSINK_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "soc/gpio_struct.h"
+#else
+#include "HostArduino.h"
+#endif
+#include "TimerPlayer.h"
+#include "PdmModulator.h"
+
+/**
+ * Output sink policies of BasicChirpmaker. Every sink provides
+ *
+ *   TICK_HZ, TICKS_PER_US          resolution of the durations it accepts
+ *   void begin(uint8_t pin)        prepare the output
+ *   void set(uint8_t level)        change the level right now
+ *   uint32_t write(level, ticks)   output level for ticks ticks, returns
+ *                                  the us the clock has to wait for it
+ *   uint32_t pause(ms)             stay silent for ms, returns the ms
+ *                                  the clock has to wait for it
+ *
+ * The sinks are resolved at compile time, write() inlines into the period
+ * loop of the chirp.
+ */
+
+// The buzzer pin driven with digitalWrite(), the caller waits
+class GpioSink
+{
+  public:
+    static const uint32_t TICK_HZ = 1000000;
+    static const uint32_t TICKS_PER_US = 1;
+
+    void begin(uint8_t pin) { _pin = pin; pinMode(_pin, OUTPUT); }
+    inline void set(uint8_t level) { digitalWrite(_pin, level); }
+    inline uint32_t write(uint8_t level, uint32_t ticks) { set(level); return ticks; }
+    inline uint32_t pause(uint32_t ms) { return ms; }
+
+  private:
+    uint8_t _pin;
+};
+
+// The buzzer pin driven through the GPIO set/clear registers of the ESP32
+class FastGpioSink
+{
+  public:
+    static const uint32_t TICK_HZ = 1000000;
+    static const uint32_t TICKS_PER_US = 1;
+
+    void begin(uint8_t pin)
+    {
+      _pin = pin;
+      _mask = 1UL << (pin & 31);
+      pinMode(_pin, OUTPUT);
+    }
+
+    inline void set(uint8_t level)
+    {
+#ifdef ARDUINO
+      if (_pin < 32)
+      {
+        if (level) GPIO.out_w1ts = _mask;
+        else GPIO.out_w1tc = _mask;
+      }
+      else
+      {
+        if (level) GPIO.out1_w1ts.val = _mask;
+        else GPIO.out1_w1tc.val = _mask;
+      }
+#else
+      digitalWrite(_pin, level);
+#endif
+    }
+
+    inline uint32_t write(uint8_t level, uint32_t ticks) { set(level); return ticks; }
+    inline uint32_t pause(uint32_t ms) { return ms; }
+
+  private:
+    uint8_t _pin;
+    uint32_t _mask;
+};
+
+// Edges are queued for the hardware timer interrupt, the caller does not wait
+class TimerSink
+{
+  public:
+    static const uint32_t TICK_HZ = TimerPlayer::TICK_HZ;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+
+    void begin(uint8_t pin, uint8_t timerNbr = 0) { _player.begin(pin, timerNbr); _pin = pin; }
+    inline void set(uint8_t level) { digitalWrite(_pin, level); }
+    inline uint32_t write(uint8_t level, uint32_t ticks) { _player.push(level, ticks); return 0; }
+    inline uint32_t pause(uint32_t ms) { _player.push(LOW, ms * 1000 * TICKS_PER_US); return 0; }
+    TimerPlayer &player() { return _player; }
+
+  private:
+    TimerPlayer _player;
+    uint8_t _pin;
+};
+
+// Edges are appended to a caller supplied buffer
+class RecorderSink
+{
+  public:
+    static const uint32_t TICK_HZ = TimerPlayer::TICK_HZ;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+
+    void begin(uint8_t pin) { (void)pin; }
+    void setBuffer(Edge *edges, size_t capacity) { _edges = edges; _capacity = capacity; clear(); }
+    void clear() { _count = 0; _dropped = 0; _ticks = 0; }
+    inline void set(uint8_t level) { write(level, 0); }
+    inline uint32_t write(uint8_t level, uint32_t ticks)
+    {
+      if (_count < _capacity) _edges[_count++] = {ticks, level};
+      else _dropped++;
+      _ticks += ticks;
+      return 0;
+    }
+    inline uint32_t pause(uint32_t ms) { write(LOW, ms * 1000 * TICKS_PER_US); return 0; }
+    size_t count() const { return _count; }
+    size_t dropped() const { return _dropped; }
+    uint64_t ticks() const { return _ticks; }
+    const Edge &operator[](size_t i) const { return _edges[i]; }
+
+  private:
+    Edge *_edges = nullptr;
+    size_t _capacity = 0;
+    size_t _count = 0;
+    size_t _dropped = 0;
+    uint64_t _ticks = 0;
+};
+
+/**
+ * Renders the square wave into 16 bit PCM samples. Each sample takes the
+ * level that is on at its start (no band limiting). Full blocks are handed
+ * to a callback, call flush() at the end for the rest.
+ */
+class PcmSink
+{
+  public:
+    static const uint32_t TICK_HZ = TimerPlayer::TICK_HZ;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+    static const uint16_t BLOCK_SIZE = 256;
+    using BlockHandler = void (*)(const int16_t *samples, size_t n, void *ctx);
+
+    void begin(uint8_t pin) { (void)pin; }
+    void setOutput(uint32_t sampleRate, BlockHandler handler, void *ctx = nullptr, int16_t amplitude = 16000)
+    {
+      _sampleRate = sampleRate; _handler = handler; _ctx = ctx; _amplitude = amplitude;
+      _ticks = 0; _samples = 0; _n = 0;
+    }
+    inline void set(uint8_t level) { _level = level; }
+    inline uint32_t write(uint8_t level, uint32_t ticks)
+    {
+      _ticks += ticks;
+      uint64_t end = _ticks * _sampleRate / TICK_HZ;  // samples that start before the next edge
+      int16_t v = level ? _amplitude : -_amplitude;
+      for (; _samples < end; _samples++)
+      {
+        _block[_n++] = v;
+        if (_n == BLOCK_SIZE) flush();
+      }
+      _level = level;
+      return 0;
+    }
+    inline uint32_t pause(uint32_t ms) { return write(LOW, ms * 1000 * TICKS_PER_US); }
+    void flush() { if (_n && _handler) _handler(_block, _n, _ctx); _n = 0; }
+    uint64_t samples() const { return _samples; }
+
+  private:
+    uint32_t _sampleRate = 44100;
+    BlockHandler _handler = nullptr;
+    void *_ctx = nullptr;
+    int16_t _amplitude = 16000;
+    uint64_t _ticks = 0;
+    uint64_t _samples = 0;
+    uint8_t _level = LOW;
+    int16_t _block[BLOCK_SIZE];
+    uint16_t _n = 0;
+};
+
+/**
+ * Renders the square wave into 16 bit PCM samples without the aliasing of
+ * PcmSink. Every edge is a step at its exact time, and the 32 samples
+ * around it are corrected by a BLEP residual: the step of a Kaiser windowed
+ * sinc low pass minus the naive step, taken from a table of 64 phases. So
+ * pulses of a few % duty at 5 kHz and more can be rendered at 44.1 kHz.
+ * The samples are summed in float and converted block by block to int16
+ * with SSE2/AVX2/NEON where available. Full blocks are handed to a
+ * callback, 16 samples later than PcmSink; call flush() at the end.
+ */
+class BlepSink
+{
+  public:
+    static const uint32_t TICK_HZ = TimerPlayer::TICK_HZ;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+    static const uint16_t BLOCK_SIZE = PcmSink::BLOCK_SIZE;
+    static const uint16_t TAPS = 32;      // samples corrected per edge, half before it
+    static const uint16_t PHASES = 64;    // table resolution per sample
+    using BlockHandler = PcmSink::BlockHandler;
+
+    void begin(uint8_t pin) { (void)pin; }
+    void setOutput(uint32_t sampleRate, BlockHandler handler, void *ctx = nullptr, int16_t amplitude = 16000);
+    inline void set(uint8_t level) { write(level, 0); }
+    inline uint32_t write(uint8_t level, uint32_t ticks)
+    {
+      if (level != _level) _step(level);
+      _ticks += ticks;
+      uint64_t end = (_ticks * _sampleRate + TICK_HZ - 1) / TICK_HZ;  // samples that start before the next edge
+      if (end > _samples) _fill(end);
+      return 0;
+    }
+    inline uint32_t pause(uint32_t ms) { return write(LOW, ms * 1000 * TICKS_PER_US); }
+    void flush();
+    uint64_t samples() const { return _samples; }
+
+    static void convert(const float *in, int16_t *out, size_t n);
+
+  private:
+    static const float *_residual();
+    void _step(uint8_t level);
+    void _fill(uint64_t end);
+    void _emit();
+
+    const float *_table = nullptr;
+    uint32_t _sampleRate = 44100;
+    BlockHandler _handler = nullptr;
+    void *_ctx = nullptr;
+    int16_t _amplitude = 16000;
+    uint64_t _ticks = 0;
+    uint64_t _samples = 0;
+    uint8_t _level = LOW;
+    float _buf[BLOCK_SIZE + TAPS];    // the samples up to _n, corrections of the next ones after it
+    int16_t _block[BLOCK_SIZE];
+    uint16_t _n = 0;
+};
+
+/**
+ * Drives the buzzer with a pulse density stream instead of squares. Each
+ * period of the sound, from one rising edge to the next, becomes one cycle
+ * of a sine (or of another wave table) of the same length, so a chirp keeps
+ * its frequency curve but loses its duty. Periods longer than MAX_PERIOD_MS
+ * and pauses become silence. A period is output when it is complete, one
+ * period late.
+ *
+ * On the ESP32 setOutput() without a handler sends the bits through I2S0
+ * and DMA to the buzzer pin, 32 bit stereo frames at bitRate / 64, and
+ * i2s_write() paces the caller. Elsewhere the words go to the handler.
+ *   PdmChirpmaker cm(PIN_BUZZER);
+ *   cm.sink().setOutput(2560000);
+ *   cm.cuckoo();
+ */
+class PdmSink
+{
+  public:
+    static const uint32_t TICK_HZ = TimerPlayer::TICK_HZ;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+    static const uint32_t BIT_RATE = 2560000;
+    static const uint32_t MAX_PERIOD_MS = 20;
+    using WordHandler = PdmModulator::WordHandler;
+
+    void begin(uint8_t pin) { _pin = pin; }
+    void setOutput(uint32_t bitRate = BIT_RATE, WordHandler handler = nullptr, void *ctx = nullptr, int16_t amplitude = 16384, const int16_t *wave = nullptr);
+    inline void set(uint8_t level) { write(level, 0); }
+    inline uint32_t write(uint8_t level, uint32_t ticks)
+    {
+      if (level && ! _level) _period();   // a rising edge completes the period before it
+      _level = level;
+      _periodTicks += ticks;
+      return 0;
+    }
+    inline uint32_t pause(uint32_t ms)
+    {
+      _period();
+      _level = LOW;
+      _output((uint64_t)ms * 1000 * TICKS_PER_US, false);
+      return 0;
+    }
+    void flush();
+    PdmModulator &modulator() { return _pdm; }
+
+  private:
+    void _period();
+    void _output(uint64_t ticks, bool sound);
+
+    PdmModulator _pdm;
+    uint8_t _pin = 0;
+    uint8_t _level = LOW;
+    uint32_t _periodTicks = 0;   // since the last rising edge
+    uint64_t _ticks = 0;         // output so far
+};
+
+// Discards everything, only counts the edges and their time
+class NullSink
+{
+  public:
+    static const uint32_t TICK_HZ = TimerPlayer::TICK_HZ;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+
+    void begin(uint8_t pin) { (void)pin; }
+    inline void set(uint8_t level) { (void)level; }
+    inline uint32_t write(uint8_t level, uint32_t ticks) { (void)level; _edges++; _ticks += ticks; return 0; }
+    inline uint32_t pause(uint32_t ms) { return write(LOW, ms * 1000 * TICKS_PER_US); }
+    uint32_t edges() const { return _edges; }
+    uint64_t ticks() const { return _ticks; }
+
+  private:
+    uint32_t _edges = 0;
+    uint64_t _ticks = 0;
+};
+#endif
@@ -0,0 +1,109 @@
+#include "PdmModulator.h"
+#include <math.h>
+
+// A sine of TABLE_SIZE + 1 values at full 16 bit scale, computed on first use
+const int16_t *PdmModulator::sine()
+{
+  static const int16_t *table = []
+  {
+    int16_t *t = new int16_t[TABLE_SIZE + 1];
+    for (uint16_t i = 0; i <= TABLE_SIZE; i++) t[i] = (int16_t)lrint(32767 * sin(2 * M_PI * i / TABLE_SIZE));
+    return t;
+  }();
+  return table;
+}
+
+/**
+ * Start a stream of bitRate bits per s. The words go to handler, the wave
+ * (nullptr: sine()) is scaled by amplitude / 32768.
+ */
+void PdmModulator::begin(uint32_t bitRate, WordHandler handler, void *ctx, int16_t amplitude, const int16_t *wave)
+{
+  _bitRate = bitRate;
+  _handler = handler;
+  _ctx = ctx;
+  _amplitude = amplitude;
+  _wave = wave ? wave : sine();
+  _phase = 0;
+  _e1 = _e2 = 0;
+  _word = 0;
+  _fill = 0;
+  _n = 0;
+  _bits = 0;
+}
+
+/**
+ * nBits bits of the wave, its phase advancing by inc per bit. The value of
+ * the wave is taken every 16 bits.
+ */
+void PdmModulator::tone(uint32_t inc, uint32_t nBits)
+{
+  const uint8_t FRAC_BITS = 32 - TABLE_BITS;
+  while (nBits)
+  {
+    uint32_t n = 16 - (_fill & 15);
+    if (n > nBits) n = nBits;
+    uint32_t i = _phase >> FRAC_BITS;
+    int32_t frac = (_phase >> (FRAC_BITS - 14)) & 0x3FFF;
+    int32_t s = _wave[i] + (((_wave[i + 1] - _wave[i]) * frac) >> 14);
+    _run((s * _amplitude) >> 15, n);
+    _phase += inc * n;
+    nBits -= n;
+  }
+}
+
+// nBits bits of silence, an even density of ones and zeros. The next tone starts at phase 0.
+void PdmModulator::silence(uint32_t nBits)
+{
+  while (nBits)
+  {
+    uint32_t n = 32 - _fill;
+    if (n > nBits) n = nBits;
+    _run(0, n);
+    nBits -= n;
+  }
+  _phase = 0;
+}
+
+/**
+ * The modulator proper, n bits of the value x, n <= 32 - _fill. The bit is
+ * the sign of x plus the shaped error, the error is what the bit missed.
+ */
+void PdmModulator::_run(int32_t x, uint32_t n)
+{
+  int32_t e1 = _e1, e2 = _e2;
+  uint32_t word = _word;
+  for (uint32_t k = 0; k < n; k++)
+  {
+    int32_t u = x + 2 * e1 - e2;
+    uint32_t bit = u >= 0;
+    e2 = e1;
+    e1 = u - (bit ? FULL_SCALE : -FULL_SCALE);
+    word = word << 1 | bit;
+  }
+  _e1 = e1;
+  _e2 = e2;
+  _bits += n;
+  _fill += n;
+  if (_fill < 32)
+  {
+    _word = word;
+    return;
+  }
+  _block[_n++] = word;
+  _word = 0;
+  _fill = 0;
+  if (_n == BLOCK_WORDS)
+  {
+    if (_handler) _handler(_block, _n, _ctx);
+    _n = 0;
+  }
+}
+
+// Hand on the words so far, a word begun is filled up with silence
+void PdmModulator::flush()
+{
+  if (_fill) silence(32 - _fill);
+  if (_n && _handler) _handler(_block, _n, _ctx);
+  _n = 0;
+}
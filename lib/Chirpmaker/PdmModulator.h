@@ -0,0 +1,57 @@
+#ifndef _PDMMODULATOR_H_
+#define _PDMMODULATOR_H_
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Second order sigma-delta modulator: turns a wave, a sine by default,
+ * into a 1 bit pulse density stream at a high bit rate. The quantization
+ * error is fed back through (1 - z^-1)^2, which pushes its noise far above
+ * the audio band, where the buzzer and the ear filter it out. Integer
+ * only, a few instructions per bit.
+ *
+ * The wave is a table of TABLE_SIZE + 1 values (the last equal to the
+ * first), read with linear interpolation every 16 bits. Its phase is a 32
+ * bit accumulator, 2^32 is one cycle. The bits are packed MSB first into
+ * 32 bit words and handed to a callback BLOCK_WORDS at a time.
+ *   pdm.begin(2560000, handler);
+ *   pdm.tone(PdmModulator::increment(1000, 2560000), 2560000);   // 1 s of 1 kHz
+ *   pdm.flush();
+ */
+class PdmModulator
+{
+  public:
+    static const uint8_t TABLE_BITS = 10;
+    static const uint16_t TABLE_SIZE = 1 << TABLE_BITS;
+    static const uint16_t BLOCK_WORDS = 256;
+    static const int32_t FULL_SCALE = 32768;    // the level of a 1 bit
+    using WordHandler = void (*)(const uint32_t *words, size_t n, void *ctx);
+
+    void begin(uint32_t bitRate, WordHandler handler, void *ctx = nullptr, int16_t amplitude = 16384, const int16_t *wave = nullptr);
+    void tone(uint32_t inc, uint32_t nBits);
+    void silence(uint32_t nBits);
+    void flush();
+    uint32_t bitRate() const { return _bitRate; }
+    uint64_t bits() const { return _bits; }
+
+    static uint32_t increment(double freq, uint32_t bitRate) { return (uint32_t)(freq / bitRate * 4294967296.0 + 0.5); }
+    static const int16_t *sine();
+
+  private:
+    void _run(int32_t x, uint32_t n);
+
+    uint32_t _bitRate = 2560000;
+    WordHandler _handler = nullptr;
+    void *_ctx = nullptr;
+    int16_t _amplitude = 16384;           // of the wave, at most half of FULL_SCALE keeps the loop stable
+    const int16_t *_wave = nullptr;
+    uint32_t _phase = 0;
+    int32_t _e1 = 0;                      // quantization errors of the last two bits
+    int32_t _e2 = 0;
+    uint32_t _word = 0;
+    uint8_t _fill = 0;                    // bits in _word
+    uint16_t _n = 0;                      // words in _block
+    uint64_t _bits = 0;
+    uint32_t _block[BLOCK_WORDS];
+};
+#endif
@@ -0,0 +1,172 @@
+#include "PolyPlayer.h"
+
+PolyPlayer *PolyPlayer::_active = nullptr;
+
+/**
+ * Start the free running timer the voices share, without any voice
+ * timerNbr   hardware timer 0..3 to be used
+ */
+void PolyPlayer::begin(uint8_t timerNbr)
+{
+  _nVoices = 0;
+  _size = 0;
+  _interrupts = 0;
+  _edges = 0;
+  for (uint8_t v = 0; v < MAX_VOICES; v++) _slot[v] = NONE;
+  _active = this;
+  _timer = timerBegin(timerNbr, DIVIDER, true);
+  timerAttachInterrupt(_timer, &PolyPlayer::_isr, true);
+}
+
+void PolyPlayer::end()
+{
+  flush();
+  timerAlarmDisable(_timer);
+  timerDetachInterrupt(_timer);
+  timerEnd(_timer);
+  _timer = nullptr;
+  _active = nullptr;
+}
+
+/**
+ * Add a voice on pin. Returns its number, -1 if all voices are taken.
+ */
+int8_t PolyPlayer::addVoice(uint8_t pin)
+{
+  if (_nVoices == MAX_VOICES) return -1;
+  Voice &vc = _voices[_nVoices];
+  vc.pin = pin;
+  vc.head.store(0);
+  vc.tail.store(0);
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  return _nVoices++;
+}
+
+/**
+ * Queue an edge of voice. Waits while its queue is full and starts the
+ * voice if it has run dry. Edges of zero length are dropped.
+ * level    HIGH or LOW
+ * ticks    duration of the level in timer ticks
+ */
+void PolyPlayer::push(uint8_t voice, uint8_t level, uint32_t ticks)
+{
+  if (ticks == 0 || voice >= _nVoices) return;
+  Voice &vc = _voices[voice];
+  uint16_t head = vc.head.load(std::memory_order_relaxed);
+  while (((head + 1) & (QUEUE_SIZE - 1)) == vc.tail.load(std::memory_order_acquire)) delay(1);
+  vc.queue[head] = {ticks, level};
+  vc.head.store((head + 1) & (QUEUE_SIZE - 1), std::memory_order_release);
+
+  portENTER_CRITICAL(&_mux);
+  if (_slot[voice] == NONE)
+  {
+    uint64_t now = timerRead(_timer);
+    vc.deadline = now + START_TICKS;
+    _place(_size, voice);
+    _size = _size + 1;
+    _siftUp(_slot[voice]);
+    if (_heap[0] == voice) _arm(now);
+  }
+  portEXIT_CRITICAL(&_mux);
+}
+
+/**
+ * Wait until all voices have played their queued edges
+ */
+void PolyPlayer::flush()
+{
+  while (_size > 0) delay(1);
+}
+
+void IRAM_ATTR PolyPlayer::_isr()
+{
+  if (_active) _active->_serve();
+}
+
+/**
+ * Output the edges of all voices that are due. A voice whose queue is
+ * empty leaves the heap and keeps its last level.
+ */
+void IRAM_ATTR PolyPlayer::_serve()
+{
+  portENTER_CRITICAL_ISR(&_mux);
+  _interrupts = _interrupts + 1;
+  uint64_t now = timerRead(_timer);
+  while (_size > 0 && _voices[_heap[0]].deadline <= now)
+  {
+    uint8_t voice = _heap[0];
+    Voice &vc = _voices[voice];
+    uint16_t tail = vc.tail.load(std::memory_order_relaxed);
+    if (tail == vc.head.load(std::memory_order_acquire))
+    {
+      _slot[voice] = NONE;
+      _size = _size - 1;
+      if (_size > 0)
+      {
+        _place(0, _heap[_size]);
+        _siftDown(0);
+      }
+      continue;
+    }
+    const Edge &e = vc.queue[tail];
+    digitalWrite(vc.pin, e.level);
+    vc.deadline += e.ticks;
+    vc.tail.store((tail + 1) & (QUEUE_SIZE - 1), std::memory_order_release);
+    _edges = _edges + 1;
+    _siftDown(0);
+  }
+  _arm(now);
+  portEXIT_CRITICAL_ISR(&_mux);
+}
+
+/**
+ * Set the alarm to the earliest deadline, never into the past
+ */
+void IRAM_ATTR PolyPlayer::_arm(uint64_t now)
+{
+  if (_size == 0)
+  {
+    timerAlarmDisable(_timer);
+    return;
+  }
+  uint64_t deadline = _voices[_heap[0]].deadline;
+  timerAlarmWrite(_timer, deadline > now ? deadline : now + 1, false);
+  timerAlarmEnable(_timer);
+}
+
+void IRAM_ATTR PolyPlayer::_place(uint8_t i, uint8_t voice)
+{
+  _heap[i] = voice;
+  _slot[voice] = i;
+}
+
+void IRAM_ATTR PolyPlayer::_siftUp(uint8_t i)
+{
+  uint8_t voice = _heap[i];
+  uint64_t deadline = _voices[voice].deadline;
+  while (i > 0)
+  {
+    uint8_t parent = (i - 1) / 2;
+    if (_voices[_heap[parent]].deadline <= deadline) break;
+    _place(i, _heap[parent]);
+    i = parent;
+  }
+  _place(i, voice);
+}
+
+void IRAM_ATTR PolyPlayer::_siftDown(uint8_t i)
+{
+  uint8_t voice = _heap[i];
+  uint64_t deadline = _voices[voice].deadline;
+  for (;;)
+  {
+    uint8_t child = 2 * i + 1;
+    if (child >= _size) break;
+    if (child + 1 < _size && _voices[_heap[child + 1]].deadline < _voices[_heap[child]].deadline) child++;
+    if (_voices[_heap[child]].deadline >= deadline) break;
+    _place(i, _heap[child]);
+    i = child;
+  }
+  _place(i, voice);
+}
@@ -0,0 +1,100 @@
+#ifndef _POLYPLAYER_H_
+#define _POLYPLAYER_H_
+#include "TimerPlayer.h"
+
+#ifndef CHIRPMAKER_VOICES
+#define CHIRPMAKER_VOICES 16
+#endif
+
+/**
+ * Plays up to MAX_VOICES edge streams on as many pins from one hardware
+ * timer. Each voice has its own ring buffer of edges like the TimerPlayer,
+ * the timer counts freely and the voices are kept in a binary min-heap by
+ * the deadline of their next edge. The alarm is set to the earliest
+ * deadline; the ISR outputs the edges of all voices that are due, moves
+ * each one down the heap with its new deadline (O(log N) per edge) and
+ * rearms the alarm. The deadlines are absolute, an edge served late does
+ * not shift the rest of its voice.
+ *
+ * A voice is fed with push(), or from a Chirpmaker started non-blocking:
+ *   cm[v].startBird(b, 20);
+ *   while (poly.feed(v, cm[v])) { ... }    // call again before the queue runs dry
+ * A voice whose queue runs dry drops out of the heap and keeps its last
+ * level, the next push() starts it again START_TICKS later.
+ */
+class PolyPlayer
+{
+  public:
+    static const uint32_t TICK_HZ      = TimerPlayer::TICK_HZ;
+    static const uint16_t DIVIDER      = TimerPlayer::DIVIDER;
+    static const uint32_t TICKS_PER_US = TimerPlayer::TICKS_PER_US;
+    static const uint8_t  MAX_VOICES   = CHIRPMAKER_VOICES;
+    static const uint16_t QUEUE_SIZE   = 64;                 // per voice, must be a power of 2
+    static const uint32_t START_TICKS  = 20 * TICKS_PER_US;  // lead of a voice that starts
+
+    void begin(uint8_t timerNbr = 0);
+    void end();
+    int8_t addVoice(uint8_t pin);
+    uint8_t voices() const { return _nVoices; }
+    void push(uint8_t voice, uint8_t level, uint32_t ticks);
+    void pushUs(uint8_t voice, uint8_t level, uint32_t us) { push(voice, level, us * TICKS_PER_US); }
+    template <class Source>
+    bool feed(uint8_t voice, Source &source);
+    void flush();
+    uint16_t room(uint8_t voice) const { return QUEUE_SIZE - 1 - queued(voice); }
+    uint16_t queued(uint8_t voice) const { return (_voices[voice].head.load() - _voices[voice].tail.load()) & (QUEUE_SIZE - 1); }
+    bool isIdle(uint8_t voice) const { return _slot[voice] == NONE; }
+    bool isIdle() const { return _size == 0; }
+    uint32_t interrupts() const { return _interrupts; }
+    uint32_t edges() const { return _edges; }
+
+  private:
+    static const uint8_t NONE = 0xff;
+
+    struct Voice
+    {
+      uint8_t pin;
+      uint64_t deadline;                // timer tick of the next edge
+      Edge queue[QUEUE_SIZE];
+      std::atomic<uint16_t> head{0};    // written by the producer only
+      std::atomic<uint16_t> tail{0};    // written by the ISR only
+    };
+
+    static void IRAM_ATTR _isr();
+    void IRAM_ATTR _serve();
+    void IRAM_ATTR _arm(uint64_t now);
+    void IRAM_ATTR _siftUp(uint8_t i);
+    void IRAM_ATTR _siftDown(uint8_t i);
+    void IRAM_ATTR _place(uint8_t i, uint8_t voice);
+
+    static PolyPlayer *_active;
+    hw_timer_t *_timer = nullptr;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    Voice _voices[MAX_VOICES];
+    uint8_t _nVoices = 0;
+    volatile uint8_t _heap[MAX_VOICES];   // voices by deadline, the earliest first
+    volatile uint8_t _slot[MAX_VOICES];   // place of each voice in the heap, NONE if idle
+    volatile uint8_t _size = 0;
+    volatile uint32_t _interrupts = 0;
+    volatile uint32_t _edges = 0;
+};
+
+/**
+ * Fill the queue of voice with the edges of source, anything with
+ *   bool pull(uint8_t &level, uint32_t &us)
+ * like a Chirpmaker started with startBird() ... Never waits.
+ * Returns false when the source has no more edges.
+ */
+template <class Source>
+bool PolyPlayer::feed(uint8_t voice, Source &source)
+{
+  uint8_t level;
+  uint32_t us;
+  while (room(voice) > 0)
+  {
+    if (! source.pull(level, us)) return false;
+    push(voice, level, us * TICKS_PER_US);
+  }
+  return true;
+}
+#endif
@@ -0,0 +1,114 @@
+#include "ProgramCache.h"
+
+// FNV-1a over the fields of the key except the generator, which may have padding
+uint32_t ProgramCache::Key::hash() const
+{
+  uint32_t h = 2166136261u;
+  auto mix = [&h](const void *p, size_t n)
+  {
+    for (size_t i = 0; i < n; i++) h = (h ^ static_cast<const uint8_t *>(p)[i]) * 16777619u;
+  };
+  mix(&fStart, sizeof(fStart));
+  mix(&fStop, sizeof(fStop));
+  mix(&nSteps, sizeof(nSteps));
+  mix(&nPeriods, sizeof(nPeriods));
+  mix(&duty, sizeof(duty));
+  mix(&msPause, sizeof(msPause));
+  return h;
+}
+
+/**
+ * The segments of the program compiled for key, nullptr if there is none.
+ * They stay valid until the next insert().
+ */
+const Segment *ProgramCache::find(const Key &key, uint16_t &nSegments)
+{
+  if (! _enabled || ! key.gen.pure()) return nullptr;
+  for (uint8_t i = 0; i < _nPrograms; i++)
+  {
+    Entry &e = _entries[i];
+    if (e.key == key)
+    {
+      _hits++;
+      e.lastUse = ++_clock;
+      nSegments = e.nSegments;
+      return _pool + e.offset;
+    }
+  }
+  _misses++;
+  return nullptr;
+}
+
+/**
+ * Keep the segments of a completely compiled program for key, dropping the
+ * least recently used programs as long as there is no room.
+ * Returns false if the key is new or the program larger than the whole pool.
+ */
+bool ProgramCache::insert(const Key &key, const ChirpProgram &program)
+{
+  uint16_t n = program.size();
+  if (! _enabled || ! key.gen.pure() || n > _poolSegments) return false;
+  if (! _seenBefore(key.hash()))
+  {
+    _rejected++;
+    return false;
+  }
+  while (_nPrograms == MAX_PROGRAMS || _used + n > _poolSegments) _evict();
+
+  Entry &e = _entries[_nPrograms++];
+  e = {key, ++_clock, _used, n};
+  for (uint16_t i = 0; i < n; i++) _pool[_used + i] = program[i];
+  _used += n;
+  return true;
+}
+
+void ProgramCache::clear()
+{
+  _nPrograms = 0;
+  _used = 0;
+  for (uint32_t &h : _recent) h = 0;
+}
+
+// Was the key among the last RECENT_KEYS misses? Otherwise remember it.
+bool ProgramCache::_seenBefore(uint32_t hash)
+{
+  for (uint32_t h : _recent) if (h == hash) return true;
+  _recent[_nextRecent] = hash;
+  _nextRecent = (_nextRecent + 1) % RECENT_KEYS;
+  return false;
+}
+
+// Drop the least recently used program and move the segments behind it down
+void ProgramCache::_evict()
+{
+  uint8_t lru = 0;
+  for (uint8_t i = 1; i < _nPrograms; i++) if (_entries[i].lastUse < _entries[lru].lastUse) lru = i;
+
+  uint16_t gap = _entries[lru].nSegments;
+  for (uint16_t s = _entries[lru].offset; s + gap < _used; s++) _pool[s] = _pool[s + gap];
+  for (uint8_t i = lru; i + 1 < _nPrograms; i++)
+  {
+    _entries[i] = _entries[i + 1];
+    _entries[i].offset -= gap;
+  }
+  _nPrograms--;
+  _used -= gap;
+  _evictions++;
+}
+
+#ifdef ARDUINO
+ProgramCache &ProgramCache::shared()
+{
+  static Segment pool[CHIRPMAKER_PROGRAM_CACHE_BYTES / sizeof(Segment)];
+  static ProgramCache cache(pool, sizeof(pool) / sizeof(pool[0]));
+  return cache;
+}
+#else
+// One cache per thread on the host, like the curve cache
+ProgramCache &ProgramCache::shared()
+{
+  static thread_local Segment pool[CHIRPMAKER_PROGRAM_CACHE_BYTES / sizeof(Segment)];
+  static thread_local ProgramCache cache(pool, sizeof(pool) / sizeof(pool[0]));
+  return cache;
+}
+#endif
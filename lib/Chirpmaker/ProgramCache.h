@@ -0,0 +1,97 @@
+#ifndef _PROGRAMCACHE_H_
+#define _PROGRAMCACHE_H_
+#include "ChirpProgram.h"
+
+#ifndef CHIRPMAKER_PROGRAM_CACHE_BYTES
+#define CHIRPMAKER_PROGRAM_CACHE_BYTES 6144
+#endif
+
+/**
+ * Keeps the segments of recently compiled chirps, so a chirp that is
+ * played again with the same arguments is not compiled again. The key is
+ * everything the segments depend on, the generator included with its type
+ * and state (a FreqFn by its function, a Sinc by its nPi ...); nChirps is
+ * not part of it, it only sets the repeats. Only chirps of pure generators
+ * are kept (see BatchGen): a lambda or a function of the sketch may depend
+ * on more than its arguments, it is compiled every time.
+ * The segments of all programs share a pool supplied by the caller, when
+ * it or the MAX_PROGRAMS entries are used up, the least recently used
+ * programs are dropped and the others moved together.
+ * A program is only kept when its key has been seen shortly before, so
+ * the chirps with random arguments, which hardly ever come again, cost a
+ * lookup and do not push out the programs that do.
+ * A Chirpmaker has no cache unless one is handed to useProgramCache().
+ * shared() is one cache of CHIRPMAKER_PROGRAM_CACHE_BYTES for all of them;
+ * it is not locked, so the Chirpmakers of other tasks need their own.
+ */
+class ProgramCache
+{
+  public:
+    static const uint8_t MAX_PROGRAMS = 32;
+    static const uint8_t RECENT_KEYS = 64;
+
+    ProgramCache(Segment *pool, uint16_t poolSegments) : _pool(pool), _poolSegments(poolSegments) {}
+
+    struct Key
+    {
+      double fStart;
+      double fStop;
+      int nSteps;
+      int nPeriods;
+      int duty;
+      uint32_t msPause;
+      AnyFreqGen gen;
+
+      bool operator==(const Key &k) const
+      {
+        return fStart == k.fStart && fStop == k.fStop && nSteps == k.nSteps && nPeriods == k.nPeriods
+            && duty == k.duty && msPause == k.msPause && gen == k.gen;
+      }
+
+      uint32_t hash() const;
+    };
+
+    const Segment *find(const Key &key, uint16_t &nSegments);
+    bool insert(const Key &key, const ChirpProgram &program);
+    void clear();
+    void enable(bool on) { _enabled = on; if (! on) clear(); }
+    bool isEnabled() const { return _enabled; }
+    uint8_t size() const { return _nPrograms; }
+    uint16_t segments() const { return _used; }
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+    uint32_t evictions() const { return _evictions; }
+    uint32_t rejected() const { return _rejected; }  // programs not kept, seen once only
+    void resetCounters() { _hits = _misses = _evictions = _rejected = 0; }
+    uint16_t poolSegments() const { return _poolSegments; }
+
+    // CHIRPMAKER_PROGRAM_CACHE_BYTES of segments, one cache per thread on the host
+    static ProgramCache &shared();
+
+  private:
+    struct Entry
+    {
+      Key key;
+      uint32_t lastUse;
+      uint16_t offset;
+      uint16_t nSegments;
+    };
+
+    void _evict();
+    bool _seenBefore(uint32_t hash);
+
+    Segment *_pool;
+    uint16_t _poolSegments;
+    Entry _entries[MAX_PROGRAMS];  // in the order of their segments in the pool
+    uint32_t _recent[RECENT_KEYS] = {};  // hashes of the keys that missed last
+    uint8_t _nextRecent = 0;
+    uint8_t _nPrograms = 0;
+    uint16_t _used = 0;
+    uint32_t _clock = 0;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    uint32_t _evictions = 0;
+    uint32_t _rejected = 0;
+    bool _enabled = true;
+};
+#endif
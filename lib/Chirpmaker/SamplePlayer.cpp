@@ -0,0 +1,273 @@
+#include "SamplePlayer.h"
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#ifdef ARDUINO
+#include "driver/i2s.h"
+#endif
+
+// Collect the blocks of a sink, the buffer grows by half
+void SampleClip::block(const int16_t *samples, size_t n, void *self)
+{
+  SampleClip &c = *static_cast<SampleClip *>(self);
+  if (c._failed) return;
+  uint32_t need = bytes(c._format, c._samples + n);
+  if (need > c._capacity)
+  {
+    uint32_t capacity = c._capacity + c._capacity / 2 + need + 4096;
+    uint8_t *p = (uint8_t *)realloc(c._owned, capacity);
+    if (! p)
+    {
+      c._failed = true;
+      return;
+    }
+    c._owned = p;
+    c._capacity = capacity;
+  }
+  switch (c._format)
+  {
+    case PCM8:
+      for (size_t i = 0; i < n; i++) c._owned[c._samples + i] = (uint8_t)(128 + (samples[i] >> 8));
+      break;
+    case PCM16:
+      memcpy(c._owned + c._samples * 2, samples, n * 2);
+      break;
+    case ADPCM:
+      // Coded as the samples come, a block header whenever a block begins
+      for (size_t i = 0; i < n; i++)
+      {
+        uint32_t s = c._samples + i, k = s % Adpcm::BLOCK_SAMPLES;
+        uint8_t *block = c._owned + s / Adpcm::BLOCK_SAMPLES * Adpcm::BLOCK_BYTES;
+        if (k == 0)
+        {
+          block[0] = c._coder.predictor;
+          block[1] = (uint16_t)c._coder.predictor >> 8;
+          block[2] = c._coder.index;
+          memset(block + 3, 0, Adpcm::BLOCK_BYTES - 3);   // the end of a last, short block stays defined
+        }
+        uint8_t code = Adpcm::encode(c._coder, samples[i]);
+        uint8_t &codes = block[Adpcm::HEADER_BYTES + k / 2];
+        codes = k & 1 ? (codes & 15) | code << 4 : code;
+      }
+      break;
+  }
+  c._samples += n;
+}
+
+/**
+ * Start a clip at sampleRate in format, to be filled by block() as the
+ * block handler of a sink and closed by end(). This is how a clip takes
+ * the samples of a BlepSink, while render() uses a PcmSink:
+ *   clip.begin(22050, SampleClip::ADPCM);
+ *   cm.sink().setOutput(22050, SampleClip::block, &clip);
+ *   ...
+ *   cm.sink().flush();
+ *   clip.end();
+ */
+void SampleClip::begin(uint32_t sampleRate, Format format)
+{
+  release();
+  _sampleRate = sampleRate;
+  _format = format;
+  _coder = Adpcm::State();
+}
+
+// Shrink the buffer to the samples. Returns false if the heap ran out.
+bool SampleClip::end()
+{
+  if (_failed)
+  {
+    release();
+    return false;
+  }
+  uint8_t *p = (uint8_t *)realloc(_owned, bytes() + 1);
+  if (p) _owned = p;
+  _data = _owned;
+  return true;
+}
+
+/**
+ * Render sound at sampleRate into a buffer of the heap, just as large as
+ * needed in the end. sound gets ctx along with the PcmChirpmaker, which is
+ * allocated on the heap while it plays. Returns false if the heap ran out.
+ *   clip.render([](PcmChirpmaker &cm, void *) { cm.signet(); }, nullptr, 22050, SampleClip::PCM8);
+ */
+bool SampleClip::render(Sound sound, void *ctx, uint32_t sampleRate, Format format, int16_t amplitude)
+{
+  begin(sampleRate, format);
+  PcmChirpmaker *cm = new (std::nothrow) PcmChirpmaker(0);
+  if (! cm) return false;
+  cm->sink().setOutput(sampleRate, block, this, amplitude);
+  sound(*cm, ctx);
+  cm->sink().flush();
+  delete cm;
+  return end();
+}
+
+// A bird of the registry, without a pause after it
+bool SampleClip::render(uint16_t birdNbr, uint32_t sampleRate, Format format, int16_t amplitude)
+{
+  return render([](PcmChirpmaker &cm, void *bird) { cm.birdVoice(*static_cast<uint16_t *>(bird), 0); }, &birdNbr, sampleRate, format, amplitude);
+}
+
+void SampleClip::release()
+{
+  free(_owned);
+  _owned = nullptr;
+  _data = nullptr;
+  _capacity = 0;
+  _samples = 0;
+  _failed = false;
+}
+
+// n samples from first on as 16 bit, past the end silence
+void SampleClip::read(uint32_t first, int16_t *out, uint32_t n) const
+{
+  uint32_t i = 0;
+  switch (_format)
+  {
+    case PCM8:
+      for (; i < n && first + i < _samples; i++) out[i] = (int16_t)((_data[first + i] - 128) << 8);
+      break;
+    case PCM16:
+      for (; i < n && first + i < _samples; i++) memcpy(out + i, _data + 2 * (first + i), 2);
+      break;
+    case ADPCM:
+      while (i < n && first + i < _samples)
+      {
+        uint32_t s = first + i, k = s % Adpcm::BLOCK_SAMPLES;
+        uint32_t m = Adpcm::BLOCK_SAMPLES - k;
+        if (m > n - i) m = n - i;
+        if (m > _samples - s) m = _samples - s;
+        Adpcm::decodeBlock(_data + s / Adpcm::BLOCK_SAMPLES * Adpcm::BLOCK_BYTES, k, out + i, m);
+        i += m;
+      }
+      break;
+  }
+  for (; i < n; i++) out[i] = 0;
+}
+
+// Bytes of samples samples in format
+uint32_t SampleClip::bytes(Format format, uint32_t samples)
+{
+  switch (format)
+  {
+    case PCM8: return samples;
+    case PCM16: return 2 * samples;
+    case ADPCM: return Adpcm::bytes(samples);
+  }
+  return 0;
+}
+
+/**
+ * Prepare the output at sampleRate. Without a handler, on the ESP32, I2S0
+ * drives the built-in DAC, both channels the same sample.
+ */
+bool SamplePlayer::begin(uint32_t sampleRate, BlockHandler handler, void *ctx)
+{
+  _sampleRate = sampleRate;
+  _handler = handler;
+  _ctx = ctx;
+  _clip = nullptr;
+  _filled = false;
+  _started = false;
+  _blocks = _underruns = 0;
+#ifdef ARDUINO
+  if (! handler)
+  {
+    i2s_config_t config = {};
+    config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
+    config.sample_rate = sampleRate;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+    config.dma_buf_count = BUFFERS;
+    config.dma_buf_len = BLOCK_SAMPLES;
+    config.tx_desc_auto_clear = true;     // silence when no block is ready
+    _written = 0;
+    if (i2s_driver_install(I2S_NUM_0, &config, 0, nullptr) != ESP_OK) return false;
+    i2s_set_pin(I2S_NUM_0, nullptr);
+    i2s_set_dac_mode(I2S_DAC_CHANNEL_BOTH_EN);
+  }
+#endif
+  return true;
+}
+
+void SamplePlayer::end()
+{
+  _clip = nullptr;
+#ifdef ARDUINO
+  if (! _handler) i2s_driver_uninstall(I2S_NUM_0);
+#endif
+}
+
+// Start clip, a clip that is playing is cut off
+void SamplePlayer::play(const SampleClip &clip)
+{
+  _clip = &clip;
+  _position = 0;
+  _filled = false;
+}
+
+/**
+ * Fill the free buffers with the next blocks of the clip. Returns true as
+ * long as the clip is playing; its last block may still be in a buffer.
+ */
+bool SamplePlayer::service(uint32_t nowUs)
+{
+  while (_clip)
+  {
+    if (! _filled) _fill();
+    if (! _submit(nowUs)) break;
+    _filled = false;
+    _blocks++;
+    if (_position >= _clip->samples()) _clip = nullptr;
+  }
+  return _clip != nullptr;
+}
+
+// The next block of the clip, silence after its end
+void SamplePlayer::_fill()
+{
+  _clip->read(_position, _block, BLOCK_SAMPLES);
+  _position += BLOCK_SAMPLES;
+  _filled = true;
+#ifdef ARDUINO
+  for (uint16_t i = 0; i < BLOCK_SAMPLES; i++) _frames[2 * i] = _frames[2 * i + 1] = (uint16_t)(_block[i] + 32768);  // the DAC takes the high byte
+  _written = 0;
+#endif
+}
+
+/**
+ * Hand the block to a free buffer. False if both are still playing.
+ */
+bool SamplePlayer::_submit(uint32_t nowUs)
+{
+#ifdef ARDUINO
+  if (! _handler)
+  {
+    size_t n = 0;
+    i2s_write(I2S_NUM_0, (const uint8_t *)_frames + _written, sizeof(_frames) - _written, &n, 0);
+    _written += n;
+    return _written == sizeof(_frames);
+  }
+#endif
+  if (! _started)
+  {
+    _startUs = nowUs;
+    _queued = 0;
+    _started = true;
+  }
+  uint64_t played = (uint64_t)(nowUs - _startUs) * _sampleRate / 1000000 / BLOCK_SAMPLES;
+  if (played > _queued)
+  {
+    // The output ran dry, it starts again with this block; between clips that is no underrun
+    if (_position > BLOCK_SAMPLES) _underruns++;
+    _startUs = nowUs;
+    _queued = played = 0;
+  }
+  if (_queued - played >= BUFFERS) return false;
+  if (_handler) _handler(_block, BLOCK_SAMPLES, _ctx);
+  _queued++;
+  return true;
+}
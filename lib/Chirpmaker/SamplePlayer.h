@@ -0,0 +1,115 @@
+#ifndef _SAMPLEPLAYER_H_
+#define _SAMPLEPLAYER_H_
+#include "Chirpmaker.h"
+#include "Adpcm.h"
+
+/**
+ * A sound rendered once into samples, to be played without computing it
+ * again. render() plays a bird or any sound of a PcmChirpmaker into a
+ * buffer on the heap, e.g. in setup(); the random parameters of a bird are
+ * drawn once. The PcmChirpmaker that plays it is on the heap as well, for
+ * the time of render() only. A clip can also wrap samples that are in flash already.
+ *   PCM8    unsigned 8 bit, 128 is silence, the resolution of the ESP32 DAC
+ *   PCM16   signed 16 bit, little endian
+ *   ADPCM   IMA ADPCM in blocks of 256 samples (see Adpcm.h), 4 bits, a
+ *           quarter of the memory of PCM16 but far noisier than PCM8
+ * read() decodes any part of a clip into 16 bit samples, an ADPCM clip
+ * block by block, never the whole clip.
+ */
+class SampleClip
+{
+  public:
+    enum Format : uint8_t { PCM8, PCM16, ADPCM };
+    using Sound = void (*)(PcmChirpmaker &cm, void *ctx);
+
+    SampleClip() = default;
+    SampleClip(const void *data, uint32_t samples, uint32_t sampleRate, Format format)
+      : _data(static_cast<const uint8_t *>(data)), _samples(samples), _sampleRate(sampleRate), _format(format) {}
+    SampleClip(const SampleClip &) = delete;
+    SampleClip &operator=(const SampleClip &) = delete;
+    ~SampleClip() { release(); }
+
+    bool render(Sound sound, void *ctx, uint32_t sampleRate, Format format, int16_t amplitude = 16000);
+    bool render(uint16_t birdNbr, uint32_t sampleRate, Format format, int16_t amplitude = 16000);
+    void begin(uint32_t sampleRate, Format format);
+    static void block(const int16_t *samples, size_t n, void *clip);
+    bool end();
+    void release();
+    void read(uint32_t first, int16_t *out, uint32_t n) const;
+
+    const uint8_t *data() const { return _data; }
+    uint32_t samples() const { return _samples; }
+    uint32_t sampleRate() const { return _sampleRate; }
+    Format format() const { return _format; }
+    uint32_t bytes() const { return bytes(_format, _samples); }
+    uint32_t bytesPerSecond() const { return (uint64_t)bytes(_format, 256 * _sampleRate) / 256; }   // whole ADPCM blocks
+    static uint32_t bytes(Format format, uint32_t samples);
+
+  private:
+    const uint8_t *_data = nullptr;
+    uint8_t *_owned = nullptr;      // rendered by render(), freed by release()
+    uint32_t _capacity = 0;         // bytes while rendering
+    Adpcm::State _coder;            // of the ADPCM encoder while rendering
+    uint32_t _samples = 0;
+    uint32_t _sampleRate = 0;
+    Format _format = PCM16;
+    bool _failed = false;
+};
+
+/**
+ * Plays clips through a double-buffered DMA output: while the hardware
+ * plays one block of BLOCK_SAMPLES, service() fills the other, a copy (or
+ * a decode) per block, so the CPU has next to nothing to do while a clip
+ * plays. Call it from loop() at least once per block, 11 ms at 22050 Hz.
+ *
+ * On the ESP32 begin() without a handler sets up I2S0 with the built-in
+ * DAC, the sound comes out on GPIO25 and GPIO26 and the driver's two DMA
+ * buffers are the double buffer. An ADPCM clip is decoded a block at a
+ * time on its way to the DMA buffer. With a handler (a WavWriter, a pipe on the
+ * host) the player keeps the time of such an output itself: a block is
+ * handed on when one of the two buffers is free by nowUs, and a call that
+ * comes too late is counted as an underrun.
+ *   player.begin(22050);
+ *   cuckoo.render(11, 22050, SampleClip::PCM8);   // once, in setup()
+ *   player.play(cuckoo);
+ *   while (player.service(micros())) { ... }
+ */
+class SamplePlayer
+{
+  public:
+    static const uint16_t BLOCK_SAMPLES = 256;
+    static const uint8_t BUFFERS = 2;
+    using BlockHandler = PcmSink::BlockHandler;
+
+    bool begin(uint32_t sampleRate, BlockHandler handler = nullptr, void *ctx = nullptr);
+    void end();
+    void play(const SampleClip &clip);
+    void stop() { _clip = nullptr; }
+    bool service(uint32_t nowUs);
+    bool isPlaying() const { return _clip != nullptr; }
+    uint32_t blocks() const { return _blocks; }
+    uint32_t underruns() const { return _underruns; }   // with a handler only
+
+  private:
+    void _fill();
+    bool _submit(uint32_t nowUs);
+
+    uint32_t _sampleRate = 22050;
+    BlockHandler _handler = nullptr;
+    void *_ctx = nullptr;
+    const SampleClip *_clip = nullptr;
+    uint32_t _position = 0;          // next sample of the clip to fill
+    int16_t _block[BLOCK_SAMPLES];
+    bool _filled = false;            // _block waits for a free buffer
+    uint32_t _blocks = 0;
+    uint32_t _underruns = 0;
+    // Time of the output of a handler
+    uint32_t _startUs = 0;
+    uint32_t _queued = 0;            // blocks since _startUs
+    bool _started = false;
+#ifdef ARDUINO
+    uint16_t _frames[2 * BLOCK_SAMPLES];
+    uint16_t _written = 0;           // bytes of _frames taken by the driver
+#endif
+};
+#endif
@@ -0,0 +1,134 @@
+#include "SongBank.h"
+#ifdef ARDUINO
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Use the bank at data, which has to stay in place while it is used.
+ * Only the header is checked: magic, version and that every section lies
+ * within the bank, aligned. Returns false if it is not a song bank.
+ */
+bool SongBank::open(const void *data, size_t size)
+{
+  _header = nullptr;
+  const SongBankHeader *h = static_cast<const SongBankHeader *>(data);
+  if (! data || (uintptr_t)data % 4 || size < sizeof(SongBankHeader)) return false;
+  if (h->magic != SONG_BANK_MAGIC || h->version != SONG_BANK_VERSION || h->headerBytes < sizeof(SongBankHeader)) return false;
+  if (h->totalBytes > size || h->nSlots == 0 || (h->nSlots & (h->nSlots - 1)) || h->nSlots < h->nBirds || h->nTables > 256) return false;
+
+  auto inside = [h](uint32_t offset, uint64_t bytes) { return offset % 4 == 0 && offset >= h->headerBytes && offset + bytes <= h->totalBytes; };
+  if (! inside(h->birdsOffset, (uint64_t)h->nBirds * sizeof(SongBankBird))
+   || ! inside(h->slotsOffset, (uint64_t)h->nSlots * sizeof(uint32_t))
+   || ! inside(h->tablesOffset, (uint64_t)h->nTables * sizeof(SongRange))
+   || ! inside(h->segmentsOffset, (uint64_t)h->nSegments * sizeof(Segment))
+   || ! inside(h->codeOffset, h->codeBytes)
+   || ! inside(h->namesOffset, h->nameBytes)) return false;
+
+  const uint8_t *base = static_cast<const uint8_t *>(data);
+  _birds = reinterpret_cast<const SongBankBird *>(base + h->birdsOffset);
+  _slots = reinterpret_cast<const uint32_t *>(base + h->slotsOffset);
+  _tables = reinterpret_cast<const SongRange *>(base + h->tablesOffset);
+  _segments = reinterpret_cast<const Segment *>(base + h->segmentsOffset);
+  _code = base + h->codeOffset;
+  _names = reinterpret_cast<const char *>(base + h->namesOffset);
+  _header = h;
+  return true;
+}
+
+/**
+ * Check everything open() does not: the names, tables and songs of all
+ * birds (see songCheck()) and the name index. Takes time in proportion
+ * to the bank, run it once after a bank was written, not at every start.
+ */
+bool SongBank::check() const
+{
+  if (! _header) return false;
+  const SongBankHeader &h = *_header;
+  for (uint32_t t = 0; t < h.nTables; t++)
+  {
+    if (_tables[t].nSegments > UINT16_MAX || _tables[t].first > h.nSegments || _tables[t].nSegments > h.nSegments - _tables[t].first) return false;
+  }
+  for (uint32_t b = 0; b < h.nBirds; b++)
+  {
+    const SongBankBird &bird = _birds[b];
+    if (bird.name >= h.nameBytes || ! memchr(_names + bird.name, 0, h.nameBytes - bird.name)) return false;
+    if (bird.code > h.codeBytes || bird.codeBytes > h.codeBytes - bird.code) return false;
+    if (songCheck(_code + bird.code, bird.codeBytes, nullptr, h.nTables) != bird.codeBytes) return false;
+    if (indexOf(name(b)) != (int32_t)b) return false;
+  }
+  return true;
+}
+
+// Index of the bird called name, -1 if there is none
+int32_t SongBank::indexOf(const char *name) const
+{
+  if (! _header) return -1;
+  uint32_t mask = _header->nSlots - 1;
+  for (uint32_t s = birdHash(name) & mask, n = 0; _slots[s] && n < _header->nSlots; s = (s + 1) & mask, n++)
+  {
+    uint32_t b = _slots[s] - 1;
+    if (b < _header->nBirds && sameBirdName(this->name(b), name)) return b;
+  }
+  return -1;
+}
+
+#ifdef ARDUINO
+/**
+ * Map the data partition labelled name into the address space and open
+ * the bank in it. The partition is read through the flash cache.
+ */
+bool SongBank::map(const char *name)
+{
+  unmap();
+  const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+  if (! part) return false;
+  const void *data;
+  spi_flash_mmap_handle_t handle;
+  if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &data, &handle) != ESP_OK) return false;
+  _map = data;
+  _mapBytes = part->size;
+  _mapHandle = handle;
+  if (open(data, part->size)) return true;
+  unmap();
+  return false;
+}
+
+void SongBank::unmap()
+{
+  if (_map) spi_flash_munmap(_mapHandle);
+  _map = nullptr;
+  _header = nullptr;
+}
+#else
+/**
+ * Map the bank file name read only and open the bank in it. The pages
+ * are read when they are touched.
+ */
+bool SongBank::map(const char *name)
+{
+  unmap();
+  int fd = ::open(name, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  void *data = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (data == MAP_FAILED) return false;
+  _map = data;
+  _mapBytes = st.st_size;
+  if (open(data, st.st_size)) return true;
+  unmap();
+  return false;
+}
+
+void SongBank::unmap()
+{
+  if (_map) munmap(const_cast<void *>(_map), _mapBytes);
+  _map = nullptr;
+  _header = nullptr;
+}
+#endif
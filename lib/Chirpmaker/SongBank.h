@@ -0,0 +1,99 @@
+#ifndef _SONGBANK_H_
+#define _SONGBANK_H_
+#include "SongCode.h"
+#include "BirdRegistry.h"
+
+/**
+ * A song bank is a binary file of birds that is played in place: mapped
+ * with mmap() on a host, from a memory mapped flash partition on the ESP32.
+ * open() only checks the header, nothing is parsed or copied, so opening
+ * takes the same time for 10 or 10000 birds.
+ *
+ * Layout, little endian, every section 4 byte aligned, offsets from the
+ * start of the bank:
+ *   SongBankHeader
+ *   SongBankBird[nBirds]     name, song and metadata of each bird
+ *   uint32_t[nSlots]         name index: bird + 1 by birdHash(name), 0: free
+ *   SongRange[nTables]       the tables of SONG_TABLE as ranges of the segment stream
+ *   Segment[nSegments]       precompiled segment stream (see ChirpProgram.h)
+ *   uint8_t[codeBytes]       bytecode of the songs (see SongCode.h)
+ *   char[nameBytes]          0 terminated names
+ * Birds may share their bytecode. chirptool bank builds a bank from the
+ * birds of Chirpmaker.
+ */
+static const uint32_t SONG_BANK_MAGIC = 0x42534d43;  // "CMSB"
+static const uint16_t SONG_BANK_VERSION = 1;
+
+struct SongBankHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerBytes;
+  uint32_t totalBytes;
+  uint32_t nBirds;
+  uint32_t nSlots;         // power of 2
+  uint32_t nTables;
+  uint32_t nSegments;
+  uint32_t codeBytes;
+  uint32_t nameBytes;
+  uint32_t birdsOffset;
+  uint32_t slotsOffset;
+  uint32_t tablesOffset;
+  uint32_t segmentsOffset;
+  uint32_t codeOffset;
+  uint32_t namesOffset;
+  uint32_t reserved;
+};
+
+struct SongBankBird
+{
+  uint32_t name;           // offset into the names
+  uint32_t code;           // offset into the bytecode
+  uint16_t codeBytes;
+  uint16_t msTypical;
+  uint8_t  weight;
+  uint8_t  reserved[3];
+};
+
+static_assert(sizeof(Segment) == 12 && sizeof(SongRange) == 8 && sizeof(SongBankBird) == 16 && sizeof(SongBankHeader) == 64,
+              "the song bank layout must not depend on the compiler");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "song banks are little endian");
+
+class SongBank
+{
+  public:
+    SongBank() = default;
+    SongBank(const SongBank &) = delete;
+    SongBank &operator=(const SongBank &) = delete;
+    ~SongBank() { unmap(); }
+
+    bool open(const void *data, size_t size);
+    bool map(const char *name);
+    void unmap();
+    bool check() const;
+
+    bool isOpen() const { return _header != nullptr; }
+    uint32_t size() const { return _header ? _header->nBirds : 0; }
+    size_t bytes() const { return _header ? _header->totalBytes : 0; }
+    const char *name(uint32_t bird) const { return _names + _birds[bird].name; }
+    const uint8_t *song(uint32_t bird) const { return _code + _birds[bird].code; }
+    uint16_t songBytes(uint32_t bird) const { return _birds[bird].codeBytes; }
+    uint16_t msTypical(uint32_t bird) const { return _birds[bird].msTypical; }
+    uint8_t weight(uint32_t bird) const { return _birds[bird].weight; }
+    int32_t indexOf(const char *name) const;
+    SongTables tables() const { return SongTables(_segments, _tables, _header ? _header->nTables : 0); }
+
+  private:
+    const SongBankHeader *_header = nullptr;
+    const SongBankBird *_birds = nullptr;
+    const uint32_t *_slots = nullptr;
+    const SongRange *_tables = nullptr;
+    const Segment *_segments = nullptr;
+    const uint8_t *_code = nullptr;
+    const char *_names = nullptr;
+
+    const void *_map = nullptr;  // what map() mapped
+    size_t _mapBytes = 0;
+    uint32_t _mapHandle = 0;
+};
+#endif
@@ -0,0 +1,55 @@
+#include "SongCode.h"
+
+// Operand bytes of each op
+static const uint8_t OPERANDS[SONG_OPS] = {0, 1, 2, 2, 4, 1, 0, 1, 0, 0, 0};
+// Values each op takes from the stack and pushes onto it
+static const uint8_t POPS[SONG_OPS]     = {0, 0, 0, 0, 0, 7, 6, 1, 1, 1, 0};
+static const uint8_t PUSHES[SONG_OPS]   = {0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0};
+
+/**
+ * The instruction after the one at pc
+ */
+const uint8_t *songNext(const uint8_t *pc)
+{
+  return pc + 1 + (*pc < SONG_OPS ? OPERANDS[*pc] : 0);
+}
+
+/**
+ * Check a song before it is played, e.g. one loaded from a file:
+ * known ops, generators and tables, no stack underflow or overflow, loops
+ * balanced and nested at most SONG_LOOPS deep, SONG_END within maxBytes.
+ * nTables is the number of tables the song can refer to.
+ * Returns the size of the song in bytes, -1 if it is not valid.
+ * maxDepth receives the deepest stack the song needs.
+ */
+int songCheck(const uint8_t *song, uint16_t maxBytes, uint8_t *maxDepth, uint16_t nTables)
+{
+  uint8_t depth = 0, deepest = 0, loops = 0;
+  uint8_t loopDepth[SONG_LOOPS];  // stack depth at each open loop
+  const uint8_t *pc = song;
+  while (pc < song + maxBytes)
+  {
+    uint8_t op = *pc;
+    if (op >= SONG_OPS || pc + 1 + OPERANDS[op] > song + maxBytes) return -1;
+    if (depth < POPS[op]) return -1;
+    if (op == SONG_CHIRP && (pc[1] & 0x0f) >= SONG_GENS) return -1;
+    if (op == SONG_TABLE && pc[1] >= nTables) return -1;
+    depth = depth - POPS[op] + PUSHES[op];
+    if (depth > SONG_STACK) return -1;
+    if (depth > deepest) deepest = depth;
+    if (op == SONG_REPEAT)
+    {
+      if (loops == SONG_LOOPS) return -1;
+      loopDepth[loops++] = depth;
+    }
+    if (op == SONG_LOOP && (loops == 0 || loopDepth[--loops] != depth)) return -1;  // a loop body has to leave the stack as it found it
+    if (op == SONG_END)
+    {
+      if (loops > 0 || depth > 0) return -1;
+      if (maxDepth) *maxDepth = deepest;
+      return pc + 1 - song;
+    }
+    pc = songNext(pc);
+  }
+  return -1;
+}
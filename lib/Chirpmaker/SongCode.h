@@ -0,0 +1,159 @@
+#ifndef _SONGCODE_H_
+#define _SONGCODE_H_
+#include "ConstSounds.h"
+
+/**
+ * Bytecode of a bird song. The parameters are pushed on a small stack,
+ * constant or drawn by random(lo, hi) when the song runs, in the order of
+ * the parameters of the C++ call; chirp, phaser, table and pause take them
+ * from there. Multi byte operands are little endian.
+ *
+ *   op              operands         stack
+ *   SONG_END                                      end of the song
+ *   SONG_PUSH8      v                -> v
+ *   SONG_PUSH16     v v              -> v
+ *   SONG_RANDOM8    lo hi            -> random(lo, hi)
+ *   SONG_RANDOM16   lo lo hi hi      -> random(lo, hi)
+ *   SONG_CHIRP      gen              fStart fStop nSteps nPeriods nChirps duty msPause ->
+ *   SONG_PHASER                      freq nPeriods dutyStart dutyEnd nChirps msPause ->
+ *   SONG_TABLE      table            repeats ->   play a table (SONG_TABLES or of a song bank)
+ *   SONG_PAUSE                       ms ->
+ *   SONG_REPEAT                      n ->         the code up to the matching
+ *   SONG_LOOP                                     SONG_LOOP is played n times
+ *
+ * gen is a SongGen, the sinc generators carry nPi in the upper 4 bits.
+ * The S_xxx macros write the instructions into a byte array:
+ *   const uint8_t SONG[] = {S_RANDOM8(2, 6), S_TABLE(SONG_RAVEN), S_END};
+ */
+enum SongOp : uint8_t
+{
+  SONG_END,
+  SONG_PUSH8,
+  SONG_PUSH16,
+  SONG_RANDOM8,
+  SONG_RANDOM16,
+  SONG_CHIRP,
+  SONG_PHASER,
+  SONG_TABLE,
+  SONG_PAUSE,
+  SONG_REPEAT,
+  SONG_LOOP,
+  SONG_OPS
+};
+
+enum SongGen : uint8_t
+{
+  GEN_LINEAR,
+  GEN_CHROMATIC,
+  GEN_SINE_PI,
+  GEN_SINE_2PI,
+  GEN_COSINE_PI,
+  GEN_COSINE_2PI,
+  GEN_ATAN_PI,
+  GEN_ATAN_2PI,
+  GEN_SINC_NPI_NPI,
+  GEN_SINC_NPI_0,
+  GEN_SINC_0_NPI,
+  SONG_GENS
+};
+
+// The compile time tables of ConstSounds.h a song can play
+enum SongTableId : uint8_t
+{
+  SONG_SIGNET_UP,
+  SONG_SIGNET_DOWN,
+  SONG_PHONE_CALL,
+  SONG_CUCKOO_CUC,
+  SONG_CUCKOO_KOO,
+  SONG_BIRD4_A,
+  SONG_BIRD4_B,
+  SONG_BIRD4_C,
+  SONG_BIRD8,
+  SONG_BIRD10_UP,
+  SONG_BIRD10_DOWN,
+  SONG_RAVEN,
+  SONG_TABLES_COUNT
+};
+
+struct SongTable
+{
+  const Segment *segments;
+  uint16_t nSegments;
+};
+
+inline constexpr SongTable SONG_TABLES[SONG_TABLES_COUNT] =
+{
+  {ConstSounds::SIGNET_UP.segments,        ConstSounds::SIGNET_UP.size()},
+  {ConstSounds::SIGNET_DOWN.segments,      ConstSounds::SIGNET_DOWN.size()},
+  {ConstSounds::PHONE_CALL.segments,       ConstSounds::PHONE_CALL.size()},
+  {ConstSounds::CUCKOO_CUC_TABLE.segments, ConstSounds::CUCKOO_CUC_TABLE.size()},
+  {ConstSounds::CUCKOO_KOO_TABLE.segments, ConstSounds::CUCKOO_KOO_TABLE.size()},
+  {ConstSounds::BIRD4_A.segments,          ConstSounds::BIRD4_A.size()},
+  {ConstSounds::BIRD4_B.segments,          ConstSounds::BIRD4_B.size()},
+  {ConstSounds::BIRD4_C.segments,          ConstSounds::BIRD4_C.size()},
+  {ConstSounds::BIRD8.segments,            ConstSounds::BIRD8.size()},
+  {ConstSounds::BIRD10_UP.segments,        ConstSounds::BIRD10_UP.size()},
+  {ConstSounds::BIRD10_DOWN.segments,      ConstSounds::BIRD10_DOWN.size()},
+  {ConstSounds::RAVEN.segments,            ConstSounds::RAVEN.size()},
+};
+
+/**
+ * The tables a song plays with SONG_TABLE: the compile time tables of
+ * SONG_TABLES, or those of a song bank, given as ranges of one segment stream
+ */
+struct SongRange
+{
+  uint32_t first;
+  uint32_t nSegments;
+};
+
+class SongTables
+{
+  public:
+    constexpr SongTables(const SongTable *tables, uint16_t count) : _tables(tables), _stream(nullptr), _ranges(nullptr), _count(count) {}
+    constexpr SongTables(const Segment *stream, const SongRange *ranges, uint16_t count) : _tables(nullptr), _stream(stream), _ranges(ranges), _count(count) {}
+
+    uint16_t size() const { return _count; }
+
+    // Segments of table id, nullptr if there is none
+    const Segment *get(uint8_t id, uint16_t &nSegments) const
+    {
+      if (id >= _count) return nullptr;
+      if (_tables)
+      {
+        nSegments = _tables[id].nSegments;
+        return _tables[id].segments;
+      }
+      nSegments = _ranges[id].nSegments;
+      return _stream + _ranges[id].first;
+    }
+
+  private:
+    const SongTable *_tables;
+    const Segment *_stream;
+    const SongRange *_ranges;
+    uint16_t _count;
+};
+
+inline constexpr SongTables CONST_SONG_TABLES(SONG_TABLES, SONG_TABLES_COUNT);
+
+#define S_END               SONG_END
+#define S_PUSH8(v)          SONG_PUSH8, (uint8_t)(v)
+#define S_PUSH16(v)         SONG_PUSH16, (uint8_t)((v) & 0xff), (uint8_t)((v) >> 8)
+#define S_RANDOM8(lo, hi)   SONG_RANDOM8, (uint8_t)(lo), (uint8_t)(hi)
+#define S_RANDOM16(lo, hi)  SONG_RANDOM16, (uint8_t)((lo) & 0xff), (uint8_t)((lo) >> 8), (uint8_t)((hi) & 0xff), (uint8_t)((hi) >> 8)
+#define S_CHIRP(gen)        SONG_CHIRP, (uint8_t)(gen)
+#define S_SINC(gen, nPi)    SONG_CHIRP, (uint8_t)((gen) | (nPi) << 4)
+#define S_PHASER            SONG_PHASER
+#define S_TABLE(table)      SONG_TABLE, (uint8_t)(table)
+#define S_PAUSE             SONG_PAUSE
+#define S_REPEAT            SONG_REPEAT
+#define S_LOOP              SONG_LOOP
+
+// Limits of the interpreter, a song that stays within them never fails
+const uint8_t SONG_STACK = 16;
+const uint8_t SONG_LOOPS = 4;
+
+const uint8_t *songNext(const uint8_t *pc);
+int songCheck(const uint8_t *song, uint16_t maxBytes, uint8_t *maxDepth = nullptr, uint16_t nTables = SONG_TABLES_COUNT);
+#endif
@@ -0,0 +1,44 @@
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * Wait-free ring buffer for one producer and one consumer, which may run
+ * on different cores. push() and pop() never block and never take a lock;
+ * push() fails when the queue is full. Holds N - 1 items, N a power of 2.
+ */
+template <class T, uint16_t N>
+class SpscQueue
+{
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "the size of an SpscQueue must be a power of 2");
+
+  public:
+    bool push(const T &item)
+    {
+      uint16_t head = _head.load(std::memory_order_relaxed);
+      uint16_t next = (head + 1) & (N - 1);
+      if (next == _tail.load(std::memory_order_acquire)) return false;
+      _items[head] = item;
+      _head.store(next, std::memory_order_release);
+      return true;
+    }
+
+    bool pop(T &item)
+    {
+      uint16_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire)) return false;
+      item = _items[tail];
+      _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+      return true;
+    }
+
+    uint16_t size() const { return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & (N - 1); }
+    static constexpr uint16_t capacity() { return N - 1; }
+
+  private:
+    T _items[N];
+    std::atomic<uint16_t> _head{0};   // written by the producer only
+    std::atomic<uint16_t> _tail{0};   // written by the consumer only
+};
+#endif
@@ -0,0 +1,122 @@
+#include "TimerPlayer.h"
+
+TimerPlayer *TimerPlayer::_players[TIMERS] = {};
+
+/**
+ * Attach the player to a pin and a hardware timer
+ * pin        GPIO the buzzer is connected to
+ * timerNbr   hardware timer 0..3 to be used
+ */
+void TimerPlayer::begin(uint8_t pin, uint8_t timerNbr)
+{
+  static void (*const isrs[TIMERS])() = {&TimerPlayer::_isr0, &TimerPlayer::_isr1, &TimerPlayer::_isr2, &TimerPlayer::_isr3};
+  _pin = pin;
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+  _timerNbr = timerNbr & (TIMERS - 1);
+  _players[_timerNbr] = this;
+  _timer = timerBegin(_timerNbr, DIVIDER, true);
+  timerAttachInterrupt(_timer, isrs[_timerNbr], true);
+}
+
+void TimerPlayer::end()
+{
+  flush();
+  timerAlarmDisable(_timer);
+  timerDetachInterrupt(_timer);
+  timerEnd(_timer);
+  _timer = nullptr;
+  if (_players[_timerNbr] == this) _players[_timerNbr] = nullptr;
+}
+
+/**
+ * Queue an edge. Waits while the queue is full and starts the timer
+ * if it has run dry. Edges of zero length are dropped.
+ * level    HIGH or LOW
+ * ticks    duration of the level in timer ticks
+ */
+void TimerPlayer::push(uint8_t level, uint32_t ticks)
+{
+  if (ticks == 0) return;
+  uint16_t head = _head.load(std::memory_order_relaxed);
+  while (((head + 1) & (QUEUE_SIZE - 1)) == _tail.load(std::memory_order_acquire)) _wait();
+  _queue[head] = {ticks, level};
+  _head.store((head + 1) & (QUEUE_SIZE - 1), std::memory_order_release);
+
+  portENTER_CRITICAL(&_mux);
+  bool kick = ! _running;
+  _running = true;
+  portEXIT_CRITICAL(&_mux);
+  if (kick)
+  {
+    _deadline = timerRead(_timer);
+    _next();
+  }
+}
+
+/**
+ * Wait until all queued edges have been played
+ */
+void TimerPlayer::flush()
+{
+  while (_running) _wait();
+}
+
+/**
+ * Sleep until the ISR has taken an edge, a tick of FreeRTOS at most in
+ * case it did so before _waiter was set. On the host delay() runs the
+ * virtual clock and with it the alarms.
+ */
+void TimerPlayer::_wait()
+{
+#ifdef ARDUINO
+  _waiter = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 1);
+  _waiter = nullptr;
+#else
+  delay(1);
+#endif
+}
+
+void IRAM_ATTR TimerPlayer::_isr0() { if (_players[0]) _players[0]->_next(); }
+void IRAM_ATTR TimerPlayer::_isr1() { if (_players[1]) _players[1]->_next(); }
+void IRAM_ATTR TimerPlayer::_isr2() { if (_players[2]) _players[2]->_next(); }
+void IRAM_ATTR TimerPlayer::_isr3() { if (_players[3]) _players[3]->_next(); }
+
+/**
+ * Output the next edge at its deadline and set the alarm to the end of
+ * it, never into the past. When the queue is empty the alarm is switched
+ * off and the pin keeps its last level.
+ */
+void IRAM_ATTR TimerPlayer::_next()
+{
+  uint16_t tail = _tail.load(std::memory_order_relaxed);
+  portENTER_CRITICAL_ISR(&_mux);
+  if (tail == _head.load(std::memory_order_acquire))
+  {
+    timerAlarmDisable(_timer);
+    _running = false;
+    portEXIT_CRITICAL_ISR(&_mux);
+  }
+  else
+  {
+    portEXIT_CRITICAL_ISR(&_mux);
+    const Edge &e = _queue[tail];
+    digitalWrite(_pin, e.level);
+    _deadline += e.ticks;
+    uint64_t now = timerRead(_timer);
+    timerAlarmWrite(_timer, _deadline > now ? _deadline : now + 1, false);
+    timerAlarmEnable(_timer);
+    _tail.store((tail + 1) & (QUEUE_SIZE - 1), std::memory_order_release);
+  }
+#ifdef ARDUINO
+  TaskHandle_t waiter = _waiter;
+  if (waiter)
+  {
+    BaseType_t woken = pdFALSE;
+    _waiter = nullptr;
+    vTaskNotifyGiveFromISR(waiter, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+#endif
+}
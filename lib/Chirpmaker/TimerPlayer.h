@@ -0,0 +1,76 @@
+#ifndef _TIMERPLAYER_H_
+#define _TIMERPLAYER_H_
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "HostArduino.h"
+#endif
+#include <atomic>
+
+/**
+ * One level change of the buzzer pin: drive the pin to level and keep it
+ * there for ticks timer ticks.
+ */
+struct Edge
+{
+  uint32_t ticks;
+  uint8_t  level;
+};
+
+/**
+ * Plays a stream of edges from a hardware timer interrupt instead of busy
+ * waiting with delayMicroseconds(). The producer pushes (level, duration)
+ * pairs into a single-producer/single-consumer ring buffer, the alarm ISR
+ * pops the next edge, writes the pin and sets the alarm to the deadline of
+ * the edge after it. The timer counts freely and the deadlines are
+ * absolute, like in the PolyPlayer, so the latency of the ISR delays an
+ * edge but does not lengthen the level before it.
+ * The calling task only sleeps while the queue is full; on the ESP32 the
+ * ISR wakes it with a task notification as soon as an edge is taken.
+ *
+ * There can be one player per hardware timer, 4 at most, and a timer taken
+ * by a PolyPlayer cannot be used here as well.
+ *
+ * On the host the same code runs against the simulated timers of
+ * HostArduino, driven by the virtual clock.
+ */
+class TimerPlayer
+{
+  public:
+    static const uint32_t TICK_HZ      = 10000000;          // 10 MHz, 0.1 us per tick
+    static const uint16_t DIVIDER      = 80000000 / TICK_HZ; // from the 80 MHz APB clock
+    static const uint32_t TICKS_PER_US = TICK_HZ / 1000000;
+    static const uint16_t QUEUE_SIZE   = 256;                // must be a power of 2
+    static const uint8_t  TIMERS       = 4;
+
+    void begin(uint8_t pin, uint8_t timerNbr = 0);
+    void end();
+    void push(uint8_t level, uint32_t ticks);
+    void pushUs(uint8_t level, uint32_t us) { push(level, us * TICKS_PER_US); }
+    void flush();
+    bool isIdle() const { return ! _running; }
+    uint16_t queued() const { return (_head.load() - _tail.load()) & (QUEUE_SIZE - 1); }
+
+  private:
+    static void IRAM_ATTR _isr0();
+    static void IRAM_ATTR _isr1();
+    static void IRAM_ATTR _isr2();
+    static void IRAM_ATTR _isr3();
+    void IRAM_ATTR _next();
+    void _wait();
+
+    static TimerPlayer *_players[TIMERS];
+    hw_timer_t *_timer = nullptr;
+    uint8_t _timerNbr = 0;
+    uint64_t _deadline = 0;           // timer tick at which the current edge ends
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t _pin;
+    Edge _queue[QUEUE_SIZE];
+    std::atomic<uint16_t> _head{0};   // written by the producer only
+    std::atomic<uint16_t> _tail{0};   // written by the ISR only
+    volatile bool _running = false;
+#ifdef ARDUINO
+    volatile TaskHandle_t _waiter = nullptr;   // task sleeping in _wait()
+#endif
+};
+#endif
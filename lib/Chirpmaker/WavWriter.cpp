@@ -0,0 +1,82 @@
+#include "WavWriter.h"
+#include <string.h>
+
+static void putLe(uint8_t *p, uint32_t v, int bytes)
+{
+  for (int i = 0; i < bytes; i++) p[i] = v >> (8 * i);
+}
+
+/**
+ * Create the file path and write a header with open sizes
+ */
+bool WavWriter::open(const char *path, uint32_t sampleRate)
+{
+  close();
+  FILE *f = fopen(path, "wb");
+  if (! f) return false;
+  open(f, sampleRate);
+  _owned = true;
+  return ! _failed;
+}
+
+/**
+ * Write to a file that is already open, e.g. stdout. It is not closed.
+ */
+bool WavWriter::open(FILE *file, uint32_t sampleRate)
+{
+  close();
+  _file = file;
+  _owned = false;
+  _failed = false;
+  _sampleRate = sampleRate;
+  _samples = 0;
+  _header(UINT32_MAX - 36);
+  return ! _failed;
+}
+
+bool WavWriter::write(const int16_t *samples, size_t n)
+{
+  if (! _file || _failed) return false;
+  static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "WAV samples are little endian");
+  if (fwrite(samples, sizeof(int16_t), n, _file) != n) _failed = true;
+  _samples += n;
+  return ! _failed;
+}
+
+/**
+ * Fill in the sizes if the file can seek, and close it if it was opened here.
+ * Returns false if anything could not be written.
+ */
+bool WavWriter::close()
+{
+  if (! _file) return ! _failed;
+  uint64_t bytes = _samples * sizeof(int16_t);
+  if (bytes <= UINT32_MAX - 36 && fseek(_file, 0, SEEK_SET) == 0)
+  {
+    _header(bytes);
+    fseek(_file, 0, SEEK_END);
+  }
+  if (fflush(_file) != 0) _failed = true;
+  if (_owned && fclose(_file) != 0) _failed = true;
+  _file = nullptr;
+  return ! _failed;
+}
+
+// RIFF header of 16 bit mono PCM
+void WavWriter::_header(uint32_t dataBytes)
+{
+  uint8_t h[44];
+  memcpy(h, "RIFF", 4);
+  putLe(h + 4, 36 + dataBytes, 4);
+  memcpy(h + 8, "WAVEfmt ", 8);
+  putLe(h + 16, 16, 4);                  // size of the fmt chunk
+  putLe(h + 20, 1, 2);                   // PCM
+  putLe(h + 22, 1, 2);                   // mono
+  putLe(h + 24, _sampleRate, 4);
+  putLe(h + 28, _sampleRate * 2, 4);     // bytes per second
+  putLe(h + 32, 2, 2);                   // bytes per frame
+  putLe(h + 34, 16, 2);                  // bits per sample
+  memcpy(h + 36, "data", 4);
+  putLe(h + 40, dataBytes, 4);
+  if (fwrite(h, 1, sizeof(h), _file) != sizeof(h)) _failed = true;
+}
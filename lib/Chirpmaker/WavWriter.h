@@ -0,0 +1,46 @@
+#ifndef _WAVWRITER_H_
+#define _WAVWRITER_H_
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Streams 16 bit mono PCM into a WAV file block by block, nothing is kept
+ * in memory. close() fills in the sizes of the header; on a pipe, which
+ * cannot seek, they stay at their maximum, which players accept.
+ * It fits the block handler of PcmSink:
+ *   WavWriter wav;
+ *   wav.open("cuckoo.wav", 44100);
+ *   PcmChirpmaker cm(0);
+ *   cm.sink().setOutput(44100, WavWriter::block, &wav);
+ *   cm.cuckoo();
+ *   cm.sink().flush();
+ *   wav.close();
+ */
+class WavWriter
+{
+  public:
+    WavWriter() = default;
+    WavWriter(const WavWriter &) = delete;
+    WavWriter &operator=(const WavWriter &) = delete;
+    ~WavWriter() { close(); }
+
+    bool open(const char *path, uint32_t sampleRate);
+    bool open(FILE *file, uint32_t sampleRate);
+    bool write(const int16_t *samples, size_t n);
+    bool close();
+    uint64_t samples() const { return _samples; }
+    bool failed() const { return _failed; }
+
+    static void block(const int16_t *samples, size_t n, void *self) { static_cast<WavWriter *>(self)->write(samples, n); }
+
+  private:
+    void _header(uint32_t dataBytes);
+
+    FILE *_file = nullptr;
+    bool _owned = false;
+    bool _failed = false;
+    uint32_t _sampleRate = 0;
+    uint64_t _samples = 0;
+};
+#endif
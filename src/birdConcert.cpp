@@ -29,34 +29,37 @@ Chirpmaker cm(PIN_BUZZER);
 void setup() 
 {
   Serial.begin(115200);
+  cm.useProgramCache();  // the constant chirp of loop() is compiled once
   cm.signet();
 }
 
 void loop() 
 {
-  printf("Phone call\n");
+  CHIRP_LOG_I("Phone call");
   cm.phoneCall(7);
+  chirpLog().flush();  // print in the pause, not between the sounds
   delay(1000);
 
-  printf("Birdconcert\n");
+  CHIRP_LOG_I("Birdconcert");
   cm.birdConcert(3000);
 
-  printf("Chirp\n");
+  CHIRP_LOG_I("Chirp");
   cm.chirp(1800, 2400, 50, 15, 7, sincScale0_Npi, 50, 5000);
 
-  printf("Cuckoo\n");
+  CHIRP_LOG_I("Cuckoo");
   cm.cuckoo();
 
-  printf("Raven\n");
+  CHIRP_LOG_I("Raven");
   cm.raven();
 
-  printf("Chaffinch\n");
+  CHIRP_LOG_I("Chaffinch");
   cm.chaffinch();
 
-  printf("Blackbird\n");
+  CHIRP_LOG_I("Blackbird");
   cm.blackbird();
 
-  printf("Phaser\n");
+  CHIRP_LOG_I("Phaser");
   cm.phaser(1500, 30, 5, 95, 3, 200);
+  chirpLog().flush();
   delay(2000);
 }
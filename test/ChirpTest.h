@@ -0,0 +1,105 @@
+#ifndef _CHIRPTEST_H_
+#define _CHIRPTEST_H_
+#include <vector>
+#include <complex>
+#include <cmath>
+#include "Chirpmaker.h"
+
+/**
+ * Helpers shared by the unit tests under test/, one folder per module, run
+ * on the host by pio test -e native. A test includes it as "../ChirpTest.h".
+ */
+const uint8_t TEST_PIN = 4;
+
+// The samples of a sink, a PCM block handler
+struct Samples
+{
+  std::vector<int16_t> v;
+  size_t blocks = 0;
+  size_t largest = 0;
+
+  static void block(const int16_t *s, size_t n, void *self)
+  {
+    Samples &c = *static_cast<Samples *>(self);
+    c.v.insert(c.v.end(), s, s + n);
+    c.blocks++;
+    if (n > c.largest) c.largest = n;
+  }
+};
+
+// All samples of a SampleClip, decoded
+template <class Clip>
+std::vector<int16_t> samplesOf(const Clip &clip)
+{
+  std::vector<int16_t> v(clip.samples());
+  clip.read(0, v.data(), clip.samples());
+  return v;
+}
+
+/**
+ * What a sound gives when each sample takes the level that is on at its
+ * start, from the edges a RecorderSink records: the reference of PcmSink.
+ */
+template <class Play>
+std::vector<int16_t> sampledEdges(uint32_t rate, Play play, int16_t amplitude = 16000)
+{
+  static Edge recording[200000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(TEST_PIN);
+  rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(rec);
+  std::vector<int16_t> out;
+  uint64_t ticks = 0;
+  for (size_t i = 0; i < rec.sink().count(); i++)
+  {
+    ticks += rec.sink()[i].ticks;
+    while (out.size() < ticks * rate / RecorderSink::TICK_HZ) out.push_back(rec.sink()[i].level ? amplitude : -amplitude);
+  }
+  return out;
+}
+
+// In place radix 2 FFT, n a power of 2
+inline void fft(std::vector<std::complex<double>> &x)
+{
+  size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j |= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1)
+  {
+    std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+    for (size_t i = 0; i < n; i += len)
+    {
+      std::complex<double> wk = 1;
+      for (size_t k = 0; k < len / 2; k++, wk *= w)
+      {
+        std::complex<double> u = x[i + k], v = x[i + k + len / 2] * wk;
+        x[i + k] = u + v;
+        x[i + k + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+/**
+ * Power spectrum of n values of x from first on with a Blackman-Harris
+ * window, bins 0 .. n/2
+ */
+template <class T>
+std::vector<double> powerSpectrum(const std::vector<T> &x, size_t first, size_t n)
+{
+  std::vector<std::complex<double>> c(n);
+  for (size_t i = 0; i < n; i++)
+  {
+    double p = 2 * M_PI * i / n;
+    c[i] = x[first + i] * (0.35875 - 0.48829 * cos(p) + 0.14128 * cos(2 * p) - 0.01168 * cos(3 * p));
+  }
+  fft(c);
+  std::vector<double> power(n / 2 + 1);
+  for (size_t b = 0; b <= n / 2; b++) power[b] = std::norm(c[b]);
+  return power;
+}
+#endif
@@ -0,0 +1,114 @@
+/**
+ * Adpcm and ADPCM clips: the codec on a smooth signal, blocks that decode
+ * on their own, reads in any pieces and the SNR of the birds, plain and
+ * band-limited, against 8 bit.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "SamplePlayer.h"
+
+static double snrDb(const std::vector<int16_t> &ref, const std::vector<int16_t> &x)
+{
+  double signal = 0, noise = 0;
+  for (size_t i = 0; i < ref.size(); i++)
+  {
+    double d = (double)x[i] - ref[i];
+    signal += (double)ref[i] * ref[i];
+    noise += d * d;
+  }
+  return 10 * log10(signal / noise);
+}
+
+// A bird through a BlepSink into clip
+static bool blepRender(SampleClip &clip, uint16_t bird, SampleClip::Format format)
+{
+  static BlepChirpmaker cm(TEST_PIN);
+  clip.begin(22050, format);
+  cm.sink().setOutput(22050, SampleClip::block, &clip);
+  randomSeed(bird + 1);
+  cm.birdVoice(bird, 0);
+  cm.sink().flush();
+  return clip.end();
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// The decoder follows the encoder, and a slow sine comes back with little noise
+void test_codec()
+{
+  Adpcm::State enc, dec;
+  std::vector<int16_t> in(4096), out(4096);
+  for (size_t i = 0; i < in.size(); i++)
+  {
+    in[i] = (int16_t)(12000 * sin(i * 0.05));
+    out[i] = Adpcm::decode(dec, Adpcm::encode(enc, in[i]));
+    TEST_ASSERT_EQUAL_INT(enc.predictor, dec.predictor);
+    TEST_ASSERT_EQUAL_INT(enc.index, dec.index);
+  }
+  TEST_ASSERT_GREATER_THAN_DOUBLE(30, snrDb(in, out));
+}
+
+// Each block starts with the state of the coder and decodes on its own, in any pieces
+void test_blocks()
+{
+  SampleClip clip;
+  randomSeed(12);
+  TEST_ASSERT_TRUE(clip.render(11, 22050, SampleClip::ADPCM));
+  TEST_ASSERT_EQUAL_UINT32(Adpcm::bytes(clip.samples()), clip.bytes());
+  TEST_ASSERT_EQUAL_UINT32((clip.samples() + 255) / 256 * 132, clip.bytes());
+  std::vector<int16_t> whole = samplesOf(clip);
+  for (uint32_t step : {1u, 100u, 256u, 1000u})
+  {
+    for (uint32_t i = 0; i < whole.size(); i += step * 7)
+    {
+      int16_t piece[1000];
+      uint32_t n = std::min<uint32_t>(step, whole.size() - i);
+      clip.read(i, piece, n);
+      TEST_ASSERT_EQUAL_INT16_ARRAY(&whole[i], piece, n);
+    }
+  }
+  const uint8_t *block = clip.data() + 5 * Adpcm::BLOCK_BYTES;
+  TEST_ASSERT_EQUAL_INT(whole[5 * 256 - 1], (int16_t)(block[0] | block[1] << 8));   // the predictor so far
+  TEST_ASSERT_LESS_OR_EQUAL(88, block[2]);
+  TEST_ASSERT_EQUAL_INT(0, block[3]);
+}
+
+/**
+ * Every bird: ADPCM of the band-limited samples is better than of the
+ * squares, but it does not come near 8 bits
+ */
+void test_bird_snr()
+{
+  static PcmChirpmaker cm(TEST_PIN);
+  for (uint16_t b = 0; b < cm.birds().size(); b++)
+  {
+    SampleClip pcm16, pcm8, adpcm, blep16, blepAdpcm;
+    randomSeed(b + 1);
+    pcm16.render(b, 22050, SampleClip::PCM16);
+    randomSeed(b + 1);
+    pcm8.render(b, 22050, SampleClip::PCM8);
+    randomSeed(b + 1);
+    adpcm.render(b, 22050, SampleClip::ADPCM);
+    TEST_ASSERT_TRUE(blepRender(blep16, b, SampleClip::PCM16) && blepRender(blepAdpcm, b, SampleClip::ADPCM));
+    TEST_ASSERT_EQUAL_UINT32(blep16.samples(), blepAdpcm.samples());
+
+    double eightBit = snrDb(samplesOf(pcm16), samplesOf(pcm8));
+    double plain = snrDb(samplesOf(pcm16), samplesOf(adpcm));
+    double bandLimited = snrDb(samplesOf(blep16), samplesOf(blepAdpcm));
+    TEST_ASSERT_GREATER_THAN_DOUBLE(9, plain);
+    TEST_ASSERT_GREATER_THAN_DOUBLE(19, bandLimited);
+    TEST_ASSERT_GREATER_THAN_DOUBLE(plain + 1, bandLimited);
+    TEST_ASSERT_GREATER_THAN_DOUBLE(bandLimited + 10, eightBit);
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_codec);
+  RUN_TEST(test_blocks);
+  RUN_TEST(test_bird_snr);
+  return UNITY_END();
+}
@@ -0,0 +1,127 @@
+/**
+ * Non-blocking playback: the edges of the state machine against the
+ * blocking functions, tick() on a fake clock, stop() and the sounds that
+ * do not fit into the script.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+// The edges of a sound played blocking, in ticks of the recorder
+template <class Play>
+static std::vector<uint64_t> blocking(Play play)
+{
+  static Edge recording[200000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(TEST_PIN);
+  rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(rec);
+  std::vector<uint64_t> v;
+  for (size_t i = 0; i < rec.sink().count(); i++) if (rec.sink()[i].ticks) v.push_back(rec.sink()[i].ticks << 1 | rec.sink()[i].level);
+  return v;
+}
+
+// The edges of a started sound as pull() hands them on
+static std::vector<uint64_t> pulled(NullChirpmaker &cm)
+{
+  std::vector<uint64_t> v;
+  uint8_t level;
+  uint32_t us;
+  while (cm.pull(level, us)) if (us) v.push_back((uint64_t)us * RecorderSink::TICKS_PER_US << 1 | level);
+  return v;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Every bird started non-blocking has the edges of birdVoice()
+void test_birds_match_blocking()
+{
+  static NullChirpmaker cm(TEST_PIN);
+  for (uint16_t b = 0; b < cm.birds().size(); b++)
+  {
+    std::vector<uint64_t> expected = blocking([b](auto &rec) { randomSeed(b + 1); rec.birdVoice(b, 20); });
+    randomSeed(b + 1);
+    TEST_ASSERT_TRUE(cm.startBird(b, 20));
+    TEST_ASSERT_TRUE(cm.isBusy());
+    TEST_ASSERT_TRUE_MESSAGE(pulled(cm) == expected, cm.birds()[b].name);
+    TEST_ASSERT_FALSE(cm.isBusy());
+  }
+}
+
+// A chirp longer than a program and a phaser play like the blocking calls
+void test_long_chirp_and_phaser()
+{
+  static NullChirpmaker cm(TEST_PIN);
+  TEST_ASSERT_TRUE(cm.startChirp(1000, 4000, 200, 2, 3, linearScale, 30, 15));
+  TEST_ASSERT_TRUE(pulled(cm) == blocking([](auto &rec) { rec.chirp(1000, 4000, 200, 2, 3, linearScale, 30, 15); }));
+  TEST_ASSERT_TRUE(cm.startPhaser(1500, 30, 5, 95, 2, 200));
+  TEST_ASSERT_TRUE(pulled(cm) == blocking([](auto &rec) { rec.phaser(1500, 30, 5, 95, 2, 200); }));
+}
+
+// tick() switches the pin when the time of an edge has come
+void test_tick_on_fake_clock()
+{
+  Chirpmaker cm(TEST_PIN);
+  TEST_ASSERT_TRUE(cm.startPhaser(1000, 2, 50, 50, 1, 0));   // 2 periods of 500 us HIGH, 500 us LOW
+  TEST_ASSERT_TRUE(cm.tick(1000));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(TEST_PIN));
+  TEST_ASSERT_TRUE(cm.tick(1499));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(TEST_PIN));
+  TEST_ASSERT_TRUE(cm.tick(1500));
+  TEST_ASSERT_EQUAL(LOW, digitalRead(TEST_PIN));
+  TEST_ASSERT_TRUE(cm.tick(2000));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(TEST_PIN));
+  TEST_ASSERT_TRUE(cm.tick(2700));   // late, the level that is due now
+  TEST_ASSERT_EQUAL(LOW, digitalRead(TEST_PIN));
+  TEST_ASSERT_TRUE(cm.tick(2999));
+  TEST_ASSERT_FALSE(cm.tick(3000));
+  TEST_ASSERT_FALSE(cm.isBusy());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(TEST_PIN));
+}
+
+// stop() silences the buzzer at once
+void test_stop()
+{
+  Chirpmaker cm(TEST_PIN);
+  randomSeed(1);
+  TEST_ASSERT_TRUE(cm.startConcert(100));
+  TEST_ASSERT_TRUE(cm.tick(0));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(TEST_PIN));
+  cm.stop();
+  TEST_ASSERT_FALSE(cm.isBusy());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(TEST_PIN));
+  TEST_ASSERT_FALSE(cm.tick(1000000));
+}
+
+// A sound that does not fit into the script is not played at all
+void test_overflow()
+{
+  static NullChirpmaker cm(TEST_PIN);
+  uint8_t song[] = {S_PUSH8(0), S_REPEAT, S_PUSH16(2000), S_PUSH16(3000), S_PUSH8(10), S_PUSH8(2), S_PUSH8(1), S_PUSH8(50), S_PUSH8(5),
+                    S_CHIRP(GEN_LINEAR), S_LOOP, S_END};
+  song[1] = CHIRPMAKER_CALLS - 1;   // and the closing pause
+  TEST_ASSERT_TRUE(cm.startSong(song, 20));
+  TEST_ASSERT_FALSE(cm.overflowed());
+  cm.stop();
+  song[1] = CHIRPMAKER_CALLS;
+  TEST_ASSERT_FALSE(cm.startSong(song, 20));
+  TEST_ASSERT_TRUE(cm.overflowed());
+  TEST_ASSERT_FALSE(cm.isBusy());
+
+  TEST_ASSERT_FALSE(cm.startChirp(2000, 3000, 40000, 1, 1, linearScale, 50, 0));
+  TEST_ASSERT_TRUE(cm.overflowed());
+  TEST_ASSERT_TRUE(cm.startChirp(2000, 3000, 30000, 1, 1, linearScale, 50, 0));
+  TEST_ASSERT_FALSE(cm.overflowed());
+  cm.stop();
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_birds_match_blocking);
+  RUN_TEST(test_long_chirp_and_phaser);
+  RUN_TEST(test_tick_on_fake_clock);
+  RUN_TEST(test_stop);
+  RUN_TEST(test_overflow);
+  return UNITY_END();
+}
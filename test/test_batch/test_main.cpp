@@ -0,0 +1,98 @@
+/**
+ * Batch generators: the batch forms give the values of the scalar ones for
+ * any split into batches, batchOf() finds them and fillSteps() falls back
+ * to step by step for other functions.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+struct Pair
+{
+  FreqGen scalar;
+  FreqGenBatch batch;
+};
+
+static const Pair pairs[] =
+{
+  {linearScale, linearScaleBatch}, {chromaticScale, chromaticScaleBatch},
+  {sinePiScale, sinePiScaleBatch}, {sine2PiScale, sine2PiScaleBatch},
+  {cosinePiScale, cosinePiScaleBatch}, {cosine2PiScale, cosine2PiScaleBatch},
+  {atanPiScale, atanPiScaleBatch}, {atan2PiScale, atan2PiScaleBatch},
+};
+
+struct SincPair
+{
+  FreqGenSinc scalar;
+  FreqGenSincBatch batch;
+};
+
+static const SincPair sincPairs[] =
+{
+  {sincScaleNpi_Npi, sincScaleNpi_NpiBatch}, {sincScale0_Npi, sincScale0_NpiBatch}, {sincScaleNpi_0, sincScaleNpi_0Batch},
+};
+
+static double userScale(int stepNbr, double fStart, double fStop, int nSteps)
+{
+  return fStart + (fStop - fStart) * stepNbr * stepNbr / (nSteps * nSteps);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Bit for bit the scalar values, whole or in batches of 7 steps
+void test_batch_equals_scalar()
+{
+  const int nSteps = 50;
+  double whole[nSteps + 1], pieces[nSteps + 1];
+  for (const Pair &p : pairs)
+  {
+    p.batch(whole, 0, nSteps + 1, 1300, 4100, nSteps);
+    for (int s = 0; s <= nSteps; s += 7) p.batch(pieces + s, s, nSteps + 1 - s < 7 ? nSteps + 1 - s : 7, 1300, 4100, nSteps);
+    for (int s = 0; s <= nSteps; s++)
+    {
+      double f = p.scalar(s, 1300, 4100, nSteps);
+      TEST_ASSERT_EQUAL_MEMORY(&f, &whole[s], sizeof(f));
+      TEST_ASSERT_EQUAL_MEMORY(&f, &pieces[s], sizeof(f));
+    }
+  }
+  for (const SincPair &p : sincPairs)
+    for (int nPi = 1; nPi <= 4; nPi++)
+    {
+      p.batch(whole, 0, nSteps + 1, 1300, 4100, nSteps, nPi);
+      for (int s = 0; s <= nSteps; s++)
+      {
+        double f = p.scalar(s, 1300, 4100, nSteps, nPi);
+        TEST_ASSERT_EQUAL_MEMORY(&f, &whole[s], sizeof(f));
+      }
+    }
+}
+
+// batchOf() knows the library generators and nothing else
+void test_batch_of()
+{
+#if ! CHIRPMAKER_INCREMENTAL
+  for (const Pair &p : pairs) TEST_ASSERT_TRUE(batchOf(p.scalar) == p.batch);
+  for (const SincPair &p : sincPairs) TEST_ASSERT_TRUE(batchOf(p.scalar) == p.batch);
+#endif
+  TEST_ASSERT_TRUE(batchOf(userScale) == nullptr);
+}
+
+// Any other function is called step by step
+void test_fill_steps_of_user_function()
+{
+  double freqs[11];
+  fillSteps(freqs, 0, 11, 1000, 2000, 10, userScale);
+  for (int s = 0; s <= 10; s++) TEST_ASSERT_TRUE(userScale(s, 1000, 2000, 10) == freqs[s]);
+  fillSteps(freqs, 4, 3, 1000, 2000, 10, userScale);
+  for (int i = 0; i < 3; i++) TEST_ASSERT_TRUE(userScale(4 + i, 1000, 2000, 10) == freqs[i]);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_batch_equals_scalar);
+  RUN_TEST(test_batch_of);
+  RUN_TEST(test_fill_steps_of_user_function);
+  return UNITY_END();
+}
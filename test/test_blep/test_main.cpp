@@ -0,0 +1,112 @@
+/**
+ * BlepSink: the aliases of a narrow pulse train, the vector conversion and
+ * the samples flush() hands on.
+ */
+#include <unity.h>
+#include <algorithm>
+#include "../ChirpTest.h"
+
+/**
+ * Power of the aliases relative to the signal in dB: the bins around DC
+ * and around the harmonics below Nyquist are the signal, the rest alias
+ */
+static double aliasDb(const std::vector<int16_t> &x, double f0, uint32_t rate)
+{
+  const size_t N = 16384;
+  std::vector<double> power = powerSpectrum(x, 1000, N);   // past the start
+  double signal = 0, alias = 0;
+  for (size_t b = 0; b < power.size(); b++)
+  {
+    double f = (double)b * rate / N, h = round(f / f0);
+    bool harmonic = h * f0 < rate / 2.0 && fabs(f - h * f0) * N / rate <= 5;
+    (harmonic ? signal : alias) += power[b];
+  }
+  return 10 * log10(alias / signal);
+}
+
+// A pulse train of period and high ticks through sink
+template <class Sink>
+static std::vector<int16_t> pulses(uint32_t rate, uint32_t period, uint32_t high)
+{
+  static Sink sink;
+  Samples out;
+  sink.setOutput(rate, Samples::block, &out);
+  while (sink.samples() < 20000)
+  {
+    sink.write(HIGH, high);
+    sink.write(LOW, period - high);
+  }
+  sink.flush();
+  return out.v;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// 5 % duty at 5.5 kHz as in _bird10, and 50 % at 2.2 kHz
+void test_aliases()
+{
+  struct Case { uint32_t period, high; } cases[] = {{1810, 91}, {1810, 905}, {4400, 2200}};
+  for (uint32_t rate : {44100u, 48000u})
+  {
+    for (auto c : cases)
+    {
+      double f0 = (double)BlepSink::TICK_HZ / c.period;
+      double naive = aliasDb(pulses<PcmSink>(rate, c.period, c.high), f0, rate);
+      double blep = aliasDb(pulses<BlepSink>(rate, c.period, c.high), f0, rate);
+      TEST_ASSERT_GREATER_THAN_DOUBLE(-30, naive);
+      TEST_ASSERT_LESS_THAN_DOUBLE(-70, blep);
+    }
+  }
+}
+
+// Away from the edges a long step settles at the amplitude
+void test_step_settles()
+{
+  BlepSink sink;
+  Samples out;
+  sink.setOutput(44100, Samples::block, &out, 10000);
+  sink.write(HIGH, 1000ULL * BlepSink::TICK_HZ / 44100);
+  sink.write(LOW, 1000ULL * BlepSink::TICK_HZ / 44100);
+  sink.flush();
+  TEST_ASSERT_EQUAL_UINT64(2000, out.v.size());
+  for (size_t i = BlepSink::TAPS; i < 1000 - BlepSink::TAPS; i++) TEST_ASSERT_TRUE(abs(out.v[i] - 10000) <= 2);
+  for (size_t i = 1000 + BlepSink::TAPS; i < out.v.size(); i++) TEST_ASSERT_TRUE(abs(out.v[i] + 10000) <= 2);
+}
+
+// The vector conversion rounds and saturates like the scalar one
+void test_conversion()
+{
+  std::vector<float> in(1000);
+  for (size_t i = 0; i < in.size(); i++) in[i] = (i % 7 == 0 ? 40000.0f : 1.0f) * sinf(i * 0.37f) * 33000 / (1 + i % 3) + (i % 4) * 0.5f;
+  std::vector<int16_t> vec(in.size()), ref(in.size());
+  BlepSink::convert(in.data(), vec.data(), in.size());
+  for (size_t i = 0; i < in.size(); i++) ref[i] = (int16_t)lrintf(std::min(32767.0f, std::max(-32768.0f, in[i])));
+  TEST_ASSERT_TRUE(vec == ref);
+}
+
+// flush() hands on whatever is pending, more than a block too, in blocks of at most BLOCK_SIZE
+void test_flush()
+{
+  for (uint32_t n = 0; n <= BlepSink::BLOCK_SIZE + BlepSink::TAPS; n++)
+  {
+    BlepSink sink;
+    Samples out;
+    sink.setOutput(44100, Samples::block, &out);
+    sink.write(HIGH, (uint64_t)n * BlepSink::TICK_HZ / 44100);
+    sink.flush();
+    TEST_ASSERT_EQUAL_UINT64(sink.samples(), out.v.size());
+    TEST_ASSERT_LESS_OR_EQUAL(BlepSink::BLOCK_SIZE, out.largest);
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_aliases);
+  RUN_TEST(test_step_settles);
+  RUN_TEST(test_conversion);
+  RUN_TEST(test_flush);
+  return UNITY_END();
+}
@@ -0,0 +1,196 @@
+/**
+ * ProgramCache: programs kept on the second miss of their key, the keys
+ * of the generators, least recently used programs dropped from a full
+ * pool, and a Chirpmaker that plays the same edges with a cache.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+// Level and ticks of each edge of whatever play() does
+template <class Play>
+static std::vector<uint64_t> recorded(Recorder &cm, Play play)
+{
+  static Edge recording[100000];
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+// The key of a chirp of nSteps from 1000 Hz to fStop with gen, and in prog the program of the chirp with Sine2Pi
+static ProgramCache::Key keyOf(double fStop, int nSteps, ChirpProgram &prog, const AnyFreqGen &gen = Sine2Pi())
+{
+  prog.compileChirp(1000, fStop, nSteps, 2, 1, Sine2Pi(), 50, 10);
+  return {1000, fStop, nSteps, 2, 50, 10, gen};
+}
+
+// Timing and count of each segment, not the padding
+static bool sameSegments(const Segment *a, uint16_t n, const ChirpProgram &b)
+{
+  return n == b.size() && std::equal(a, a + n, b.begin(), [](const Segment &x, const Segment &y)
+         { return x.tOn == y.tOn && x.tOff == y.tOff && x.count == y.count; });
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// A key seen for the first time is not kept, the second time it is
+void test_kept_on_second_miss()
+{
+  static Segment pool[200];
+  ProgramCache cache(pool, 200);
+  ChirpProgram prog;
+  ProgramCache::Key key = keyOf(3000, 20, prog);
+  uint16_t n = 0;
+  TEST_ASSERT_NULL(cache.find(key, n));
+  TEST_ASSERT_FALSE(cache.insert(key, prog));
+  TEST_ASSERT_EQUAL_UINT32(1, cache.rejected());
+  TEST_ASSERT_NULL(cache.find(key, n));
+  TEST_ASSERT_TRUE(cache.insert(key, prog));
+  TEST_ASSERT_EQUAL(1, cache.size());
+  TEST_ASSERT_EQUAL(prog.size(), cache.segments());
+
+  const Segment *segs = cache.find(key, n);
+  TEST_ASSERT_NOT_NULL(segs);
+  TEST_ASSERT_TRUE(sameSegments(segs, n, prog));
+  TEST_ASSERT_EQUAL_UINT32(1, cache.hits());
+  TEST_ASSERT_EQUAL_UINT32(2, cache.misses());
+
+  cache.clear();
+  TEST_ASSERT_EQUAL(0, cache.size());
+  TEST_ASSERT_NULL(cache.find(key, n));
+}
+
+// Every argument and the generator with its state are part of the key, only pure generators are kept
+void test_keys()
+{
+  ChirpProgram prog;
+  ProgramCache::Key key = keyOf(3000, 20, prog);
+  TEST_ASSERT_TRUE(key == keyOf(3000, 20, prog));
+  TEST_ASSERT_FALSE(key == keyOf(3001, 20, prog));
+  TEST_ASSERT_FALSE(key == keyOf(3000, 21, prog));
+  TEST_ASSERT_FALSE(key == keyOf(3000, 20, prog, Cosine2Pi()));
+  TEST_ASSERT_FALSE(keyOf(3000, 20, prog, Sinc(2)) == keyOf(3000, 20, prog, Sinc(3)));
+  TEST_ASSERT_FALSE(keyOf(3000, 20, prog, FreqFn{chromaticScale}) == keyOf(3000, 20, prog, Chromatic()));
+  TEST_ASSERT_EQUAL_UINT32(key.hash(), keyOf(3000, 20, prog).hash());
+
+  static Segment pool[200];
+  ProgramCache cache(pool, 200);
+  auto lambda = [](int s, double fStart, double fStop, int nSteps) { return fStart + (fStop - fStart) * s / nSteps; };
+  ProgramCache::Key impure = keyOf(3000, 20, prog, lambda);
+  uint16_t n;
+  for (int i = 0; i < 3; i++)
+  {
+    TEST_ASSERT_NULL(cache.find(impure, n));
+    TEST_ASSERT_FALSE(cache.insert(impure, prog));
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, cache.misses() + cache.rejected());
+
+  cache.enable(false);
+  TEST_ASSERT_FALSE(cache.insert(key, prog));
+  TEST_ASSERT_FALSE(cache.insert(key, prog));
+  TEST_ASSERT_EQUAL(0, cache.size());
+}
+
+// A full pool drops the least recently used programs and keeps the others intact
+void test_lru_eviction()
+{
+  ChirpProgram progs[4];
+  ProgramCache::Key keys[4];
+  uint16_t total = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    keys[i] = keyOf(2000 + 500 * i, 10 + i, progs[i]);
+    total += progs[i].size();
+  }
+  static Segment pool[200];
+  ProgramCache cache(pool, total - 1);   // one segment short for all four
+  for (int i = 0; i < 3; i++)
+  {
+    cache.insert(keys[i], progs[i]);
+    TEST_ASSERT_TRUE(cache.insert(keys[i], progs[i]));
+  }
+  uint16_t n;
+  TEST_ASSERT_NOT_NULL(cache.find(keys[0], n));   // 1 is now the oldest
+  cache.insert(keys[3], progs[3]);
+  TEST_ASSERT_TRUE(cache.insert(keys[3], progs[3]));
+  TEST_ASSERT_EQUAL_UINT32(1, cache.evictions());
+  TEST_ASSERT_EQUAL(3, cache.size());
+  TEST_ASSERT_NULL(cache.find(keys[1], n));
+  for (int i : {0, 2, 3})
+  {
+    const Segment *segs = cache.find(keys[i], n);
+    TEST_ASSERT_NOT_NULL(segs);
+    TEST_ASSERT_TRUE(sameSegments(segs, n, progs[i]));
+  }
+  TEST_ASSERT_EQUAL(total - progs[1].size(), cache.segments());
+
+  // A program larger than the pool is not kept
+  ProgramCache tiny(pool, 2);
+  tiny.insert(keys[0], progs[0]);
+  TEST_ASSERT_FALSE(tiny.insert(keys[0], progs[0]));
+}
+
+// At most MAX_PROGRAMS programs, however small
+void test_max_programs()
+{
+  static Segment pool[2000];
+  ProgramCache cache(pool, 2000);
+  ChirpProgram prog;
+  for (int i = 0; i <= ProgramCache::MAX_PROGRAMS; i++)
+  {
+    ProgramCache::Key key = keyOf(2000 + i, 3, prog);
+    cache.insert(key, prog);
+    cache.insert(key, prog);
+  }
+  TEST_ASSERT_EQUAL(ProgramCache::MAX_PROGRAMS, cache.size());
+  TEST_ASSERT_EQUAL_UINT32(1, cache.evictions());
+  uint16_t n;
+  TEST_ASSERT_NULL(cache.find(keyOf(2000, 3, prog), n));
+  TEST_ASSERT_NOT_NULL(cache.find(keyOf(2001, 3, prog), n));
+}
+
+// A Chirpmaker plays the same edges with a cache, the second time from it
+void test_chirpmaker_with_cache()
+{
+  static Segment pool[500];
+  ProgramCache cache(pool, 500);
+  Recorder plain(TEST_PIN), cached(TEST_PIN);
+  TEST_ASSERT_NULL(plain.programCache());
+  cached.useProgramCache(&cache);
+  TEST_ASSERT_TRUE(cached.programCache() == &cache);
+
+  auto sound = [](Recorder &cm)
+  {
+    cm.chirp(1500, 4500, 30, 2, 2, Sine2Pi(), 50, 20);
+    cm.chirp(2500, 3500, 12, 3, 1, FreqFn{atanPiScale}, 40, 0);
+  };
+  std::vector<uint64_t> reference = recorded(plain, sound);
+  for (int i = 0; i < 3; i++) TEST_ASSERT_TRUE(recorded(cached, sound) == reference);
+  if (ChirpProgram::MAX_SEGMENTS > 31)   // a chirp compiled in pieces is not kept
+  {
+    TEST_ASSERT_EQUAL(2, cache.size());
+    TEST_ASSERT_EQUAL_UINT32(2, cache.hits());
+    TEST_ASSERT_EQUAL_UINT32(4, cache.misses());
+  }
+
+  uint32_t hits = cache.hits();
+  cached.useProgramCache(nullptr);
+  TEST_ASSERT_TRUE(recorded(cached, sound) == reference);
+  TEST_ASSERT_EQUAL_UINT32(hits, cache.hits());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_kept_on_second_miss);
+  RUN_TEST(test_keys);
+  RUN_TEST(test_lru_eviction);
+  RUN_TEST(test_max_programs);
+  RUN_TEST(test_chirpmaker_with_cache);
+  return UNITY_END();
+}
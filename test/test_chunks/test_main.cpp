@@ -0,0 +1,80 @@
+/**
+ * ConcertRenderer: the timeline of compile() and the samples of render(),
+ * which must not depend on the number of threads or the chunk length.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "ConcertRenderer.h"
+
+static ConcertRenderer<NullChirpmaker> renderer;
+
+static Concert<NullChirpmaker>::Plan plan()
+{
+  Concert<NullChirpmaker>::Plan p;
+  p.birdsPerMinute = 30;
+  p.maxOverlap = 3;
+  p.seed = 7;
+  return p;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// The same plan gives the same timeline, on any number of threads
+void test_compile()
+{
+  renderer.compile(plan(), 4, 120000);
+  std::vector<ConcertRenderer<NullChirpmaker>::Segment> one = renderer.segments();
+  TEST_ASSERT_GREATER_THAN(10, one.size());
+  renderer.compile(plan(), 4, 120000, 4);
+  const auto &four = renderer.segments();
+  TEST_ASSERT_EQUAL(one.size(), four.size());
+  for (size_t i = 0; i < one.size(); i++)
+  {
+    TEST_ASSERT_EQUAL_UINT64(one[i].start, four[i].start);
+    TEST_ASSERT_EQUAL_UINT64(one[i].end, four[i].end);
+    TEST_ASSERT_EQUAL_UINT32(one[i].seed, four[i].seed);
+    TEST_ASSERT_TRUE(one[i].end > one[i].start);
+    TEST_ASSERT_TRUE(i == 0 || one[i].start >= one[i - 1].start);
+    TEST_ASSERT_TRUE(one[i].voice < 4);
+  }
+}
+
+// Chunks on threads give the samples of one chunk on one thread, bit for bit
+void test_chunks_match_one_piece()
+{
+  renderer.compile(plan(), 4, 120000);
+  Samples ref;
+  uint64_t n = renderer.render(22050, Samples::block, &ref, 1, 0);
+  TEST_ASSERT_EQUAL_UINT64(n, ref.v.size());
+  TEST_ASSERT_EQUAL_UINT64((renderer.ticks() * 22050 + ConcertRenderer<NullChirpmaker>::TICK_HZ - 1) / ConcertRenderer<NullChirpmaker>::TICK_HZ, n);   // up to the end of the last bird
+  for (unsigned threads : {1u, 3u, 8u})
+  {
+    for (uint32_t msChunk : {500u, 5000u})
+    {
+      Samples out;
+      renderer.render(22050, Samples::block, &out, threads, msChunk);
+      TEST_ASSERT_GREATER_THAN(1, renderer.chunks());
+      TEST_ASSERT_TRUE(out.v == ref.v);
+    }
+  }
+}
+
+// Short chunks cut through birds, which then carry on in the next chunk
+void test_birds_carried_over()
+{
+  renderer.compile(plan(), 4, 120000);
+  Samples out;
+  renderer.render(22050, Samples::block, &out, 2, 500);
+  TEST_ASSERT_GREATER_THAN(0, renderer.carried());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_compile);
+  RUN_TEST(test_chunks_match_one_piece);
+  RUN_TEST(test_birds_carried_over);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/**
+ * SampleClip and SamplePlayer: the samples of a rendered clip, the context
+ * of its sound, playback through two buffers and rendering on threads.
+ */
+#include <unity.h>
+#include <thread>
+#include <algorithm>
+#include "../ChirpTest.h"
+#include "SamplePlayer.h"
+
+// The bird through a PcmSink as it comes, the reference of a clip
+static std::vector<int16_t> pcmBird(uint16_t bird, uint32_t rate)
+{
+  static PcmChirpmaker cm(TEST_PIN);
+  Samples out;
+  cm.sink().setOutput(rate, Samples::block, &out);
+  randomSeed(bird + 1);
+  cm.birdVoice(bird, 0);
+  cm.sink().flush();
+  return out.v;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// A clip holds what PcmSink gives, 8 bit ones cut to the upper byte
+void test_render_matches_pcm()
+{
+  for (uint16_t bird : {8, 11})
+  {
+    std::vector<int16_t> ref = pcmBird(bird, 22050);
+    SampleClip pcm16, pcm8;
+    randomSeed(bird + 1);
+    TEST_ASSERT_TRUE(pcm16.render(bird, 22050, SampleClip::PCM16));
+    randomSeed(bird + 1);
+    TEST_ASSERT_TRUE(pcm8.render(bird, 22050, SampleClip::PCM8));
+    TEST_ASSERT_TRUE(samplesOf(pcm16) == ref);
+    for (int16_t &s : ref) s = (s >> 8) << 8;
+    TEST_ASSERT_TRUE(samplesOf(pcm8) == ref);
+    TEST_ASSERT_EQUAL_UINT32(ref.size(), pcm8.bytes());
+    TEST_ASSERT_EQUAL_UINT32(2 * ref.size(), pcm16.bytes());
+  }
+}
+
+// The sound gets its context
+void test_sound_context()
+{
+  int rings = 3;
+  SampleClip clip;
+  TEST_ASSERT_TRUE(clip.render([](PcmChirpmaker &cm, void *ctx) { cm.phoneCall(*static_cast<int *>(ctx)); }, &rings, 22050, SampleClip::PCM16));
+  PcmChirpmaker cm(TEST_PIN);
+  Samples ref;
+  cm.sink().setOutput(22050, Samples::block, &ref);
+  cm.phoneCall(3);
+  cm.sink().flush();
+  TEST_ASSERT_TRUE(samplesOf(clip) == ref.v);
+}
+
+// A clip filled through begin(), block() and end(), and one wrapped around samples in flash
+void test_begin_end_and_wrap()
+{
+  static const int16_t data[300] = {1, 2, 3, -32768, 32767};
+  SampleClip clip;
+  clip.begin(8000, SampleClip::PCM16);
+  SampleClip::block(data, 100, &clip);
+  SampleClip::block(data + 100, 200, &clip);
+  TEST_ASSERT_TRUE(clip.end());
+  TEST_ASSERT_EQUAL_UINT32(300, clip.samples());
+  TEST_ASSERT_EQUAL_MEMORY(data, clip.data(), sizeof(data));
+
+  SampleClip flash(data, 300, 8000, SampleClip::PCM16);
+  int16_t out[310];
+  flash.read(0, out, 310);
+  TEST_ASSERT_EQUAL_INT16_ARRAY(data, out, 300);
+  for (int i = 300; i < 310; i++) TEST_ASSERT_EQUAL_INT(0, out[i]);   // silence past the end
+  clip.release();
+  TEST_ASSERT_EQUAL_UINT32(0, clip.samples());
+  TEST_ASSERT_TRUE(clip.data() == nullptr);
+}
+
+// Serviced every ms, the player hands on the clip and then silence to the end of its block
+void test_playback()
+{
+  SampleClip clip;
+  randomSeed(12);
+  TEST_ASSERT_TRUE(clip.render(11, 22050, SampleClip::PCM8));
+  Samples out;
+  SamplePlayer player;
+  player.begin(22050, Samples::block, &out);
+  player.play(clip);
+  uint32_t us = 0;
+  while (player.service(us)) us += 1000;
+  std::vector<int16_t> ref = samplesOf(clip);
+  TEST_ASSERT_EQUAL_UINT32(0, player.underruns());
+  TEST_ASSERT_LESS_THAN(SamplePlayer::BLOCK_SAMPLES, out.v.size() - ref.size());
+  TEST_ASSERT_TRUE(std::equal(ref.begin(), ref.end(), out.v.begin()));
+  TEST_ASSERT_TRUE(std::all_of(out.v.begin() + ref.size(), out.v.end(), [](int16_t x) { return x == 0; }));
+}
+
+// A loop that is 50 ms late leaves the output dry once
+void test_underrun()
+{
+  SampleClip clip;
+  TEST_ASSERT_TRUE(clip.render(11, 22050, SampleClip::PCM8));
+  SamplePlayer player;
+  Samples out;
+  player.begin(22050, Samples::block, &out);
+  player.play(clip);
+  uint32_t us = 0;
+  for (; us < 500000; us += 1000) player.service(us);
+  for (us += 50000; player.service(us); us += 1000);
+  TEST_ASSERT_EQUAL_UINT32(1, player.underruns());
+}
+
+// Birds rendered on several threads at once are the birds rendered one by one
+void test_render_on_threads()
+{
+  const uint16_t birds[] = {11, 8, 3, 14};
+  std::vector<std::vector<uint8_t>> serial, parallel(4);
+  for (uint16_t b : birds)
+  {
+    randomSeed(b);
+    SampleClip c;
+    c.render(b, 22050, SampleClip::PCM8);
+    serial.emplace_back(c.data(), c.data() + c.bytes());
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([&, t]
+    {
+      hostOwnRandom();
+      randomSeed(birds[t]);
+      SampleClip c;
+      c.render(birds[t], 22050, SampleClip::PCM8);
+      parallel[t].assign(c.data(), c.data() + c.bytes());
+    });
+  for (std::thread &t : threads) t.join();
+  TEST_ASSERT_TRUE(parallel == serial);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_render_matches_pcm);
+  RUN_TEST(test_sound_context);
+  RUN_TEST(test_begin_end_and_wrap);
+  RUN_TEST(test_playback);
+  RUN_TEST(test_underrun);
+  RUN_TEST(test_render_on_threads);
+  return UNITY_END();
+}
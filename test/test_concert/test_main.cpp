@@ -0,0 +1,233 @@
+/**
+ * Concert: the timeline of a plan, its overlap, density and rates, the
+ * dispatch of due events to free voices, and render() which starts each
+ * bird at its time.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "Concert.h"
+
+// A voice that only records the birds it is asked to start, busy while told so
+struct ProbeVoice
+{
+  static auto birds() { return NullChirpmaker::birds(); }
+  bool isBusy() const { return busy; }
+  void startBird(uint16_t bird, uint32_t msPause) { started.push_back(bird); (void)msPause; }
+  bool pull(uint8_t &level, uint32_t &us) { (void)level; (void)us; return false; }
+
+  bool busy = false;
+  std::vector<uint16_t> started;
+};
+
+using Event = Concert<ProbeVoice>::Event;
+
+static ProbeVoice probes[4];
+static ProbeVoice *const voices[4] = {&probes[0], &probes[1], &probes[2], &probes[3]};
+static Concert<ProbeVoice> concert;
+
+// The first n events of plan, taken from the concert as they are planned
+static std::vector<Event> timeline(const Concert<ProbeVoice>::Plan &plan, size_t n)
+{
+  std::vector<Event> events;
+  Event e;
+  concert.begin(voices, 4, plan);
+  for (uint32_t nowMs = 0; events.size() < n; nowMs += 10000)
+  {
+    concert.plan(nowMs);
+    while (events.size() < n && concert.next(e)) events.push_back(e);
+  }
+  return events;
+}
+
+static uint32_t typicalMs(const Event &e) { return ProbeVoice::birds()[e.bird].msTypical; }
+
+void setUp()
+{
+  for (ProbeVoice &p : probes) p = ProbeVoice();
+}
+
+void tearDown() {}
+
+// The same seed gives the same events whatever random() does, another seed other events
+void test_same_seed_same_timeline()
+{
+  Concert<ProbeVoice>::Plan plan;
+  plan.seed = 5;
+  randomSeed(1);
+  std::vector<Event> a = timeline(plan, 100);
+  randomSeed(2);
+  for (int i = 0; i < 10; i++) random(1000);
+  std::vector<Event> b = timeline(plan, 100);
+  plan.seed = 6;
+  std::vector<Event> c = timeline(plan, 100);
+  bool same = true, other = false;
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    same = same && a[i].atMs == b[i].atMs && a[i].bird == b[i].bird && a[i].voice == b[i].voice;
+    other = other || a[i].atMs != c[i].atMs || a[i].bird != c[i].bird;
+  }
+  TEST_ASSERT_TRUE(same);
+  TEST_ASSERT_TRUE(other);
+}
+
+// Never more than maxOverlap birds at once, a voice is free again before its next bird
+void test_max_overlap()
+{
+  Concert<ProbeVoice>::Plan plan;
+  plan.birdsPerMinute = 60;
+  plan.maxOverlap = 2;
+  plan.msGap = 100;
+  std::vector<Event> events = timeline(plan, 500);
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    TEST_ASSERT_TRUE(events[i].voice < 4);
+    TEST_ASSERT_TRUE(i == 0 || events[i].atMs >= events[i - 1].atMs);
+    uint8_t singing = 0;
+    for (size_t j = 0; j < i; j++)
+    {
+      bool taken = events[j].atMs + typicalMs(events[j]) + plan.msGap > events[i].atMs;
+      singing += taken;
+      TEST_ASSERT_FALSE(taken && events[j].voice == events[i].voice);
+    }
+    TEST_ASSERT_TRUE(singing < plan.maxOverlap);
+  }
+}
+
+// The birds arrive birdsPerMinute on average, each as often as its rate, never one of rate 0
+void test_density_and_rates()
+{
+  static const uint8_t rates[15] = {1, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0};
+  Concert<ProbeVoice>::Plan plan;
+  plan.birdsPerMinute = 10;
+  plan.maxOverlap = 4;
+  plan.rates = rates;
+  const size_t n = 4000;
+  std::vector<Event> events = timeline(plan, n);
+  double perMinute = n * 60000.0 / events.back().atMs;
+  TEST_ASSERT_DOUBLE_WITHIN(0.1 * plan.birdsPerMinute, plan.birdsPerMinute, perMinute);
+  uint32_t count[15] = {};
+  for (const Event &e : events) count[e.bird]++;
+  for (int b = 0; b < 15; b++) TEST_ASSERT_DOUBLE_WITHIN(0.03, rates[b] / 7.0, count[b] / (double)n);
+
+  // Without rates the weights of the registry, every bird sings
+  plan.rates = nullptr;
+  uint32_t all[15] = {};
+  for (const Event &e : timeline(plan, 1000)) all[e.bird]++;
+  for (int b = 0; b < 15; b++) TEST_ASSERT_TRUE(all[b] > 0);
+}
+
+// A concert of nBirds plans no more, and is over once they have all been started and sung
+void test_length()
+{
+  Concert<ProbeVoice>::Plan plan;
+  plan.nBirds = 12;
+  plan.msAhead = 60000;
+  concert.begin(voices, 4, plan);
+  for (uint32_t nowMs = 0; nowMs < 3600000; nowMs += 1000)
+  {
+    concert.plan(nowMs);
+    concert.dispatch(nowMs);
+  }
+  TEST_ASSERT_EQUAL_UINT32(12, concert.planned());
+  TEST_ASSERT_EQUAL_UINT32(12, concert.started());
+  TEST_ASSERT_EQUAL(0, concert.pending());
+  probes[1].busy = true;
+  TEST_ASSERT_FALSE(concert.isOver());
+  probes[1].busy = false;
+  TEST_ASSERT_TRUE(concert.isOver());
+}
+
+// dispatch() starts due events only, moves them off a busy voice, and lets them wait if all are busy
+void test_dispatch()
+{
+  Concert<ProbeVoice>::Plan plan;
+  plan.birdsPerMinute = 1;
+  plan.maxOverlap = 4;
+  plan.msAhead = 0;
+  concert.begin(voices, 4, plan, 1000);
+  concert.plan(1000);
+  TEST_ASSERT_EQUAL(1, concert.pending());
+  const Event first = concert.pendingEvent(0);
+  TEST_ASSERT_EQUAL_UINT32(1000, first.atMs);
+  TEST_ASSERT_EQUAL(0, concert.dispatch(999));
+
+  for (ProbeVoice &p : probes) p.busy = true;
+  TEST_ASSERT_EQUAL(0, concert.dispatch(1000));
+  TEST_ASSERT_EQUAL(1, concert.pending());
+
+  uint8_t other = (first.voice + 1) % 4;
+  probes[other].busy = false;
+  TEST_ASSERT_EQUAL(1, concert.dispatch(1030));
+  TEST_ASSERT_EQUAL(1, probes[other].started.size());
+  TEST_ASSERT_EQUAL(first.bird, probes[other].started[0]);
+  TEST_ASSERT_EQUAL(0, probes[first.voice].started.size());
+  TEST_ASSERT_EQUAL_UINT32(1, concert.moved());
+  TEST_ASSERT_EQUAL_UINT32(30, concert.msLateMax());
+}
+
+// render() starts each bird at its time on a fresh voice, silent in between, with the HIGH time of the birds alone
+void test_render()
+{
+  static NullChirpmaker *cms[1];
+  if (! cms[0]) cms[0] = new NullChirpmaker(TEST_PIN);
+  Concert<NullChirpmaker>::Plan plan;
+  plan.nBirds = 2;
+  plan.maxOverlap = 1;
+  plan.msGap = 5000;
+  plan.msAhead = 60000;
+  plan.seed = 3;
+  const uint32_t rate = 22050;
+
+  // The birds alone, their length and HIGH time in us
+  static Concert<NullChirpmaker> mix;
+  mix.begin(cms, 1, plan);
+  mix.plan(0);
+  TEST_ASSERT_EQUAL(2, mix.pending());
+  const Concert<NullChirpmaker>::Event first = mix.pendingEvent(0), second = mix.pendingEvent(1);
+  uint64_t lengthUs = 0, highUs = 0;
+  randomSeed(11);
+  for (const Concert<NullChirpmaker>::Event *e : {&first, &second})
+  {
+    uint8_t level;
+    uint32_t us;
+    cms[0]->startBird(e->bird, 0);
+    for (uint64_t t = 0; cms[0]->pull(level, us); t += us)
+    {
+      if (level) highUs += us;
+      if (e == &first) lengthUs = t + us;
+    }
+  }
+
+  randomSeed(11);
+  mix.begin(cms, 1, plan);
+  Samples out;
+  static int16_t block[1000];
+  while (! mix.isOver())
+  {
+    mix.render(block, 1000, rate, 8000);
+    out.v.insert(out.v.end(), block, block + 1000);
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, mix.started());
+  uint64_t high = 0;
+  for (int16_t s : out.v) high += s == 8000;
+  TEST_ASSERT_DOUBLE_WITHIN(0.002 * highUs, highUs, high * 1e6 / rate);
+
+  size_t end1 = lengthUs * rate / 1000000 + 1, start2 = (uint64_t)second.atMs * rate / 1000;
+  TEST_ASSERT_TRUE(end1 < start2);
+  for (size_t i = end1; i < start2; i++) TEST_ASSERT_EQUAL(0, out.v[i]);
+  size_t firstHigh = start2;
+  while (firstHigh < out.v.size() && out.v[firstHigh] == 0) firstHigh++;
+  TEST_ASSERT_TRUE(firstHigh < start2 + rate / 20);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_same_seed_same_timeline);
+  RUN_TEST(test_max_overlap);
+  RUN_TEST(test_density_and_rates);
+  RUN_TEST(test_length);
+  RUN_TEST(test_dispatch);
+  RUN_TEST(test_render);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+/**
+ * CurveCache and the Cached generators: the values of the generators
+ * themselves, hits and misses, a pool that is refilled from its start and
+ * a cache per thread on the host.
+ */
+#include <unity.h>
+#include <thread>
+#include "../ChirpTest.h"
+#include "CurveCache.h"
+
+// Cached<Gen> gives the values of Gen, from the cache up to CHIRPMAKER_CURVE_STEPS steps and beyond
+template <class Gen>
+static void sameAsGenerator(const Gen &gen)
+{
+  for (int nSteps : {1, 5, 17, CHIRPMAKER_CURVE_STEPS, CHIRPMAKER_CURVE_STEPS + 1, 300})
+  {
+    std::vector<double> direct(nSteps + 1), cached(nSteps + 1);
+    gen.fill(direct.data(), 0, nSteps + 1, 1320, 3880, nSteps);
+    Cached<Gen>(gen).fill(cached.data(), 0, nSteps + 1, 1320, 3880, nSteps);
+    for (int s = 0; s <= nSteps; s++) TEST_ASSERT_DOUBLE_WITHIN(1e-9, direct[s], cached[s]);
+
+    // The periods are those of the generator
+    for (int s = 0; s <= nSteps; s++)
+    {
+      uint32_t on, off, onCached, offCached;
+      chirpPeriod(Real(direct[s]), 50, on, off);
+      chirpPeriod(Real(cached[s]), 50, onCached, offCached);
+      TEST_ASSERT_EQUAL_UINT32(on, onCached);
+      TEST_ASSERT_EQUAL_UINT32(off, offCached);
+    }
+  }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_cached_equals_generator()
+{
+  sameAsGenerator(SinePi());
+  sameAsGenerator(Sine2Pi());
+  sameAsGenerator(CosinePi());
+  sameAsGenerator(Cosine2Pi());
+  sameAsGenerator(AtanPi());
+  sameAsGenerator(Atan2Pi());
+  sameAsGenerator(Sinc(3));
+  sameAsGenerator(SincNpi_0(2));
+  sameAsGenerator(Sinc0_Npi(5));
+}
+
+// A curve is computed once per generator, step count and nPi of a sinc
+void test_hits_and_misses()
+{
+  Real pool[1000];
+  CurveCache cache(pool, 1000);
+  const Real *a = cache.get(SINE_PI_CURVE, 20, 0);
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_TRUE(cache.get(SINE_PI_CURVE, 20, 0) == a);
+  TEST_ASSERT_TRUE(cache.get(SINE_PI_CURVE, 20, 7) == a);   // nPi is for the sinc curves only
+  TEST_ASSERT_EQUAL_UINT32(1, cache.misses());
+  TEST_ASSERT_EQUAL_UINT32(2, cache.hits());
+  TEST_ASSERT_TRUE(cache.get(SINE_PI_CURVE, 21, 0) != a);
+  TEST_ASSERT_TRUE(cache.get(SINE_2PI_CURVE, 20, 0) != a);
+  const Real *sinc2 = cache.get(SINC_NPI_NPI_CURVE, 20, 2);
+  TEST_ASSERT_TRUE(cache.get(SINC_NPI_NPI_CURVE, 20, 3) != sinc2);
+  TEST_ASSERT_TRUE(cache.get(SINC_NPI_NPI_CURVE, 20, 2) == sinc2);
+  TEST_ASSERT_EQUAL_UINT32(5, cache.misses());
+
+  // The values of the curve itself
+  Real curve[21];
+  curveT(curve, SINE_PI_CURVE, 20, 0);
+  TEST_ASSERT_EQUAL_MEMORY(curve, a, sizeof(curve));
+
+  cache.clear();
+  TEST_ASSERT_EQUAL_UINT32(0, cache.hits() + cache.misses());
+  cache.get(SINE_PI_CURVE, 20, 0);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.misses());
+}
+
+// A full pool is refilled from its start, the curves that are overwritten drop out
+void test_pool_refill()
+{
+  Real pool[30];
+  CurveCache cache(pool, 30);
+  const Real *a = cache.get(ATAN_PI_CURVE, 10, 0);   // 0 .. 10
+  const Real *b = cache.get(ATAN_2PI_CURVE, 10, 0);  // 11 .. 21
+  const Real *c = cache.get(COSINE_PI_CURVE, 10, 0); // 0 .. 10, a drops out
+  TEST_ASSERT_TRUE(a == pool && b == pool + 11 && c == pool);
+  TEST_ASSERT_EQUAL_UINT32(3, cache.misses());
+  TEST_ASSERT_TRUE(cache.get(ATAN_2PI_CURVE, 10, 0) == b);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.hits());
+  TEST_ASSERT_TRUE(cache.get(ATAN_PI_CURVE, 10, 0) == pool + 11);   // computed again, over b
+  TEST_ASSERT_EQUAL_UINT32(4, cache.misses());
+  cache.get(ATAN_2PI_CURVE, 10, 0);
+  TEST_ASSERT_EQUAL_UINT32(5, cache.misses());
+
+  // A curve larger than the pool is not cached
+  TEST_ASSERT_NULL(cache.get(SINE_PI_CURVE, 30, 0));
+  TEST_ASSERT_NULL(cache.get(SINE_PI_CURVE, -1, 0));
+}
+
+// At most MAX_CURVES curves are kept, the oldest drops out first
+void test_entries_run_out()
+{
+  static Real pool[20000];
+  CurveCache cache(pool, 20000);
+  for (int n = 1; n <= CurveCache::MAX_CURVES + 1; n++) cache.get(SINE_2PI_CURVE, n, 0);
+  TEST_ASSERT_EQUAL_UINT32(CurveCache::MAX_CURVES + 1, cache.misses());
+  cache.get(SINE_2PI_CURVE, CurveCache::MAX_CURVES, 0);
+  cache.get(SINE_2PI_CURVE, 2, 0);
+  TEST_ASSERT_EQUAL_UINT32(2, cache.hits());
+  cache.get(SINE_2PI_CURVE, 1, 0);
+  TEST_ASSERT_EQUAL_UINT32(CurveCache::MAX_CURVES + 2, cache.misses());
+}
+
+// On the host every thread has a cache of its own
+void test_cache_per_thread()
+{
+  CurveCache *mine = &CurveCache::shared(), *other = nullptr;
+  std::thread t([&] { other = &CurveCache::shared(); });
+  t.join();
+  TEST_ASSERT_TRUE(other != nullptr && other != mine);
+  TEST_ASSERT_TRUE(&CurveCache::shared() == mine);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_cached_equals_generator);
+  RUN_TEST(test_hits_and_misses);
+  RUN_TEST(test_pool_refill);
+  RUN_TEST(test_entries_run_out);
+  RUN_TEST(test_cache_per_thread);
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+/**
+ * DdsEngine: exact periods where the tick divides them, the average
+ * frequency of a run of periods, the jitter of one tick, the duty cycle
+ * and a change of tone that keeps the phase.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "DdsEngine.h"
+
+static const uint32_t TICK_HZ = 10000000;
+
+void setUp() {}
+
+void tearDown() {}
+
+// A frequency whose period is a whole number of ticks has exact periods
+void test_exact_period()
+{
+  DdsEngine dds(TICK_HZ);
+  dds.setTone(1000, 50);
+  for (int i = 0; i < 100; i++)
+  {
+    uint32_t on, off;
+    dds.nextPeriod(on, off);
+    TEST_ASSERT_EQUAL_UINT32(5000, on);
+    TEST_ASSERT_EQUAL_UINT32(5000, off);
+  }
+}
+
+// Any run of periods averages to the frequency, each period is off by one tick at most
+void test_average_frequency()
+{
+  for (double f : {440.0, 4321.7, 5555.5, 12345.6})
+  {
+    DdsEngine dds(TICK_HZ);
+    dds.setTone(f, 30);
+    TEST_ASSERT_TRUE(fabs(dds.frequency() - f) <= TICK_HZ / 4294967296.0);
+    const int n = 20000;
+    uint64_t ticks = 0;
+    for (int i = 0; i < n; i++)
+    {
+      uint32_t on, off;
+      dds.nextPeriod(on, off);
+      double period = on + off;
+      TEST_ASSERT_TRUE(fabs(period - TICK_HZ / f) < 1.0);
+      ticks += on + off;
+    }
+    double realized = (double)n * TICK_HZ / ticks;
+    TEST_ASSERT_TRUE(fabs(realized - dds.frequency()) / f < 1e-7);
+  }
+}
+
+// The high part takes duty percent of the period
+void test_duty()
+{
+  DdsEngine dds(TICK_HZ);
+  for (int duty : {0, 5, 50, 95, 100})
+  {
+    dds.reset();
+    dds.setTone(2000, duty);
+    uint64_t high = 0, all = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+      uint32_t on, off;
+      dds.nextPeriod(on, off);
+      high += on;
+      all += on + off;
+    }
+    TEST_ASSERT_TRUE(fabs(100.0 * high / all - duty) < 0.01);
+  }
+  dds.setTone(2000, -10);   // clamped
+  uint32_t on, off;
+  dds.nextPeriod(on, off);
+  TEST_ASSERT_EQUAL_UINT32(0, on);
+}
+
+// setTone() keeps the phase, the limit is two ticks per period
+void test_tone_change()
+{
+  DdsEngine once(TICK_HZ), twice(TICK_HZ);
+  once.setTone(3000, 50);
+  twice.setTone(3000, 50);
+  for (int i = 0; i < 20; i++)
+  {
+    if (i == 7) twice.setTone(3000, 50);
+    uint32_t on, off, on2, off2;
+    once.nextPeriod(on, off);
+    twice.nextPeriod(on2, off2);
+    TEST_ASSERT_EQUAL_UINT32(on, on2);
+    TEST_ASSERT_EQUAL_UINT32(off, off2);
+  }
+
+  uint32_t on, off;
+  once.setTone(TICK_HZ, 50);
+  once.reset();
+  once.nextPeriod(on, off);
+  TEST_ASSERT_EQUAL_UINT32(2, on + off);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_exact_period);
+  RUN_TEST(test_average_frequency);
+  RUN_TEST(test_duty);
+  RUN_TEST(test_tone_change);
+  return UNITY_END();
+}
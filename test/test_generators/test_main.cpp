@@ -0,0 +1,147 @@
+/**
+ * Generator objects: the same values and edges as the functions, fill()
+ * and a single step agree, a lambda is a generator, sinc chirps repeat and
+ * AnyFreqGen compares pure generators only.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+// Level and ticks of each edge of whatever play() does
+template <class Play>
+static std::vector<uint64_t> recorded(Play play)
+{
+  static Edge recording[100000];
+  static Recorder cm(TEST_PIN);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+// The object plays the edges of the function
+template <class Gen>
+static void sameAsFunction(FreqGen fgen, const Gen &gen)
+{
+  TEST_ASSERT_TRUE(recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, fgen, 50, 20); })
+                == recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, gen, 50, 20); }));
+}
+
+// A sinc function takes nPi in the place of nChirps
+template <class Gen>
+static void sameAsSincFunction(FreqGenSinc fgen, const Gen &gen)
+{
+  TEST_ASSERT_TRUE(recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 3, fgen, 50, 20); })
+                == recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 1, gen, 50, 20); }));
+}
+
+// operator() gives the value fill() gives for the same step
+template <class Gen>
+static void stepEqualsFill(const Gen &gen)
+{
+  const int nSteps = 40;
+  double freqs[nSteps + 1];
+  gen.fill(freqs, 0, nSteps + 1, 1200, 5100, nSteps);
+  for (int s = 0; s <= nSteps; s++)
+  {
+    double f = gen(s, 1200, 5100, nSteps);
+    TEST_ASSERT_EQUAL_MEMORY(&freqs[s], &f, sizeof(f));
+  }
+}
+
+static double userScale(int stepNbr, double fStart, double fStop, int nSteps)
+{
+  return fStart + (fStop - fStart) * stepNbr * stepNbr / (nSteps * nSteps);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_objects_play_like_functions()
+{
+  sameAsFunction(linearScale, Linear());
+  sameAsFunction(chromaticScale, Chromatic());
+  sameAsFunction(sinePiScale, SinePi());
+  sameAsFunction(sine2PiScale, Sine2Pi());
+  sameAsFunction(cosinePiScale, CosinePi());
+  sameAsFunction(cosine2PiScale, Cosine2Pi());
+  sameAsFunction(atanPiScale, AtanPi());
+  sameAsFunction(atan2PiScale, Atan2Pi());
+  sameAsSincFunction(sincScaleNpi_Npi, Sinc(3));
+  sameAsSincFunction(sincScaleNpi_0, SincNpi_0(3));
+  sameAsSincFunction(sincScale0_Npi, Sinc0_Npi(3));
+}
+
+void test_step_equals_fill()
+{
+  stepEqualsFill(Linear());
+  stepEqualsFill(Chromatic());
+  stepEqualsFill(SinePi());
+  stepEqualsFill(Sine2Pi());
+  stepEqualsFill(CosinePi());
+  stepEqualsFill(Cosine2Pi());
+  stepEqualsFill(AtanPi());
+  stepEqualsFill(Atan2Pi());
+  stepEqualsFill(Sinc(2));
+  stepEqualsFill(SincNpi_0(2));
+  stepEqualsFill(Sinc0_Npi(2));
+  stepEqualsFill(FreqFn{userScale});
+  stepEqualsFill(FreqFnSinc{sincScale0_Npi, 4});
+}
+
+// A lambda is called step by step, a sinc object repeats its chirp
+void test_lambda_and_sinc_repeats()
+{
+  auto lambda = [](int s, double fStart, double fStop, int nSteps) { return userScale(s, fStart, fStop, nSteps); };
+  std::vector<uint64_t> edges = recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, lambda, 50, 20); });
+  TEST_ASSERT_EQUAL(2 * (101 * 2 * 2 + 1), edges.size());
+  TEST_ASSERT_TRUE(edges == recorded([](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, FreqFn{userScale}, 50, 20); }));
+  std::vector<uint64_t> once = recorded([](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 1, Sinc(3), 50, 20); });
+  std::vector<uint64_t> thrice = recorded([](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 3, Sinc(3), 50, 20); });
+  TEST_ASSERT_EQUAL(3 * once.size(), thrice.size());
+  TEST_ASSERT_TRUE(std::equal(once.begin(), once.end(), thrice.end() - once.size()));
+}
+
+// Pure generators of the same type and state are equal, any other generator equals none
+void test_any_freq_gen()
+{
+  auto lambda = [](int s, double fStart, double fStop, int nSteps) { return fStart + (fStop - fStart) * s / nSteps; };
+  AnyFreqGen none, linear{Linear()}, sinc3{Sinc(3)}, fn{FreqFn{linearScale}}, user{FreqFn{userScale}}, any{lambda};
+  TEST_ASSERT_FALSE(none.pure());
+  TEST_ASSERT_TRUE(linear.pure() && sinc3.pure() && fn.pure());
+  TEST_ASSERT_FALSE(user.pure());
+  TEST_ASSERT_FALSE(any.pure());
+
+  TEST_ASSERT_TRUE(linear == AnyFreqGen(Linear()));
+  TEST_ASSERT_TRUE(sinc3 == AnyFreqGen(Sinc(3)));
+  TEST_ASSERT_FALSE(sinc3 == AnyFreqGen(Sinc(2)));
+  TEST_ASSERT_FALSE(sinc3 == AnyFreqGen(Sinc0_Npi(3)));
+  TEST_ASSERT_FALSE(linear == fn);
+  TEST_ASSERT_TRUE(fn == AnyFreqGen(FreqFn{linearScale}));
+  TEST_ASSERT_FALSE(fn == AnyFreqGen(FreqFn{chromaticScale}));
+  TEST_ASSERT_TRUE(AnyFreqGen(FreqFnSinc{sincScale0_Npi, 4}) == AnyFreqGen(FreqFnSinc{sincScale0_Npi, 4}));
+  TEST_ASSERT_FALSE(AnyFreqGen(FreqFnSinc{sincScale0_Npi, 4}) == AnyFreqGen(FreqFnSinc{sincScale0_Npi, 5}));
+  TEST_ASSERT_FALSE(user == user);
+  TEST_ASSERT_FALSE(any == any);
+  TEST_ASSERT_FALSE(none == none);
+
+  // It fills like the generator it holds
+  double held[21], direct[21];
+  sinc3.fill(held, 0, 21, 1000, 3000, 20);
+  Sinc(3).fill(direct, 0, 21, 1000, 3000, 20);
+  TEST_ASSERT_EQUAL_MEMORY(direct, held, sizeof(direct));
+  TEST_ASSERT_TRUE(any(7, 1000, 3000, 20) == lambda(7, 1000, 3000, 20));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_objects_play_like_functions);
+  RUN_TEST(test_step_equals_fill);
+  RUN_TEST(test_lambda_and_sinc_repeats);
+  RUN_TEST(test_any_freq_gen);
+  return UNITY_END();
+}
@@ -0,0 +1,83 @@
+/**
+ * Incremental generators: the drift from the exact values in double, float
+ * and Q16.16, and values that do not depend on where a batch begins.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+template <class T>
+struct Incremental
+{
+  void (*exact)(double *, int, int, T, T, int);
+  void (*incremental)(double *, int, int, T, T, int);
+};
+
+template <class T>
+static const Incremental<T> generators[] =
+{
+  {chromaticScaleBatchT<T, double>, chromaticScaleIncT<T, double>},
+  {sinePiScaleBatchT<T, double>,    sinePiScaleIncT<T, double>},
+  {sine2PiScaleBatchT<T, double>,   sine2PiScaleIncT<T, double>},
+  {cosinePiScaleBatchT<T, double>,  cosinePiScaleIncT<T, double>},
+  {cosine2PiScaleBatchT<T, double>, cosine2PiScaleIncT<T, double>},
+};
+
+/**
+ * Worst deviation from the exact generator relative to the span, the
+ * steps generated in batches of 32 like ChirpProgram does, which must
+ * give the values of a single batch
+ */
+template <class T>
+static double drift(const Incremental<T> &gen, int nSteps)
+{
+  const double fStart = 1000, fStop = 4000;
+  std::vector<double> exact(nSteps + 1), whole(nSteps + 1), chunked(nSteps + 1);
+  gen.exact(exact.data(), 0, nSteps + 1, T(fStart), T(fStop), nSteps);
+  gen.incremental(whole.data(), 0, nSteps + 1, T(fStart), T(fStop), nSteps);
+  for (int s = 0; s <= nSteps; s += ChirpProgram::STEP_CHUNK)
+  {
+    int n = nSteps + 1 - s < ChirpProgram::STEP_CHUNK ? nSteps + 1 - s : ChirpProgram::STEP_CHUNK;
+    gen.incremental(chunked.data() + s, s, n, T(fStart), T(fStop), nSteps);
+  }
+  TEST_ASSERT_TRUE(chunked == whole);
+  double worst = 0;
+  for (int s = 0; s <= nSteps; s++) worst = fmax(worst, fabs(whole[s] - exact[s]) / (fStop - fStart));
+  return worst;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// The limits of FreqGen.h: 1e-14 of the span in double, 2e-6 in float, 1e-3 in Q16.16
+void test_drift()
+{
+  for (int nSteps : {10, 100, 1000, 10000})
+    for (int g = 0; g < 5; g++)
+    {
+      TEST_ASSERT_LESS_THAN_DOUBLE(1e-14, drift(generators<double>[g], nSteps));
+      TEST_ASSERT_LESS_THAN_DOUBLE(2e-6, drift(generators<float>[g], nSteps));
+      TEST_ASSERT_LESS_THAN_DOUBLE(1e-3, drift(generators<Fix16>[g], nSteps));
+    }
+}
+
+// Where a batch begins at a multiple of 32, its first value is exact
+void test_resync()
+{
+  const int nSteps = 200;
+  double exact[nSteps + 1], inc[nSteps + 1];
+  sine2PiScaleBatch(exact, 0, nSteps + 1, 1000, 4000, nSteps);
+  sine2PiScaleIncBatch(inc, 0, nSteps + 1, 1000, 4000, nSteps);
+  for (int s = 0; s <= nSteps; s += 32) TEST_ASSERT_TRUE(inc[s] == exact[s]);
+  chromaticScaleBatch(exact, 0, nSteps + 1, 1000, 4000, nSteps);
+  chromaticScaleIncBatch(inc, 0, nSteps + 1, 1000, 4000, nSteps);
+  for (int s = 0; s <= nSteps; s += 32) TEST_ASSERT_TRUE(inc[s] == exact[s]);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_drift);
+  RUN_TEST(test_resync);
+  return UNITY_END();
+}
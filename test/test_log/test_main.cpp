@@ -0,0 +1,143 @@
+/**
+ * ChirpLog: events come out of flush() formatted and in order, sites
+ * above the log level are not compiled, a full ring loses the oldest
+ * events, and producers on two threads never tear an event.
+ */
+#include <unity.h>
+#include <string>
+#include <thread>
+#include "../ChirpTest.h"
+#include "ChirpLog.h"
+
+static std::vector<std::string> lines;
+
+static void collect(const char *line) { lines.push_back(line); }
+
+// The line without its time stamp
+static std::string text(const std::string &line) { return line.substr(line.find(']') + 2); }
+
+static int sideEffects = 0;
+
+static int sideEffect() { return ++sideEffects; }
+
+static const LogSite INFO = {CHIRP_LOG_INFO, "event %d"};
+
+void setUp()
+{
+  lines.clear();
+}
+
+void tearDown() {}
+
+// The sites of the library log format and level, the debug site is stripped with its arguments
+void test_format()
+{
+  if (CHIRPMAKER_LOG_LEVEL != CHIRP_LOG_INFO) return;   // the lines below are those of the default level
+  ChirpLog &log = chirpLog();
+  log.setWriter(collect);
+  log.flush();
+  lines.clear();
+  for (int b = 0; b < 3; b++) CHIRP_LOG_I("Bird %2d is singing", b);
+  CHIRP_LOG_W("%d of %d edges dropped", 5, 100);
+  CHIRP_LOG_E("%d %d %d %d", 1, -2, 3, -4);
+  CHIRP_LOG_D("never %d", sideEffect());
+  TEST_ASSERT_EQUAL(5, log.pending());
+  TEST_ASSERT_EQUAL(5, log.flush());
+  log.setWriter(nullptr);
+  TEST_ASSERT_EQUAL(0, sideEffects);
+
+  const char *expected[] = {"I Bird  0 is singing", "I Bird  1 is singing", "I Bird  2 is singing", "W 5 of 100 edges dropped", "E 1 -2 3 -4"};
+  TEST_ASSERT_EQUAL(5, lines.size());
+  unsigned last = 0;
+  for (size_t i = 0; i < lines.size(); i++)
+  {
+    TEST_ASSERT_EQUAL_STRING(expected[i], text(lines[i]).c_str());
+    unsigned s, us;
+    TEST_ASSERT_EQUAL(2, sscanf(lines[i].c_str(), "[%u.%u]", &s, &us));
+    TEST_ASSERT_TRUE(us < 1000000 && s * 1000000 + us >= last);
+    last = s * 1000000 + us;
+  }
+}
+
+// flush() writes at most maxEvents, the rest stays for the next call
+void test_flush_in_parts()
+{
+  static ChirpLog log;
+  log.setWriter(collect);
+  for (int i = 0; i < 10; i++) log.record(&INFO, i);
+  TEST_ASSERT_EQUAL_UINT32(10, log.recorded());
+  TEST_ASSERT_EQUAL(3, log.flush(3));
+  TEST_ASSERT_EQUAL(7, log.pending());
+  TEST_ASSERT_EQUAL(7, log.flush());
+  TEST_ASSERT_EQUAL(0, log.flush());
+  TEST_ASSERT_EQUAL(0, log.pending());
+  TEST_ASSERT_EQUAL(10, lines.size());
+  for (int i = 0; i < 10; i++) TEST_ASSERT_EQUAL_STRING(("I event " + std::to_string(i)).c_str(), text(lines[i]).c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, log.lost());
+}
+
+// A full ring overwrites the oldest events and counts them as lost
+void test_overflow()
+{
+  static ChirpLog log;
+  log.setWriter(collect);
+  for (int i = 0; i < ChirpLog::EVENTS + 44; i++) log.record(&INFO, i);
+  TEST_ASSERT_EQUAL(ChirpLog::EVENTS, log.pending());
+  TEST_ASSERT_EQUAL(ChirpLog::EVENTS, log.flush());
+  TEST_ASSERT_EQUAL_UINT32(44, log.lost());
+  TEST_ASSERT_EQUAL(ChirpLog::EVENTS, lines.size());
+  TEST_ASSERT_EQUAL_STRING("I event 44", text(lines[0]).c_str());
+  TEST_ASSERT_EQUAL_STRING(("I event " + std::to_string(ChirpLog::EVENTS + 43)).c_str(), text(lines.back()).c_str());
+}
+
+// Two threads log while a third flushes: every event is written once or counted lost, none is torn
+void test_threads()
+{
+  static ChirpLog log;
+  static const LogSite SITE = {CHIRP_LOG_INFO, "%d %d %d"};
+  log.setWriter(collect);
+  const int perThread = 100000;
+  std::atomic<int> running{2};
+  auto producer = [&](int id)
+  {
+    for (int i = 0; i < perThread; i++)
+    {
+      log.record(&SITE, id, i, ~i);
+      if (i % 32 == 0) std::this_thread::yield();
+    }
+    running--;
+  };
+  std::thread a(producer, 1), b(producer, 2);
+  while (running > 0) log.flush(64);
+  a.join();
+  b.join();
+  log.flush();
+
+  int torn = 0, last[3] = {-1, -1, -1};
+  bool ordered = true;
+  for (const std::string &l : lines)
+  {
+    int id, i, j;
+    if (sscanf(text(l).c_str(), "I %d %d %d", &id, &i, &j) != 3 || j != ~i || (id != 1 && id != 2))
+    {
+      torn++;
+      continue;
+    }
+    ordered = ordered && i > last[id];
+    last[id] = i;
+  }
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL_UINT32(2 * perThread, log.recorded());
+  TEST_ASSERT_EQUAL_UINT32(2 * perThread, lines.size() + log.lost());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_format);
+  RUN_TEST(test_flush_in_parts);
+  RUN_TEST(test_overflow);
+  RUN_TEST(test_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,100 @@
+/**
+ * Float and Q16.16 generators: the Fix16 arithmetic and functions, the
+ * generators against double and the period computation.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// Q16.16 rounds to the nearest 1/65536 and saturates a division by zero
+void test_fix16_arithmetic()
+{
+  TEST_ASSERT_EQUAL(65536, Fix16(1).raw);
+  TEST_ASSERT_EQUAL(98304, Fix16(1.5).raw);
+  TEST_ASSERT_EQUAL(-98304, Fix16(-1.5).raw);
+  TEST_ASSERT_EQUAL(1, Fix16(1.0 / 65536 * 0.6).raw);
+  TEST_ASSERT_EQUAL(Fix16(3.75).raw, (Fix16(1.25) + Fix16(2.5)).raw);
+  TEST_ASSERT_EQUAL(Fix16(-1.25).raw, (Fix16(1.25) - Fix16(2.5)).raw);
+  TEST_ASSERT_EQUAL(Fix16(3.125).raw, (Fix16(1.25) * Fix16(2.5)).raw);
+  TEST_ASSERT_EQUAL(Fix16(0.5).raw, (Fix16(1.25) / Fix16(2.5)).raw);
+  TEST_ASSERT_EQUAL(INT32_MAX, (Fix16(1) / Fix16()).raw);
+  TEST_ASSERT_EQUAL(INT32_MIN, (Fix16(-1) / Fix16()).raw);
+  TEST_ASSERT_TRUE(Fix16(-2) < Fix16(1));
+  TEST_ASSERT_EQUAL(Fix16(2).raw, fabs(Fix16(-2)).raw);
+}
+
+// The integer functions stay within a few units of the last place, relative beyond 1
+void test_fix16_functions()
+{
+  for (double x = -6.0; x <= 6.0; x += 0.01)
+  {
+    TEST_ASSERT_TRUE(fabs((double)sin(Fix16(x)) - sin(x)) < 5e-5);
+    TEST_ASSERT_TRUE(fabs((double)cos(Fix16(x)) - cos(x)) < 5e-5);
+    TEST_ASSERT_TRUE(fabs((double)atan(Fix16(x)) - atan(x)) < 5e-5);
+  }
+  for (double x = -5.0; x <= 5.0; x += 0.01) TEST_ASSERT_TRUE(fabs((double)exp(Fix16(x)) - exp(x)) < 5e-5 * fmax(exp(x), 1.0));
+  for (double x = 0.01; x <= 1000.0; x *= 1.1) TEST_ASSERT_TRUE(fabs((double)log(Fix16(x)) - log(x)) < 1e-3);
+  TEST_ASSERT_EQUAL(INT32_MIN, log(Fix16()).raw);
+}
+
+// float and Q16.16 generators give the frequencies of double, to 1e-6 and 2e-4
+template <class G>
+static void compare(G gen)
+{
+  for (int nSteps : {5, 20, 100})
+    for (int s = 0; s <= nSteps; s++)
+    {
+      double f = gen(s, 1200.0, 4500.0, nSteps);
+      TEST_ASSERT_TRUE(fabs(gen(s, 1200.0f, 4500.0f, nSteps) / f - 1) < 1e-6);
+      TEST_ASSERT_TRUE(fabs((double)gen(s, Fix16(1200), Fix16(4500), nSteps) / f - 1) < 2e-4);
+    }
+}
+
+void test_generators_against_double()
+{
+  compare([](int s, auto a, auto b, int n) { return linearScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return chromaticScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return sinePiScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return sine2PiScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return cosinePiScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return cosine2PiScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return atanPiScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return atan2PiScaleT(s, a, b, n); });
+  compare([](int s, auto a, auto b, int n) { return sincScaleNpi_NpiT(s, a, b, n, 3); });
+  compare([](int s, auto a, auto b, int n) { return sincScale0_NpiT(s, a, b, n, 3); });
+  compare([](int s, auto a, auto b, int n) { return sincScaleNpi_0T(s, a, b, n, 3); });
+}
+
+// The period is truncated to whole us, in any number type within one us of double
+void test_periods()
+{
+  uint32_t tOn, tOff;
+  chirpPeriod(3000.0, 50, tOn, tOff);
+  TEST_ASSERT_EQUAL_UINT32(166, tOn);
+  TEST_ASSERT_EQUAL_UINT32(167, tOff);
+  for (double f = 400; f < 8000; f += 37.3)
+    for (int duty : {5, 50, 95})
+    {
+      uint32_t on, off, onF, offF, onQ, offQ;
+      chirpPeriod(f, duty, on, off);
+      chirpPeriod((float)f, duty, onF, offF);
+      chirpPeriod(Fix16(f), duty, onQ, offQ);
+      TEST_ASSERT_TRUE(abs((int)(onF + offF) - (int)(on + off)) <= 1 && abs((int)onF - (int)on) <= 1);
+      TEST_ASSERT_TRUE(abs((int)(onQ + offQ) - (int)(on + off)) <= 1 && abs((int)onQ - (int)on) <= 1);
+    }
+  chirpPeriod(Fix16(), 50, tOn, tOff);
+  TEST_ASSERT_EQUAL_UINT32(0, tOn + tOff);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fix16_arithmetic);
+  RUN_TEST(test_fix16_functions);
+  RUN_TEST(test_generators_against_double);
+  RUN_TEST(test_periods);
+  return UNITY_END();
+}
@@ -0,0 +1,115 @@
+/**
+ * PdmModulator and PdmSink: the noise of the sigma-delta loop in the audio
+ * band, the bits it hands on and a chirp played as a sine.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "PdmModulator.h"
+
+// The bits of a PDM stream as +-1, a word handler
+static std::vector<double> bits;
+static size_t words;
+
+static void collectWords(const uint32_t *w, size_t n, void *ctx)
+{
+  (void)ctx;
+  words += n;
+  for (size_t i = 0; i < n; i++)
+  {
+    for (int b = 31; b >= 0; b--) bits.push_back(w[i] >> b & 1 ? 1.0 : -1.0);
+  }
+}
+
+// Power of the bins within 5 of frequency f
+static double bandPower(const std::vector<double> &power, double f, double binHz)
+{
+  double sum = 0;
+  long centre = lround(f / binHz);
+  for (long b = std::max(0L, centre - 5); b <= centre + 5 && b < (long)power.size(); b++) sum += power[b];
+  return sum;
+}
+
+void setUp()
+{
+  bits.clear();
+  words = 0;
+}
+
+void tearDown() {}
+
+// Sines keep 65 dB of SNR up to 20 kHz, what is left after a low pass
+void test_tone_snr()
+{
+  const uint32_t rate = 2560000;
+  const size_t N = 1 << 19;
+  PdmModulator pdm;
+  for (double f : {440.0, 1000.0, 3000.0})
+  {
+    bits.clear();
+    pdm.begin(rate, collectWords);
+    pdm.tone(PdmModulator::increment(f, rate), N + 8192);
+    pdm.flush();
+    std::vector<double> power = powerSpectrum(bits, 8192, N);
+    double binHz = (double)rate / N, signal = bandPower(power, f, binHz), noise = 0;
+    for (size_t b = lround(20 / binHz); b <= 20000 / binHz; b++) noise += power[b];
+    noise -= signal;
+    TEST_ASSERT_GREATER_THAN_DOUBLE(65, 10 * log10(signal / noise));
+  }
+}
+
+// Silence is as many ones as zeros
+void test_silence()
+{
+  PdmModulator pdm;
+  pdm.begin(2560000, collectWords);
+  pdm.silence(100000);
+  pdm.flush();
+  double sum = 0;
+  for (double b : bits) sum += b;
+  TEST_ASSERT_LESS_THAN_DOUBLE(0.001, fabs(sum / bits.size()));
+}
+
+// Every bit is handed on, flush() fills up the last word with silence
+void test_bit_count()
+{
+  PdmModulator pdm;
+  pdm.begin(2560000, collectWords);
+  pdm.tone(PdmModulator::increment(1000, 2560000), 100001);
+  pdm.silence(999);
+  pdm.flush();
+  TEST_ASSERT_EQUAL((101000 + 31) / 32, words);
+  TEST_ASSERT_EQUAL_UINT64(words * 32, pdm.bits());
+}
+
+// A steady chirp at 1 kHz through PdmSink lasts as long as its edges and loses the harmonics of the squares
+void test_chirp_is_a_sine()
+{
+  const uint32_t rate = 2560000;
+  static PdmChirpmaker cm(TEST_PIN);
+  cm.sink().setOutput(rate, collectWords);
+  cm.chirp(1000, 1000, 10, 50, 1, Chromatic(), 50, 0);
+  cm.sink().flush();
+
+  static Edge recording[10000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(TEST_PIN);
+  rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  rec.chirp(1000, 1000, 10, 50, 1, Chromatic(), 50, 0);
+  double expected = (double)rec.sink().ticks() * rate / RecorderSink::TICK_HZ;
+  TEST_ASSERT_TRUE(bits.size() >= expected && bits.size() < expected + 32);
+
+  const size_t N = 1 << 20;
+  std::vector<double> power = powerSpectrum(bits, 0, N);
+  double binHz = (double)rate / N, harmonics = 0;
+  for (int k = 2; k * 1000 <= 20000; k++) harmonics += bandPower(power, k * 1000.0, binHz);
+  TEST_ASSERT_LESS_THAN_DOUBLE(-60, 10 * log10(harmonics / bandPower(power, 1000, binHz)));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_tone_snr);
+  RUN_TEST(test_silence);
+  RUN_TEST(test_bit_count);
+  RUN_TEST(test_chirp_is_a_sine);
+  return UNITY_END();
+}
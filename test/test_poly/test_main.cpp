@@ -0,0 +1,194 @@
+/**
+ * PolyPlayer on the simulated timer: every voice keeps its own timing,
+ * edges due at once share an interrupt, a voice that runs dry starts
+ * again, and birds fed from Chirpmakers play as they do alone.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "PolyPlayer.h"
+
+struct PinEdge
+{
+  uint64_t cycle;
+  uint8_t level;
+};
+
+static const uint8_t FIRST_PIN = 12;
+static std::vector<PinEdge> pinEdges[FIRST_PIN + PolyPlayer::MAX_VOICES];
+
+static void onEdge(uint8_t pin, uint8_t level, uint64_t cycle)
+{
+  if (pin >= FIRST_PIN && pin < FIRST_PIN + PolyPlayer::MAX_VOICES) pinEdges[pin].push_back({cycle, level});
+}
+
+// Timer ticks between the level changes on pin
+static std::vector<uint64_t> ticksOn(uint8_t pin)
+{
+  std::vector<uint64_t> d;
+  for (size_t i = 1; i < pinEdges[pin].size(); i++) d.push_back((pinEdges[pin][i].cycle - pinEdges[pin][i - 1].cycle) / PolyPlayer::DIVIDER);
+  return d;
+}
+
+static PolyPlayer poly;
+
+void setUp()
+{
+  for (std::vector<PinEdge> &e : pinEdges) e.clear();
+  hostSetEdgeHook(onEdge);
+  poly.begin(1);
+}
+
+void tearDown()
+{
+  poly.end();
+  hostSetEdgeHook(nullptr);
+}
+
+// Each voice plays its levels for exactly their ticks, whatever the others do
+void test_voices_keep_their_timing()
+{
+  TEST_ASSERT_EQUAL(0, poly.addVoice(FIRST_PIN));
+  TEST_ASSERT_EQUAL(1, poly.addVoice(FIRST_PIN + 1));
+  TEST_ASSERT_EQUAL(2, poly.voices());
+  for (int i = 0; i < 60; i++)
+  {
+    poly.push(0, i % 2 ? LOW : HIGH, 300 + 7 * (i % 5));
+    poly.push(1, i % 2 ? LOW : HIGH, 1100 - 3 * (i % 11));
+  }
+  poly.push(0, LOW, 0);   // dropped
+  poly.push(5, HIGH, 100);   // no such voice
+  poly.flush();
+  TEST_ASSERT_TRUE(poly.isIdle());
+  TEST_ASSERT_EQUAL_UINT32(120, poly.edges());
+
+  std::vector<uint64_t> d0 = ticksOn(FIRST_PIN), d1 = ticksOn(FIRST_PIN + 1);
+  TEST_ASSERT_EQUAL(59, d0.size());
+  TEST_ASSERT_EQUAL(59, d1.size());
+  for (int i = 0; i < 59; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT64(300 + 7 * (i % 5), d0[i]);
+    TEST_ASSERT_EQUAL_UINT64(1100 - 3 * (i % 11), d1[i]);
+  }
+  TEST_ASSERT_EQUAL(LOW, pinEdges[FIRST_PIN].back().level);
+}
+
+// push() waits while the queue is full, no edge is lost
+void test_full_queue()
+{
+  poly.addVoice(FIRST_PIN);
+  for (int i = 0; i < 4 * PolyPlayer::QUEUE_SIZE; i++)
+  {
+    poly.push(0, i % 2 ? LOW : HIGH, 200 + i);
+    TEST_ASSERT_TRUE(poly.queued(0) < PolyPlayer::QUEUE_SIZE);
+  }
+  poly.flush();
+  std::vector<uint64_t> d = ticksOn(FIRST_PIN);
+  TEST_ASSERT_EQUAL(4 * PolyPlayer::QUEUE_SIZE - 1, d.size());
+  for (size_t i = 0; i < d.size(); i++) TEST_ASSERT_EQUAL_UINT64(200 + i, d[i]);
+}
+
+// Edges that are due at the same time come out of one interrupt
+void test_shared_interrupts()
+{
+  for (uint8_t v = 0; v < 4; v++) poly.addVoice(FIRST_PIN + v);
+  for (int i = 0; i < 40; i++)
+    for (uint8_t v = 0; v < 4; v++) poly.push(v, i % 2 ? LOW : HIGH, 500);
+  poly.flush();
+  TEST_ASSERT_EQUAL_UINT32(160, poly.edges());
+  TEST_ASSERT_TRUE(poly.interrupts() < 80);
+  for (uint8_t v = 0; v < 4; v++)
+  {
+    std::vector<uint64_t> d = ticksOn(FIRST_PIN + v);
+    TEST_ASSERT_EQUAL(39, d.size());
+    for (uint64_t t : d) TEST_ASSERT_EQUAL_UINT64(500, t);
+  }
+}
+
+// A voice that runs dry keeps its level and starts again START_TICKS after the next push()
+void test_voice_runs_dry()
+{
+  poly.addVoice(FIRST_PIN);
+  poly.push(0, HIGH, 1000);
+  poly.flush();
+  TEST_ASSERT_TRUE(poly.isIdle(0));
+  TEST_ASSERT_EQUAL(1, pinEdges[FIRST_PIN].size());
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(FIRST_PIN));
+
+  delayMicroseconds(5000);
+  uint64_t pushed = hostNow();
+  poly.push(0, LOW, 1000);
+  TEST_ASSERT_FALSE(poly.isIdle(0));
+  poly.flush();
+  TEST_ASSERT_EQUAL(2, pinEdges[FIRST_PIN].size());
+  uint64_t lead = (pinEdges[FIRST_PIN][1].cycle - pushed) / PolyPlayer::DIVIDER;
+  TEST_ASSERT_TRUE(lead >= PolyPlayer::START_TICKS && lead <= PolyPlayer::START_TICKS + 1);
+}
+
+// No more than MAX_VOICES voices
+void test_voice_limit()
+{
+  for (uint8_t v = 0; v < PolyPlayer::MAX_VOICES; v++) TEST_ASSERT_EQUAL(v, poly.addVoice(FIRST_PIN + v));
+  TEST_ASSERT_EQUAL(-1, poly.addVoice(FIRST_PIN));
+  TEST_ASSERT_EQUAL(PolyPlayer::MAX_VOICES, poly.voices());
+}
+
+// Birds fed from Chirpmakers started non-blocking keep the timing they have alone, to a tick
+void test_birds_from_chirpmakers()
+{
+  static Edge recording[100000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> ref(TEST_PIN);
+  static NullChirpmaker *cms[4];
+  const uint8_t n = 4;
+  std::vector<uint64_t> alone[n];
+  ref.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  for (uint8_t v = 0; v < n; v++)
+  {
+    ref.sink().clear();
+    randomSeed(100 + v);
+    ref.birdVoice(3 * v, 20);
+    int level = LOW;
+    uint64_t ticks = 0;
+    bool started = false;
+    for (size_t i = 0; i < ref.sink().count(); i++)   // as on a pin that starts LOW
+    {
+      if (ref.sink()[i].ticks == 0) continue;
+      if (ref.sink()[i].level != level)
+      {
+        if (started) alone[v].push_back(ticks);
+        started = true;
+        ticks = 0;
+      }
+      level = ref.sink()[i].level;
+      ticks += ref.sink()[i].ticks;
+    }
+
+    if (! cms[v]) cms[v] = new NullChirpmaker(TEST_PIN);
+    poly.addVoice(FIRST_PIN + v);
+    randomSeed(100 + v);
+    TEST_ASSERT_TRUE(cms[v]->startBird(3 * v, 20));
+  }
+  for (bool more = true; more || ! poly.isIdle(); delayMicroseconds(500))
+  {
+    more = false;
+    for (uint8_t v = 0; v < n; v++) more = poly.feed(v, *cms[v]) || more;
+  }
+
+  for (uint8_t v = 0; v < n; v++)
+  {
+    std::vector<uint64_t> d = ticksOn(FIRST_PIN + v);
+    TEST_ASSERT_EQUAL(alone[v].size(), d.size());
+    for (size_t i = 0; i < d.size(); i++) TEST_ASSERT_TRUE(d[i] + 1 >= alone[v][i] && d[i] <= alone[v][i] + 1);
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_voices_keep_their_timing);
+  RUN_TEST(test_full_queue);
+  RUN_TEST(test_shared_interrupts);
+  RUN_TEST(test_voice_runs_dry);
+  RUN_TEST(test_voice_limit);
+  RUN_TEST(test_birds_from_chirpmakers);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+/**
+ * ChirpProgram: merged steps, the closing pause, phasers, counts out of
+ * range and chirps that are compiled piece by piece.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// Steps of the same period become one segment, the pause closes the program
+void test_constant_chirp_merges()
+{
+  ChirpProgram prog;
+  TEST_ASSERT_EQUAL(10, prog.compileChirp(1000, 1000, 9, 3, 2, linearScale, 50, 100));
+  TEST_ASSERT_EQUAL(2, prog.size());
+  TEST_ASSERT_EQUAL_UINT32(500, prog[0].tOn);
+  TEST_ASSERT_EQUAL_UINT32(500, prog[0].tOff);
+  TEST_ASSERT_EQUAL(30, prog[0].count);
+  TEST_ASSERT_TRUE(prog[1].isPause());
+  TEST_ASSERT_EQUAL_UINT32(100, prog[1].tOff);
+  TEST_ASSERT_EQUAL(2, prog.repeats);
+  TEST_ASSERT_EQUAL_UINT32(30 * 1000 + 100 * 1000, prog.durationUs());
+}
+
+// Each step gets the period of its frequency, truncated to whole us
+void test_steps_follow_generator()
+{
+  ChirpProgram prog;
+  prog.compileChirp(1000, 3000, 4, 2, 1, linearScale, 25, 0);
+  TEST_ASSERT_EQUAL(5, prog.size());
+  for (int s = 0; s <= 4; s++)
+  {
+    uint32_t tOn, tOff;
+    chirpPeriod(Real(linearScale(s, 1000, 3000, 4)), 25, tOn, tOff);
+    TEST_ASSERT_EQUAL_UINT32(tOn, prog[s].tOn);
+    TEST_ASSERT_EQUAL_UINT32(tOff, prog[s].tOff);
+    TEST_ASSERT_EQUAL(2, prog[s].count);
+  }
+}
+
+// One segment per duty cycle, without a pause of 0 ms
+void test_phaser()
+{
+  ChirpProgram prog;
+  TEST_ASSERT_EQUAL(3, prog.compilePhaser(1000, 7, 10, 12, 4, 0));
+  TEST_ASSERT_EQUAL(3, prog.size());
+  for (int d = 10; d <= 12; d++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(10 * d, prog[d - 10].tOn);
+    TEST_ASSERT_EQUAL_UINT32(1000 - 10 * d, prog[d - 10].tOff);
+    TEST_ASSERT_EQUAL(7, prog[d - 10].count);
+  }
+  TEST_ASSERT_EQUAL(4, prog.repeats);
+}
+
+// Counts of 0 or less play nothing, counts beyond 16 bits are split or clamped
+void test_counts()
+{
+  ChirpProgram prog;
+  prog.compileChirp(1000, 1000, 3, 5, 0, linearScale, 50, 20);
+  TEST_ASSERT_EQUAL(0, prog.repeats);
+  prog.compileChirp(1000, 1000, 3, 5, 70000, linearScale, 50, 20);
+  TEST_ASSERT_EQUAL(UINT16_MAX, prog.repeats);
+  prog.compileChirp(1000, 1000, 3, -1, 1, linearScale, 50, 20);
+  TEST_ASSERT_EQUAL(1, prog.size());
+  TEST_ASSERT_TRUE(prog[0].isPause());
+
+  prog.clear();
+  TEST_ASSERT_TRUE(prog.add(10, 10, 60000));
+  TEST_ASSERT_TRUE(prog.add(10, 10, 10000));
+  TEST_ASSERT_EQUAL(2, prog.size());
+  TEST_ASSERT_EQUAL(60000, prog[0].count);
+  TEST_ASSERT_EQUAL(10000, prog[1].count);
+}
+
+// A chirp longer than a program comes in pieces that add up to the whole
+void test_piecewise()
+{
+  const int nSteps = 3 * ChirpProgram::MAX_SEGMENTS;
+  ChirpProgram prog;
+  uint64_t periods = 0, us = 0;
+  int pieces = 0;
+  for (int s = 0; s <= nSteps; pieces++)
+  {
+    s = prog.compileChirp(1000, 5000, nSteps, 2, 3, linearScale, 50, 10, s);
+    TEST_ASSERT_TRUE(prog.size() <= ChirpProgram::MAX_SEGMENTS);
+    for (const Segment &seg : prog) if (! seg.isPause()) periods += seg.count;
+    us += prog.durationUs();
+    TEST_ASSERT_EQUAL(1, prog.repeats);   // only a complete program is repeated
+  }
+  TEST_ASSERT_TRUE(pieces >= 3);
+  TEST_ASSERT_TRUE(prog[prog.size() - 1].isPause());
+  TEST_ASSERT_EQUAL_UINT64(2 * (nSteps + 1), periods);
+
+  uint64_t expected = 10 * 1000;
+  for (int s = 0; s <= nSteps; s++)
+  {
+    uint32_t tOn, tOff;
+    chirpPeriod(Real(linearScale(s, 1000, 5000, nSteps)), 50, tOn, tOff);
+    expected += 2 * (tOn + tOff);
+  }
+  TEST_ASSERT_EQUAL_UINT64(expected, us);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_constant_chirp_merges);
+  RUN_TEST(test_steps_follow_generator);
+  RUN_TEST(test_phaser);
+  RUN_TEST(test_counts);
+  RUN_TEST(test_piecewise);
+  return UNITY_END();
+}
@@ -0,0 +1,238 @@
+/**
+ * SpscQueue and AudioWorker: items come out in the order they went in,
+ * a full queue refuses, a producer and a consumer on two threads, and the
+ * worker playing, dropping and stopping what it is posted.
+ */
+#include <unity.h>
+#include <thread>
+#include <atomic>
+#include "../ChirpTest.h"
+#include "AudioWorker.h"
+
+struct PinEdge
+{
+  uint64_t cycle;
+  uint8_t level;
+};
+
+static const uint8_t PINS[2] = {12, 13};
+static std::vector<PinEdge> pinEdges[2];
+
+static void onEdge(uint8_t pin, uint8_t level, uint64_t cycle)
+{
+  for (uint8_t v = 0; v < 2; v++) if (pin == PINS[v]) pinEdges[v].push_back({cycle, level});
+}
+
+// Timer ticks between the level changes of voice v
+static std::vector<uint64_t> ticksOn(uint8_t v)
+{
+  std::vector<uint64_t> d;
+  for (size_t i = 1; i < pinEdges[v].size(); i++) d.push_back((pinEdges[v][i].cycle - pinEdges[v][i - 1].cycle) / PolyPlayer::DIVIDER);
+  return d;
+}
+
+// Ticks between the level changes of whatever play() does, as on a pin that starts LOW
+template <class Play>
+static std::vector<uint64_t> alone(Play play)
+{
+  static Edge recording[100000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(TEST_PIN);
+  rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(rec);
+  std::vector<uint64_t> d;
+  int level = LOW;
+  uint64_t ticks = 0;
+  bool started = false;
+  for (size_t i = 0; i < rec.sink().count(); i++)
+  {
+    if (rec.sink()[i].ticks == 0) continue;
+    if (rec.sink()[i].level != level)
+    {
+      if (started) d.push_back(ticks);
+      started = true;
+      ticks = 0;
+    }
+    level = rec.sink()[i].level;
+    ticks += rec.sink()[i].ticks;
+  }
+  return d;
+}
+
+/**
+ * A voice that records the pause of each bird it is asked to start, and
+ * holds the worker there while hold is set
+ */
+struct ProbeVoice
+{
+  static inline std::vector<uint32_t> started;
+  static inline std::atomic<bool> hold{false};
+  static inline std::atomic<bool> held{false};
+
+  static auto birds() { return NullChirpmaker::birds(); }
+  bool isBusy() const { return false; }
+  bool startBird(uint16_t bird, uint32_t msPause)
+  {
+    (void)bird;
+    started.push_back(msPause);
+    held = true;
+    while (hold) std::this_thread::yield();
+    return true;
+  }
+  bool startSong(const uint8_t *song, uint32_t msPause) { (void)song; (void)msPause; return true; }
+  void stop() {}
+  bool pull(uint8_t &level, uint32_t &us) { (void)level; (void)us; return false; }
+};
+
+static NullChirpmaker *cms[2];
+
+void setUp()
+{
+  for (NullChirpmaker *&cm : cms) if (! cm) cm = new NullChirpmaker(TEST_PIN);
+  for (std::vector<PinEdge> &e : pinEdges) e.clear();
+  hostSetEdgeHook(onEdge);
+}
+
+void tearDown()
+{
+  hostSetEdgeHook(nullptr);
+}
+
+// N - 1 items fit, they come out in order, also after the indexes have wrapped around many times
+void test_fifo_and_capacity()
+{
+  static SpscQueue<int, 8> q;
+  TEST_ASSERT_EQUAL(7, q.capacity());
+  int item = -1;
+  TEST_ASSERT_FALSE(q.pop(item));
+  TEST_ASSERT_EQUAL(-1, item);
+  int in = 0, out = 0;
+  for (int round = 0; round < 100; round++)
+  {
+    int n = 1 + round % 7;
+    for (int i = 0; i < n; i++) TEST_ASSERT_TRUE(q.push(in++));
+    TEST_ASSERT_EQUAL(n, q.size());
+    while (q.pop(item)) TEST_ASSERT_EQUAL(out++, item);
+    TEST_ASSERT_EQUAL(0, q.size());
+  }
+  for (int i = 0; i < 7; i++) TEST_ASSERT_TRUE(q.push(in++));
+  TEST_ASSERT_FALSE(q.push(-1));
+  TEST_ASSERT_EQUAL(7, q.size());
+  TEST_ASSERT_TRUE(q.pop(item));
+  TEST_ASSERT_EQUAL(out++, item);
+  TEST_ASSERT_TRUE(q.push(in++));
+  while (q.pop(item)) TEST_ASSERT_EQUAL(out++, item);
+  TEST_ASSERT_EQUAL(in, out);
+}
+
+// A producer and a consumer on two threads, every item arrives once and in order
+void test_two_threads()
+{
+  static SpscQueue<uint32_t, 256> q;
+  const uint32_t n = 200000;
+  std::atomic<uint32_t> full{0};
+  std::thread producer([&]
+  {
+    for (uint32_t i = 0; i < n; i++)
+      while (! q.push(i))
+      {
+        full++;
+        std::this_thread::yield();
+      }
+  });
+  uint32_t next = 0, wrong = 0, item;
+  while (next < n)
+  {
+    if (! q.pop(item))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    wrong += item != next;
+    next++;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL_UINT32(0, wrong);
+  TEST_ASSERT_FALSE(q.pop(item));
+}
+
+// A bird and a chirp posted to two voices play as they do alone
+void test_worker_plays()
+{
+  randomSeed(21);
+  std::vector<uint64_t> bird = alone([](BasicChirpmaker<RecorderSink, VirtualClock> &cm) { cm.birdVoice((uint16_t)0, 20); });
+  std::vector<uint64_t> chirp = alone([](BasicChirpmaker<RecorderSink, VirtualClock> &cm) { cm.chirp(1000, 3000, 20, 5, 3, Chromatic(), 50, 100); });
+
+  static AudioWorker<NullChirpmaker> audio;
+  randomSeed(21);
+  TEST_ASSERT_TRUE(audio.begin(cms, PINS, 2, 1));
+  TEST_ASSERT_FALSE(audio.begin(cms, PINS, 2, 1));
+  TEST_ASSERT_TRUE(audio.bird(0, 0, 20));
+  TEST_ASSERT_TRUE(audio.chirp(1, 1000, 3000, 20, 5, 3, GEN_CHROMATIC, 50, 100));
+  while (audio.executed() < audio.posted() || audio.isBusy()) std::this_thread::yield();
+  audio.end();
+  TEST_ASSERT_EQUAL_UINT32(2, audio.executed());
+  TEST_ASSERT_EQUAL_UINT32(0, audio.dropped());
+  TEST_ASSERT_TRUE(ticksOn(0) == bird);
+  TEST_ASSERT_TRUE(ticksOn(1) == chirp);
+}
+
+// While the worker is held, the queue fills up and further posts are dropped; the queued ones run in order
+void test_worker_drops_when_full()
+{
+  static ProbeVoice probes[2];
+  static ProbeVoice *const voices[2] = {&probes[0], &probes[1]};
+  static AudioWorker<ProbeVoice> burst;
+  const uint16_t QUEUE_SIZE = AudioWorker<ProbeVoice>::QUEUE_SIZE;
+  std::vector<uint32_t> queued;
+  uint32_t seq = 0;
+  ProbeVoice::started.clear();
+  ProbeVoice::hold = true;
+  ProbeVoice::held = false;
+  TEST_ASSERT_TRUE(burst.begin(voices, PINS, 2, 1));
+  TEST_ASSERT_TRUE(burst.bird(0, 0, seq));
+  queued.push_back(seq++);
+  while (! ProbeVoice::held) std::this_thread::yield();
+
+  for (int i = 0; i < 2 * QUEUE_SIZE; i++, seq++)
+  {
+    if (burst.bird(0, 0, seq)) queued.push_back(seq);
+    else TEST_ASSERT_EQUAL(QUEUE_SIZE - 1, burst.depth());
+  }
+  TEST_ASSERT_EQUAL(QUEUE_SIZE, queued.size());
+  TEST_ASSERT_EQUAL_UINT32(QUEUE_SIZE + 1, burst.dropped());
+
+  ProbeVoice::hold = false;
+  for (int i = 0; i < 1000; i++, seq++) if (burst.bird(0, 0, seq)) queued.push_back(seq);
+  while (burst.executed() < burst.posted()) std::this_thread::yield();
+  burst.end();
+  TEST_ASSERT_TRUE(ProbeVoice::started == queued);
+  TEST_ASSERT_EQUAL_UINT32(seq, burst.posted() + burst.dropped());
+  TEST_ASSERT_TRUE(burst.maxDepth() <= QUEUE_SIZE - 1);
+}
+
+// A concert plays until it is stopped, then every voice is silent
+void test_worker_stop()
+{
+  static AudioWorker<NullChirpmaker> live;
+  TEST_ASSERT_TRUE(live.begin(cms, PINS, 2, 1));
+  TEST_ASSERT_TRUE(live.concert(40, 2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  TEST_ASSERT_TRUE(live.stop());
+  while (live.executed() < live.posted() || live.isBusy()) std::this_thread::yield();
+  live.end();
+  TEST_ASSERT_TRUE(live.concertState().started() > 0);
+  TEST_ASSERT_FALSE(cms[0]->isBusy());
+  TEST_ASSERT_FALSE(cms[1]->isBusy());
+  for (uint8_t v = 0; v < 2; v++) TEST_ASSERT_TRUE(pinEdges[v].empty() || pinEdges[v].back().level == LOW);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_and_capacity);
+  RUN_TEST(test_two_threads);
+  RUN_TEST(test_worker_plays);
+  RUN_TEST(test_worker_drops_when_full);
+  RUN_TEST(test_worker_stop);
+  return UNITY_END();
+}
@@ -0,0 +1,118 @@
+/**
+ * BirdRegistry: names found through the hash table, birds chosen by their
+ * weights, the registry of the Chirpmaker and birdVoice() by name.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+// A registry of its own, the bird is just a number here
+static constexpr auto REGISTRY = makeBirdRegistry<int>({
+  {"wren",   1, 100, 2},
+  {"owl",    2, 200, 0},
+  {"wren2",  3, 300, 3},
+  {"w",      4, 400, 1},
+  {"hoopoe", 5, 500, 0},
+});
+static_assert(! REGISTRY.hasDuplicates(), "two birds with the same name");
+static_assert(makeBirdRegistry<int>({{"a", 1, 1, 1}, {"b", 2, 1, 1}, {"a", 3, 1, 1}}).hasDuplicates(), "a duplicate is not found");
+static_assert(REGISTRY.SLOTS == 16, "at least twice as many slots as birds, a power of 2");
+static_assert(birdHash("") == 2166136261u && birdHash("a") == 0xe40c292cu, "FNV-1a at compile time");
+
+// Level and ticks of each edge of whatever play() does
+template <class Play>
+static std::vector<uint64_t> recorded(Play play)
+{
+  static Edge recording[200000];
+  static Recorder cm(TEST_PIN);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Every name is found, a prefix or an extension of a name is not
+void test_names()
+{
+  BirdTable<int> table = REGISTRY.table();
+  TEST_ASSERT_EQUAL(5, table.size());
+  for (uint16_t b = 0; b < table.size(); b++)
+  {
+    TEST_ASSERT_EQUAL(b, table.indexOf(table[b].name));
+    TEST_ASSERT_EQUAL(b + 1, table[b].sing);
+  }
+  for (const char *name : {"", "wre", "wren3", "Wren", "ww", "hoopoes"}) TEST_ASSERT_EQUAL(-1, table.indexOf(name));
+}
+
+// A number below the total weight picks each bird as often as its weight, never one of weight 0
+void test_weights()
+{
+  BirdTable<int> table = REGISTRY.table();
+  TEST_ASSERT_EQUAL_UINT32(6, table.totalWeight());
+  const uint16_t expected[] = {0, 0, 2, 2, 2, 3};
+  for (uint32_t w = 0; w < 6; w++) TEST_ASSERT_EQUAL(expected[w], table.byWeight(w));
+}
+
+// The birds of the Chirpmaker, each under its own name
+void test_chirpmaker_registry()
+{
+  BirdTable<Recorder::Bird> birds = Recorder::birds();
+  TEST_ASSERT_EQUAL(15, birds.size());
+  TEST_ASSERT_EQUAL_UINT32(15, birds.totalWeight());
+  TEST_ASSERT_EQUAL(11, birds.indexOf("cuckoo"));
+  TEST_ASSERT_EQUAL(14, birds.indexOf("blackbird"));
+  for (uint16_t b = 0; b < birds.size(); b++)
+  {
+    TEST_ASSERT_EQUAL(b, birds.indexOf(birds[b].name));
+    TEST_ASSERT_EQUAL(b, birds.byWeight(b));
+    TEST_ASSERT_TRUE(birds[b].msTypical > 0);
+  }
+  for (const char *name : {"", "bird", "bird11", "Cuckoo", "blackbirds"}) TEST_ASSERT_EQUAL(-1, birds.indexOf(name));
+}
+
+// birdVoice() by name sings the bird of that number, an unknown bird sings nothing
+void test_bird_voice_by_name()
+{
+  BirdTable<Recorder::Bird> birds = Recorder::birds();
+  for (uint16_t b = 0; b < birds.size(); b++)
+  {
+    randomSeed(b + 1);
+    std::vector<uint64_t> byNumber = recorded([&](Recorder &cm) { cm.birdVoice(b, 20); });
+    randomSeed(b + 1);
+    TEST_ASSERT_TRUE_MESSAGE(recorded([&](Recorder &cm) { cm.birdVoice(birds[b].name, 20); }) == byNumber, birds[b].name);
+  }
+  TEST_ASSERT_EQUAL(0, recorded([](Recorder &cm) { cm.birdVoice("nightingale", 20); }).size());
+  TEST_ASSERT_EQUAL(0, recorded([](Recorder &cm) { cm.birdVoice(15, 20); }).size());
+}
+
+// The typical length of a bird is within 25 % of the mean of its songs
+void test_typical_length()
+{
+  BirdTable<NullChirpmaker::Bird> birds = NullChirpmaker::birds();
+  randomSeed(3);
+  for (uint16_t b = 0; b < birds.size(); b++)
+  {
+    NullChirpmaker cm(TEST_PIN);
+    const int songs = 100;
+    for (int i = 0; i < songs; i++) cm.birdVoice(b, 0);
+    double ms = cm.sink().ticks() / (1000.0 * NullSink::TICKS_PER_US * songs);
+    TEST_ASSERT_TRUE_MESSAGE(fabs(ms - birds[b].msTypical) < 0.25 * birds[b].msTypical, birds[b].name);
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_names);
+  RUN_TEST(test_weights);
+  RUN_TEST(test_chirpmaker_registry);
+  RUN_TEST(test_bird_voice_by_name);
+  RUN_TEST(test_typical_length);
+  return UNITY_END();
+}
@@ -0,0 +1,119 @@
+/**
+ * Output sinks and clocks: the same bird on the pin, in the recorder and
+ * in the counter, a recorder that runs full, and the virtual clock.
+ */
+#include <unity.h>
+#include <thread>
+#include "../ChirpTest.h"
+
+static std::vector<uint64_t> pinEdges;   // APB cycle of each level change
+
+static void onEdge(uint8_t pin, uint8_t level, uint64_t cycle)
+{
+  (void)level;
+  if (pin == TEST_PIN) pinEdges.push_back(cycle);
+}
+
+// The time between the level changes on the pin, in ticks of 0.1 us
+template <class Cm>
+static std::vector<uint64_t> onPin(uint16_t bird)
+{
+  Cm cm(TEST_PIN);
+  pinEdges.clear();
+  randomSeed(bird + 1);
+  cm.birdVoice(bird, 20);
+  digitalWrite(TEST_PIN, ! digitalRead(TEST_PIN));   // close the last level
+  std::vector<uint64_t> d;
+  for (size_t i = 1; i < pinEdges.size(); i++) d.push_back((pinEdges[i] - pinEdges[i - 1]) / (HOST_APB_HZ / RecorderSink::TICK_HZ));
+  digitalWrite(TEST_PIN, LOW);
+  return d;
+}
+
+void setUp()
+{
+  digitalWrite(TEST_PIN, LOW);
+  hostSetEdgeHook(onEdge);
+}
+
+void tearDown()
+{
+  hostSetEdgeHook(nullptr);
+}
+
+// Every sink gets the same sound: the pin sinks, the recorder and the counter
+void test_sinks_agree()
+{
+  static Edge recording[100000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(TEST_PIN);
+  static NullChirpmaker null(TEST_PIN);
+  for (uint16_t b : {0, 4, 11, 13})
+  {
+    rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+    randomSeed(b + 1);
+    rec.birdVoice(b, 20);
+    TEST_ASSERT_EQUAL(0, rec.sink().dropped());
+
+    // The recorder has an entry per half period, the pin only changes its level
+    std::vector<uint64_t> merged;
+    uint64_t ticks = 0;
+    for (size_t i = 0; i < rec.sink().count(); i++)
+    {
+      if (i > 0 && rec.sink()[i].level != rec.sink()[i - 1].level)
+      {
+        merged.push_back(ticks);
+        ticks = 0;
+      }
+      ticks += rec.sink()[i].ticks;
+    }
+    merged.push_back(ticks);
+    TEST_ASSERT_TRUE_MESSAGE(onPin<Chirpmaker>(b) == merged, rec.birds()[b].name);
+    TEST_ASSERT_TRUE_MESSAGE(onPin<FastChirpmaker>(b) == merged, rec.birds()[b].name);
+
+    uint32_t edges = null.sink().edges();
+    uint64_t nullTicks = null.sink().ticks();
+    randomSeed(b + 1);
+    null.birdVoice(b, 20);
+    TEST_ASSERT_EQUAL(rec.sink().count(), null.sink().edges() - edges);
+    TEST_ASSERT_EQUAL_UINT64(rec.sink().ticks(), null.sink().ticks() - nullTicks);
+  }
+}
+
+// A full recorder counts what it drops, the time still adds up
+void test_recorder_full()
+{
+  static Edge small[100];
+  BasicChirpmaker<RecorderSink, VirtualClock> rec(TEST_PIN);
+  rec.sink().setBuffer(small, 100);
+  rec.phaser(1000, 10, 50, 50, 1, 5);
+  TEST_ASSERT_EQUAL(21, rec.sink().count());
+  TEST_ASSERT_EQUAL(0, rec.sink().dropped());
+  TEST_ASSERT_EQUAL_UINT64(10 * 1000 * 10 + 5 * 1000 * 10, rec.sink().ticks());
+  rec.sink().clear();
+  rec.phaser(1000, 60, 50, 50, 1, 0);
+  TEST_ASSERT_EQUAL(100, rec.sink().count());
+  TEST_ASSERT_EQUAL(20, rec.sink().dropped());
+  TEST_ASSERT_EQUAL_UINT64(60 * 1000 * 10, rec.sink().ticks());
+}
+
+// The virtual clock only adds up, per thread
+void test_virtual_clock()
+{
+  uint64_t start = VirtualClock::us;
+  VirtualClock::delayUs(250);
+  VirtualClock::delayMs(3);
+  TEST_ASSERT_EQUAL_UINT64(start + 3250, VirtualClock::us);
+  uint64_t other = 1;
+  std::thread t([&] { VirtualClock::delayMs(10); other = VirtualClock::us; });
+  t.join();
+  TEST_ASSERT_EQUAL_UINT64(10000, other);
+  TEST_ASSERT_EQUAL_UINT64(start + 3250, VirtualClock::us);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_sinks_agree);
+  RUN_TEST(test_recorder_full);
+  RUN_TEST(test_virtual_clock);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+/**
+ * Song bytecode: the bird songs pass songCheck() and play like their C++
+ * birds, loops, sinc generators and tables of one's own, and the songs
+ * songCheck() and sing() refuse.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "BirdSongs.h"
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+// Level and ticks of each edge of whatever play() does
+template <class Play>
+static std::vector<uint64_t> recorded(Play play)
+{
+  static Edge recording[200000];
+  static Recorder cm(TEST_PIN);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+// Order independent stand-ins for random(), the same values whatever the order of the draws
+static long lowRandom(long howbig) { return howbig / 7; }
+static long highRandom(long howbig) { return howbig - 1; }
+
+static const uint16_t N_SONGS = sizeof(BIRD_SONGS) / sizeof(BIRD_SONGS[0]);
+
+void setUp() {}
+
+void tearDown()
+{
+  hostSetRandomHook(nullptr);
+}
+
+// Every bird song is valid, within the stack, and plays the edges of its bird
+void test_bird_songs()
+{
+  TEST_ASSERT_EQUAL(Recorder::birds().size(), N_SONGS);
+  for (uint16_t b = 0; b < N_SONGS; b++)
+  {
+    uint8_t depth = 0;
+    TEST_ASSERT_EQUAL(BIRD_SONGS[b].bytes, songCheck(BIRD_SONGS[b].code, BIRD_SONGS[b].bytes, &depth));
+    TEST_ASSERT_TRUE(depth > 0 && depth <= SONG_STACK);
+    for (HostRandomHook hook : {lowRandom, highRandom})
+    {
+      hostSetRandomHook(hook);
+      bool ok = false;
+      TEST_ASSERT_TRUE_MESSAGE(recorded([&](Recorder &cm) { cm.birdVoice(b, 20); })
+                            == recorded([&](Recorder &cm) { ok = cm.sing(BIRD_SONGS[b].code); cm.sink().pause(20); }),
+                               Recorder::birds()[b].name);
+      TEST_ASSERT_TRUE(ok);
+    }
+  }
+}
+
+// The length of each instruction
+void test_song_next()
+{
+  const uint8_t song[] = {S_PUSH8(1), S_PUSH16(300), S_RANDOM8(1, 2), S_RANDOM16(1000, 2000), S_CHIRP(GEN_LINEAR), S_PHASER, S_TABLE(0), S_PAUSE, S_REPEAT, S_LOOP, S_END};
+  const uint8_t sizes[] = {2, 3, 3, 5, 2, 1, 2, 1, 1, 1, 1};
+  const uint8_t *pc = song;
+  for (uint8_t size : sizes)
+  {
+    TEST_ASSERT_EQUAL(size, songNext(pc) - pc);
+    pc = songNext(pc);
+  }
+  TEST_ASSERT_TRUE(pc == song + sizeof(song));
+}
+
+// A loop plays its body n times, a sinc carries nPi in the upper bits of its generator
+void test_loops_and_sinc()
+{
+  const uint8_t song[] =
+  {
+    S_PUSH8(3), S_REPEAT,
+      S_PUSH8(2), S_REPEAT,
+        S_PUSH16(2000), S_PUSH8(4), S_PUSH8(10), S_PUSH8(60), S_PUSH8(1), S_PUSH8(5), S_PHASER,
+      S_LOOP,
+      S_PUSH16(1800), S_PUSH16(2400), S_PUSH8(50), S_PUSH8(15), S_PUSH8(2), S_PUSH8(50), S_PUSH8(30), S_SINC(GEN_SINC_0_NPI, 7),
+    S_LOOP,
+    S_END
+  };
+  TEST_ASSERT_EQUAL(sizeof(song), songCheck(song, sizeof(song)));
+  TEST_ASSERT_TRUE(recorded([&](Recorder &cm) { TEST_ASSERT_TRUE(cm.sing(song)); })
+                == recorded([](Recorder &cm)
+                   {
+                     for (int i = 0; i < 3; i++)
+                     {
+                       for (int j = 0; j < 2; j++) cm.phaser(2000, 4, 10, 60, 1, 5);
+                       cm.chirp(1800, 2400, 50, 15, 2, Sinc0_Npi(7), 50, 30);
+                     }
+                   }));
+}
+
+// SONG_TABLE plays the tables it is given, e.g. ranges of a segment stream
+void test_tables_of_ones_own()
+{
+  static const Segment stream[] = {{100, 100, 30}, {0, 5, 0}, {200, 300, 10}};
+  static const SongRange ranges[] = {{0, 2}, {2, 1}};
+  SongTables tables(stream, ranges, 2);
+  const uint8_t song[] = {S_PUSH8(2), S_TABLE(1), S_PUSH8(1), S_TABLE(0), S_END};
+  TEST_ASSERT_EQUAL(sizeof(song), songCheck(song, sizeof(song), nullptr, tables.size()));
+  TEST_ASSERT_EQUAL(-1, songCheck(song, sizeof(song), nullptr, 1));
+  TEST_ASSERT_TRUE(recorded([&](Recorder &cm) { TEST_ASSERT_TRUE(cm.sing(song, tables)); })
+                == recorded([](Recorder &cm) { cm.play(stream + 2, 1, 2); cm.play(stream, 2, 1); }));
+
+  const uint8_t unknown[] = {S_PUSH8(1), S_TABLE(2), S_END};
+  TEST_ASSERT_FALSE(recorded([&](Recorder &cm) { TEST_ASSERT_FALSE(cm.sing(unknown, tables)); }).size());
+}
+
+// songCheck() refuses what sing() cannot play
+void test_invalid_songs()
+{
+  const uint8_t leftOver[]   = {S_PUSH8(1), S_END};
+  const uint8_t underflow[]  = {S_PUSH8(1), S_PHASER, S_END};
+  const uint8_t noRepeat[]   = {S_LOOP, S_END};
+  const uint8_t noLoop[]     = {S_PUSH8(2), S_REPEAT, S_END};
+  const uint8_t loopPushes[] = {S_PUSH8(2), S_REPEAT, S_PUSH8(1), S_LOOP, S_END};
+  const uint8_t badTable[]   = {S_PUSH8(1), S_TABLE(SONG_TABLES_COUNT), S_END};
+  const uint8_t badGen[]     = {S_PUSH8(1), S_PUSH8(1), S_PUSH8(1), S_PUSH8(1), S_PUSH8(1), S_PUSH8(1), S_PUSH8(1), S_CHIRP(SONG_GENS), S_END};
+  const uint8_t badOp[]      = {SONG_OPS, S_END};
+  const uint8_t noEnd[]      = {S_PUSH16(10), S_PAUSE};
+  const uint8_t cutOperand[] = {SONG_PUSH16, 10};
+  const uint8_t deepLoops[]  = {S_PUSH8(1), S_REPEAT, S_PUSH8(1), S_REPEAT, S_PUSH8(1), S_REPEAT, S_PUSH8(1), S_REPEAT,
+                                S_PUSH8(1), S_REPEAT, S_LOOP, S_LOOP, S_LOOP, S_LOOP, S_LOOP, S_END};
+  TEST_ASSERT_EQUAL(-1, songCheck(leftOver, sizeof(leftOver)));
+  TEST_ASSERT_EQUAL(-1, songCheck(underflow, sizeof(underflow)));
+  TEST_ASSERT_EQUAL(-1, songCheck(noRepeat, sizeof(noRepeat)));
+  TEST_ASSERT_EQUAL(-1, songCheck(noLoop, sizeof(noLoop)));
+  TEST_ASSERT_EQUAL(-1, songCheck(loopPushes, sizeof(loopPushes)));
+  TEST_ASSERT_EQUAL(-1, songCheck(badTable, sizeof(badTable)));
+  TEST_ASSERT_EQUAL(-1, songCheck(badGen, sizeof(badGen)));
+  TEST_ASSERT_EQUAL(-1, songCheck(badOp, sizeof(badOp)));
+  TEST_ASSERT_EQUAL(-1, songCheck(noEnd, sizeof(noEnd)));
+  TEST_ASSERT_EQUAL(-1, songCheck(cutOperand, sizeof(cutOperand)));
+  TEST_ASSERT_EQUAL(-1, songCheck(deepLoops, sizeof(deepLoops)));
+
+  uint8_t full[2 * (SONG_STACK + 1) + 1];
+  for (int i = 0; i <= SONG_STACK; i++)
+  {
+    full[2 * i] = SONG_PUSH8;
+    full[2 * i + 1] = 1;
+  }
+  full[sizeof(full) - 1] = SONG_END;
+  TEST_ASSERT_EQUAL(-1, songCheck(full, sizeof(full)));
+
+  // sing() stops at the fault, what was played before stays played
+  const uint8_t late[] = {S_PUSH16(100), S_PAUSE, S_PAUSE, S_END};
+  std::vector<uint64_t> edges = recorded([&](Recorder &cm) { TEST_ASSERT_FALSE(cm.sing(late)); });
+  TEST_ASSERT_TRUE(edges == recorded([](Recorder &cm) { cm.sink().pause(100); }));
+  TEST_ASSERT_FALSE(recorded([&](Recorder &cm) { TEST_ASSERT_FALSE(cm.sing(full)); }).size());
+  TEST_ASSERT_FALSE(recorded([&](Recorder &cm) { TEST_ASSERT_FALSE(cm.sing(badOp)); }).size());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_bird_songs);
+  RUN_TEST(test_song_next);
+  RUN_TEST(test_loops_and_sinc);
+  RUN_TEST(test_tables_of_ones_own);
+  RUN_TEST(test_invalid_songs);
+  return UNITY_END();
+}
@@ -0,0 +1,241 @@
+/**
+ * SongBank: a bank of the bird songs opened in place and mapped from a
+ * file, names, metadata and songs, and the banks open() and check() refuse.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+#include "BirdSongs.h"
+#include "SongBank.h"
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+static const uint32_t N_SONGS = sizeof(BIRD_SONGS) / sizeof(BIRD_SONGS[0]);
+
+// Level and ticks of each edge of whatever play() does
+template <class Play>
+static std::vector<uint64_t> recorded(Play play)
+{
+  static Edge recording[200000];
+  static Recorder cm(TEST_PIN);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+// An order independent stand-in for random()
+static long lowRandom(long howbig) { return howbig / 7; }
+
+/**
+ * A bank of the bird songs, each copies times with the bytecode shared,
+ * the copies called name#copy. In words, so it is 4 byte aligned.
+ */
+static std::vector<uint32_t> buildBank(uint32_t copies)
+{
+  BirdTable<Recorder::Bird> registry = Recorder::birds();
+  std::vector<uint8_t> code;
+  std::vector<uint32_t> codeOffset;
+  for (const BirdSong &song : BIRD_SONGS)
+  {
+    codeOffset.push_back(code.size());
+    code.insert(code.end(), song.code, song.code + song.bytes);
+  }
+  std::vector<Segment> segments;
+  std::vector<SongRange> tables;
+  for (const SongTable &t : SONG_TABLES)
+  {
+    tables.push_back({(uint32_t)segments.size(), t.nSegments});
+    segments.insert(segments.end(), t.segments, t.segments + t.nSegments);
+  }
+  std::vector<SongBankBird> birds;
+  std::vector<char> names;
+  for (uint32_t c = 0; c < copies; c++)
+    for (uint32_t b = 0; b < N_SONGS; b++)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), c ? "%s#%u" : "%s", registry[b].name, c);
+      birds.push_back({(uint32_t)names.size(), codeOffset[b], BIRD_SONGS[b].bytes, registry[b].msTypical, registry[b].weight, {}});
+      names.insert(names.end(), name, name + strlen(name) + 1);
+    }
+  uint32_t nSlots = 1;
+  while (nSlots < 2 * birds.size()) nSlots *= 2;
+  std::vector<uint32_t> slots(nSlots);
+  for (uint32_t b = 0; b < birds.size(); b++)
+  {
+    uint32_t s = birdHash(&names[birds[b].name]) & (nSlots - 1);
+    while (slots[s]) s = (s + 1) & (nSlots - 1);
+    slots[s] = b + 1;
+  }
+
+  SongBankHeader h = {};
+  auto align = [](uint32_t n) { return (n + 3) & ~3u; };
+  h.magic = SONG_BANK_MAGIC;
+  h.version = SONG_BANK_VERSION;
+  h.headerBytes = sizeof(h);
+  h.nBirds = birds.size();
+  h.nSlots = nSlots;
+  h.nTables = tables.size();
+  h.nSegments = segments.size();
+  h.codeBytes = code.size();
+  h.nameBytes = names.size();
+  h.birdsOffset = sizeof(h);
+  h.slotsOffset = h.birdsOffset + h.nBirds * sizeof(SongBankBird);
+  h.tablesOffset = h.slotsOffset + h.nSlots * sizeof(uint32_t);
+  h.segmentsOffset = h.tablesOffset + h.nTables * sizeof(SongRange);
+  h.codeOffset = h.segmentsOffset + h.nSegments * sizeof(Segment);
+  h.namesOffset = align(h.codeOffset + h.codeBytes);
+  h.totalBytes = align(h.namesOffset + h.nameBytes);
+
+  std::vector<uint32_t> bank(h.totalBytes / 4);
+  uint8_t *p = reinterpret_cast<uint8_t *>(bank.data());
+  memcpy(p, &h, sizeof(h));
+  memcpy(p + h.birdsOffset, birds.data(), birds.size() * sizeof(SongBankBird));
+  memcpy(p + h.slotsOffset, slots.data(), slots.size() * sizeof(uint32_t));
+  memcpy(p + h.tablesOffset, tables.data(), tables.size() * sizeof(SongRange));
+  memcpy(p + h.segmentsOffset, segments.data(), segments.size() * sizeof(Segment));
+  memcpy(p + h.codeOffset, code.data(), code.size());
+  memcpy(p + h.namesOffset, names.data(), names.size());
+  return bank;
+}
+
+static SongBankHeader &headerOf(std::vector<uint32_t> &bank)
+{
+  return *reinterpret_cast<SongBankHeader *>(bank.data());
+}
+
+void setUp() {}
+
+void tearDown()
+{
+  hostSetRandomHook(nullptr);
+}
+
+// Every bird under its name with its metadata, the songs play like BirdSongs.h
+void test_open_in_place()
+{
+  std::vector<uint32_t> data = buildBank(3);
+  SongBank sb;
+  TEST_ASSERT_FALSE(sb.isOpen());
+  TEST_ASSERT_EQUAL(-1, sb.indexOf("cuckoo"));
+  TEST_ASSERT_TRUE(sb.open(data.data(), data.size() * 4));
+  TEST_ASSERT_TRUE(sb.check());
+  TEST_ASSERT_EQUAL_UINT32(3 * N_SONGS, sb.size());
+  TEST_ASSERT_EQUAL(data.size() * 4, sb.bytes());
+  TEST_ASSERT_EQUAL(SONG_TABLES_COUNT, sb.tables().size());
+
+  BirdTable<Recorder::Bird> registry = Recorder::birds();
+  for (uint32_t b = 0; b < N_SONGS; b++)
+  {
+    TEST_ASSERT_EQUAL(b, sb.indexOf(registry[b].name));
+    char name[32];
+    snprintf(name, sizeof(name), "%s#2", registry[b].name);
+    TEST_ASSERT_EQUAL(2 * N_SONGS + b, sb.indexOf(name));
+    TEST_ASSERT_EQUAL_STRING(name, sb.name(2 * N_SONGS + b));
+    TEST_ASSERT_EQUAL(registry[b].msTypical, sb.msTypical(b));
+    TEST_ASSERT_EQUAL(registry[b].weight, sb.weight(b));
+    TEST_ASSERT_EQUAL(BIRD_SONGS[b].bytes, sb.songBytes(b));
+    TEST_ASSERT_EQUAL_MEMORY(BIRD_SONGS[b].code, sb.song(2 * N_SONGS + b), BIRD_SONGS[b].bytes);
+  }
+  for (const char *name : {"", "cuckoo#3", "cuckoo#", "Raven"}) TEST_ASSERT_EQUAL(-1, sb.indexOf(name));
+
+  hostSetRandomHook(lowRandom);
+  for (uint32_t b = 0; b < N_SONGS; b++)
+  {
+    TEST_ASSERT_TRUE_MESSAGE(recorded([&](Recorder &cm) { cm.sing(BIRD_SONGS[b].code); })
+                          == recorded([&](Recorder &cm) { TEST_ASSERT_TRUE(cm.sing(sb.song(N_SONGS + b), sb.tables())); }),
+                             registry[b].name);
+  }
+}
+
+// open() only takes a header whose sections lie within the bank, aligned
+void test_open_refuses()
+{
+  std::vector<uint32_t> good = buildBank(1);
+  size_t bytes = good.size() * 4;
+  SongBank sb;
+  TEST_ASSERT_FALSE(sb.open(nullptr, bytes));
+  TEST_ASSERT_FALSE(sb.open(good.data(), sizeof(SongBankHeader) - 1));
+  TEST_ASSERT_FALSE(sb.open(good.data(), bytes - 4));
+  TEST_ASSERT_FALSE(sb.open(reinterpret_cast<uint8_t *>(good.data()) + 1, bytes - 1));
+
+  auto refused = [&](void (*spoil)(SongBankHeader &))
+  {
+    std::vector<uint32_t> bank = good;
+    spoil(headerOf(bank));
+    SongBank b;
+    return ! b.open(bank.data(), bytes) && ! b.isOpen();
+  };
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.magic ^= 1; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.version++; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.headerBytes = 8; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.nSlots--; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.nSlots = 8; }));   // fewer than the birds
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.nTables = 257; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.slotsOffset += 2; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.nSegments += 1000; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.nameBytes += 4; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.codeOffset = 0xfffffffc; }));
+  TEST_ASSERT_TRUE(refused([](SongBankHeader &h) { h.nBirds = 0x40000000; h.nSlots = 0x80000000; }));
+
+  TEST_ASSERT_TRUE(sb.open(good.data(), bytes));
+  TEST_ASSERT_FALSE(sb.open(good.data(), 10));
+  TEST_ASSERT_FALSE(sb.isOpen());
+}
+
+// check() finds a broken song, name, table or index that open() lets through
+void test_check_refuses()
+{
+  std::vector<uint32_t> good = buildBank(1);
+  size_t bytes = good.size() * 4;
+  auto checked = [&](void (*spoil)(uint8_t *bank, const SongBankHeader &h))
+  {
+    std::vector<uint32_t> bank = good;
+    spoil(reinterpret_cast<uint8_t *>(bank.data()), headerOf(bank));
+    SongBank b;
+    return b.open(bank.data(), bytes) && b.check();
+  };
+  TEST_ASSERT_TRUE(checked([](uint8_t *, const SongBankHeader &) {}));
+  TEST_ASSERT_FALSE(checked([](uint8_t *p, const SongBankHeader &h) { p[h.codeOffset] = SONG_OPS; }));
+  TEST_ASSERT_FALSE(checked([](uint8_t *p, const SongBankHeader &h) { memset(p + h.namesOffset, 'x', h.nameBytes); }));
+  TEST_ASSERT_FALSE(checked([](uint8_t *p, const SongBankHeader &h) { reinterpret_cast<SongRange *>(p + h.tablesOffset)->first = h.nSegments; }));
+  TEST_ASSERT_FALSE(checked([](uint8_t *p, const SongBankHeader &h) { reinterpret_cast<SongBankBird *>(p + h.birdsOffset)->codeBytes = 0xffff; }));
+  TEST_ASSERT_FALSE(checked([](uint8_t *p, const SongBankHeader &h) { memset(p + h.slotsOffset, 0, h.nSlots * 4); }));
+  TEST_ASSERT_FALSE(checked([](uint8_t *p, const SongBankHeader &h) { reinterpret_cast<SongBankBird *>(p + h.birdsOffset)[1].name = 0; }));
+}
+
+// map() opens a bank file in place, unmap() closes it
+void test_map_file()
+{
+  const char *path = "/tmp/test_song_bank.bin";
+  std::vector<uint32_t> data = buildBank(2);
+  FILE *f = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(f);
+  TEST_ASSERT_EQUAL(data.size(), fwrite(data.data(), 4, data.size(), f));
+  fclose(f);
+
+  SongBank sb;
+  TEST_ASSERT_TRUE(sb.map(path));
+  TEST_ASSERT_TRUE(sb.check());
+  TEST_ASSERT_EQUAL_UINT32(2 * N_SONGS, sb.size());
+  TEST_ASSERT_EQUAL(N_SONGS + 12, sb.indexOf("raven#1"));
+  sb.unmap();
+  TEST_ASSERT_FALSE(sb.isOpen());
+
+  f = fopen(path, "wb");
+  fwrite(data.data(), 1, 40, f);
+  fclose(f);
+  TEST_ASSERT_FALSE(sb.map(path));
+  remove(path);
+  TEST_ASSERT_FALSE(sb.map(path));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_open_in_place);
+  RUN_TEST(test_open_refuses);
+  RUN_TEST(test_check_refuses);
+  RUN_TEST(test_map_file);
+  return UNITY_END();
+}
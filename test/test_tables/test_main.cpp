@@ -0,0 +1,130 @@
+/**
+ * Compile time tables: the constexpr math against libm, every table of
+ * ConstSounds against the chirp compiled at runtime, and the sounds that
+ * play them.
+ */
+#include <unity.h>
+#include <type_traits>
+#include "../ChirpTest.h"
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+// Level and ticks of each edge of whatever play() does
+template <class Play>
+static std::vector<uint64_t> recorded(Play play)
+{
+  static Edge recording[100000];
+  static Recorder cm(TEST_PIN);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+// Append a segment, merged with the last one if it has the same timing, as ChirpProgram::add() does
+static void appendSegment(std::vector<Segment> &v, const Segment &seg)
+{
+  if (! v.empty() && ! seg.isPause() && ! v.back().isPause() && v.back().tOn == seg.tOn && v.back().tOff == seg.tOff) v.back().count += seg.count;
+  else v.push_back(seg);
+}
+
+// Timing and count of each segment, not the padding
+static bool sameSegments(const std::vector<Segment> &a, const Segment *b, size_t n)
+{
+  return a.size() == n && std::equal(a.begin(), a.end(), b, [](const Segment &x, const Segment &y)
+         { return x.tOn == y.tOn && x.tOff == y.tOff && x.count == y.count; });
+}
+
+/**
+ * The table against the periods of the double generator and, in a double
+ * build, against ChirpProgram::compileChirp() piece by piece
+ */
+template <size_t N>
+static void sameTable(const ConstProgram<N> &table, const ConstChirp &spec, double (*fgen)(int, double, double, int))
+{
+  std::vector<Segment> ref;
+  for (int s = 0; s <= spec.nSteps; s++)
+  {
+    uint32_t tOn, tOff;
+    chirpPeriod(fgen(s, spec.fStart, spec.fStop, spec.nSteps), spec.duty, tOn, tOff);
+    appendSegment(ref, {tOn, tOff, (uint16_t)spec.nPeriods});
+  }
+  if (spec.msPause) appendSegment(ref, {0, spec.msPause, 0});
+  TEST_ASSERT_TRUE(sameSegments(ref, table.begin(), N));
+
+  if (! std::is_same<Real, double>::value) return;
+  ChirpProgram prog;
+  std::vector<Segment> compiled;
+  for (int s = 0; s <= spec.nSteps; )
+  {
+    s = prog.compileChirp(spec.fStart, spec.fStop, spec.nSteps, spec.nPeriods, 1, FreqFn{fgen}, spec.duty, spec.msPause, s);
+    for (const Segment &seg : prog) appendSegment(compiled, seg);
+  }
+  TEST_ASSERT_TRUE(sameSegments(compiled, table.begin(), N));
+}
+
+// The tables are constant expressions
+static_assert(ConstSounds::SIGNET_UP.size() == constSegments(ConstSounds::SIGNET_UP_SPEC), "SIGNET_UP is not constexpr");
+static_assert(ConstSounds::BYTES <= 2048, "the tables are beyond their budget");
+
+void setUp() {}
+
+void tearDown() {}
+
+// The constexpr functions stay within 1e-15 of libm, relative; sin and cos within 4e-15 up to |x| = 20
+void test_const_math()
+{
+  for (double x = -20; x <= 20; x += 0.037)
+  {
+    TEST_ASSERT_DOUBLE_WITHIN(4e-15, sin(x), cxSin(x));
+    TEST_ASSERT_DOUBLE_WITHIN(4e-15, cos(x), cxCos(x));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-15 * fabs(atan(x)), atan(x), cxAtan(x));
+  }
+  for (double x = -30; x <= 30; x += 0.037) TEST_ASSERT_DOUBLE_WITHIN(1e-15 * exp(x), exp(x), cxExp(x));
+  for (double x = 1e-3; x <= 1e5; x *= 1.07) TEST_ASSERT_DOUBLE_WITHIN(1e-15 * fmax(fabs(log(x)), 1.0), log(x), cxLog(x));
+}
+
+// Period for period the chirps compiled at runtime
+void test_tables_equal_runtime()
+{
+  using S = ConstSounds;
+  sameTable(S::SIGNET_UP,        S::SIGNET_UP_SPEC,   cosine2PiScaleT<double>);
+  sameTable(S::SIGNET_DOWN,      S::SIGNET_DOWN_SPEC, cosine2PiScaleT<double>);
+  sameTable(S::PHONE_CALL,       S::PHONE_CALL_SPEC,  sinePiScaleT<double>);
+  sameTable(S::CUCKOO_CUC_TABLE, S::CUCKOO_CUC_SPEC,  linearScaleT<double>);
+  sameTable(S::CUCKOO_KOO_TABLE, S::CUCKOO_KOO_SPEC,  linearScaleT<double>);
+  sameTable(S::BIRD4_A,          S::BIRD4_A_SPEC,     atan2PiScaleT<double>);
+  sameTable(S::BIRD4_B,          S::BIRD4_B_SPEC,     atanPiScaleT<double>);
+  sameTable(S::BIRD4_C,          S::BIRD4_C_SPEC,     sinePiScaleT<double>);
+  sameTable(S::BIRD8,            S::BIRD8_SPEC,       sine2PiScaleT<double>);
+  sameTable(S::BIRD10_UP,        S::BIRD10_UP_SPEC,   atanPiScaleT<double>);
+  sameTable(S::BIRD10_DOWN,      S::BIRD10_DOWN_SPEC, atanPiScaleT<double>);
+  sameTable(S::RAVEN,            S::RAVEN_SPEC,       atanPiScaleT<double>);
+}
+
+// signet() and phoneCall() play the edges of their chirps, a table repeats
+void test_sounds_play_tables()
+{
+  if (std::is_same<Real, double>::value)
+  {
+    TEST_ASSERT_TRUE(recorded([](Recorder &cm) { cm.signet(); })
+                  == recorded([](Recorder &cm) { cm.chirp(440, 1320, 6, 300, 1, cosine2PiScale, 50, 1000);
+                                                 cm.chirp(1320, 440, 6, 300, 1, cosine2PiScale, 50, 3000); }));
+    TEST_ASSERT_TRUE(recorded([](Recorder &cm) { cm.phoneCall(3); })
+                  == recorded([](Recorder &cm) { cm.chirp(667, 557, 2, 20, 3, sinePiScale, 50, 20); }));
+  }
+  std::vector<uint64_t> once = recorded([](Recorder &cm) { cm.play(ConstSounds::BIRD8, 1); });
+  std::vector<uint64_t> twice = recorded([](Recorder &cm) { cm.play(ConstSounds::BIRD8, 2); });
+  TEST_ASSERT_EQUAL(2 * once.size(), twice.size());
+  TEST_ASSERT_TRUE(std::equal(once.begin(), once.end(), twice.begin() + once.size()));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_const_math);
+  RUN_TEST(test_tables_equal_runtime);
+  RUN_TEST(test_sounds_play_tables);
+  return UNITY_END();
+}
@@ -0,0 +1,139 @@
+/**
+ * TimerPlayer on the simulated timers: edges at their deadlines, ISR
+ * latency that does not add up, a full queue, the same bird as busy
+ * waiting, and the reproducible random() of the host.
+ */
+#include <unity.h>
+#include "../ChirpTest.h"
+
+struct PinEdge
+{
+  uint64_t cycle;
+  uint8_t level;
+};
+
+static std::vector<PinEdge> edges;
+
+static void onEdge(uint8_t pin, uint8_t level, uint64_t cycle)
+{
+  if (pin == TEST_PIN) edges.push_back({cycle, level});
+}
+
+// Durations between successive edges in APB cycles
+static std::vector<uint64_t> durations()
+{
+  std::vector<uint64_t> d;
+  for (size_t i = 1; i < edges.size(); i++) d.push_back(edges[i].cycle - edges[i - 1].cycle);
+  return d;
+}
+
+void setUp()
+{
+  edges.clear();
+  digitalWrite(TEST_PIN, LOW);
+  hostSetEdgeHook(onEdge);
+}
+
+void tearDown()
+{
+  hostSetEdgeHook(nullptr);
+  hostSetIsrLatency(0);
+}
+
+// Each level lasts exactly its ticks
+void test_edges_on_time()
+{
+  static TimerPlayer player;
+  player.begin(TEST_PIN);
+  const uint32_t ticks[] = {1000, 2500, 7, 40000, 123};
+  for (int i = 0; i < 5; i++) player.push(i % 2 ? LOW : HIGH, ticks[i]);
+  player.push(LOW, 0);   // dropped
+  player.flush();
+  TEST_ASSERT_TRUE(player.isIdle());
+  player.end();
+
+  TEST_ASSERT_EQUAL(5, edges.size());
+  std::vector<uint64_t> d = durations();
+  for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL_UINT64((uint64_t)ticks[i] * TimerPlayer::DIVIDER, d[i]);
+}
+
+// A late ISR delays each edge, but the delays do not add up
+void test_latency_does_not_accumulate()
+{
+  static TimerPlayer player;
+  player.begin(TEST_PIN);
+  const uint64_t latency = 3 * (HOST_APB_HZ / 1000000);
+  hostSetIsrLatency(latency);
+  for (int i = 0; i < 200; i++) player.pushUs(i % 2 ? LOW : HIGH, 50 + i % 7);
+  player.end();
+
+  TEST_ASSERT_EQUAL(200, edges.size());
+  uint64_t t0 = 0;
+  for (int i = 1; i < 200; i++)
+  {
+    t0 += (50 + (i - 1) % 7) * (HOST_APB_HZ / 1000000);
+    uint64_t t = edges[i].cycle - edges[0].cycle;
+    TEST_ASSERT_TRUE(t >= t0 && t <= t0 + latency);
+  }
+}
+
+// The producer waits while the queue is full, no edge is lost
+void test_full_queue()
+{
+  static TimerPlayer player;
+  player.begin(TEST_PIN, 1);
+  const int n = 3 * TimerPlayer::QUEUE_SIZE + 5;
+  for (int i = 0; i < n; i++) player.push(i % 2 ? LOW : HIGH, 100 + i);
+  TEST_ASSERT_TRUE(player.queued() < TimerPlayer::QUEUE_SIZE);
+  player.end();
+
+  TEST_ASSERT_EQUAL(n, edges.size());
+  std::vector<uint64_t> d = durations();
+  for (int i = 0; i < n - 1; i++) TEST_ASSERT_EQUAL_UINT64((uint64_t)(100 + i) * TimerPlayer::DIVIDER, d[i]);
+}
+
+// A bird played by the timer has the edges of the busy waiting original
+void test_same_as_busy_waiting()
+{
+  for (uint16_t b : {0, 11, 14})
+  {
+    Chirpmaker busy(TEST_PIN);
+    randomSeed(b + 1);
+    edges.clear();
+    busy.birdVoice(b, 20);
+    std::vector<uint64_t> expected = durations();
+
+    TimedChirpmaker timed(TEST_PIN);
+    randomSeed(b + 1);
+    edges.clear();
+    timed.birdVoice(b, 20);
+    timed.sink().player().end();
+    TEST_ASSERT_TRUE_MESSAGE(durations() == expected, busy.birds()[b].name);
+  }
+}
+
+// random() is the Park-Miller minimal standard generator
+void test_random_is_minimal_standard()
+{
+  randomSeed(1);
+  TEST_ASSERT_EQUAL(16807, random(2147483647L));
+  TEST_ASSERT_EQUAL(282475249, random(2147483647L));
+  TEST_ASSERT_EQUAL(1622650073, random(2147483647L));
+  randomSeed(42);
+  long a = random(10, 20);
+  randomSeed(42);
+  TEST_ASSERT_EQUAL(a, random(10, 20));
+  TEST_ASSERT_TRUE(a >= 10 && a < 20);
+  TEST_ASSERT_EQUAL(7, random(7, 7));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_edges_on_time);
+  RUN_TEST(test_latency_does_not_accumulate);
+  RUN_TEST(test_full_queue);
+  RUN_TEST(test_same_as_busy_waiting);
+  RUN_TEST(test_random_is_minimal_standard);
+  return UNITY_END();
+}
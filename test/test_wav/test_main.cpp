@@ -0,0 +1,108 @@
+/**
+ * WavWriter and the PcmSink behind it: the header, the samples against the
+ * recorded edges and the blocks handed to the writer.
+ */
+#include <unity.h>
+#include <unistd.h>
+#include "../ChirpTest.h"
+#include "WavWriter.h"
+
+static uint32_t le(const uint8_t *p, int bytes)
+{
+  uint32_t v = 0;
+  for (int i = bytes - 1; i >= 0; i--) v = v << 8 | p[i];
+  return v;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// A file that can seek gets the sizes of the samples written
+void test_header_sizes()
+{
+  FILE *f = tmpfile();
+  TEST_ASSERT_TRUE(f);
+  WavWriter wav;
+  TEST_ASSERT_TRUE(wav.open(f, 22050));
+  PcmChirpmaker cm(TEST_PIN);
+  cm.sink().setOutput(22050, WavWriter::block, &wav);
+  cm.cuckoo();
+  cm.sink().flush();
+  TEST_ASSERT_TRUE(wav.close());
+  TEST_ASSERT_EQUAL_UINT64(cm.sink().samples(), wav.samples());
+
+  uint8_t h[44];
+  rewind(f);
+  TEST_ASSERT_EQUAL(44, fread(h, 1, 44, f));
+  TEST_ASSERT_EQUAL_MEMORY("RIFF", h, 4);
+  TEST_ASSERT_EQUAL_MEMORY("WAVEfmt ", h + 8, 8);
+  TEST_ASSERT_EQUAL_MEMORY("data", h + 36, 4);
+  TEST_ASSERT_EQUAL_UINT32(22050, le(h + 24, 4));
+  TEST_ASSERT_EQUAL_UINT32(wav.samples() * 2, le(h + 40, 4));
+  TEST_ASSERT_EQUAL_UINT32(36 + wav.samples() * 2, le(h + 4, 4));
+  fseek(f, 0, SEEK_END);
+  TEST_ASSERT_EQUAL(44 + wav.samples() * 2, ftell(f));
+  fclose(f);
+}
+
+// On a pipe the sizes stay at their maximum
+void test_pipe_keeps_open_sizes()
+{
+  int fd[2];
+  TEST_ASSERT_EQUAL(0, pipe(fd));
+  FILE *out = fdopen(fd[1], "wb");
+  WavWriter wav;
+  TEST_ASSERT_TRUE(wav.open(out, 44100));
+  int16_t samples[100] = {};
+  TEST_ASSERT_TRUE(wav.write(samples, 100));
+  TEST_ASSERT_TRUE(wav.close());
+  fclose(out);
+
+  uint8_t h[44];
+  TEST_ASSERT_EQUAL(44, read(fd[0], h, 44));
+  close(fd[0]);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX - 36, le(h + 40, 4));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, le(h + 4, 4));
+}
+
+// Each sample has the level of the edge at its start, for every bird
+void test_samples_match_edges()
+{
+  static PcmChirpmaker cm(TEST_PIN);
+  for (uint16_t b = 0; b < cm.birds().size(); b++)
+  {
+    Samples pcm;
+    cm.sink().setOutput(44100, Samples::block, &pcm);
+    randomSeed(b + 1);
+    cm.birdVoice(b, 20);
+    cm.sink().flush();
+    std::vector<int16_t> expected = sampledEdges(44100, [b](auto &rec) { randomSeed(b + 1); rec.birdVoice(b, 20); });
+    TEST_ASSERT_EQUAL(expected.size(), pcm.v.size());
+    TEST_ASSERT_TRUE_MESSAGE(pcm.v == expected, cm.birds()[b].name);
+  }
+}
+
+// Full blocks reach the handler, only flush() hands on a shorter one
+void test_blocks()
+{
+  PcmChirpmaker cm(TEST_PIN);
+  Samples pcm;
+  cm.sink().setOutput(44100, Samples::block, &pcm);
+  cm.phoneCall(2);
+  TEST_ASSERT_EQUAL(pcm.blocks * PcmSink::BLOCK_SIZE, pcm.v.size());
+  cm.sink().flush();
+  TEST_ASSERT_EQUAL(PcmSink::BLOCK_SIZE, pcm.largest);
+  TEST_ASSERT_EQUAL_UINT64(cm.sink().samples(), pcm.v.size());
+  TEST_ASSERT_EQUAL((pcm.v.size() + PcmSink::BLOCK_SIZE - 1) / PcmSink::BLOCK_SIZE, pcm.blocks);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_header_sizes);
+  RUN_TEST(test_pipe_keeps_open_sizes);
+  RUN_TEST(test_samples_match_edges);
+  RUN_TEST(test_blocks);
+  return UNITY_END();
+}
@@ -0,0 +1,2450 @@
+/**
+ * Program      chirptool.cpp
+ * 
+ * Purpose      Host side companion of the Chirpmaker library (PlatformIO env:native).
+ *              Runs the library against the virtual clock of HostArduino and
+ *              checks or dumps what would appear on the buzzer pin.
+ * 
+ * Usage        chirptool trace          print the edge stream of a chirp played by the timer
+ *              chirptool check          compare busy waiting, timer (also with ISR latency) and recorder output of all birds
+ *              chirptool program        list the segments of compiled chirps
+ *              chirptool async          compare blocking and tick driven output of all birds, a sound of 13 calls or 40000 steps is refused
+ *              chirptool record         run every bird against the recording sink
+ *              chirptool measure        realized vs. requested frequency per step, us timing vs. DDS
+ *              chirptool numeric        accuracy and speed of the float and Q16.16 generators
+ *              chirptool batch          setup time of a 100 step chirp, scalar vs. batch generators
+ *              chirptool drift          accuracy of the incremental generators up to 10000 steps
+ *              chirptool objects        generator objects vs. free functions: output and compile time
+ *              chirptool tables         size of the compile time chirp tables, checked against runtime compilation
+ *              chirptool templates      100k randomized bird chirps: plain vs. cached generators vs. table
+ *              chirptool programs       program cache: hits and misses over the birds, output and time with and without
+ *              chirptool birds          the bird registry: name lookup, typical vs. measured song length
+ *              chirptool songs          bytecode of the birds: size, check, same edges as the C++ birds, speed
+ *              chirptool bank FILE [N]  write a song bank of the birds, each N times (default 1)
+ *              chirptool banks          open time of song banks of 15 .. 10005 birds, checked against the birds
+ *              chirptool poly           1 .. 16 birds at once on one timer, each pin against its bird played alone
+ *              chirptool concert        overlapping birds: timeline statistics, 4 buzzers against a PCM mix of the same concert
+ *              chirptool worker         commands to the audio thread: same edges as played directly, post time, FIFO order, drops only when full
+ *              chirptool log            deferred logging: cost of a log site, formatting, lost events, stripped sites, 2 threads
+ *              chirptool wav FILE|- [RATE] [blep] bird N|NAME, chirp fStart fStop nSteps nPeriods nChirps duty msPause,
+ *                                       phaser freq nPeriods dutyStart dutyEnd nChirps msPause, concert nBirds
+ *                                       render a sound into a WAV file (- stdout), default 44100 Hz, blep band-limited
+ *              chirptool render         all birds to WAV: speed against real time, samples against the recorded edges
+ *              chirptool blep           band-limited pulses: alias level against naive sampling and the ideal pulse, SIMD vs. scalar, speed
+ *              chirptool chunks         concert rendered in chunks on 1 .. 32 threads: same samples as one chunk, scaling of an hour
+ *              chirptool pdm            sigma-delta sine: SNR of the low-passed bitstream, Mbit/s, harmonics of a chirp vs. squares
+ *              chirptool clips [FILE]   prerendered clips: memory per second, startup cost, double-buffered playback, CPU, on 4 threads; FILE gets the cuckoo
+ *              chirptool adpcm [FILE [RATE]]  ADPCM clips of all birds: size, SNR per bird plain, at 1/4 amplitude and band-limited, decode speed; FILE gets a band-limited C header bank
+ */
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "Chirpmaker.h"
+#include "ConstSounds.h"
+#include "CurveCache.h"
+#include "BirdSongs.h"
+#include "SongBank.h"
+#include "PolyPlayer.h"
+#include "Concert.h"
+#include "AudioWorker.h"
+#include "WavWriter.h"
+#include "ConcertRenderer.h"
+#include "SamplePlayer.h"
+#include <thread>
+#include <string>
+#include <complex>
+
+const uint8_t PIN_BUZZER = 4;
+
+struct PinEdge
+{
+  uint64_t cycle;
+  uint8_t  level;
+};
+
+static std::vector<PinEdge> edges;
+
+static void recordEdge(uint8_t pin, uint8_t level, uint64_t cycle)
+{
+  if (pin == PIN_BUZZER) edges.push_back({cycle, level});
+}
+
+/**
+ * Durations between successive edges in us, independent of the start time
+ */
+static std::vector<uint64_t> durations(const std::vector<PinEdge> &e)
+{
+  std::vector<uint64_t> d;
+  for (size_t i = 1; i < e.size(); i++) d.push_back((e[i].cycle - e[i-1].cycle) / (HOST_APB_HZ / 1000000));
+  return d;
+}
+
+static int trace()
+{
+  TimedChirpmaker cm(PIN_BUZZER);
+  edges.clear();
+  cm.chirp(1000, 3000, 5, 3, 1, chromaticScale, 50, 10);
+  cm.sink().player().flush();
+  for (auto &e : edges) printf("%12.1f us  %s\n", e.cycle * 1e6 / HOST_APB_HZ, e.level ? "HIGH" : "LOW");
+  return 0;
+}
+
+/**
+ * Durations between the level changes of a recording in us. Like on the
+ * pin, equal levels are merged and the duration of the last level is open.
+ */
+static std::vector<uint64_t> durations(const RecorderSink &rec)
+{
+  std::vector<uint64_t> d;
+  int level = -1;
+  uint64_t ticks = 0;
+  for (size_t i = 0; i < rec.count(); i++)
+  {
+    if (rec[i].ticks == 0) continue;
+    if (rec[i].level != level && level >= 0)
+    {
+      d.push_back(ticks / RecorderSink::TICKS_PER_US);
+      ticks = 0;
+    }
+    level = rec[i].level;
+    ticks += rec[i].ticks;
+  }
+  return d;
+}
+
+static void listProgram(const char *title, const ChirpProgram &prog)
+{
+  printf("%s: %u segments, %u repeats, %u us per pass\n", title, prog.size(), prog.repeats, prog.durationUs());
+  for (const Segment &seg : prog)
+  {
+    if (seg.isPause()) printf("  pause %6u ms\n", seg.tOff);
+    else printf("  %5u x %6u us on %6u us off\n", seg.count, seg.tOn, seg.tOff);
+  }
+}
+
+static int program()
+{
+  ChirpProgram prog;
+  prog.compileChirp(1320, 3880, 5, 10, 5, sine2PiScale, 50, 100);
+  listProgram("bird8", prog);
+  prog.compileChirp(440, 1320, 6, 300, 1, cosine2PiScale, 50, 1000);
+  listProgram("signet", prog);
+  prog.compilePhaser(1500, 30, 5, 95, 3, 200);
+  listProgram("phaser", prog);
+  return 0;
+}
+
+static int check()
+{
+  int failures = 0;
+  static Edge recording[100000];
+  for (uint8_t b = 0; b < 15; b++)
+  {
+    Chirpmaker cm(PIN_BUZZER);
+    randomSeed(b + 1);
+    edges.clear();
+    cm.birdVoice(b, 20);
+    std::vector<uint64_t> busy = durations(edges);
+
+    TimedChirpmaker tcm(PIN_BUZZER);
+    randomSeed(b + 1);
+    edges.clear();
+    tcm.birdVoice(b, 20);
+    tcm.sink().player().end();
+    std::vector<uint64_t> timed = durations(edges);
+    std::vector<PinEdge> onTime = edges;
+
+    // An ISR that runs 3 us late delays each edge, by twice that after an edge shorter than
+    // the latency, but the delays must not add up
+    const uint64_t latency = 3 * HOST_APB_HZ / 1000000;
+    hostSetIsrLatency(latency);
+    TimedChirpmaker lcm(PIN_BUZZER);
+    randomSeed(b + 1);
+    edges.clear();
+    lcm.birdVoice(b, 20);
+    lcm.sink().player().end();
+    hostSetIsrLatency(0);
+    bool late = edges.size() == onTime.size();
+    for (size_t i = 0; i < edges.size() && late; i++)
+    {
+      uint64_t t = edges[i].cycle - edges[0].cycle, t0 = onTime[i].cycle - onTime[0].cycle;
+      late = t >= t0 && t <= t0 + 2 * latency;
+    }
+
+    BasicChirpmaker<RecorderSink, VirtualClock> rcm(PIN_BUZZER);
+    rcm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+    randomSeed(b + 1);
+    rcm.birdVoice(b, 20);
+    std::vector<uint64_t> recorded = durations(rcm.sink());
+
+    bool ok = busy == timed && busy == recorded && late;
+    printf("bird %2d: %6zu edges %s\n", b, busy.size(), ok ? "ok" : "MISMATCH");
+    if (! ok) failures++;
+  }
+  return failures ? 1 : 0;
+}
+
+/**
+ * Every bird against the recording sink on the virtual clock
+ */
+static int record()
+{
+  static Edge recording[100000];
+  BasicChirpmaker<RecorderSink, VirtualClock> cm(PIN_BUZZER);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  for (uint8_t b = 0; b < 15; b++)
+  {
+    cm.sink().clear();
+    randomSeed(b + 1);
+    cm.birdVoice(b, 20);
+    printf("bird %2d: %6zu edges %8.1f ms\n", b, cm.sink().count(), cm.sink().ticks() / (RecorderSink::TICK_HZ / 1000.0));
+  }
+  return 0;
+}
+
+/**
+ * Play with the non-blocking API, stepping a fake clock by 1 us per tick
+ */
+static std::vector<uint64_t> tickDriven(Chirpmaker &cm)
+{
+  edges.clear();
+  uint32_t now = micros();
+  while (cm.tick(now))
+  {
+    delayMicroseconds(1);
+    now = micros();
+  }
+  digitalWrite(PIN_BUZZER, HIGH);  // close the final pause
+  std::vector<uint64_t> d = durations(edges);
+  digitalWrite(PIN_BUZZER, LOW);
+  return d;
+}
+
+static int async()
+{
+  int failures = 0;
+  Chirpmaker cm(PIN_BUZZER);
+  for (uint8_t b = 0; b < 15; b++)
+  {
+    randomSeed(b + 1);
+    edges.clear();
+    cm.birdVoice(b, 20);
+    digitalWrite(PIN_BUZZER, HIGH);  // close the final pause
+    std::vector<uint64_t> blocking = durations(edges);
+    digitalWrite(PIN_BUZZER, LOW);
+
+    randomSeed(b + 1);
+    cm.startBird(b, 20);
+    std::vector<uint64_t> ticked = tickDriven(cm);
+
+    bool ok = blocking == ticked;
+    printf("bird %2d: %6zu edges %s\n", b, blocking.size(), ok ? "ok" : "MISMATCH");
+    if (! ok) failures++;
+  }
+
+  randomSeed(99);
+  edges.clear();
+  cm.birdConcert(500);
+  digitalWrite(PIN_BUZZER, HIGH);
+  std::vector<uint64_t> blocking = durations(edges);
+  digitalWrite(PIN_BUZZER, LOW);
+  randomSeed(99);
+  cm.startConcert(500);
+  std::vector<uint64_t> ticked = tickDriven(cm);
+  bool ok = blocking == ticked;
+  printf("concert: %6zu edges %s\n", blocking.size(), ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  // n short chirps and the pause of startSong(), a sound of n + 1 calls
+  uint8_t song[] = {S_PUSH8(0), S_REPEAT, S_PUSH16(2000), S_PUSH16(3000), S_PUSH8(10), S_PUSH8(2), S_PUSH8(1), S_PUSH8(50), S_PUSH8(5),
+                    S_CHIRP(GEN_LINEAR), S_LOOP, S_END};
+  for (uint8_t n : {11, 12})
+  {
+    song[1] = n;
+    edges.clear();
+    cm.sing(song);
+    delay(20);
+    digitalWrite(PIN_BUZZER, HIGH);
+    blocking = durations(edges);
+    digitalWrite(PIN_BUZZER, LOW);
+    bool started = cm.startSong(song, 20);
+    ticked = tickDriven(cm);
+    bool fits = n + 1 <= 12;
+    ok = started == fits && cm.overflowed() != fits && (fits ? ticked == blocking : ticked.size() <= 1);
+    printf("%d calls: %s %s\n", n + 1, fits ? "played " : "refused", ok ? "ok" : "MISMATCH");
+    if (! ok) failures++;
+  }
+
+  // The counts of a call are 16 bits
+  ok = ! cm.startChirp(2000, 3000, 40000, 1, 1, linearScale, 50, 0) && cm.overflowed() && ! cm.isBusy();
+  printf("40000 steps: refused %s\n", ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+  return failures ? 1 : 0;
+}
+
+struct Generator
+{
+  const char *name;
+  double (*fgen)(int, double, double, int);
+  double (*fgenSinc)(int, double, double, int, int);
+  FreqGenBatch batch;
+  FreqGenSincBatch batchSinc;
+  FreqGenBatch incremental;
+};
+
+static const Generator generators[] =
+{
+  {"linearScale",      linearScale,    nullptr,          linearScaleBatch,    nullptr,               nullptr},
+  {"chromaticScale",   chromaticScale, nullptr,          chromaticScaleBatch, nullptr,               chromaticScaleIncBatch},
+  {"sinePiScale",      sinePiScale,    nullptr,          sinePiScaleBatch,    nullptr,               sinePiScaleIncBatch},
+  {"sine2PiScale",     sine2PiScale,   nullptr,          sine2PiScaleBatch,   nullptr,               sine2PiScaleIncBatch},
+  {"cosinePiScale",    cosinePiScale,  nullptr,          cosinePiScaleBatch,  nullptr,               cosinePiScaleIncBatch},
+  {"cosine2PiScale",   cosine2PiScale, nullptr,          cosine2PiScaleBatch, nullptr,               cosine2PiScaleIncBatch},
+  {"atanPiScale",      atanPiScale,    nullptr,          atanPiScaleBatch,    nullptr,               nullptr},
+  {"atan2PiScale",     atan2PiScale,   nullptr,          atan2PiScaleBatch,   nullptr,               nullptr},
+  {"sincScaleNpi_Npi", nullptr,        sincScaleNpi_Npi, nullptr,             sincScaleNpi_NpiBatch, nullptr},
+  {"sincScale0_Npi",   nullptr,        sincScale0_Npi,   nullptr,             sincScale0_NpiBatch,   nullptr},
+  {"sincScaleNpi_0",   nullptr,        sincScaleNpi_0,   nullptr,             sincScaleNpi_0Batch,   nullptr},
+};
+
+static double generate(const Generator &g, int s, double fStart, double fStop, int nSteps)
+{
+  return g.fgen ? g.fgen(s, fStart, fStop, nSteps) : g.fgenSinc(s, fStart, fStop, nSteps, 3);
+}
+
+/**
+ * Realized frequency of every step of a 4..6 kHz chirp, once with the
+ * whole us periods of chirp() and once with the DDS engine at 0.1 us ticks
+ */
+static int measure()
+{
+  const double fStart = 4000, fStop = 6000;
+  const int nSteps = 10, nPeriods = 20, duty = 50;
+  printf("%-17s %4s %10s %10s %8s %10s %8s\n", "generator", "step", "requested", "us timing", "error %", "DDS", "error %");
+  for (const Generator &g : generators)
+  {
+    DdsEngine dds(TimerPlayer::TICK_HZ);
+    double worstUs = 0, worstDds = 0;
+    for (int s = 0; s <= nSteps; s++)
+    {
+      double f = generate(g, s, fStart, fStop, nSteps);
+      double p = 1000000.0 / f;
+      uint32_t tOn  = p * duty / 100.0;
+      uint32_t tOff = p - tOn;
+      double fUs = 1000000.0 / (tOn + tOff);
+
+      dds.setTone(f, duty);
+      uint64_t ticks = 0;
+      for (int n = 0; n < nPeriods; n++)
+      {
+        uint32_t on, off;
+        dds.nextPeriod(on, off);
+        ticks += on + off;
+      }
+      double fDds = (double)nPeriods * TimerPlayer::TICK_HZ / ticks;
+
+      double eUs = 100.0 * (fUs - f) / f, eDds = 100.0 * (fDds - f) / f;
+      if (fabs(eUs) > worstUs) worstUs = fabs(eUs);
+      if (fabs(eDds) > worstDds) worstDds = fabs(eDds);
+      printf("%-17s %4d %10.2f %10.2f %8.3f %10.2f %8.3f\n", g.name, s, f, fUs, eUs, fDds, eDds);
+    }
+    printf("%-17s worst error: us timing %.3f %%, DDS %.4f %%\n\n", g.name, worstUs, worstDds);
+  }
+  return 0;
+}
+
+template <class T>
+struct TypedGenerator
+{
+  T (*fgen)(int, T, T, int);
+  T (*fgenSinc)(int, T, T, int, int);
+
+  T operator()(int s, T fStart, T fStop, int nSteps) const
+  {
+    return fgen ? fgen(s, fStart, fStop, nSteps) : fgenSinc(s, fStart, fStop, nSteps, 3);
+  }
+};
+
+template <class T>
+static const TypedGenerator<T> typedGenerators[] =
+{
+  {linearScaleT<T>, nullptr}, {chromaticScaleT<T>, nullptr}, {sinePiScaleT<T>, nullptr}, {sine2PiScaleT<T>, nullptr},
+  {cosinePiScaleT<T>, nullptr}, {cosine2PiScaleT<T>, nullptr}, {atanPiScaleT<T>, nullptr}, {atan2PiScaleT<T>, nullptr},
+  {nullptr, sincScaleNpi_NpiT<T>}, {nullptr, sincScale0_NpiT<T>}, {nullptr, sincScaleNpi_0T<T>},
+};
+
+// Frequency ranges and step counts as used by the birds
+struct ChirpRange { double fStart, fStop; int nSteps; };
+static const ChirpRange ranges[] =
+{
+  {4000, 6000, 10}, {1000, 3000, 70}, {440, 1320, 6}, {75, 65, 8}, {900, 2000, 50},
+  {2400, 1000, 65}, {1500, 4500, 100}, {4400, 2500, 100}, {1440, 1880, 20}, {3000, 1200, 120},
+};
+
+/**
+ * Worst relative frequency deviation and worst period deviation in us
+ * of the generator g of type T against the double reference
+ */
+template <class T>
+static void deviation(size_t g, double &worstF, uint32_t &worstP)
+{
+  worstF = 0; worstP = 0;
+  for (const ChirpRange &r : ranges)
+  {
+    for (int s = 0; s <= r.nSteps; s++)
+    {
+      double ref = typedGenerators<double>[g](s, r.fStart, r.fStop, r.nSteps);
+      T f = typedGenerators<T>[g](s, T(r.fStart), T(r.fStop), r.nSteps);
+      double e = fabs((double)f - ref) / ref;
+      if (e > worstF) worstF = e;
+
+      uint32_t onRef, offRef, on, off;
+      chirpPeriod(ref, 50, onRef, offRef);
+      chirpPeriod(f, 50, on, off);
+      uint32_t dp = on + off > onRef + offRef ? on + off - onRef - offRef : onRef + offRef - on - off;
+      if (dp > worstP) worstP = dp;
+    }
+  }
+}
+
+// Time per generator call plus period computation in ns
+template <class T>
+static double speed(size_t g)
+{
+  const int rounds = 2000;
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+  {
+    const ChirpRange &r = ranges[i % 10];
+    for (int s = 0; s <= r.nSteps; s++)
+    {
+      uint32_t on, off;
+      chirpPeriod(typedGenerators<T>[g](s, T(r.fStart + i % 7), T(r.fStop), r.nSteps), 50, on, off);
+      sink = sink + on + off;
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  int calls = 0;
+  for (int i = 0; i < rounds; i++) calls += ranges[i % 10].nSteps + 1;
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+}
+
+static int numeric()
+{
+  printf("%-17s %28s %28s %27s\n", "", "float vs. double", "Q16.16 vs. double", "ns per step (host)");
+  printf("%-17s %14s %13s %14s %13s %9s %8s %8s\n", "generator", "freq error", "period us", "freq error", "period us", "double", "float", "Q16.16");
+  for (size_t g = 0; g < sizeof(generators) / sizeof(generators[0]); g++)
+  {
+    double ef, eq;
+    uint32_t pf, pq;
+    deviation<float>(g, ef, pf);
+    deviation<Fix16>(g, eq, pq);
+    printf("%-17s %13.5f%% %13u %13.5f%% %13u %9.1f %8.1f %8.1f\n", generators[g].name, 100 * ef, pf, 100 * eq, pq,
+           speed<double>(g), speed<float>(g), speed<Fix16>(g));
+  }
+  return 0;
+}
+
+/**
+ * Time to compute the 101 frequencies of a 100 step chirp (the longest
+ * chirps of _bird1 and blackbird), once step by step with the scalar
+ * generator, once with a single call of its batch form and, where there
+ * is one, of its incremental form. Scalar and batch tables have to be
+ * identical.
+ */
+template <typename Fill>
+static double chirpNs(Fill fill, double *freqs, int nSteps)
+{
+  const int rounds = 20000;
+  volatile double sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+  {
+    fill(freqs, 1500 + i % 7, 4500.0);
+    sink = sink + freqs[nSteps / 2];
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+}
+
+static int batch()
+{
+  const int nSteps = 100;
+  double scalar[nSteps + 1], batched[nSteps + 1], incremental[nSteps + 1];
+  int failures = 0;
+  printf("%-17s %10s %10s %8s %14s %8s\n", "generator", "scalar ns", "batch ns", "speedup", "incremental ns", "speedup");
+  for (const Generator &g : generators)
+  {
+    double nsScalar = chirpNs([&](double *f, double fStart, double fStop)
+      { for (int s = 0; s <= nSteps; s++) f[s] = generate(g, s, fStart, fStop, nSteps); }, scalar, nSteps);
+    double nsBatch = chirpNs([&](double *f, double fStart, double fStop)
+      {
+        if (g.batch) g.batch(f, 0, nSteps + 1, fStart, fStop, nSteps);
+        else g.batchSinc(f, 0, nSteps + 1, fStart, fStop, nSteps, 3);
+      }, batched, nSteps);
+    bool same = memcmp(scalar, batched, sizeof(scalar)) == 0;
+    printf("%-17s %10.0f %10.0f %7.1fx", g.name, nsScalar, nsBatch, nsScalar / nsBatch);
+    if (g.incremental)
+    {
+      double nsInc = chirpNs([&](double *f, double fStart, double fStop)
+        { g.incremental(f, 0, nSteps + 1, fStart, fStop, nSteps); }, incremental, nSteps);
+      printf(" %14.0f %7.1fx", nsInc, nsScalar / nsInc);
+    }
+    else printf(" %14s %8s", "-", "-");
+    printf("%s\n", same ? "" : " MISMATCH");
+    if (! same) failures++;
+  }
+  return failures ? 1 : 0;
+}
+
+template <class T>
+struct IncrementalGenerator
+{
+  void (*exact)(double *, int, int, T, T, int);
+  void (*incremental)(double *, int, int, T, T, int);
+};
+
+template <class T>
+static const IncrementalGenerator<T> incrementalGenerators[] =
+{
+  {chromaticScaleBatchT<T, double>, chromaticScaleIncT<T, double>},
+  {sinePiScaleBatchT<T, double>,    sinePiScaleIncT<T, double>},
+  {sine2PiScaleBatchT<T, double>,   sine2PiScaleIncT<T, double>},
+  {cosinePiScaleBatchT<T, double>,  cosinePiScaleIncT<T, double>},
+  {cosine2PiScaleBatchT<T, double>, cosine2PiScaleIncT<T, double>},
+};
+static const char *incrementalNames[] = {"chromaticScale", "sinePiScale", "sine2PiScale", "cosinePiScale", "cosine2PiScale"};
+
+/**
+ * Worst deviation of the incremental from the exact generator g of type T,
+ * relative to the frequency span. The steps are generated in batches of
+ * 32 like ChirpProgram does, and once more in a single batch, both have to
+ * give the same values. periods counts the steps whose whole us period differs.
+ */
+template <class T>
+static double drift(size_t g, int nSteps, int &periods, bool &chunked)
+{
+  const double fStart = 1000, fStop = 4000;
+  std::vector<double> exact(nSteps + 1), inc(nSteps + 1), whole(nSteps + 1);
+  const IncrementalGenerator<T> &gen = incrementalGenerators<T>[g];
+  gen.exact(exact.data(), 0, nSteps + 1, T(fStart), T(fStop), nSteps);
+  gen.incremental(whole.data(), 0, nSteps + 1, T(fStart), T(fStop), nSteps);
+  for (int s = 0; s <= nSteps; s += ChirpProgram::STEP_CHUNK)
+  {
+    int n = nSteps + 1 - s < ChirpProgram::STEP_CHUNK ? nSteps + 1 - s : ChirpProgram::STEP_CHUNK;
+    gen.incremental(inc.data() + s, s, n, T(fStart), T(fStop), nSteps);
+  }
+  chunked = inc == whole;
+  double worst = 0;
+  periods = 0;
+  for (int s = 0; s <= nSteps; s++)
+  {
+    double e = fabs(inc[s] - exact[s]) / (fStop - fStart);
+    if (e > worst) worst = e;
+    uint32_t on, off, onExact, offExact;
+    chirpPeriod(inc[s], 50, on, off);
+    chirpPeriod(exact[s], 50, onExact, offExact);
+    if (on != onExact || off != offExact) periods++;
+  }
+  return worst;
+}
+
+static int driftTest()
+{
+  const int steps[] = {10, 100, 1000, 10000};
+  const double limit[] = {1e-12, 1e-5, 2e-3};  // double, float, Q16.16
+  int failures = 0;
+  printf("%-17s %6s %12s %12s %12s %8s\n", "generator", "nSteps", "double", "float", "Q16.16", "periods");
+  for (size_t g = 0; g < sizeof(incrementalNames) / sizeof(incrementalNames[0]); g++)
+  {
+    for (int nSteps : steps)
+    {
+      int periods, p;
+      bool c0, c1, c2;
+      double e[3] = {drift<double>(g, nSteps, periods, c0), drift<float>(g, nSteps, p, c1), drift<Fix16>(g, nSteps, p, c2)};
+      bool ok = c0 && c1 && c2 && e[0] < limit[0] && e[1] < limit[1] && e[2] < limit[2];
+      printf("%-17s %6d %12.2e %12.2e %12.2e %8d %s\n", incrementalNames[g], nSteps, e[0], e[1], e[2], periods, ok ? "ok" : "FAIL");
+      if (! ok) failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
+
+using Recorder = BasicChirpmaker<RecorderSink, VirtualClock>;
+
+// Edges of whatever play() does on a recording chirpmaker
+template <typename Play>
+static std::vector<uint64_t> recorded(Play play)
+{
+  static Edge recording[100000];
+  Recorder cm(PIN_BUZZER);
+  cm.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  play(cm);
+  std::vector<uint64_t> d;
+  for (size_t i = 0; i < cm.sink().count(); i++) d.push_back(cm.sink()[i].ticks << 1 | cm.sink()[i].level);
+  return d;
+}
+
+// ns to compile a 100 step chirp with generator gen
+template <class Gen>
+static double compileNs(const Gen &gen)
+{
+  const int rounds = 20000;
+  static ChirpProgram prog;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) prog.compileChirp(1500 + i % 7, 4500, 100, 1, 1, gen, 50, 20);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+}
+
+/**
+ * The generator objects have to produce the same edges as the free
+ * functions, sinc chirps can now be repeated, also without blocking
+ */
+static int objects()
+{
+  int failures = 0;
+  auto report = [&](const char *what, bool ok, double nsFn, double nsObj)
+  {
+    printf("%-17s %s", what, ok ? "ok      " : "MISMATCH");
+    if (nsFn > 0) printf(" %8.0f ns function %8.0f ns object", nsFn, nsObj);
+    printf("\n");
+    if (! ok) failures++;
+  };
+  auto same = [](FreqGen fgen, auto gen)
+  {
+    return recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, fgen, 50, 20); })
+        == recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, gen, 50, 20); });
+  };
+  auto sameSinc = [](FreqGenSinc fgen, auto gen)
+  {
+    return recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 3, fgen, 50, 20); })
+        == recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 1, gen, 50, 20); });
+  };
+
+  report("Linear",    same(linearScale, Linear()),       compileNs(FreqFn{linearScale}),    compileNs(Linear()));
+  report("Chromatic", same(chromaticScale, Chromatic()), compileNs(FreqFn{chromaticScale}), compileNs(Chromatic()));
+  report("SinePi",    same(sinePiScale, SinePi()),       compileNs(FreqFn{sinePiScale}),    compileNs(SinePi()));
+  report("Sine2Pi",   same(sine2PiScale, Sine2Pi()),     compileNs(FreqFn{sine2PiScale}),   compileNs(Sine2Pi()));
+  report("CosinePi",  same(cosinePiScale, CosinePi()),   compileNs(FreqFn{cosinePiScale}),  compileNs(CosinePi()));
+  report("Cosine2Pi", same(cosine2PiScale, Cosine2Pi()), compileNs(FreqFn{cosine2PiScale}), compileNs(Cosine2Pi()));
+  report("AtanPi",    same(atanPiScale, AtanPi()),       compileNs(FreqFn{atanPiScale}),    compileNs(AtanPi()));
+  report("Atan2Pi",   same(atan2PiScale, Atan2Pi()),     compileNs(FreqFn{atan2PiScale}),   compileNs(Atan2Pi()));
+  report("Sinc",      sameSinc(sincScaleNpi_Npi, Sinc(3)),     compileNs(FreqFnSinc{sincScaleNpi_Npi, 3}), compileNs(Sinc(3)));
+  report("SincNpi_0", sameSinc(sincScaleNpi_0, SincNpi_0(3)),  compileNs(FreqFnSinc{sincScaleNpi_0, 3}),   compileNs(SincNpi_0(3)));
+  report("Sinc0_Npi", sameSinc(sincScale0_Npi, Sinc0_Npi(3)),  compileNs(FreqFnSinc{sincScale0_Npi, 3}),   compileNs(Sinc0_Npi(3)));
+
+  // A lambda is a generator as well, it is called step by step
+  auto lambda = [](int s, double fStart, double fStop, int nSteps) { return fStart + (fStop - fStart) * s / nSteps; };
+  report("lambda", recorded([&](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 2, lambda, 50, 20); }).size() == 2 * (101 * 4 + 1), 0, 0);
+
+  size_t once = recorded([](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 1, Sinc(3), 50, 20); }).size();
+  size_t thrice = recorded([](Recorder &cm) { cm.chirp(1500, 4500, 100, 2, 3, Sinc(3), 50, 20); }).size();
+  report("Sinc x 3", thrice == 3 * once, 0, 0);
+
+  Chirpmaker cm(PIN_BUZZER);
+  edges.clear();
+  cm.chirp(1500, 4500, 300, 2, 3, Sinc0_Npi(2), 50, 20);
+  digitalWrite(PIN_BUZZER, HIGH);
+  std::vector<uint64_t> blocking = durations(edges);
+  digitalWrite(PIN_BUZZER, LOW);
+  cm.startChirp(1500, 4500, 300, 2, 3, Sinc0_Npi(2), 50, 20);
+  report("startChirp", blocking == tickDriven(cm), 0, 0);
+  return failures ? 1 : 0;
+}
+
+// Append a segment, merged with the last one if it has the same timing, as ChirpProgram::add() does
+static void appendSegment(std::vector<Segment> &v, const Segment &seg)
+{
+  if (seg.count == 0 && ! seg.isPause()) return;
+  if (! v.empty() && ! seg.isPause() && ! v.back().isPause() && v.back().tOn == seg.tOn && v.back().tOff == seg.tOff) v.back().count += seg.count;
+  else v.push_back(seg);
+}
+
+static bool sameSegments(const Segment *a, size_t n, const std::vector<Segment> &b)
+{
+  return n == b.size() && std::equal(a, a + n, b.begin(), [](const Segment &x, const Segment &y)
+         { return x.tOn == y.tOn && x.tOff == y.tOff && x.count == y.count; });
+}
+
+/**
+ * A compile time table against the same chirp compiled at runtime in
+ * double, period for period. With CHIRPMAKER_NUMERIC at double also
+ * against ChirpProgram::compileChirp() itself, piece by piece if the
+ * chirp does not fit into one program.
+ */
+template <size_t N>
+static bool sameTable(const char *name, const ConstProgram<N> &table, const ConstChirp &spec, double (*fgen)(int, double, double, int))
+{
+  std::vector<Segment> ref;
+  for (int s = 0; s <= spec.nSteps; s++)
+  {
+    uint32_t tOn, tOff;
+    chirpPeriod(fgen(s, spec.fStart, spec.fStop, spec.nSteps), spec.duty, tOn, tOff);
+    appendSegment(ref, {tOn, tOff, (uint16_t)spec.nPeriods});
+  }
+  if (spec.msPause) appendSegment(ref, {0, spec.msPause, 0});
+  bool ok = sameSegments(table.begin(), N, ref);
+
+  const char *runtime = "";
+  if (std::is_same<Real, double>::value)
+  {
+    ChirpProgram prog;
+    std::vector<Segment> compiled;
+    for (int s = 0; s <= spec.nSteps; )
+    {
+      s = prog.compileChirp(spec.fStart, spec.fStop, spec.nSteps, spec.nPeriods, 1, FreqFn{fgen}, spec.duty, spec.msPause, s);
+      for (const Segment &seg : prog) appendSegment(compiled, seg);
+    }
+    ok = ok && sameSegments(table.begin(), N, compiled);
+  }
+  else runtime = " (double reference only)";
+  printf("%-12s %3zu segments %5zu bytes %s%s\n", name, N, sizeof(table), ok ? "ok" : "MISMATCH", runtime);
+  return ok;
+}
+
+static int tables()
+{
+  using S = ConstSounds;
+  int failures = 0;
+  failures += ! sameTable("SIGNET_UP",   S::SIGNET_UP,        S::SIGNET_UP_SPEC,   cosine2PiScaleT<double>);
+  failures += ! sameTable("SIGNET_DOWN", S::SIGNET_DOWN,      S::SIGNET_DOWN_SPEC, cosine2PiScaleT<double>);
+  failures += ! sameTable("PHONE_CALL",  S::PHONE_CALL,       S::PHONE_CALL_SPEC,  sinePiScaleT<double>);
+  failures += ! sameTable("CUCKOO_CUC",  S::CUCKOO_CUC_TABLE, S::CUCKOO_CUC_SPEC,  linearScaleT<double>);
+  failures += ! sameTable("CUCKOO_KOO",  S::CUCKOO_KOO_TABLE, S::CUCKOO_KOO_SPEC,  linearScaleT<double>);
+  failures += ! sameTable("BIRD4_A",     S::BIRD4_A,          S::BIRD4_A_SPEC,     atan2PiScaleT<double>);
+  failures += ! sameTable("BIRD4_B",     S::BIRD4_B,          S::BIRD4_B_SPEC,     atanPiScaleT<double>);
+  failures += ! sameTable("BIRD4_C",     S::BIRD4_C,          S::BIRD4_C_SPEC,     sinePiScaleT<double>);
+  failures += ! sameTable("BIRD8",       S::BIRD8,            S::BIRD8_SPEC,       sine2PiScaleT<double>);
+  failures += ! sameTable("BIRD10_UP",   S::BIRD10_UP,        S::BIRD10_UP_SPEC,   atanPiScaleT<double>);
+  failures += ! sameTable("BIRD10_DOWN", S::BIRD10_DOWN,      S::BIRD10_DOWN_SPEC, atanPiScaleT<double>);
+  failures += ! sameTable("RAVEN",       S::RAVEN,            S::RAVEN_SPEC,       atanPiScaleT<double>);
+  printf("%zu bytes in all\n", S::BYTES);
+
+  // The constexpr math against the library functions
+  double worst = 0;
+  for (double x = -7; x <= 7; x += 0.001)
+  {
+    double e[] = {cxSin(x) - sin(x), cxCos(x) - cos(x), cxAtan(x) - atan(x), (cxExp(x) - exp(x)) / exp(x), x > 0 ? cxLog(x) - log(x) : 0};
+    for (double d : e) if (fabs(d) > worst) worst = fabs(d);
+  }
+  printf("constexpr math: worst deviation %.2e\n", worst);
+  if (worst > 1e-14) failures++;
+  return failures ? 1 : 0;
+}
+
+// A randomized chirp of a bird, the ranges as in Chirpmaker.cpp
+struct BirdTemplate
+{
+  long fStart0, fStart1;
+  long fStop0, fStop1;
+  long nSteps0, nSteps1;
+  long nPeriods0, nPeriods1;
+};
+
+struct Instance
+{
+  double fStart, fStop;
+  int nSteps, nPeriods;
+};
+
+/**
+ * 100k instantiations of the template t, compiled with the generator gen
+ * and with Cached<Gen>. Both programs have to be the same, unless the
+ * sines are stepped incrementally (CHIRPMAKER_INCREMENTAL), then the
+ * cached curves are the exact ones.
+ */
+template <class Gen>
+static bool instantiate(const char *name, const BirdTemplate &t, Gen gen)
+{
+  const int rounds = 100000;
+  static std::vector<Instance> instances(rounds);
+  randomSeed(7);
+  for (Instance &i : instances)
+  {
+    i = {(double)random(t.fStart0, t.fStart1), (double)random(t.fStop0, t.fStop1), (int)random(t.nSteps0, t.nSteps1), (int)random(t.nPeriods0, t.nPeriods1)};
+  }
+  static ChirpProgram plain, cached;
+  auto ns = [&](auto g, ChirpProgram &prog)  // the best of 5 runs, after a warm up
+  {
+    double best = 1e30;
+    for (int run = 0; run < 6; run++)
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      for (const Instance &i : instances) prog.compileChirp(i.fStart, i.fStop, i.nSteps, i.nPeriods, 1, g, 50, 20);
+      auto t1 = std::chrono::steady_clock::now();
+      if (run > 0) best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds);
+    }
+    return best;
+  };
+
+  double nsPlain = ns(gen, plain);
+  CurveCache::shared().clear();
+  double nsCached = ns(Cached<Gen>(gen), cached);
+  uint32_t hits = CurveCache::shared().hits() / 6, misses = CurveCache::shared().misses() / 6;
+
+  bool ok = true;
+  for (const Instance &i : instances)
+  {
+    plain.compileChirp(i.fStart, i.fStop, i.nSteps, i.nPeriods, 1, gen, 50, 20);
+    cached.compileChirp(i.fStart, i.fStop, i.nSteps, i.nPeriods, 1, Cached<Gen>(gen), 50, 20);
+    ok = ok && plain.size() == cached.size() && std::equal(plain.begin(), plain.end(), cached.begin(), [](const Segment &a, const Segment &b)
+         { return a.tOn == b.tOn && a.tOff == b.tOff && a.count == b.count; });
+  }
+  printf("%-11s %s %7.0f ns plain %7.0f ns cached %5.1fx  %6u hits %5u misses\n",
+         name, ok ? "ok      " : CHIRPMAKER_INCREMENTAL ? "differs " : "MISMATCH", nsPlain, nsCached, nsPlain / nsCached, hits, misses);
+  return ok || CHIRPMAKER_INCREMENTAL;
+}
+
+/**
+ * The randomized chirps of the birds compiled over and over, as a song
+ * does. A constant table only has to be copied, for comparison.
+ */
+static int templates()
+{
+  int failures = 0;
+  failures += ! instantiate("bird0 a",     {2000, 2050, 3200, 3400, 5, 30, 2, 15}, AtanPi());
+  failures += ! instantiate("bird0 b",     {1500, 1500, 4500, 4500, 50, 100, 1, 13}, Sine2Pi());
+  failures += ! instantiate("bird2 a",     {3500, 3900, 5600, 5900, 3, 7, 5, 10}, Sine2Pi());
+  failures += ! instantiate("bird2 b",     {5600, 5900, 3500, 3900, 6, 15, 3, 7}, Cosine2Pi());
+  failures += ! instantiate("blackbird a", {900, 900, 2000, 2000, 10, 50, 13, 13}, AtanPi());
+  failures += ! instantiate("blackbird b", {2400, 2400, 1000, 1000, 15, 65, 8, 8}, Sine2Pi());
+  failures += ! instantiate("blackbird c", {2000, 3000, 1200, 1500, 75, 120, 2, 9}, Cosine2Pi());
+  failures += ! instantiate("sinc",        {1500, 2500, 3500, 4500, 50, 100, 1, 4}, Sinc(3));
+
+  const int rounds = 100000;
+  static ChirpProgram prog;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) prog.assign(ConstSounds::BIRD8.segments, ConstSounds::BIRD8.size(), 1 + i % 3);
+  auto t1 = std::chrono::steady_clock::now();
+  printf("table       %7.0f ns to assign BIRD8\n", std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds);
+  printf("curve pool %u bytes\n", (unsigned)CHIRPMAKER_CURVE_BYTES);
+  return failures ? 1 : 0;
+}
+
+// A generator of the sketch that depends on a global
+static double userShift = 0;
+static double shiftedScale(int stepNbr, double fStart, double fStop, int nSteps)
+{
+  return linearScale(stepNbr, fStart, fStop, nSteps) + userShift;
+}
+
+/**
+ * The loop of birdConcert.cpp without its delays, with and without the
+ * program cache. The edges have to be the same, the cache only saves compiling.
+ */
+template <class Cm>
+static void sketchLoop(Cm &cm, int rounds)
+{
+  randomSeed(5);
+  for (int r = 0; r < rounds; r++)
+  {
+    cm.signet();
+    cm.phoneCall(7);
+    for (uint8_t b = 0; b < 15; b++) cm.birdVoice(b, 20);
+    cm.chirp(1800, 2400, 50, 15, 7, sincScale0_Npi, 50, 5000);
+    cm.cuckoo();
+    cm.raven();
+    cm.chaffinch();
+    cm.blackbird();
+    cm.phaser(1500, 30, 5, 95, 3, 200);
+  }
+}
+
+static int programs()
+{
+  auto edgesOf = [](bool on)
+  {
+    ProgramCache::shared().clear();
+    return recorded([&](Recorder &cm) { cm.useProgramCache(on ? &ProgramCache::shared() : nullptr); sketchLoop(cm, 2); });
+  };
+  bool ok = edgesOf(true) == edgesOf(false);
+
+  const int rounds = 50;
+  static NullChirpmaker cm(PIN_BUZZER);
+  ProgramCache &pc = ProgramCache::shared();
+  double us[2];
+  for (int on = 0; on < 2; on++)
+  {
+    pc.clear();
+    pc.resetCounters();
+    cm.useProgramCache(on ? &pc : nullptr);
+    auto t0 = std::chrono::steady_clock::now();
+    sketchLoop(cm, rounds);
+    auto t1 = std::chrono::steady_clock::now();
+    us[on] = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+  }
+  printf("output with and without cache %s\n", ok ? "ok" : "MISMATCH");
+  printf("%.1f us per loop without, %.1f us with cache\n", us[0], us[1]);
+  printf("%u hits %u misses %u rejected %u evictions, %u programs with %u segments cached\n",
+         pc.hits(), pc.misses(), pc.rejected(), pc.evictions(), pc.size(), pc.segments());
+  printf("%u bytes of segments, %zu bytes in all, shared by all Chirpmakers of a thread; %zu bytes per Chirpmaker\n",
+         (unsigned)(pc.poolSegments() * sizeof(Segment)), pc.poolSegments() * sizeof(Segment) + sizeof(ProgramCache), sizeof(Chirpmaker));
+
+  // A program compiled by one Chirpmaker is played from the cache by another
+  pc.clear();
+  pc.resetCounters();
+  std::vector<uint64_t> first = recorded([](Recorder &cm) { cm.useProgramCache(); for (int i = 0; i < 2; i++) cm.chirp(1800, 2400, 50, 15, 1, Chromatic(), 50, 20); });
+  uint32_t hits = pc.hits();
+  std::vector<uint64_t> second = recorded([](Recorder &cm) { cm.useProgramCache(); cm.chirp(1800, 2400, 50, 15, 2, Chromatic(), 50, 20); });
+  bool shared = hits == 0 && pc.hits() == 1 && first == second;
+  printf("program of one Chirpmaker played by another %s\n", shared ? "ok" : "MISMATCH");
+  ok = ok && shared;
+
+  // A lambda or a function of the sketch may depend on more than its arguments, they are compiled every time
+  double shift = 0;
+  auto moving = [&shift](int s, double fStart, double fStop, int nSteps) { return fStart + (fStop - fStart) * s / nSteps + shift; };
+  auto impure = [&](bool cached)
+  {
+    pc.clear();
+    return recorded([&](Recorder &cm)
+    {
+      cm.useProgramCache(cached ? &pc : nullptr);
+      for (shift = userShift = 0; shift < 1000; shift = userShift += 250)
+      {
+        for (int i = 0; i < 2; i++)
+        {
+          cm.chirp(1800, 2400, 50, 15, 1, moving, 50, 20);
+          cm.chirp(1800, 2400, 50, 15, 1, shiftedScale, 50, 20);
+        }
+      }
+    });
+  };
+  bool fresh = impure(true) == impure(false);
+  printf("lambdas and functions of the sketch not cached %s\n", fresh ? "ok" : "STALE");
+  ok = ok && fresh;
+
+  // The constant chirp of the sketch alone
+  static NullChirpmaker single(PIN_BUZZER);
+  for (int on = 0; on < 2; on++)
+  {
+    pc.clear();
+    single.useProgramCache(on ? &pc : nullptr);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; i++) single.chirp(1800, 2400, 50, 15, 7, sincScale0_Npi, 50, 5000);
+    auto t1 = std::chrono::steady_clock::now();
+    us[on] = std::chrono::duration<double, std::micro>(t1 - t0).count() / 1000;
+  }
+  printf("%.2f us per sinc chirp without, %.2f us with cache\n", us[0], us[1]);
+
+  // Counts <= 0 play nothing, blocking and started, from the cache and piece by piece, as in the baseline
+  auto counts = [](int n)
+  {
+    return recorded([n](Recorder &cm)
+    {
+      cm.useProgramCache();
+      for (int i = 0; i < 3; i++) cm.chirp(1800, 2400, 50, 15, n, Chromatic(), 50, 20);   // the last one from the cache
+      cm.chirp(1500, 4500, 2 * ChirpProgram::MAX_SEGMENTS, 2, n, chromaticScale, 50, 20);
+      cm.phaser(1500, 30, 5, 95, n, 200);
+      cm.phaser(1500, n, 5, 95, 1, 0);
+      uint8_t level;
+      uint32_t us;
+      cm.startChirp(1800, 2400, 50, 15, n, Chromatic(), 50, 20);
+      while (cm.pull(level, us)) cm.sink().write(level, us * RecorderSink::TICKS_PER_US);
+      cm.startPhaser(1500, 30, 5, 95, n, 200);
+      while (cm.pull(level, us)) cm.sink().write(level, us * RecorderSink::TICKS_PER_US);
+    });
+  };
+  ChirpProgram prog;
+  prog.compileChirp(1800, 2400, 0, 15, 70000, Chromatic(), 50, 20);
+  uint16_t many = prog.repeats;
+  prog.compilePhaser(1500, 30, 5, 5, -1, 200);
+  bool none = counts(0).empty() && counts(-1).empty() && counts(INT16_MIN).empty() && ! counts(1).empty() && many == UINT16_MAX && prog.repeats == 0;
+  printf("counts <= 0 play nothing, more than %u play %u times %s\n", UINT16_MAX, UINT16_MAX, none ? "ok" : "WRAPPED");
+  return ok && none ? 0 : 1;
+}
+
+/**
+ * Every bird of the registry found by its name, unknown names not found,
+ * and its typical song length within 25 % of the mean of 200 songs
+ */
+static int birdRegistry()
+{
+  BirdTable<NullChirpmaker::Bird> birds = NullChirpmaker::birds();
+  int failures = 0;
+  randomSeed(3);
+  for (uint16_t b = 0; b < birds.size(); b++)
+  {
+    NullChirpmaker cm(PIN_BUZZER);
+    const int songs = 200;
+    for (int i = 0; i < songs; i++) cm.birdVoice(birds[b].name, 0);
+    double ms = cm.sink().ticks() / (1000.0 * NullSink::TICKS_PER_US * songs);
+    bool found = birds.indexOf(birds[b].name) == b && fabs(ms - birds[b].msTypical) < 0.25 * birds[b].msTypical;
+    printf("%2u %-10s %s weight %u typical %5u ms measured %7.1f ms\n",
+           b, birds[b].name, found ? "ok      " : "MISMATCH", birds[b].weight, birds[b].msTypical, ms);
+    if (! found) failures++;
+  }
+  const char *unknown[] = {"", "bird", "bird11", "Cuckoo", "blackbirds"};
+  for (const char *name : unknown) if (birds.indexOf(name) >= 0) failures++;
+  printf("unknown names %s\n", failures ? "MISMATCH" : "ok");
+
+  const int rounds = 1000000;
+  int sum = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) sum += birds.indexOf(birds[i % birds.size()].name);
+  auto t1 = std::chrono::steady_clock::now();
+  printf("%.1f ns per lookup by name (%d)\n", std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds, sum & 1);
+  return failures ? 1 : 0;
+}
+
+// Order independent stand-ins for random(), the same values whatever the order of the draws
+static long lowRandom(long howbig) { return howbig / 7; }
+static long highRandom(long howbig) { return howbig - 1; }
+
+/**
+ * Each bird as bytecode against its member function: same edges blocking
+ * and non-blocking. The C++ birds draw their random parameters in the
+ * order the compiler evaluates the arguments, the songs from left to
+ * right, so random() is replaced by functions of the range only.
+ */
+static int songs()
+{
+  int failures = 0;
+  size_t total = 0;
+  for (uint16_t b = 0; b < sizeof(BIRD_SONGS) / sizeof(BIRD_SONGS[0]); b++)
+  {
+    const BirdSong &song = BIRD_SONGS[b];
+    uint8_t depth = 0;
+    bool ok = songCheck(song.code, song.bytes, &depth) == song.bytes;
+    for (HostRandomHook hook : {lowRandom, highRandom})
+    {
+      hostSetRandomHook(hook);
+      ok = ok && recorded([&](Recorder &cm) { cm.birdVoice(b, 20); })
+              == recorded([&](Recorder &cm) { ok = cm.sing(song.code) && ok; cm.sink().pause(20); });
+      Chirpmaker cm(PIN_BUZZER);
+      cm.startBird(b, 20);
+      std::vector<uint64_t> bird = tickDriven(cm);
+      cm.startSong(song.code, 20);
+      ok = ok && bird == tickDriven(cm);
+    }
+    hostSetRandomHook(nullptr);
+
+    const int rounds = 2000;
+    double ns[2];
+    for (int s = 0; s < 2; s++)
+    {
+      static NullChirpmaker cm(PIN_BUZZER);
+      randomSeed(11);
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < rounds; i++) s ? (void)cm.sing(song.code) : cm.birdVoice(b, 0);
+      auto t1 = std::chrono::steady_clock::now();
+      ns[s] = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+    }
+    printf("%-10s %s %3u bytes stack %u %8.0f ns C++ %8.0f ns bytecode\n",
+           NullChirpmaker::birds()[b].name, ok ? "ok      " : "MISMATCH", song.bytes, depth, ns[0], ns[1]);
+    total += song.bytes;
+    if (! ok) failures++;
+  }
+  printf("%zu bytes for all birds\n", total);
+
+  const uint8_t broken[][4] = {{S_PUSH8(1), S_PUSH8(2)}, {S_PAUSE, S_END}, {S_LOOP, S_END}, {S_PUSH8(1), S_REPEAT, S_END}, {S_TABLE(99), S_END}};
+  for (const uint8_t *code : broken) if (songCheck(code, 4) >= 0) failures++;
+  printf("invalid songs %s\n", failures ? "MISMATCH" : "rejected");
+  return failures ? 1 : 0;
+}
+
+/**
+ * A song bank of the birds of Chirpmaker, each copies times. The copies
+ * share the bytecode, from the second one on they are called name#copy.
+ */
+static std::vector<uint8_t> buildBank(uint32_t copies)
+{
+  BirdTable<Chirpmaker::Bird> registry = Chirpmaker::birds();
+  const uint32_t nSongs = sizeof(BIRD_SONGS) / sizeof(BIRD_SONGS[0]);
+  std::vector<uint8_t> code;
+  std::vector<uint32_t> codeOffset;
+  for (const BirdSong &song : BIRD_SONGS)
+  {
+    codeOffset.push_back(code.size());
+    code.insert(code.end(), song.code, song.code + song.bytes);
+  }
+  std::vector<Segment> segments;
+  std::vector<SongRange> tables;
+  for (const SongTable &t : SONG_TABLES)
+  {
+    tables.push_back({(uint32_t)segments.size(), t.nSegments});
+    segments.insert(segments.end(), t.segments, t.segments + t.nSegments);
+  }
+
+  std::vector<SongBankBird> birds;
+  std::vector<char> names;
+  for (uint32_t c = 0; c < copies; c++)
+  {
+    for (uint32_t b = 0; b < nSongs; b++)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), c ? "%s#%u" : "%s", registry[b].name, c);
+      birds.push_back({(uint32_t)names.size(), codeOffset[b], BIRD_SONGS[b].bytes, registry[b].msTypical, registry[b].weight, {}});
+      names.insert(names.end(), name, name + strlen(name) + 1);
+    }
+  }
+  uint32_t nSlots = 1;
+  while (nSlots < 2 * birds.size()) nSlots *= 2;
+  std::vector<uint32_t> slots(nSlots);
+  for (uint32_t b = 0; b < birds.size(); b++)
+  {
+    uint32_t s = birdHash(&names[birds[b].name]) & (nSlots - 1);
+    while (slots[s]) s = (s + 1) & (nSlots - 1);
+    slots[s] = b + 1;
+  }
+
+  SongBankHeader h = {};
+  auto align = [](uint32_t n) { return (n + 3) & ~3u; };
+  h.magic = SONG_BANK_MAGIC;
+  h.version = SONG_BANK_VERSION;
+  h.headerBytes = sizeof(h);
+  h.nBirds = birds.size();
+  h.nSlots = nSlots;
+  h.nTables = tables.size();
+  h.nSegments = segments.size();
+  h.codeBytes = code.size();
+  h.nameBytes = names.size();
+  h.birdsOffset = sizeof(h);
+  h.slotsOffset = h.birdsOffset + h.nBirds * sizeof(SongBankBird);
+  h.tablesOffset = h.slotsOffset + h.nSlots * sizeof(uint32_t);
+  h.segmentsOffset = h.tablesOffset + h.nTables * sizeof(SongRange);
+  h.codeOffset = h.segmentsOffset + h.nSegments * sizeof(Segment);
+  h.namesOffset = align(h.codeOffset + h.codeBytes);
+  h.totalBytes = align(h.namesOffset + h.nameBytes);
+
+  std::vector<uint8_t> bank(h.totalBytes);
+  memcpy(&bank[0], &h, sizeof(h));
+  memcpy(&bank[h.birdsOffset], birds.data(), birds.size() * sizeof(SongBankBird));
+  memcpy(&bank[h.slotsOffset], slots.data(), slots.size() * sizeof(uint32_t));
+  memcpy(&bank[h.tablesOffset], tables.data(), tables.size() * sizeof(SongRange));
+  memcpy(&bank[h.segmentsOffset], segments.data(), segments.size() * sizeof(Segment));
+  memcpy(&bank[h.codeOffset], code.data(), code.size());
+  memcpy(&bank[h.namesOffset], names.data(), names.size());
+  return bank;
+}
+
+static bool writeBank(const char *path, uint32_t copies)
+{
+  std::vector<uint8_t> bank = buildBank(copies);
+  FILE *f = fopen(path, "wb");
+  if (! f) return false;
+  bool ok = fwrite(bank.data(), 1, bank.size(), f) == bank.size();
+  return fclose(f) == 0 && ok;
+}
+
+static int bank(int argc, char *argv[])
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "usage: chirptool bank FILE [copies]\n");
+    return 2;
+  }
+  uint32_t copies = argc > 3 ? atoi(argv[3]) : 1;
+  if (copies < 1 || ! writeBank(argv[2], copies)) return 1;
+  SongBank sb;
+  bool ok = sb.map(argv[2]) && sb.check();
+  printf("%s: %u birds, %zu bytes %s\n", argv[2], sb.size(), sb.bytes(), ok ? "ok" : "INVALID");
+  return ok ? 0 : 1;
+}
+
+/**
+ * Banks of 1 to 667 copies of the birds: the time to map and open a bank
+ * and to find and play its last bird, against reading the whole file.
+ * The songs of the bank have to play the same edges as BirdSongs.h.
+ */
+static int banks()
+{
+  int failures = 0;
+  for (uint32_t copies : {1u, 10u, 100u, 667u})
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chirptool_bank_%u.bin", copies);
+    if (! writeBank(path, copies)) return 1;
+
+    const int rounds = 200;
+    std::vector<double> openUs, readUs;
+    for (int i = 0; i < rounds; i++)
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      {
+        SongBank sb;
+        if (! sb.map(path)) failures++;
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      FILE *f = fopen(path, "rb");
+      std::vector<uint8_t> copy;
+      fseek(f, 0, SEEK_END);
+      copy.resize(ftell(f));
+      fseek(f, 0, SEEK_SET);
+      if (fread(copy.data(), 1, copy.size(), f) != copy.size()) failures++;
+      fclose(f);
+      auto t2 = std::chrono::steady_clock::now();
+      openUs.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+      readUs.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+    }
+    std::sort(openUs.begin(), openUs.end());
+    std::sort(readUs.begin(), readUs.end());
+
+    static NullChirpmaker cm(PIN_BUZZER);
+    SongBank sb;
+    bool ok = sb.map(path);
+    auto t0 = std::chrono::steady_clock::now();
+    int32_t last = sb.indexOf(copies > 1 ? "blackbird#1" : "blackbird");
+    ok = ok && last >= 0 && cm.sing(sb.song(last), sb.tables());
+    auto t1 = std::chrono::steady_clock::now();
+    ok = ok && sb.check();
+    auto t2 = std::chrono::steady_clock::now();
+
+    hostSetRandomHook(lowRandom);
+    for (uint32_t b = 0; ok && b < sizeof(BIRD_SONGS) / sizeof(BIRD_SONGS[0]); b++)
+    {
+      uint32_t bird = sb.size() - sizeof(BIRD_SONGS) / sizeof(BIRD_SONGS[0]) + b;
+      ok = recorded([&](Recorder &r) { r.sing(BIRD_SONGS[b].code); })
+        == recorded([&](Recorder &r) { r.sing(sb.song(bird), sb.tables()); });
+    }
+    hostSetRandomHook(nullptr);
+
+    printf("%5u birds %7zu bytes %s open %5.1f us (read %7.1f us)  first song %6.1f us  check %8.1f us\n",
+           sb.size(), sb.bytes(), ok ? "ok      " : "MISMATCH", openUs[rounds / 2], readUs[rounds / 2],
+           std::chrono::duration<double, std::micro>(t1 - t0).count(), std::chrono::duration<double, std::micro>(t2 - t1).count());
+    if (! ok) failures++;
+    sb.unmap();
+    remove(path);
+  }
+  return failures ? 1 : 0;
+}
+
+static std::vector<PinEdge> pinEdges[40];
+
+static void recordPinEdge(uint8_t pin, uint8_t level, uint64_t cycle)
+{
+  if (pin < 40) pinEdges[pin].push_back({cycle, level});
+}
+
+/**
+ * Durations between the level changes of a recording in timer ticks, as
+ * they appear on a pin that starts LOW
+ */
+static std::vector<uint64_t> tickDurations(const RecorderSink &rec)
+{
+  std::vector<uint64_t> d;
+  int level = LOW;
+  uint64_t ticks = 0;
+  bool started = false;
+  for (size_t i = 0; i < rec.count(); i++)
+  {
+    if (rec[i].ticks == 0) continue;
+    if (rec[i].level != level)
+    {
+      if (started) d.push_back(ticks);
+      started = true;
+      ticks = 0;
+    }
+    level = rec[i].level;
+    ticks += rec[i].ticks;
+  }
+  return d;
+}
+
+/**
+ * 1, 4 and 16 birds sung at once by a PolyPlayer, one pin each. The edges
+ * of every pin have to lie within a tick of the same bird played alone.
+ */
+static int poly()
+{
+  static Edge recording[100000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> ref(PIN_BUZZER);
+  static NullChirpmaker *cms[PolyPlayer::MAX_VOICES];
+  static PolyPlayer poly;
+  const uint8_t firstPin = 12;
+  int failures = 0;
+
+  ref.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  for (uint8_t n : {1, 4, 16})
+  {
+    std::vector<uint64_t> alone[PolyPlayer::MAX_VOICES];
+    for (uint8_t v = 0; v < n; v++)
+    {
+      ref.sink().clear();
+      randomSeed(100 + v);
+      ref.birdVoice(v % 15, 20);
+      alone[v] = tickDurations(ref.sink());
+      pinEdges[firstPin + v].clear();
+    }
+
+    hostSetEdgeHook(recordPinEdge);
+    poly.begin(1);
+    for (uint8_t v = 0; v < n; v++)
+    {
+      if (! cms[v]) cms[v] = new NullChirpmaker(PIN_BUZZER);
+      poly.addVoice(firstPin + v);
+      randomSeed(100 + v);
+      cms[v]->startBird(v % 15, 20);
+    }
+    uint64_t start = hostNow();
+    auto t0 = std::chrono::steady_clock::now();
+    for (bool more = true; more || ! poly.isIdle(); delayMicroseconds(500))
+    {
+      more = false;
+      for (uint8_t v = 0; v < n; v++) more = poly.feed(v, *cms[v]) || more;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t cycles = hostNow() - start;
+    poly.end();
+    hostSetEdgeHook(recordEdge);
+
+    bool ok = true;
+    uint64_t worst = 0;
+    for (uint8_t v = 0; v < n; v++)
+    {
+      const std::vector<PinEdge> &e = pinEdges[firstPin + v];
+      if (e.size() != alone[v].size() + 1) { ok = false; continue; }
+      for (size_t i = 1; i < e.size(); i++)
+      {
+        uint64_t ticks = (e[i].cycle - e[i-1].cycle) / PolyPlayer::DIVIDER;
+        uint64_t dev = ticks > alone[v][i-1] ? ticks - alone[v][i-1] : alone[v][i-1] - ticks;
+        if (dev > worst) worst = dev;
+      }
+    }
+    ok = ok && worst <= 1;
+    double sec = std::chrono::duration<double>(t1 - t0).count();
+    printf("%2u voices: %7u edges %7u interrupts (%.2f edges each), worst deviation %llu ticks, %5.0f ms sound in %6.1f ms host %s\n",
+           n, poly.edges(), poly.interrupts(), (double)poly.edges() / poly.interrupts(), (unsigned long long)worst,
+           cycles * 1e3 / HOST_APB_HZ, sec * 1e3, ok ? "ok" : "MISMATCH");
+    if (! ok) failures++;
+  }
+  return failures ? 1 : 0;
+}
+
+// A voice that sings at once and is never busy, to look at the timeline only
+struct TimelineVoice
+{
+  static auto birds() { return BasicChirpmaker<NullSink, VirtualClock>::birds(); }
+  bool isBusy() const { return false; }
+  void startBird(uint16_t bird, uint32_t msPause) { (void)bird; (void)msPause; }
+  bool pull(uint8_t &level, uint32_t &us) { (void)level; (void)us; return false; }
+};
+
+/**
+ * The timeline of a long concert has to meet density, overlap and rates.
+ * Then 30 birds are sung on 4 buzzers and rendered as PCM: the same birds,
+ * so the time the mix is HIGH has to match the HIGH time of the pins.
+ */
+static int concert()
+{
+  int failures = 0;
+
+  static const uint8_t rates[15] = {1, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0};
+  static TimelineVoice listeners[4];
+  static TimelineVoice *lv[4] = {&listeners[0], &listeners[1], &listeners[2], &listeners[3]};
+  Concert<TimelineVoice>::Plan tplan;
+  tplan.birdsPerMinute = 15;
+  tplan.maxOverlap = 3;
+  tplan.rates = rates;
+  static Concert<TimelineVoice> timeline;
+  timeline.begin(lv, 4, tplan);
+  std::vector<Concert<TimelineVoice>::Event> events;
+  uint32_t nowMs = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  while (events.size() < 6000)
+  {
+    uint32_t before = timeline.planned();
+    timeline.plan(nowMs);
+    for (uint8_t i = timeline.pending() - (timeline.planned() - before); i < timeline.pending(); i++) events.push_back(timeline.pendingEvent(i));
+    nowMs += 1000;
+    timeline.dispatch(nowMs);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  uint32_t count[15] = {};
+  uint8_t overlap = 0;
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    count[events[i].bird]++;
+    uint8_t n = 1;
+    for (size_t j = i; j-- > 0 && i - j < 200; ) n += events[j].atMs + TimelineVoice::birds()[events[j].bird].msTypical > events[i].atMs;
+    if (n > overlap) overlap = n;
+  }
+  double perMinute = events.size() * 60000.0 / events.back().atMs;
+  bool ok = fabs(perMinute / tplan.birdsPerMinute - 1) < 0.1 && overlap <= tplan.maxOverlap;
+  for (int b = 0; b < 15; b++) ok = ok && fabs(count[b] / (double)events.size() - rates[b] / 7.0) < 0.02;
+  printf("timeline: %zu birds in %.0f min, %.1f per minute (asked %u), overlap %u (at most %u), cuckoo:raven:bird0 %.2f:%.2f:1, %.2f us per bird %s\n",
+         events.size(), events.back().atMs / 60000.0, perMinute, tplan.birdsPerMinute, overlap, tplan.maxOverlap,
+         (double)count[11] / count[0], (double)count[4] / count[0],
+         std::chrono::duration<double, std::micro>(t1 - t0).count() / events.size(), ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  // 30 birds on 4 buzzers
+  static NullChirpmaker *cms[4];
+  for (auto &cm : cms) if (! cm) cm = new NullChirpmaker(PIN_BUZZER);
+  Concert<NullChirpmaker>::Plan plan;
+  plan.birdsPerMinute = 40;
+  plan.maxOverlap = 3;
+  plan.nBirds = 30;
+  static Concert<NullChirpmaker> live;
+  static PolyPlayer poly;
+  const uint8_t firstPin = 12;
+  poly.begin(1);
+  for (uint8_t v = 0; v < 4; v++)
+  {
+    poly.addVoice(firstPin + v);
+    pinEdges[firstPin + v].clear();
+  }
+  hostSetEdgeHook(recordPinEdge);
+  randomSeed(7);
+  uint32_t startMs = millis();
+  live.begin(cms, 4, plan, startMs);
+  auto t2 = std::chrono::steady_clock::now();
+  while (! live.isOver())
+  {
+    live.play(poly, millis());
+    delayMicroseconds(1000);
+  }
+  poly.flush();
+  auto t3 = std::chrono::steady_clock::now();
+  uint32_t msConcert = millis() - startMs;
+  poly.end();
+  hostSetEdgeHook(recordEdge);
+
+  uint64_t pinHigh = 0;
+  uint8_t sounding = 0;
+  std::vector<std::pair<uint64_t, int>> changes;
+  for (uint8_t v = 0; v < 4; v++)
+  {
+    const std::vector<PinEdge> &e = pinEdges[firstPin + v];
+    for (size_t i = 1; i < e.size(); i++) if (e[i-1].level == HIGH) pinHigh += e[i].cycle - e[i-1].cycle;
+    // a pin sounds from its first edge to a LOW of more than 10 ms
+    for (size_t i = 0; i < e.size(); i++)
+    {
+      if (i == 0 || (e[i].level == HIGH && e[i].cycle - e[i-1].cycle > HOST_APB_HZ / 100)) changes.push_back({e[i].cycle, 1});
+      if (e[i].level == LOW && (i + 1 == e.size() || e[i+1].cycle - e[i].cycle > HOST_APB_HZ / 100)) changes.push_back({e[i].cycle, -1});
+    }
+  }
+  std::sort(changes.begin(), changes.end());
+  int active = 0;
+  for (auto &c : changes) { active += c.second; if (active > sounding) sounding = active; }
+  printf("buzzers:  %u birds in %5.1f s on 4 pins, at most %u at once, %u moved, latest start %u ms late, %5.1f ms host\n",
+         live.started(), msConcert / 1000.0, sounding, live.moved(), live.msLateMax(), std::chrono::duration<double, std::milli>(t3 - t2).count());
+
+  // The same concert mixed into PCM
+  const uint32_t rate = 44100;
+  static int16_t block[1024];
+  uint64_t samples = 0, mixHigh = 0;
+  static Concert<NullChirpmaker> mix;
+  randomSeed(7);
+  mix.begin(cms, 4, plan);
+  auto t4 = std::chrono::steady_clock::now();
+  while (! mix.isOver())
+  {
+    mix.render(block, 1024, rate, 8000);
+    for (int16_t s : block) mixHigh += s / 8000;
+    samples += 1024;
+  }
+  auto t5 = std::chrono::steady_clock::now();
+  double pinSec = pinHigh / (double)HOST_APB_HZ, mixSec = mixHigh / (double)rate;
+  ok = live.started() == plan.nBirds && mix.started() == plan.nBirds && fabs(mixSec / pinSec - 1) < 0.001;
+  printf("pcm mix:  %u birds in %5.1f s at %u Hz, HIGH %.3f s (pins %.3f s), %.0fx real time %s\n",
+         mix.started(), samples / (double)rate, rate, mixSec, pinSec,
+         samples / (double)rate / std::chrono::duration<double>(t5 - t4).count(), ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+  return failures ? 1 : 0;
+}
+
+/**
+ * The audio worker runs in a thread of its own and owns the virtual clock
+ * while it runs; this thread only posts commands and waits for them.
+ */
+/**
+ * A voice of the worker test that records the pause of each bird it is
+ * asked to start, and holds the worker there while hold is set
+ */
+struct ProbeVoice
+{
+  static inline std::vector<uint32_t> started;
+  static inline std::atomic<bool> hold{false};
+  static inline std::atomic<bool> held{false};
+
+  static auto birds() { return BasicChirpmaker<NullSink, VirtualClock>::birds(); }
+  bool isBusy() const { return false; }
+  bool startBird(uint16_t bird, uint32_t msPause)
+  {
+    (void)bird;
+    started.push_back(msPause);
+    held = true;
+    while (hold) std::this_thread::yield();
+    return true;
+  }
+  bool startSong(const uint8_t *song, uint32_t msPause) { (void)song; (void)msPause; return true; }
+  void stop() {}
+  bool pull(uint8_t &level, uint32_t &us) { (void)level; (void)us; return false; }
+};
+
+static int worker()
+{
+  static NullChirpmaker *cms[2];
+  for (auto &cm : cms) if (! cm) cm = new NullChirpmaker(PIN_BUZZER);
+  static const uint8_t pins[2] = {12, 13};
+  static AudioWorker<NullChirpmaker> audio;
+  static Edge recording[100000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> ref(PIN_BUZZER);
+  ref.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  auto waitDone = [] { while (audio.executed() < audio.posted() || audio.isBusy()) std::this_thread::yield(); };
+  int failures = 0;
+
+  // A bird and a chirp, against the same sounds played directly
+  randomSeed(21);
+  ref.birdVoice((uint16_t)0, 20);
+  std::vector<uint64_t> bird = tickDurations(ref.sink());
+  ref.sink().clear();
+  ref.chirp(1000, 3000, 20, 5, 3, Chromatic(), 50, 100);
+  std::vector<uint64_t> chirp = tickDurations(ref.sink());
+
+  for (uint8_t pin : pins) pinEdges[pin].clear();
+  hostSetEdgeHook(recordPinEdge);
+  randomSeed(21);
+  audio.begin(cms, pins, 2, 1);
+  auto t0 = std::chrono::steady_clock::now();
+  audio.bird(0, 0, 20);
+  audio.chirp(1, 1000, 3000, 20, 5, 3, GEN_CHROMATIC, 50, 100);
+  auto t1 = std::chrono::steady_clock::now();
+  waitDone();
+  audio.end();
+  hostSetEdgeHook(recordEdge);
+  auto pinTicks = [](uint8_t pin)
+  {
+    std::vector<uint64_t> d;
+    for (size_t i = 1; i < pinEdges[pin].size(); i++) d.push_back((pinEdges[pin][i].cycle - pinEdges[pin][i-1].cycle) / PolyPlayer::DIVIDER);
+    return d;
+  };
+  bool ok = pinTicks(pins[0]) == bird && pinTicks(pins[1]) == chirp;
+  printf("bird and chirp: %zu and %zu edges, 2 posts in %.2f us %s\n", bird.size(), chirp.size(),
+         std::chrono::duration<double, std::micro>(t1 - t0).count(), ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  // A burst of commands, more than the queue holds, numbered by their pause. The worker is
+  // held in the first one first: the queue fills up, and every further post is dropped.
+  static ProbeVoice probes[2];
+  static ProbeVoice *const probed[2] = {&probes[0], &probes[1]};
+  static AudioWorker<ProbeVoice> burst;
+  const int n = 100000;
+  std::vector<uint32_t> queued;
+  queued.reserve(n + 64);
+  uint32_t seq = 0;
+  ProbeVoice::started.clear();
+  ProbeVoice::hold = true;
+  ProbeVoice::held = false;
+  burst.begin(probed, pins, 2, 1);
+  if (burst.bird(0, 0, seq)) queued.push_back(seq);
+  seq++;
+  while (! ProbeVoice::held) std::this_thread::yield();
+  bool full = true;
+  for (int i = 0; i < 2 * burst.QUEUE_SIZE; i++, seq++)
+  {
+    if (burst.bird(0, 0, seq)) queued.push_back(seq);
+    else full = full && burst.depth() == burst.QUEUE_SIZE - 1;
+  }
+  full = full && queued.size() == burst.QUEUE_SIZE && burst.dropped() == burst.QUEUE_SIZE + 1u;
+  ProbeVoice::hold = false;
+  auto t2 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++, seq++) if (burst.bird(0, 0, seq)) queued.push_back(seq);
+  auto t3 = std::chrono::steady_clock::now();
+  for (size_t more = queued.size() + 10000; queued.size() < more; seq++)  // and posts the worker keeps up with, yielding when it falls behind
+  {
+    if (burst.bird(0, 0, seq)) queued.push_back(seq);
+    else std::this_thread::yield();
+  }
+  while (burst.executed() < burst.posted()) std::this_thread::yield();
+  burst.end();
+  bool fifo = ProbeVoice::started == queued;
+  ok = full && fifo && burst.posted() == queued.size() && burst.posted() + burst.dropped() == seq && burst.maxDepth() <= burst.QUEUE_SIZE - 1;
+  printf("burst: %u posts, %u queued, %u dropped, deepest queue %u, %.1f ns per post in a burst of %d %s\n", seq, burst.posted(), burst.dropped(),
+         burst.maxDepth(), std::chrono::duration<double, std::nano>(t3 - t2).count() / n, n, ok ? "ok" : "MISMATCH");
+  printf("       drops with a full queue only %s, all queued executed in order %s\n", full ? "ok" : "MISMATCH", fifo ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  // A concert, stopped after a while
+  static AudioWorker<NullChirpmaker> live;
+  live.begin(cms, pins, 2, 1);
+  live.concert(40, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  live.stop();
+  while (live.executed() < live.posted() || live.isBusy()) std::this_thread::yield();
+  live.end();
+  ok = live.concertState().started() > 0 && ! cms[0]->isBusy() && ! cms[1]->isBusy();
+  printf("concert: %u birds until stopped %s\n", live.concertState().started(), ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+  return failures ? 1 : 0;
+}
+
+static std::vector<std::string> logLines;
+
+static void collectLine(const char *line) { logLines.push_back(line); }
+
+static int sideEffects = 0;
+
+static int sideEffect() { return ++sideEffects; }
+
+/**
+ * A log site has to cost a few ns, flush() has to write what was recorded,
+ * count what was overwritten and never write a torn event.
+ */
+static int logTest()
+{
+  if (CHIRPMAKER_LOG_LEVEL < CHIRP_LOG_INFO)
+  {
+    printf("CHIRPMAKER_LOG_LEVEL %d strips the log sites of this test\n", CHIRPMAKER_LOG_LEVEL);
+    return 0;
+  }
+  int failures = 0;
+  ChirpLog &log = chirpLog();
+  log.setWriter(collectLine);
+  log.flush();
+
+  // What is recorded comes out formatted, the debug site is not compiled
+  logLines.clear();
+  for (int b = 0; b < 3; b++) CHIRP_LOG_I("Bird %2d is singing", b);
+  CHIRP_LOG_W("%d of %d edges dropped", 5, 100);
+  CHIRP_LOG_D("never %d", sideEffect());
+  log.flush();
+  static const char *expected[] = {"I Bird  0 is singing", "I Bird  1 is singing", "I Bird  2 is singing", "W 5 of 100 edges dropped"};
+  bool debug = CHIRPMAKER_LOG_LEVEL >= CHIRP_LOG_DEBUG;
+  bool ok = logLines.size() == 4u + debug && sideEffects == debug;
+  for (size_t i = 0; ok && i < 4; i++) ok = logLines[i].substr(logLines[i].find(']') + 2) == expected[i];
+  printf("format: %zu lines, debug site %s %s\n", logLines.size(), sideEffects ? "compiled" : "stripped", ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  // A full ring loses the oldest events
+  logLines.clear();
+  uint32_t lost = log.lost();
+  for (int i = 0; i < ChirpLog::EVENTS + 44; i++) CHIRP_LOG_I("event %d", i);
+  log.flush();
+  ok = logLines.size() == ChirpLog::EVENTS && log.lost() - lost == 44 && logLines[0].find("event 44") != std::string::npos;
+  printf("overflow: %u events into %u, %zu written, %u lost %s\n", ChirpLog::EVENTS + 44, ChirpLog::EVENTS, logLines.size(), log.lost() - lost, ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  // Cost of a site against formatting the line right away
+  const int n = 1000000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) CHIRP_LOG_I("Bird %2d is singing, %d edges", i & 15, i);
+  auto t1 = std::chrono::steady_clock::now();
+  char line[128];
+  int chars = 0;
+  for (int i = 0; i < n; i++) chars += snprintf(line, sizeof(line), "[%5u.%06u] I Bird %2d is singing, %d edges", i / 1000000, i % 1000000, i & 15, i);
+  auto t2 = std::chrono::steady_clock::now();
+  printf("cost: log site %.1f ns, formatted line %.1f ns (%d chars), a line at 115200 baud %.0f us\n",
+         std::chrono::duration<double, std::nano>(t1 - t0).count() / n, std::chrono::duration<double, std::nano>(t2 - t1).count() / n,
+         chars / n, (chars / n + 2) * 10 * 1e6 / 115200);
+  log.flush();
+
+  // Two tasks log while a third flushes
+  logLines.clear();
+  uint32_t before = log.recorded(), lostBefore = log.lost();
+  const int perThread = 200000;
+  std::atomic<int> running{2};
+  auto producer = [&](int id)
+  {
+    for (int i = 0; i < perThread; i++)
+    {
+      CHIRP_LOG_I("%d %d %d", id, i, ~i);
+      if (i % 32 == 0) std::this_thread::yield();
+    }
+    running--;
+  };
+  std::thread a(producer, 1), b(producer, 2);
+  while (running > 0) log.flush(64);
+  a.join();
+  b.join();
+  log.flush();
+  bool torn = false;
+  for (const std::string &l : logLines)
+  {
+    int id, i, j;
+    if (sscanf(l.c_str() + l.find(']') + 4, "%d %d %d", &id, &i, &j) != 3 || j != ~i || (id != 1 && id != 2)) torn = true;
+  }
+  ok = ! torn && log.recorded() - before == 2 * perThread && logLines.size() + (log.lost() - lostBefore) == 2 * perThread;
+  printf("threads: %d events, %zu written, %u lost, torn: %s %s\n", 2 * perThread, logLines.size(), log.lost() - lostBefore, torn ? "yes" : "no", ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+  log.setWriter(nullptr);
+  return failures ? 1 : 0;
+}
+
+/**
+ * Play a bird, chirp or phaser given on the command line, argv[a] being its
+ * first argument. Returns 0 or 2 for bad arguments.
+ */
+template <class Cm>
+static int playSound(Cm &cm, const char *kind, int argc, char *argv[], int a)
+{
+  auto arg = [&](int i) { return a + i < argc ? atoi(argv[a + i]) : 0; };
+  if (strcmp(kind, "bird") == 0 && a < argc)
+  {
+    if (isdigit((unsigned char)argv[a][0])) cm.birdVoice((uint16_t)arg(0), 20);
+    else if (cm.birds().indexOf(argv[a]) >= 0) cm.birdVoice(argv[a], 20);
+    else return fprintf(stderr, "no bird %s\n", argv[a]), 2;
+  }
+  else if (strcmp(kind, "chirp") == 0 && argc - a >= 7) cm.chirp(arg(0), arg(1), arg(2), arg(3), arg(4), Chromatic(), arg(5), arg(6));
+  else if (strcmp(kind, "phaser") == 0 && argc - a >= 6) cm.phaser(arg(0), arg(1), arg(2), arg(3), arg(4), arg(5));
+  else return fprintf(stderr, "unknown sound %s\n", kind), 2;
+  cm.sink().flush();
+  return 0;
+}
+
+/**
+ * Render one sound into a WAV file. The samples go to the file in blocks
+ * of PcmSink::BLOCK_SIZE, whatever the length of the sound. With blep the
+ * bird, chirp or phaser is rendered band-limited by a BlepSink.
+ */
+static int wav(int argc, char *argv[])
+{
+  if (argc < 4) return fprintf(stderr, "usage: chirptool wav FILE|- [RATE] [blep] bird|chirp|phaser|concert ARGS\n"), 2;
+  const char *path = argv[2];
+  int a = 3;
+  uint32_t rate = isdigit((unsigned char)argv[a][0]) ? atoi(argv[a++]) : 44100;
+  bool blep = a < argc && strcmp(argv[a], "blep") == 0;
+  if (blep) a++;
+  const char *kind = a < argc ? argv[a++] : "";
+
+  WavWriter out;
+  if (! (strcmp(path, "-") == 0 ? out.open(stdout, rate) : out.open(path, rate))) return fprintf(stderr, "cannot write %s\n", path), 1;
+  int rc = 0;
+  if (strcmp(kind, "concert") == 0)
+  {
+    static NullChirpmaker *voices[4];
+    for (auto &v : voices) if (! v) v = new NullChirpmaker(PIN_BUZZER);
+    static Concert<NullChirpmaker> concert;
+    Concert<NullChirpmaker>::Plan plan;
+    plan.birdsPerMinute = 40;
+    plan.maxOverlap = 3;
+    plan.nBirds = a < argc ? atoi(argv[a]) : 20;
+    concert.begin(voices, 4, plan);
+    int16_t block[PcmSink::BLOCK_SIZE];
+    while (! concert.isOver())
+    {
+      concert.render(block, PcmSink::BLOCK_SIZE, rate);
+      out.write(block, PcmSink::BLOCK_SIZE);
+    }
+  }
+  else if (blep)
+  {
+    static BlepChirpmaker cm(PIN_BUZZER);
+    cm.sink().setOutput(rate, WavWriter::block, &out);
+    rc = playSound(cm, kind, argc, argv, a);
+  }
+  else
+  {
+    static PcmChirpmaker cm(PIN_BUZZER);
+    cm.sink().setOutput(rate, WavWriter::block, &out);
+    rc = playSound(cm, kind, argc, argv, a);
+  }
+  if (! out.close()) rc = 1;
+  fprintf(stderr, "%s: %llu samples, %.2f s at %u Hz\n", path, (unsigned long long)out.samples(), out.samples() / (double)rate, rate);
+  return rc;
+}
+
+/**
+ * Every bird into a WAV file at 44.1 kHz. The samples have to be what the
+ * recorded edges give, and the whole set has to render at least 500 times
+ * faster than real time.
+ */
+static int render()
+{
+  const uint32_t rate = 44100;
+  static Edge recording[100000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(PIN_BUZZER);
+  rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  static PcmChirpmaker cm(PIN_BUZZER);
+  const char *path = "/tmp/chirptool_render.wav";
+  int failures = 0;
+  double audioSec = 0, hostSec = 0;
+
+  for (uint16_t b = 0; b < cm.birds().size(); b++)
+  {
+    WavWriter out;
+    if (! out.open(path, rate)) return 1;
+    cm.sink().setOutput(rate, WavWriter::block, &out);
+    randomSeed(b + 1);
+    auto t0 = std::chrono::steady_clock::now();
+    cm.birdVoice(b, 20);
+    cm.sink().flush();
+    bool ok = out.close();
+    auto t1 = std::chrono::steady_clock::now();
+
+    // The same bird as edges, sampled the way PcmSink does it
+    rec.sink().clear();
+    randomSeed(b + 1);
+    rec.birdVoice(b, 20);
+    std::vector<int16_t> expected;
+    uint64_t ticks = 0;
+    for (size_t i = 0; i < rec.sink().count(); i++)
+    {
+      ticks += rec.sink()[i].ticks;
+      while (expected.size() < ticks * rate / RecorderSink::TICK_HZ) expected.push_back(rec.sink()[i].level ? 16000 : -16000);
+    }
+    FILE *f = fopen(path, "rb");
+    uint8_t header[44];
+    std::vector<int16_t> samples(expected.size() + 1);
+    ok = ok && f && fread(header, 1, 44, f) == 44 && memcmp(header, "RIFF", 4) == 0
+      && (header[40] | header[41] << 8 | header[42] << 16 | (uint32_t)header[43] << 24) == expected.size() * 2
+      && fread(samples.data(), 2, samples.size(), f) == expected.size();
+    if (f) fclose(f);
+    samples.pop_back();
+    ok = ok && samples == expected;
+
+    double sec = out.samples() / (double)rate, host = std::chrono::duration<double>(t1 - t0).count();
+    audioSec += sec;
+    hostSec += host;
+    printf("%-10s %7.2f s %8llu samples %7.0fx real time %s\n", cm.birds()[b].name, sec, (unsigned long long)out.samples(), sec / host, ok ? "ok" : "MISMATCH");
+    if (! ok) failures++;
+  }
+  remove(path);
+  bool fast = audioSec / hostSec >= 500;
+  printf("all birds: %.1f s of audio in %.1f ms, %.0fx real time %s\n", audioSec, hostSec * 1e3, audioSec / hostSec, fast ? "ok" : "TOO SLOW");
+  return failures || ! fast ? 1 : 0;
+}
+
+/**
+ * In place radix 2 FFT, n a power of 2
+ */
+static void fft(std::vector<std::complex<double>> &x)
+{
+  size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j |= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1)
+  {
+    std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+    for (size_t i = 0; i < n; i += len)
+    {
+      std::complex<double> wk = 1;
+      for (size_t k = 0; k < len / 2; k++, wk *= w)
+      {
+        std::complex<double> u = x[i + k], v = x[i + k + len / 2] * wk;
+        x[i + k] = u + v;
+        x[i + k + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+/**
+ * Power of the aliases relative to the whole signal in dB. The spectrum is
+ * taken with a Blackman-Harris window; the bins around DC and around the
+ * harmonics below Nyquist are the signal, everything else is alias.
+ */
+static double aliasDb(const std::vector<double> &samples, double f0, uint32_t rate)
+{
+  size_t n = samples.size();
+  std::vector<std::complex<double>> x(n);
+  for (size_t i = 0; i < n; i++)
+  {
+    double p = 2 * M_PI * i / n;
+    x[i] = samples[i] * (0.35875 - 0.48829 * cos(p) + 0.14128 * cos(2 * p) - 0.01168 * cos(3 * p));
+  }
+  fft(x);
+  double signal = 0, alias = 0;
+  for (size_t b = 0; b <= n / 2; b++)
+  {
+    double f = (double)b * rate / n, h = round(f / f0);
+    bool harmonic = h * f0 < rate / 2.0 && fabs(f - h * f0) * n / rate <= 5;
+    (harmonic ? signal : alias) += std::norm(x[b]);
+  }
+  return 10 * log10(alias / signal);
+}
+
+/**
+ * The pulse train of period and high ticks sampled at rate, naive (PcmSink)
+ * or band-limited (BlepSink), as doubles
+ */
+template <class Sink>
+static std::vector<double> pulses(uint32_t rate, uint32_t period, uint32_t high, size_t n)
+{
+  static std::vector<double> out;
+  out.clear();
+  static Sink sink;
+  sink.setOutput(rate, [](const int16_t *s, size_t k, void *) { out.insert(out.end(), s, s + k); });
+  while (sink.samples() < n + 1000)
+  {
+    sink.write(HIGH, high);
+    sink.write(LOW, period - high);
+  }
+  sink.flush();
+  return std::vector<double>(out.begin() + 1000, out.begin() + 1000 + n);  // skip the start
+}
+
+/**
+ * The ideal pulse train of the same amplitude, its Fourier series up to
+ * Nyquist, as if rendered at an infinite rate and low-passed
+ */
+static std::vector<double> idealPulses(uint32_t rate, uint32_t period, uint32_t high, size_t n)
+{
+  double f0 = (double)BlepSink::TICK_HZ / period, duty = (double)high / period;
+  std::vector<double> out(n, 16000 * (2 * duty - 1));
+  for (int k = 1; k * f0 < rate / 2.0; k++)
+  {
+    double a = 16000 * 4 / (M_PI * k) * sin(M_PI * k * duty);
+    for (size_t i = 0; i < n; i++)
+    {
+      double t = (1000 + i) / (double)rate * f0;   // in periods, the same start as pulses()
+      out[i] += a * cos(2 * M_PI * k * (t - duty / 2));
+    }
+  }
+  return out;
+}
+
+/**
+ * Pulses of the birds, 5 .. 50 % duty at 2 .. 6 kHz, naive and band-limited
+ * at 44.1 and 48 kHz against the ideal pulse, then the SIMD conversion
+ * against the scalar one and the speed of all birds.
+ */
+static int blepTest()
+{
+  struct Case { uint32_t period, high; } cases[] = {{1810, 91}, {1810, 272}, {1810, 905}, {2273, 114}, {5000, 750}};
+  const size_t N = 16384;
+  int failures = 0;
+  printf("   f Hz  duty  rate    naive   blep  ideal dB alias\n");
+  for (uint32_t rate : {44100u, 48000u})
+  {
+    for (auto c : cases)
+    {
+      double f0 = (double)BlepSink::TICK_HZ / c.period;
+      double naive = aliasDb(pulses<PcmSink>(rate, c.period, c.high, N), f0, rate);
+      double blep = aliasDb(pulses<BlepSink>(rate, c.period, c.high, N), f0, rate);
+      double ideal = aliasDb(idealPulses(rate, c.period, c.high, N), f0, rate);
+      bool ok = blep < -70;
+      printf("%7.0f %4.0f%% %5u %8.1f %6.1f %6.1f %s\n", f0, 100.0 * c.high / c.period, rate, naive, blep, ideal, ok ? "ok" : "ALIASED");
+      if (! ok) failures++;
+    }
+  }
+
+  // The vector conversion has to round and saturate like the scalar one
+  std::vector<float> in(1000);
+  for (size_t i = 0; i < in.size(); i++) in[i] = (i % 7 == 0 ? 40000.0f : 1.0f) * sinf(i * 0.37f) * 33000 / (1 + i % 3) + (i % 4) * 0.5f;
+  std::vector<int16_t> vec(in.size()), ref(in.size());
+  BlepSink::convert(in.data(), vec.data(), in.size());
+  for (size_t i = 0; i < in.size(); i++) ref[i] = (int16_t)lrintf(std::min(32767.0f, std::max(-32768.0f, in[i])));
+  bool same = vec == ref;
+  printf("conversion: vector against scalar %s\n", same ? "ok" : "DIFFERENT");
+  if (! same) failures++;
+
+  // flush() hands on whatever is pending, up to a block and the samples after it, in blocks of at most BLOCK_SIZE
+  static size_t flushed, largest;
+  bool whole = true;
+  for (uint32_t n = 0; n <= BlepSink::BLOCK_SIZE + BlepSink::TAPS; n++)
+  {
+    BlepSink sink;
+    flushed = largest = 0;
+    sink.setOutput(44100, [](const int16_t *, size_t k, void *) { flushed += k; largest = std::max(largest, k); });
+    sink.write(HIGH, (uint64_t)n * BlepSink::TICK_HZ / 44100);
+    sink.flush();
+    whole = whole && flushed == sink.samples() && largest <= BlepSink::BLOCK_SIZE;
+  }
+  printf("flush: 0 .. %u samples pending, all handed on in blocks of at most %u %s\n", BlepSink::BLOCK_SIZE + BlepSink::TAPS, BlepSink::BLOCK_SIZE, whole ? "ok" : "MISMATCH");
+  if (! whole) failures++;
+
+  // All birds, one voice
+  static BlepChirpmaker cm(PIN_BUZZER);
+  static uint64_t sum;
+  cm.sink().setOutput(44100, [](const int16_t *s, size_t k, void *) { for (size_t i = 0; i < k; i++) sum += s[i]; });
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint16_t b = 0; b < cm.birds().size(); b++) cm.birdVoice(b, 20);
+  cm.sink().flush();
+  double host = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  double audio = cm.sink().samples() / 44100.0, speed = audio / host;
+  printf("all birds band-limited: %.1f s of audio in %.1f ms, %.0fx real time %s\n", audio, host * 1e3, speed, speed >= 100 ? "ok" : "TOO SLOW");
+  if (speed < 100) failures++;
+  return failures ? 1 : 0;
+}
+
+// FNV-1a of the samples, a PCM block handler
+struct SampleHash
+{
+  uint64_t hash = 14695981039346656037ULL;
+  uint64_t samples = 0;
+  uint64_t sounding = 0;
+
+  static void block(const int16_t *s, size_t n, void *self)
+  {
+    SampleHash &h = *static_cast<SampleHash *>(self);
+    for (size_t i = 0; i < n; i++)
+    {
+      h.hash = (h.hash ^ (uint16_t)s[i]) * 1099511628211ULL;
+      h.sounding += s[i] != 0;
+    }
+    h.samples += n;
+  }
+  bool operator==(const SampleHash &o) const { return hash == o.hash && samples == o.samples; }
+};
+
+/**
+ * A concert rendered in chunks on several threads has to give the same
+ * samples as a single chunk on one thread. Then an hour on 1 .. 32 threads.
+ */
+static int chunks()
+{
+  const uint32_t rate = 44100;
+  static ConcertRenderer<NullChirpmaker> r;
+  Concert<NullChirpmaker>::Plan plan;
+  plan.birdsPerMinute = 30;
+  plan.maxOverlap = 3;
+  plan.seed = 7;
+  int failures = 0;
+
+  r.compile(plan, 4, 600000);
+  SampleHash ref;
+  r.render(rate, SampleHash::block, &ref, 1, 0);
+  printf("10 min: %zu birds, %.1f s of samples in one chunk, %.0f%% of them not silent\n", r.segments().size(), ref.samples / (double)rate, 100.0 * ref.sounding / ref.samples);
+  for (unsigned threads : {1u, 2u, 4u, 8u})
+  {
+    for (uint32_t msChunk : {500u, 5000u})
+    {
+      SampleHash h;
+      r.render(rate, SampleHash::block, &h, threads, msChunk);
+      bool ok = h == ref;
+      printf("  %2u threads, chunks of %4u ms: %4u chunks, %3u birds carried over %s\n", threads, msChunk, r.chunks(), r.carried(), ok ? "ok" : "DIFFERENT");
+      if (! ok) failures++;
+    }
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  r.compile(plan, 4, 3600000);
+  double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  printf("1 hour: %zu birds, compiled in %.1f ms, %u cores\n", r.segments().size(), compileMs, std::thread::hardware_concurrency());
+  printf("threads  time ms  x real time  speedup  efficiency\n");
+  SampleHash one;
+  double oneSec = 0;
+  for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u})
+  {
+    SampleHash h;
+    auto t1 = std::chrono::steady_clock::now();
+    r.render(rate, SampleHash::block, &h, threads);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+    if (threads == 1)
+    {
+      one = h;
+      oneSec = sec;
+    }
+    bool ok = h == one;
+    printf("%7u %8.1f %12.0f %8.2f %10.0f%% %s\n", threads, sec * 1e3, h.samples / (double)rate / sec, oneSec / sec, 100 * oneSec / sec / threads, ok ? "ok" : "DIFFERENT");
+    if (! ok) failures++;
+  }
+  if (std::thread::hardware_concurrency() < 2) printf("a single core: the threads take turns, this is their cost, not multi-core scaling\n");
+  return failures ? 1 : 0;
+}
+
+// The bits of a PDM stream as +-1, a PdmModulator word handler
+static std::vector<double> pdmBits;
+
+static void collectWords(const uint32_t *words, size_t n, void *ctx)
+{
+  (void)ctx;
+  for (size_t i = 0; i < n; i++)
+  {
+    for (int b = 31; b >= 0; b--) pdmBits.push_back(words[i] >> b & 1 ? 1.0 : -1.0);
+  }
+}
+
+/**
+ * Power spectrum of the first n values of x with a Blackman-Harris window,
+ * bins 0 .. n/2
+ */
+static std::vector<double> powerSpectrum(const std::vector<double> &x, size_t first, size_t n)
+{
+  std::vector<std::complex<double>> c(n);
+  for (size_t i = 0; i < n; i++)
+  {
+    double p = 2 * M_PI * i / n;
+    c[i] = x[first + i] * (0.35875 - 0.48829 * cos(p) + 0.14128 * cos(2 * p) - 0.01168 * cos(3 * p));
+  }
+  fft(c);
+  std::vector<double> power(n / 2 + 1);
+  for (size_t b = 0; b <= n / 2; b++) power[b] = std::norm(c[b]);
+  return power;
+}
+
+// Power of the bins within 5 of frequency f
+static double bandPower(const std::vector<double> &power, double f, double binHz)
+{
+  double sum = 0;
+  long centre = lround(f / binHz);
+  for (long b = std::max(0L, centre - 5); b <= centre + 5 && b < (long)power.size(); b++) sum += power[b];
+  return sum;
+}
+
+/**
+ * The sigma-delta modulator: SNR of sines in the band up to 20 kHz, which
+ * is what is left after a low pass, then its speed; a chirp through
+ * PdmSink has to keep its frequency and lose the harmonics of the squares.
+ */
+static int pdmTest()
+{
+  int failures = 0;
+  PdmModulator pdm;
+  printf("  Mbit/s   tone Hz   SNR dB (20 Hz .. 20 kHz)\n");
+  for (uint32_t rate : {2560000u, 5120000u})
+  {
+    for (double f : {440.0, 1000.0, 3000.0})
+    {
+      pdmBits.clear();
+      pdm.begin(rate, collectWords);
+      const size_t N = 1 << 19;
+      pdm.tone(PdmModulator::increment(f, rate), N + 8192);
+      pdm.flush();
+      std::vector<double> power = powerSpectrum(pdmBits, 8192, N);
+      double binHz = (double)rate / N, signal = bandPower(power, f, binHz), noise = 0;
+      for (size_t b = lround(20 / binHz); b <= 20000 / binHz; b++) noise += power[b];
+      noise -= signal;
+      double snr = 10 * log10(signal / noise);
+      bool ok = snr >= 65;
+      printf("%8.2f %9.0f %8.1f %s\n", rate / 1e6, f, snr, ok ? "ok" : "NOISY");
+      if (! ok) failures++;
+    }
+  }
+
+  pdm.begin(2560000, nullptr);
+  const uint32_t nBits = 256000000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < nBits / 2560000; i++) pdm.tone(PdmModulator::increment(1000 + i, 2560000), 2560000);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("modulator: %.0f Mbit/s, %.2f ns per bit on the host\n", nBits / sec / 1e6, sec / nBits * 1e9);
+
+  // A steady chirp at 1 kHz as squares and as PDM, harmonics up to 20 kHz against the tone
+  const uint32_t rate = 2560000;
+  static PdmChirpmaker cm(PIN_BUZZER);
+  pdmBits.clear();
+  cm.sink().setOutput(rate, collectWords);
+  cm.chirp(1000, 1000, 10, 50, 1, Chromatic(), 50, 0);
+  cm.sink().flush();
+  std::vector<double> sine = pdmBits, square;
+  for (size_t i = 0; i < sine.size(); i++) square.push_back(fmod(i * 1000.0 / rate, 1.0) < 0.5 ? 1.0 : -1.0);
+  auto harmonicsDb = [&](const std::vector<double> &x)
+  {
+    const size_t N = 1 << 20;
+    std::vector<double> power = powerSpectrum(x, 0, N);
+    double binHz = (double)rate / N, h = 0;
+    for (int k = 2; k * 1000 <= 20000; k++) h += bandPower(power, k * 1000.0, binHz);
+    return 10 * log10(h / bandPower(power, 1000, binHz));
+  };
+  static Edge recording[10000];
+  static BasicChirpmaker<RecorderSink, VirtualClock> rec(PIN_BUZZER);
+  rec.sink().setBuffer(recording, sizeof(recording) / sizeof(recording[0]));
+  rec.chirp(1000, 1000, 10, 50, 1, Chromatic(), 50, 0);
+  double bitsExpected = (double)rec.sink().ticks() * rate / RecorderSink::TICK_HZ;
+  double sineDb = harmonicsDb(sine), squareDb = harmonicsDb(square);
+  bool ok = sine.size() >= bitsExpected && sine.size() < bitsExpected + 32 && sineDb < -60;
+  printf("chirp at 1 kHz: %zu bits, harmonics %.1f dB (squares %.1f dB) %s\n", sine.size(), sineDb, squareDb, ok ? "ok" : "MISMATCH");
+  if (! ok) failures++;
+  return failures ? 1 : 0;
+}
+
+static std::vector<int16_t> played;
+
+static void collectBlock(const int16_t *samples, size_t n, void *ctx) { played.insert(played.end(), samples, samples + n); }
+
+/**
+ * A few sounds prerendered as 8 bit at 22050 Hz and 16 bit at 44100 Hz:
+ * what a second costs in memory and what rendering them costs at startup.
+ * The samples have to be what PcmSink plays, then SamplePlayer has to play
+ * them back unchanged through its double buffer, serviced every ms, without
+ * an underrun; a gap of 50 ms has to be counted as one.
+ */
+static int clips(int argc, char *argv[])
+{
+  struct Sound
+  {
+    const char *name;
+    SampleClip::Sound sound;
+    int arg;
+  };
+  static const Sound sounds[] =
+  {
+    {"signet", [](PcmChirpmaker &cm, void *) { cm.signet(); }, 0},
+    {"phoneCall", [](PcmChirpmaker &cm, void *rings) { cm.phoneCall(*static_cast<int *>(rings)); }, 2},
+    {"cuckoo", [](PcmChirpmaker &cm, void *bird) { cm.birdVoice(*static_cast<int *>(bird), 0); }, 11},
+    {"bird 8", [](PcmChirpmaker &cm, void *bird) { cm.birdVoice(*static_cast<int *>(bird), 0); }, 8},
+  };
+  struct Setting
+  {
+    uint32_t rate;
+    SampleClip::Format format;
+  };
+  static const Setting settings[] = {{22050, SampleClip::PCM8}, {44100, SampleClip::PCM16}};
+  static PcmChirpmaker cm(PIN_BUZZER);
+  int failures = 0;
+
+  printf("render() takes %zu bytes of heap for its PcmChirpmaker besides the clip\n", sizeof(PcmChirpmaker));
+  printf("sound       format      s    bytes     KB/s  render ms  x real time  playback CPU\n");
+  for (const Setting &set : settings)
+  {
+    for (const Sound &s : sounds)
+    {
+      SampleClip clip;
+      randomSeed(7);
+      auto t0 = std::chrono::steady_clock::now();
+      int arg = s.arg;
+      bool ok = clip.render(s.sound, &arg, set.rate, set.format);
+      double renderSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+      // The same sound straight from PcmSink
+      played.clear();
+      randomSeed(7);
+      cm.sink().setOutput(set.rate, collectBlock);
+      s.sound(cm, &arg);
+      cm.sink().flush();
+      std::vector<int16_t> expected = played, samples(clip.samples());
+      clip.read(0, samples.data(), clip.samples());
+      if (set.format == SampleClip::PCM8) for (int16_t &e : expected) e = (e >> 8) << 8;
+      ok = ok && samples == expected;
+
+      // Played back, serviced every ms of a virtual time
+      SamplePlayer player;
+      played.clear();
+      player.begin(set.rate, collectBlock);
+      player.play(clip);
+      double serviceSec = 0;
+      uint32_t us = 0;
+      for (bool playing = true; playing; us += 1000)
+      {
+        auto t1 = std::chrono::steady_clock::now();
+        playing = player.service(us);
+        serviceSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+      }
+      ok = ok && player.underruns() == 0 && played.size() - clip.samples() < SamplePlayer::BLOCK_SAMPLES
+        && std::equal(expected.begin(), expected.end(), played.begin())
+        && std::all_of(played.begin() + clip.samples(), played.end(), [](int16_t x) { return x == 0; });
+
+      double sec = clip.samples() / (double)set.rate;
+      printf("%-10s %5s %7.2f %8u %8.1f %10.2f %12.0f %12.4f%% %s\n", s.name, set.format == SampleClip::PCM8 ? "8 bit" : "16 bit", sec,
+        clip.bytes(), clip.bytesPerSecond() / 1024.0, renderSec * 1e3, sec / renderSec, serviceSec / sec * 100, ok ? "ok" : "MISMATCH");
+      if (! ok) failures++;
+    }
+  }
+
+  // A loop that is 50 ms late has to leave the output dry once
+  SampleClip clip;
+  clip.render(11, 22050, SampleClip::PCM8);
+  SamplePlayer player;
+  player.begin(22050, collectBlock);
+  player.play(clip);
+  uint32_t us = 0;
+  for (; us < 500000; us += 1000) player.service(us);
+  for (us += 50000; player.service(us); us += 1000);
+  bool ok = player.underruns() == 1;
+  printf("a gap of 50 ms: %u underrun(s) %s\n", player.underruns(), ok ? "ok" : "MISSED");
+  if (! ok) failures++;
+
+  // Birds rendered on several threads at once are the birds rendered one by one
+  const uint16_t birds[] = {11, 8, 3, 14};
+  std::vector<std::vector<uint8_t>> serial, parallel(4);
+  std::vector<std::thread> threads;
+  for (uint16_t b : birds)
+  {
+    randomSeed(b);
+    SampleClip c;
+    c.render(b, 22050, SampleClip::PCM8);
+    serial.emplace_back(c.data(), c.data() + c.bytes());
+  }
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([&, t]
+    {
+      hostOwnRandom();
+      randomSeed(birds[t]);
+      SampleClip c;
+      c.render(birds[t], 22050, SampleClip::PCM8);
+      parallel[t].assign(c.data(), c.data() + c.bytes());
+    });
+  for (std::thread &t : threads) t.join();
+  ok = parallel == serial;
+  printf("4 birds rendered on 4 threads: %s\n", ok ? "same as one by one, ok" : "MISMATCH");
+  if (! ok) failures++;
+
+  if (argc > 2)
+  {
+    WavWriter out;
+    if (! out.open(argv[2], 22050)) return 1;
+    player.begin(22050, WavWriter::block, &out);
+    player.play(clip);
+    for (us = 0; player.service(us); us += 1000);
+    if (! out.close()) return 1;
+    printf("%s: %llu samples\n", argv[2], (unsigned long long)out.samples());
+  }
+  return failures ? 1 : 0;
+}
+
+// SNR of x against the reference ref in dB
+static double snrDb(const std::vector<int16_t> &ref, const std::vector<int16_t> &x)
+{
+  double signal = 0, noise = 0;
+  for (size_t i = 0; i < ref.size(); i++)
+  {
+    double d = (double)x[i] - ref[i];
+    signal += (double)ref[i] * ref[i];
+    noise += d * d;
+  }
+  return noise > 0 ? 10 * log10(signal / noise) : INFINITY;
+}
+
+static std::vector<int16_t> clipSamples(const SampleClip &clip)
+{
+  std::vector<int16_t> samples(clip.samples());
+  clip.read(0, samples.data(), clip.samples());
+  return samples;
+}
+
+/**
+ * Every bird as a 16 bit, an 8 bit and an ADPCM clip: bytes and SNR of 8
+ * bit and ADPCM against 16 bit, of ADPCM also at a quarter of the
+ * amplitude and band-limited by a BlepSink, against a band-limited 16 bit
+ * clip. ADPCM has to decode the same in blocks of SamplePlayer as in one
+ * piece, and faster than 20 Msamples/s on one host core. With FILE the
+ * band-limited ADPCM birds go into a C header to be put into flash.
+ */
+static int adpcm(int argc, char *argv[])
+{
+  uint32_t rate = argc > 3 ? atol(argv[3]) : 22050;
+  static PcmChirpmaker cm(PIN_BUZZER);
+  std::vector<SampleClip *> clips;
+  std::vector<double> plain, quiet, blep;
+  int failures = 0;
+  uint64_t pcmBytes = 0, adpcmBytes = 0;
+
+  // A bird through a BlepSink into clip
+  auto blepRender = [rate](SampleClip &clip, uint16_t b, SampleClip::Format format)
+  {
+    BlepChirpmaker *bcm = new BlepChirpmaker(PIN_BUZZER);
+    clip.begin(rate, format);
+    bcm->sink().setOutput(rate, SampleClip::block, &clip);
+    randomSeed(b + 1);
+    bcm->birdVoice(b, 0);
+    bcm->sink().flush();
+    delete bcm;
+    return clip.end();
+  };
+
+  printf("%u Hz\nbird           s   16 bit    8 bit    ADPCM  ratio      SNR dB: 8 bit  ADPCM  1/4 amp  blep ADPCM\n", rate);
+  for (uint16_t b = 0; b < cm.birds().size(); b++)
+  {
+    SampleClip pcm16, pcm8, adpcm, pcm16Quiet, adpcmQuiet, blep16, *blepAdpcm = new SampleClip;
+    randomSeed(b + 1);
+    pcm16.render(b, rate, SampleClip::PCM16);
+    randomSeed(b + 1);
+    pcm8.render(b, rate, SampleClip::PCM8);
+    randomSeed(b + 1);
+    bool ok = adpcm.render(b, rate, SampleClip::ADPCM) && adpcm.samples() == pcm16.samples();
+    randomSeed(b + 1);
+    pcm16Quiet.render(b, rate, SampleClip::PCM16, 4000);
+    randomSeed(b + 1);
+    ok = ok && adpcmQuiet.render(b, rate, SampleClip::ADPCM, 4000);
+    ok = ok && blepRender(blep16, b, SampleClip::PCM16) && blepRender(*blepAdpcm, b, SampleClip::ADPCM) && blepAdpcm->samples() == blep16.samples();
+    clips.push_back(blepAdpcm);
+
+    for (SampleClip *clip : {&adpcm, blepAdpcm})
+    {
+      std::vector<int16_t> whole = clipSamples(*clip), blocks(whole.size());
+      for (uint32_t i = 0; i < blocks.size(); i += SamplePlayer::BLOCK_SAMPLES)
+      {
+        int16_t block[SamplePlayer::BLOCK_SAMPLES];
+        clip->read(i, block, SamplePlayer::BLOCK_SAMPLES);
+        std::copy(block, block + std::min<size_t>(SamplePlayer::BLOCK_SAMPLES, blocks.size() - i), blocks.begin() + i);
+      }
+      ok = ok && blocks == whole;
+    }
+    pcmBytes += pcm16.bytes();
+    adpcmBytes += adpcm.bytes();
+    plain.push_back(snrDb(clipSamples(pcm16), clipSamples(adpcm)));
+    quiet.push_back(snrDb(clipSamples(pcm16Quiet), clipSamples(adpcmQuiet)));
+    blep.push_back(snrDb(clipSamples(blep16), clipSamples(*blepAdpcm)));
+    printf("%-10s %5.2f %8u %8u %8u %5.2f %17.1f %6.1f %8.1f %11.1f %s\n", cm.birds()[b].name, pcm16.samples() / (double)rate, pcm16.bytes(), pcm8.bytes(),
+      adpcm.bytes(), pcm16.bytes() / (double)adpcm.bytes(), snrDb(clipSamples(pcm16), clipSamples(pcm8)), plain.back(), quiet.back(), blep.back(), ok ? "ok" : "MISMATCH");
+    if (! ok) failures++;
+  }
+  auto range = [](std::vector<double> v)
+  {
+    std::sort(v.begin(), v.end());
+    char text[48];
+    snprintf(text, sizeof(text), "%.1f .. %.1f dB, median %.1f", v.front(), v.back(), v[v.size() / 2]);
+    return std::string(text);
+  };
+  printf("ADPCM: %s; at 1/4 amplitude %s; band-limited %s\n", range(plain).c_str(), range(quiet).c_str(), range(blep).c_str());
+  printf("all birds: %llu bytes 16 bit, %llu bytes ADPCM, %.2f times less, %.1f KB per second\n",
+    (unsigned long long)pcmBytes, (unsigned long long)adpcmBytes, pcmBytes / (double)adpcmBytes, clips[0]->bytesPerSecond() / 1024.0);
+
+  // Decode speed the way SamplePlayer decodes, a block at a time
+  int16_t block[SamplePlayer::BLOCK_SAMPLES];
+  uint64_t samples = 0;
+  int32_t sum = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int round = 0; round < 20; round++)
+  {
+    for (SampleClip *clip : clips)
+    {
+      for (uint32_t i = 0; i < clip->samples(); i += SamplePlayer::BLOCK_SAMPLES)
+      {
+        clip->read(i, block, SamplePlayer::BLOCK_SAMPLES);
+        sum += block[SamplePlayer::BLOCK_SAMPLES / 2];
+      }
+      samples += clip->samples();
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  bool fast = samples / sec >= 20e6;
+  printf("decode: %.1f Msamples/s on one core, %.3f %% of it at %u Hz (%d) %s\n", samples / sec / 1e6, rate / (samples / sec) * 100, rate, sum & 1, fast ? "ok" : "TOO SLOW");
+  if (! fast) failures++;
+
+  if (argc > 2)
+  {
+    FILE *f = fopen(argv[2], "w");
+    if (! f) return 1;
+    fprintf(f, "// Birds of the Chirpmaker band-limited as IMA ADPCM at %u Hz, written by chirptool adpcm\n", rate);
+    fprintf(f, "//   SampleClip clip(CLIP_CUCKOO, CLIP_CUCKOO_SAMPLES, CLIP_RATE, SampleClip::ADPCM);\n#pragma once\n#include <stdint.h>\n\n");
+    fprintf(f, "const uint32_t CLIP_RATE = %u;\n", rate);
+    for (uint16_t b = 0; b < clips.size(); b++)
+    {
+      std::string name = cm.birds()[b].name;
+      std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+      fprintf(f, "\nconst uint32_t CLIP_%s_SAMPLES = %u;\nconst uint8_t CLIP_%s[%u] =\n{", name.c_str(), clips[b]->samples(), name.c_str(), clips[b]->bytes());
+      for (uint32_t i = 0; i < clips[b]->bytes(); i++) fprintf(f, "%s%u,", i % 24 ? " " : "\n  ", clips[b]->data()[i]);
+      fprintf(f, "\n};\n");
+    }
+    if (fclose(f) != 0) return 1;
+    printf("%s: %zu birds\n", argv[2], clips.size());
+  }
+  for (SampleClip *clip : clips) delete clip;
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  hostSetEdgeHook(recordEdge);
+  const char *cmd = argc > 1 ? argv[1] : "check";
+  if (strcmp(cmd, "trace") == 0) return trace();
+  if (strcmp(cmd, "check") == 0) return check();
+  if (strcmp(cmd, "program") == 0) return program();
+  if (strcmp(cmd, "async") == 0) return async();
+  if (strcmp(cmd, "record") == 0) return record();
+  if (strcmp(cmd, "measure") == 0) return measure();
+  if (strcmp(cmd, "numeric") == 0) return numeric();
+  if (strcmp(cmd, "batch") == 0) return batch();
+  if (strcmp(cmd, "drift") == 0) return driftTest();
+  if (strcmp(cmd, "objects") == 0) return objects();
+  if (strcmp(cmd, "tables") == 0) return tables();
+  if (strcmp(cmd, "templates") == 0) return templates();
+  if (strcmp(cmd, "programs") == 0) return programs();
+  if (strcmp(cmd, "birds") == 0) return birdRegistry();
+  if (strcmp(cmd, "songs") == 0) return songs();
+  if (strcmp(cmd, "bank") == 0) return bank(argc, argv);
+  if (strcmp(cmd, "banks") == 0) return banks();
+  if (strcmp(cmd, "poly") == 0) return poly();
+  if (strcmp(cmd, "concert") == 0) return concert();
+  if (strcmp(cmd, "worker") == 0) return worker();
+  if (strcmp(cmd, "log") == 0) return logTest();
+  if (strcmp(cmd, "wav") == 0) return wav(argc, argv);
+  if (strcmp(cmd, "render") == 0) return render();
+  if (strcmp(cmd, "blep") == 0) return blepTest();
+  if (strcmp(cmd, "chunks") == 0) return chunks();
+  if (strcmp(cmd, "pdm") == 0) return pdmTest();
+  if (strcmp(cmd, "clips") == 0) return clips(argc, argv);
+  if (strcmp(cmd, "adpcm") == 0) return adpcm(argc, argv);
+  fprintf(stderr, "unknown command %s\n", cmd);
+  return 2;
+}